@@ -0,0 +1,51 @@
+/**
+ * @file boot_api.h
+ * @brief Flash layout and the bootloader entry the application calls (ota.h).
+ *
+ *     0x0000  active region   application that runs
+ *     0x3C00  staging region  new image written by the OTA downloader
+ *     0x7800  bootloader      2 KiB boot section (BOOTSZ = 1024 words)
+ *
+ * The application cannot run SPM itself (only code in the boot section
+ * can), so the bootloader exports boot_page_write() through a jump at a
+ * fixed address. On reset it copies a verified staging region over the
+ * active one if the EEPROM marker asks for it.
+ */
+
+#ifndef BOOT_API_H
+#define BOOT_API_H
+
+#include <stdint.h>
+#include <avr/io.h>
+
+#define BOOT_ACTIVE     0x0000U
+#define BOOT_STAGING    0x3C00U
+#define BOOT_REGION_SZ  0x3C00U
+#define BOOT_START      0x7800U
+
+/** MCUSR as it was at reset; the bootloader clears the register itself. */
+#define BOOT_RESET_CAUSE GPIOR0
+
+/** Byte address of the jump to boot_page_write() (.bootapi section). */
+#define BOOT_API_ADDR   0x7FF0U
+
+/** Switch request at the end of the EEPROM, past anything EEMEM allocates. */
+#define BOOT_MARK_ADDR  ((uint8_t *)(E2END + 1 - sizeof(boot_mark_t)))
+#define BOOT_MARK_SWAP  0x50415753UL     /**< "SWAP": copy staging, then clear */
+
+typedef struct {
+    uint32_t magic;     /**< BOOT_MARK_SWAP, anything else = nothing to do */
+    uint32_t crc;       /**< CRC-32 of the whole staging region */
+} boot_mark_t;
+
+/**
+ * Erase and program one SPM_PAGESIZE page of the staging region from buf
+ * (RAM). Runs with interrupts off for about 8 ms. Returns 0 (nothing
+ * written) for an address outside staging or not on a page boundary.
+ */
+typedef uint8_t (*boot_page_write_fn)(uint16_t addr, const uint8_t *buf);
+
+/* Function pointers on the AVR are word addresses */
+#define boot_page_write_api ((boot_page_write_fn)(BOOT_API_ADDR / 2))
+
+#endif /* BOOT_API_H */
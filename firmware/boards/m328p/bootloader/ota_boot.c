@@ -0,0 +1,125 @@
+/**
+ * @file ota_boot.c
+ * @brief Boot section: switches to a new image from the staging region, page writes for the application.
+ *
+ * Runs on every reset (BOOTRST). With no switch requested in the EEPROM
+ * it jumps straight to the application. Otherwise the staging region
+ * must match the CRC the application recorded after downloading it; only
+ * then is it copied over the active region, page by page, and checked
+ * again. A power cut during the copy leaves the marker set, so the next
+ * reset starts the copy over from the intact staging image. A staging
+ * region that fails its check is dropped before anything is copied and
+ * the old image keeps running. An active region that still fails after
+ * COPY_TRIES copies is never started: the marker stays and the watchdog
+ * resets into another attempt from the staging image.
+ *
+ * No interrupts are used here (IVSEL stays 0, the vectors belong to the
+ * application).
+ *
+ * testing/ota_boot_sim.c builds this file on a PC against simulated
+ * flash, EEPROM and watchdog (testing/avr_sim) and runs main() through
+ * power cuts, bad staging images and worn pages.
+ *
+ * Dependencies: boot_api.h (layout), crc32.h
+ */
+
+#include <avr/io.h>
+#include <avr/boot.h>
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <avr/wdt.h>
+#include "boot_api.h"
+#include "crc32.h"
+
+/* Whole copies tried before giving up on a worn active region */
+#define COPY_TRIES 2
+
+/* Jump to the application's reset vector (the host simulation returns to its run loop) */
+#ifndef BOOT_ENTER_APP
+#define BOOT_ENTER_APP() ((void (*)(void))BOOT_ACTIVE)()
+#endif
+
+static uint32_t region_crc(uint16_t base) {
+    uint32_t crc = CRC32_INIT;
+
+    for (uint16_t i = 0; i < BOOT_REGION_SZ; i++) {
+        crc = crc32_update(crc, pgm_read_byte(base + i));
+    }
+    return crc32_final(crc);
+}
+
+static void program(uint16_t addr, const uint8_t *buf) {
+    uint8_t sreg = SREG;
+
+    cli();
+    eeprom_busy_wait();                 // SPM is ignored while the EEPROM writes
+    boot_page_erase(addr);
+    boot_spm_busy_wait();
+    for (uint8_t i = 0; i < SPM_PAGESIZE; i += 2) {
+        boot_page_fill(addr + i, buf[i] | (buf[i + 1] << 8));
+    }
+    boot_page_write(addr);
+    boot_spm_busy_wait();
+    boot_rww_enable();                  // application section readable again
+    SREG = sreg;
+}
+
+/* Called by the application through the jump at BOOT_API_ADDR; the
+   staging region is the only one it may change */
+__attribute__((used)) uint8_t page_write(uint16_t addr, const uint8_t *buf) {
+    if (addr < BOOT_STAGING || addr >= BOOT_STAGING + BOOT_REGION_SZ) return 0;
+    if (addr % SPM_PAGESIZE) return 0;
+    program(addr, buf);
+    return 1;
+}
+
+#ifdef __AVR__
+__attribute__((naked, used, section(".bootapi"))) static void api_table(void) {
+    __asm__ volatile ("rjmp page_write");
+}
+#endif
+
+/* Staging over active, skipping pages that are already equal */
+static void copy_staging(void) {
+    static uint8_t page[SPM_PAGESIZE];
+
+    for (uint16_t off = 0; off < BOOT_REGION_SZ; off += SPM_PAGESIZE) {
+        uint8_t same = 1;
+
+        for (uint8_t i = 0; i < SPM_PAGESIZE; i++) {
+            page[i] = pgm_read_byte(BOOT_STAGING + off + i);
+            if (page[i] != pgm_read_byte(BOOT_ACTIVE + off + i)) same = 0;
+        }
+        if (!same) program(BOOT_ACTIVE + off, page);
+    }
+}
+
+int main(void) {
+    boot_mark_t mark;
+
+    BOOT_RESET_CAUSE = MCUSR;
+    MCUSR = 0;                          // WDRF would keep the watchdog on
+    wdt_disable();
+
+    eeprom_read_block(&mark, BOOT_MARK_ADDR, sizeof(mark));
+    if (mark.magic == BOOT_MARK_SWAP) {
+        if (region_crc(BOOT_STAGING) == mark.crc) {
+            uint8_t ok = 0;
+
+            for (uint8_t i = 0; i < COPY_TRIES && !ok; i++) {
+                copy_staging();
+                ok = region_crc(BOOT_ACTIVE) == mark.crc;
+            }
+            if (!ok) {
+                // Half-written image: keep the marker, start over after a reset
+                wdt_enable(WDTO_2S);
+                for (;;) { }
+            }
+        }
+        eeprom_update_dword(&((boot_mark_t *)BOOT_MARK_ADDR)->magic, 0xFFFFFFFFUL);
+    }
+
+    BOOT_ENTER_APP();
+    for (;;) { }
+}
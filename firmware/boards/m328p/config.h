@@ -24,4 +24,194 @@
 
 #ifndef BME280_ADDR
     #define BME280_ADDR 0x76
-#endif
\ No newline at end of file
+#endif
+
+/* Power rails (GSM_PWRKEY_* are set with -D, see gsm_module.h) */
+#ifndef SENSOR_RAIL_PIN
+    #define SENSOR_RAIL_PIN PD4
+#endif
+
+#ifndef SENSOR_RAIL_PORT
+    #define SENSOR_RAIL_PORT PORTD
+#endif
+
+#ifndef SENSOR_RAIL_DDR
+    #define SENSOR_RAIL_DDR DDRD
+#endif
+
+#ifndef ONE_WIRE_PULLUP_PIN
+    #define ONE_WIRE_PULLUP_PIN PD5
+#endif
+
+#ifndef ONE_WIRE_PULLUP_PORT
+    #define ONE_WIRE_PULLUP_PORT PORTD
+#endif
+
+#ifndef ONE_WIRE_PULLUP_DDR
+    #define ONE_WIRE_PULLUP_DDR DDRD
+#endif
+
+/* Measurement/upload cycle */
+#ifndef UPLOAD_URL
+    #define UPLOAD_URL "https://7fc9cee303d2.ngrok-free.app/ingest"
+#endif
+
+/* Upload transport: 0 = HTTP POST per upload, 1 = MQTT session (transport.h) */
+#ifndef UPLOAD_MQTT
+    #define UPLOAD_MQTT 0
+#endif
+
+#ifndef MQTT_BROKER
+    #define MQTT_BROKER "tcp://7fc9cee303d2.ngrok-free.app:1883"
+#endif
+
+#ifndef MQTT_CLIENT_ID
+    #define MQTT_CLIENT_ID "troposense-1"
+#endif
+
+#ifndef MQTT_TOPIC_BASE
+    #define MQTT_TOPIC_BASE "troposense/1"
+#endif
+
+#ifndef MQTT_KEEPALIVE_S
+    #define MQTT_KEEPALIVE_S 60
+#endif
+
+/* How long close() waits for a retained config that has not come yet */
+#ifndef MQTT_REPLY_WAIT_MS
+    #define MQTT_REPLY_WAIT_MS 500
+#endif
+
+/* Warm restart (warm.h): consecutive restarts that may resume from RAM
+   before a cold boot, and the uptime after which the count starts over */
+#ifndef WARM_MAX_RESTARTS
+    #define WARM_MAX_RESTARTS 3
+#endif
+
+#ifndef WARM_STABLE_MS
+    #define WARM_STABLE_MS 600000UL
+#endif
+
+/* Snapshot at most this often; modem power changes are saved at once */
+#ifndef WARM_SAVE_MS
+    #define WARM_SAVE_MS 1000UL
+#endif
+
+/* Firmware update over GSM (ota.h). The key is the patch signature
+   key of server/ota.js and comes from the same OTA_KEY (32 hex digits)
+   through the Makefile. Updates are on only when a key is given; an
+   explicit OTA_ENABLE=1 without one stops the build. */
+#ifndef OTA_ENABLE
+    #ifdef OTA_KEY
+        #define OTA_ENABLE 1
+    #else
+        #define OTA_ENABLE 0
+    #endif
+#endif
+
+#ifndef OTA_URL
+    #define OTA_URL "https://7fc9cee303d2.ngrok-free.app/ota"
+#endif
+
+#ifndef OTA_KEY
+    #if OTA_ENABLE
+        #error "OTA_ENABLE needs the fleet's signing key: make OTA_KEY=<32 hex digits> (or OTA_ENABLE=0)"
+    #endif
+    #define OTA_KEY { 0 }   /* updates off: no patch is ever checked */
+#endif
+
+#ifndef OTA_GET_TIMEOUT_MS
+    #define OTA_GET_TIMEOUT_MS 120000UL
+#endif
+
+#ifndef SAMPLE_PERIOD_MS
+    #define SAMPLE_PERIOD_MS 15000UL
+#endif
+
+/* Modem link during the upload: fastest clean baud rate (AT+IPR), RTS/CTS
+   on the uart_isr.h pins (PD7/PB2). Set 0 on boards without the handshake lines. */
+#ifndef GSM_FLOW_CONTROL
+    #define GSM_FLOW_CONTROL 1
+#endif
+
+/* Upload triggers: defaults until settings are stored in EEPROM (settings.h) */
+#ifndef REPORT_CHECK_MIN
+    #define REPORT_CHECK_MIN 10
+#endif
+
+#ifndef REPORT_MAX_SILENCE_MIN
+    #define REPORT_MAX_SILENCE_MIN 360
+#endif
+
+#ifndef DEADBAND_AIR_TEMP
+    #define DEADBAND_AIR_TEMP 200        // 0.01 °C
+#endif
+
+#ifndef DEADBAND_GROUND_TEMP
+    #define DEADBAND_GROUND_TEMP 100     // 0.01 °C
+#endif
+
+#ifndef DEADBAND_PRESSURE
+    #define DEADBAND_PRESSURE 150        // Pa
+#endif
+
+#ifndef DEADBAND_HUMIDITY
+    #define DEADBAND_HUMIDITY 1500       // 0.01 %RH
+#endif
+
+#ifndef DEADBAND_WIND
+    #define DEADBAND_WIND 300            // cm/s
+#endif
+
+#ifndef DEADBAND_RAIN
+    #define DEADBAND_RAIN 5              // tips
+#endif
+
+#ifndef PIPELINE_PROBE_MS
+    #define PIPELINE_PROBE_MS 1000
+#endif
+
+#ifndef PIPELINE_NETWORK_TIMEOUT_MS
+    #define PIPELINE_NETWORK_TIMEOUT_MS 60000UL
+#endif
+
+/* Link-quality gate: non-urgent uploads wait for CSQ >= UPLOAD_CSQ_MIN (10 = -93 dBm) */
+#ifndef UPLOAD_CSQ_MIN
+    #define UPLOAD_CSQ_MIN 10
+#endif
+
+#ifndef UPLOAD_BACKOFF_MIN_MS
+    #define UPLOAD_BACKOFF_MIN_MS 600000UL
+#endif
+
+#ifndef UPLOAD_BACKOFF_MAX_MS
+    #define UPLOAD_BACKOFF_MAX_MS 14400000UL
+#endif
+
+#ifndef PIPELINE_SESSION_LOG
+    #define PIPELINE_SESSION_LOG 4
+#endif
+
+/* Largest report body; the record batch is left out (and kept) if it
+   would not fit. No buffer of this size exists, the body is streamed. */
+#ifndef PIPELINE_PAYLOAD_SZ
+    #define PIPELINE_PAYLOAD_SZ 704
+#endif
+
+/* Compressed record batch (tscodec.h): one record per RECORD_PERIOD_S */
+#ifndef RECORD_PERIOD_S
+    #define RECORD_PERIOD_S 300
+#endif
+
+#ifndef RECORD_BUF_SZ
+    #define RECORD_BUF_SZ 160
+#endif
+
+#ifndef RECORD_FLUSH_PCT
+    #define RECORD_FLUSH_PCT 75
+#endif
+
+/* Clock scaling: divider (2^n) when nothing needs full speed */
+#ifndef CLOCK_SLOW_DIV
+    #define CLOCK_SLOW_DIV 4
+#endif
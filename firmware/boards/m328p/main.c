@@ -2,40 +2,124 @@
 #include <util/delay.h>
 #include "config.h"
 #include "uart_isr.h" 
-#include "gsm_module.h"
+#include "i2c.h"
+#include "systick.h"
+#include "event_queue.h"
+#include "events.h"
+#include "scheduler.h"
+#include "clock.h"
+#include "rails.h"
+#include "monitor_avr.h"
+#include "pipeline.h"
+#include "sampler.h"
+#include "settings.h"
+#include "reporting.h"
+#include "recorder.h"
+#include "timing_store.h"
+#include "ota.h"
+#include "warm.h"
 #include <avr/interrupt.h>  
 
-void swtich_gsm(void) {
-    // ustaw PB1 jako wyjście
-    DDRB |= (1 << PB1);
+static int8_t cycle_id = -1;
+static bool cycle_running = false;
 
-    // ustaw stan wysoki
-    PORTB |= (1 << PB1);
+/* Cykl pomiarowy: czujniki i odczyt z AVR monitorującego w trakcie rejestracji modemu */
+static uint32_t cycle_task(uint16_t events){
+    (void)events;
 
-    // odczekaj 3 sekundy
-    _delay_ms(3000);
+    if(!cycle_running){
+        pipeline_start();
+        cycle_running = true;
+        return 0;
+    }
 
-    // z powrotem niski
-    PORTB &= ~(1 << PB1);
+    if(pipeline_step() != PIPE_DONE) return pipeline_idle_ms();
+
+    cycle_running = false;
+    /* alarm, którego ten cykl już nie odczytał — od razu kolejny cykl */
+    if(monitor_alert_pending()) return 0;
+    /* słaby zasięg: ponowienie z wykładniczym odstępem */
+    if(pipeline_retry_ms()) return pipeline_retry_ms();
+    /* następny cykl budzi report_task albo alert_task */
+    return SCHED_WAIT_EVENT;
+}
+
+/* Co check_period_min: wysyłka tylko gdy kanał wyszedł poza martwą strefę lub za długa cisza */
+static uint32_t report_task(uint16_t events){
+    (void)events;
+    uint32_t period = settings.check_period_min * 60000UL;
+
+    /* po odroczeniu ponowienie planuje sam cykl */
+    if(!cycle_running && !pipeline_retry_ms() && reporting_due()){
+        sched_wake(cycle_id, 0);
+    }
+    return period;
+}
+
+/* Próbka czujników co sample_period_s do agregatów przedziału */
+static uint32_t sample_task(uint16_t events){
+    static uint32_t t_sample;
+    (void)events;
+
+    if(sampler_busy()){
+        while(sampler_poll()) { }
+        if(sampler_busy()) return sampler_wait_ms();
+
+        uint32_t period = settings.sample_period_s * 1000UL;
+        uint32_t took = systick_ms() - t_sample;
+        return (took < period) ? period - took : 0;
+    }
+
+    /* cykl wysyłki bierze własną, ostatnią próbkę */
+    if(cycle_running) return settings.sample_period_s * 1000UL;
+
+    t_sample = systick_ms();
+    sampler_start();
+    return sampler_wait_ms();
+}
+
+/* Alarm z AVR monitorującego (INT1): nie czekaj na kolejny cykl */
+static uint32_t alert_task(uint16_t events){
+    if((events & SCHED_EVENT(EVENT_MONITOR_ALERT)) && !cycle_running){
+        sched_wake(cycle_id, 0);
+    }
+    return SCHED_WAIT_EVENT;
 }
 
 int main(void){
+    /* po resecie innym niż włączenie zasilania stan z .noinit, bez zimnego startu */
+    bool warm = warm_check();
+
     UART_init_ISR(MYUBRR);
+    I2C_init();
+    systick_init();
+    clock_init(BAUD, CLOCK_SLOW_DIV);
+    sched_init();
+    /* przed rails_init: sprawdzenie modemu (gsm_ping) czeka na odpowiedź z przerwania RX */
     sei();
-    
-    /* (1) start i echo */
-    swtich_gsm();
-    gsm_wait_ready(60000);
-    gsm_disable_echo(1000);
-
-    /* (2) HTTP POST */
-    // const char* url  = "https://7fc9cee303d2.ngrok-free.app/ingest";
-    // const char* ctyp = "application/json";
-    // const char* body = "{\"hello\":\"świat\"}";
-    // gsm_http_post(url, ctyp, body, strlen(body), /*HTTPDATA timeout s*/5, /*ACTION timeout ms*/120000);
-
-    /* (3) SMS z polskimi znakami */
-    gsm_sms_send_ucs2("48668440128", "Test (źćń)", /*retries*/3, /*overall ms*/120000);
-
-    swtich_gsm();
+    /* ciepły start: modem wyłączony bez sprawdzania go komendami AT, włączony wyłączy cykl poniżej */
+    rails_init(warm ? (1 << RAIL_GSM) : 0);
+    monitor_alert_init();
+    sampler_reset_metrics();
+    recorder_reset();
+    settings_load();
+    timing_store_load();
+    reporting_init();
+    ota_init();
+
+    /* pierwszy cykl od razu po starcie, potem tylko na żądanie */
+    cycle_id = sched_add(cycle_task, 0, 0);
+    sched_add(sample_task, 0, settings.sample_period_s * 1000UL);
+    sched_add(report_task, 0, settings.check_period_min * 60000UL);
+    sched_add(alert_task, SCHED_EVENT(EVENT_MONITOR_ALERT), SCHED_WAIT_EVENT);
+
+    /* terminy zadań, agregaty i odniesienie martwej strefy sprzed resetu */
+    if(warm){
+        warm_resume();
+        /* reset przerwał cykl z włączonym modemem: powtórz go od razu, jego koniec wyłącza modem */
+        if(warm_modem_on()) sched_wake(cycle_id, 0);
+    }
+    sched_on_pass(warm_save);
+
+    sched_run();
 }
@@ -0,0 +1,124 @@
+/**
+ * @file ota.c
+ * @brief Offer matching, patch download between AT+HTTPREADs, staging check and switch marker.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include <avr/wdt.h>
+#include "config.h"
+#include "ota.h"
+#include "crc32.h"
+#include "gsm_module.h"
+#include "stream_writer.h"
+#include "bootloader/boot_api.h"
+#include "warm.h"
+
+_Static_assert(OTA_REGION_SZ == BOOT_REGION_SZ, "ota_patch.h and boot_api.h disagree on the region");
+_Static_assert(OTA_PAGE_SZ == SPM_PAGESIZE, "ota_patch.h page is not the flash page");
+
+static const uint8_t key[16] = OTA_KEY;
+static uint32_t running_crc;
+
+/* "ota":<digits> matcher over the reply */
+static const char OFFER_KEY[] = "\"ota\":";
+static uint8_t matched;         // characters of OFFER_KEY, then in the number
+static uint32_t num;
+static uint32_t offer;          // 0 = nothing offered
+
+static uint32_t region_crc(uint16_t base) {
+    uint32_t crc = CRC32_INIT;
+
+    for (uint16_t i = 0; i < OTA_REGION_SZ; i++) {
+        crc = crc32_update(crc, pgm_read_byte(base + i));
+    }
+    return crc32_final(crc);
+}
+
+void ota_init(void) {
+    running_crc = region_crc(BOOT_ACTIVE);
+}
+
+uint32_t ota_firmware_crc(void) {
+    return running_crc;
+}
+
+void ota_offer_reset(void) {
+    matched = 0;
+    num = 0;
+    offer = 0;
+}
+
+void ota_offer_feed(const char *chunk, uint16_t len) {
+    const uint8_t in_number = sizeof(OFFER_KEY) - 1;
+
+    for (uint16_t i = 0; i < len; i++) {
+        char c = chunk[i];
+
+        if (matched == in_number) {
+            if (c >= '0' && c <= '9') {
+                num = num * 10 + (uint8_t)(c - '0');
+                continue;
+            }
+            offer = num;
+            matched = 0;
+            num = 0;
+        }
+        if (c == OFFER_KEY[matched]) matched++;
+        else matched = (c == OFFER_KEY[0]) ? 1 : 0;
+    }
+}
+
+bool ota_offered(void) {
+    return offer && offer != running_crc;
+}
+
+static uint8_t read_active(uint16_t offset) {
+    return pgm_read_byte(BOOT_ACTIVE + offset);
+}
+
+static bool write_staging(uint16_t offset, const uint8_t *page) {
+    return boot_page_write_api(BOOT_STAGING + offset, page);
+}
+
+ota_result_t ota_download(void) {
+    char url[sizeof(OTA_URL) + 16];
+    uint8_t piece[GSM_HTTP_READ_CHUNK];
+    ota_patch_t patch;          // ~200 B, only for the download
+    uint32_t len;
+    sw_t w;
+
+    sw_init_buf(&w, url, sizeof(url));
+    sw_str(&w, OTA_URL "?fw=");
+    sw_u32(&w, running_crc);
+    if (!gsm_http_get(url, OTA_GET_TIMEOUT_MS, &len)) return OTA_MORE;
+
+    ota_patch_init(&patch, key, running_crc, read_active, write_staging);
+    ota_result_t r = OTA_MORE;
+    for (uint32_t off = 0; off < len && r == OTA_MORE; ) {
+        uint16_t want = (len - off < sizeof(piece)) ? (uint16_t)(len - off) : sizeof(piece);
+        int32_t n = gsm_http_read(off, piece, want);
+
+        if (n <= 0) break;
+        off += (uint32_t)n;
+        r = ota_patch_feed(&patch, piece, (uint16_t)n);   // pages written here, modem idle
+    }
+    gsm_http_term();
+
+    // What the bootloader will check, read back from flash
+    if (r == OTA_DONE && region_crc(BOOT_STAGING) != ota_patch_new_crc(&patch)) r = OTA_ERR_WRITE;
+    if (r == OTA_DONE) {
+        boot_mark_t mark = { BOOT_MARK_SWAP, ota_patch_new_crc(&patch) };
+        eeprom_update_block(&mark, BOOT_MARK_ADDR, sizeof(mark));
+    }
+    return r;
+}
+
+void ota_reboot(void) {
+    cli();
+    warm_discard();             // the new image starts cold
+    wdt_enable(WDTO_15MS);      // reset mode; clears the scheduler's WDIE
+    for (;;) { }
+}
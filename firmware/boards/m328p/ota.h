@@ -0,0 +1,72 @@
+/**
+ * @file ota.h
+ * @brief Firmware update over GSM: signed delta patch streamed into the staging region.
+ *
+ * Every report carries "fw", the CRC-32 of the running region. When the
+ * server has another build for the station, its reply names it with
+ * "ota":<crc of that build>. After a successful upload the pipeline then
+ * calls ota_download(): a GET of OTA_URL?fw=<crc>, read one AT+HTTPREAD
+ * chunk at a time into the patch decoder (ota_patch.h), which programs
+ * the staging region page by page through the bootloader
+ * (bootloader/boot_api.h). Neither the patch nor the image is held in
+ * RAM. Pages are written between reads, while the modem waits for the
+ * next request, so no UART byte is lost while SPM keeps interrupts off.
+ *
+ * The running image is never touched here. Once the staging region is
+ * complete, its tag verified and its CRC read back from flash,
+ * ota_download() records that CRC in the EEPROM marker; ota_reboot()
+ * then hands over to the bootloader, which copies it into place. A
+ * failed or cut download is simply retried at the next offer.
+ *
+ * Dependencies: gsm_module.h (GET, AT+HTTPREAD), ota_patch.h, crc32.h, boot_api.h
+ */
+
+#ifndef OTA_H
+#define OTA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ota_patch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief CRC of the running region (about 60 ms at 16 MHz), once at start-up.
+ */
+void ota_init(void);
+
+/** CRC-32 of the running region, the "fw" of the report. */
+uint32_t ota_firmware_crc(void);
+
+/**
+ * @brief Before a new reply body: forget the previous offer.
+ */
+void ota_offer_reset(void);
+
+/**
+ * @brief Look for "ota":<crc> in the next piece of the reply.
+ */
+void ota_offer_feed(const char *chunk, uint16_t len);
+
+/** true if the reply offered a build other than the running one. */
+bool ota_offered(void);
+
+/**
+ * @brief Download and verify the offered patch into the staging region (modem attached).
+ * @return OTA_DONE when the bootloader will switch at the next reset;
+ *         OTA_MORE if the download broke off; otherwise the patch error.
+ */
+ota_result_t ota_download(void);
+
+/**
+ * @brief Reset through the watchdog into the bootloader.
+ */
+void ota_reboot(void) __attribute__((noreturn));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OTA_H */
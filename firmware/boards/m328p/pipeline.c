@@ -0,0 +1,550 @@
+/**
+ * @file pipeline.c
+ * @brief Measurement/upload cycle with sensor work overlapped with network registration.
+ *
+ * Dependencies:
+ *  - rails.h       : modem power
+ *  - sampler.h     : last sensor sample and the interval aggregates
+ *  - gsm_module.h  : gsm_probe_step() / gsm_http_post(), link speed and flow control
+ *  - uart_isr.h    : RX high-water / overflow counters of the upload, bytes per session
+ *  - monitor_avr.h : weather/solar block from the ATtiny84
+ *  - clock.h       : full speed for formatting
+ *  - reporting.h   : values sent, committed as the deadband reference on success
+ *  - recorder.h    : compressed record batch, base64 in the payload
+ *  - stream_writer.h: payload counted, then written straight into the upload
+ *  - settings.h    : config version in the payload, delta from the response applied
+ *  - timing_store.h: learned AT timeouts kept across resets
+ *  - transport.h   : HTTP or MQTT upload (UPLOAD_MQTT)
+ *  - ota.h         : running build in the payload, offered update downloaded after the upload
+ *  - systick.h     : time per sleep mode for the duty-cycle counters
+ *  - warm.h        : reset cause and warm restarts in the payload
+ */
+
+#include "config.h"
+#include "pipeline.h"
+#include "rails.h"
+#include "systick.h"
+#include "clock.h"
+#include "gsm_module.h"
+#include "uart_isr.h"
+#include "monitor_avr.h"
+#include "sampler.h"
+#include "reporting.h"
+#include "recorder.h"
+#include "settings.h"
+#include "config_delta.h"
+#include "timing_store.h"
+#include "transport.h"
+#include "ota.h"
+#include "warm.h"
+
+/* Collection jobs, done one per pipeline_step() */
+#define JOB_MONITOR  (1 << 0)
+#define JOB_PAYLOAD  (1 << 1)
+
+/* JSON keys of the aggregated metrics, in METRIC_* order */
+static const char *const metric_keys[METRIC_COUNT] = { "t", "p", "rh", "t_ds" };
+
+static pipeline_state_t state = PIPE_IDLE;
+static pipeline_stats_t stats;
+static pipeline_stats_t last_stats;
+
+static uint32_t t_start;
+static uint32_t t_next_probe;
+static uint32_t probe_spent_ms;
+static gsm_stage_t stage;
+static bool no_network;
+static uint32_t idle_ms;
+static uint8_t jobs_done;
+
+static config_delta_t delta;
+
+#if UPLOAD_MQTT
+static const transport_t *const transport = &transport_mqtt;
+#else
+static const transport_t *const transport = &transport_http;
+#endif
+
+/* Link-quality gate */
+static uint32_t backoff_ms;
+
+typedef struct {
+    int8_t   csq_min;
+    int8_t   csq_max;
+    uint16_t awake_s;
+    uint8_t  outcome;
+    uint16_t modem_s;
+    uint16_t at_cmds;
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+} session_t;
+
+static session_t sessions[PIPELINE_SESSION_LOG];
+static uint8_t n_sessions;
+
+static monitor_block_t mon;
+static bool mon_ok;
+
+/* Duty-cycle counters since reset: the report carries the difference
+   between the snapshot taken with the payload and the last uploaded one */
+typedef struct {
+    uint32_t state_ms[SYSTICK_STATES];
+    uint32_t modem_ms;
+    uint32_t acq_ms[SENSOR_COUNT];
+} duty_t;
+
+static duty_t duty_now;
+static duty_t duty_sent;
+
+/* Session counters at modem power-up */
+static uint32_t at0, tx0, rx0, modem0;
+
+static uint32_t link_baud;     // rate the modem is at now
+static uint16_t payload_len;
+static bool rec_inline;
+static uint32_t rec_now;
+static bool rec_sent;
+
+static uint32_t elapsed_ms(void) {
+    return systick_ms() - t_start;
+}
+
+static void duty_snapshot(duty_t *d) {
+    for (uint8_t i = 0; i < SYSTICK_STATES; i++) d->state_ms[i] = systick_state_ms(i);
+    d->modem_ms = power_on_time_ms(RAIL_GSM);
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) d->acq_ms[i] = sampler_acq_ms[i];
+}
+
+/* Since the last successful upload: [active, idle, power-down, modem on] ms
+   and the acquisition ms of each sensor */
+static void write_duty(sw_t *w) {
+    sw_key(w, "duty");
+    sw_arr_begin(w);
+    for (uint8_t i = 0; i < SYSTICK_STATES; i++) {
+        sw_item_u32(w, duty_now.state_ms[i] - duty_sent.state_ms[i]);
+    }
+    sw_item_u32(w, duty_now.modem_ms - duty_sent.modem_ms);
+    sw_arr_end(w);
+
+    sw_key(w, "acq");
+    sw_arr_begin(w);
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        sw_item_u32(w, duty_now.acq_ms[i] - duty_sent.acq_ms[i]);
+    }
+    sw_arr_end(w);
+}
+
+/* The report, written twice: counted at JOB_PAYLOAD, then streamed into
+   the modem by the transport. Everything it reads stays put in between. */
+static void write_report(sw_t *w, void *ctx) {
+    (void)ctx;
+    sw_obj_begin(w);
+    sw_kv_u32(w, "v", 1);
+    sw_kv_u32(w, "cfg", settings.config_version);
+    sw_kv_u32(w, "fw", ota_firmware_crc());
+    sw_kv_u32(w, "why", reporting_reason());
+    sw_kv_u32(w, "rst", warm_reset_cause());
+    sw_kv_u32(w, "wr", warm_restarts());
+
+    // One record per metric over the interval: [count, min, max, mean, stddev]
+    for (uint8_t i = 0; i < METRIC_COUNT; i++) {
+        agg_record_t r;
+        agg_record(&metrics[i], &r);
+        if (r.count == 0) continue;
+
+        sw_key(w, metric_keys[i]);
+        sw_arr_begin(w);
+        sw_item_u32(w, r.count);
+        sw_item_i32(w, r.min);
+        sw_item_i32(w, r.max);
+        sw_item_i32(w, r.mean);
+        sw_item_u32(w, r.stddev);
+        sw_arr_end(w);
+    }
+
+    if (mon_ok) {
+        sw_kv_u32(w, "rain", mon.rain_count);
+        sw_kv_u32(w, "wind", mon.wind_count);
+        sw_kv_u32(w, "gust", mon.wind_gust);
+        sw_kv_u32(w, "mean", mon.wind_mean);
+        sw_kv_u32(w, "dir", mon.avg_wind_dir);
+        sw_kv_u32(w, "rate", mon.rain_rate);
+        sw_kv_u32(w, "e_uwh", mon.energy_generated);
+        sw_kv_u32(w, "pk_mw", mon.peak_power);
+        sw_kv_u32(w, "vmin", mon.min_voltage);
+        sw_kv_u32(w, "vmax", mon.max_voltage);
+        sw_kv_u32(w, "ev", mon.event_reason);
+        sw_kv_u32(w, "m_act", mon.active_ticks);
+        sw_kv_u32(w, "m_slp", mon.sleep_ticks);
+        sw_kv_u32(w, "m_adc", mon.adc_sleep_ticks);
+    }
+
+    // Timings of the previous cycle (this one is still running)
+    sw_kv_u32(w, "awake_ms", last_stats.awake_ms);
+    sw_kv_u32(w, "net_ms", last_stats.network_ready_ms);
+    sw_kv_u32(w, "up", last_stats.uploaded);
+    sw_kv_u32(w, "fast_ms", last_stats.full_speed_ms);
+    sw_kv_u32(w, "cpu_uas", last_stats.cpu_uas);
+    sw_kv_u32(w, "cpu_uas_16m", last_stats.cpu_uas_fixed);
+    write_duty(w);
+
+    if (last_stats.baud) {
+        sw_key(w, "uart");
+        sw_arr_begin(w);
+        sw_item_u32(w, last_stats.baud);
+        sw_item_u32(w, last_stats.rx_high);
+        sw_item_u32(w, last_stats.rx_ovf);
+        sw_arr_end(w);
+    }
+
+    // Update attempted last cycle that did not end in a switch (ota_result_t)
+    if (last_stats.ota_tried) sw_kv_u32(w, "ota", last_stats.ota);
+
+    // Sessions since the last upload: [csq_min, csq_max, awake_s, outcome,
+    // modem_s, AT commands, bytes sent, bytes received]
+    if (n_sessions) {
+        sw_key(w, "sess");
+        sw_arr_begin(w);
+        for (uint8_t i = 0; i < n_sessions; i++) {
+            sw_item(w);
+            sw_arr_begin(w);
+            sw_item_i32(w, sessions[i].csq_min);
+            sw_item_i32(w, sessions[i].csq_max);
+            sw_item_u32(w, sessions[i].awake_s);
+            sw_item_u32(w, sessions[i].outcome);
+            sw_item_u32(w, sessions[i].modem_s);
+            sw_item_u32(w, sessions[i].at_cmds);
+            sw_item_u32(w, sessions[i].tx_bytes);
+            sw_item_u32(w, sessions[i].rx_bytes);
+            sw_arr_end(w);
+        }
+        sw_arr_end(w);
+    }
+
+    // Records since the last upload (timestamps in seconds since start-up,
+    // "now" maps them to wall time)
+    if (rec_inline) {
+        uint16_t rec_n, rec_len;
+        const uint8_t *rec = recorder_batch(&rec_n, &rec_len);
+
+        sw_key(w, "rec");
+        sw_obj_begin(w);
+        sw_kv_u32(w, "n", rec_n);
+        sw_kv_u32(w, "ch", METRIC_COUNT);
+        sw_kv_u32(w, "now", rec_now);
+        sw_key(w, "b64");
+        sw_char(w, '"');
+        sw_base64(w, rec, rec_len);
+        sw_char(w, '"');
+        sw_obj_end(w);
+    }
+    sw_obj_end(w);
+}
+
+/* Length of the report; records only whole (a cut batch cannot be decoded)
+   and only if the report stays within PIPELINE_PAYLOAD_SZ */
+static void measure_report(void) {
+    uint16_t rec_n, rec_len;
+
+    (void)recorder_batch(&rec_n, &rec_len);
+    rec_now = recorder_uptime_s();
+    rec_inline = rec_n && !transport->records_apart;
+    payload_len = sw_measure(write_report, NULL);
+    if (rec_inline && payload_len > PIPELINE_PAYLOAD_SZ) {
+        rec_inline = false;   // kept for the next upload
+        payload_len = sw_measure(write_report, NULL);
+    }
+    rec_sent = rec_inline;
+}
+
+/* Response body straight from AT+HTTPREAD into the delta parser and the
+   update offer */
+static void on_response(const char *chunk, uint16_t len, void *ctx) {
+    config_delta_feed((config_delta_t *)ctx, chunk, len);
+    ota_offer_feed(chunk, len);
+}
+
+static void link_set(uint32_t baud) {
+    if (baud && baud != link_baud && gsm_set_baud(link_baud, baud)) link_baud = baud;
+}
+
+/* While registration is pending: a rate that stays clean at the slow
+   divider, so the UART no longer holds the clock at full speed */
+static void link_wait(void) {
+    uint32_t slow = gsm_best_baud(F_CPU >> CLOCK_SLOW_DIV, CLOCK_UART_MAX_ERR_PERMIL);
+
+    if (slow < BAUD) link_set(slow);
+}
+
+/* Upload at the fastest clean rate; counters cover just the transfer */
+static void link_fast(void) {
+    uint32_t best = gsm_best_baud(F_CPU, CLOCK_UART_MAX_ERR_PERMIL);
+
+    link_set(best > BAUD ? best : BAUD);
+    stats.baud = link_baud;
+#if GSM_FLOW_CONTROL
+    (void)gsm_set_flow_control(true);
+#endif
+    UART_clear_counters();
+}
+
+static void link_restore(void) {
+    stats.rx_high = uart_rx.ring.high_water;
+    stats.rx_ovf = UART_rx_dropped();
+#if GSM_FLOW_CONTROL
+    (void)gsm_set_flow_control(false);
+#endif
+}
+
+/* The batch as its own message, after the report it belongs to */
+static void send_records(void) {
+    sw_mem_body_t packet;
+
+    packet.data = recorder_packet(&packet.len);
+    if (packet.len) rec_sent = transport->send(TRANSPORT_RECORDS, sw_fill_mem, &packet, packet.len);
+}
+
+/* One collection job whose data is ready; false if nothing could be done now */
+static bool collect_one(void) {
+    if (sampler_poll()) return true;
+
+    if (!(jobs_done & JOB_MONITOR)) {
+        mon_ok = monitor_read(&mon);
+        if (mon_ok && mon.event_reason) monitor_ack_events();
+        jobs_done |= JOB_MONITOR;
+        return true;
+    }
+
+    if (!sampler_busy() && !(jobs_done & JOB_PAYLOAD)) {
+        reporting_snapshot(mon_ok ? &mon : NULL);
+        duty_snapshot(&duty_now);
+        clock_boost();
+        measure_report();
+        clock_unboost();
+        stats.payload_ready_ms = elapsed_ms();
+        jobs_done |= JOB_PAYLOAD;
+        return true;
+    }
+
+    return false;
+}
+
+static void sample_signal(void) {
+    int8_t csq = gsm_csq(&probe_spent_ms);
+
+    stats.csq_last = csq;
+    if (csq < 0) return;
+    if (stats.csq_min < 0 || csq < stats.csq_min) stats.csq_min = csq;
+    if (csq > stats.csq_max) stats.csq_max = csq;
+}
+
+/* One network probe if it is due; false if nothing was done */
+static bool probe_network(void) {
+    if (stage >= GSM_STAGE_ATTACHED || no_network) return false;
+    if ((int32_t)(systick_ms() - t_next_probe) < 0) return false;
+
+    gsm_stage_t was = stage;
+    if (!gsm_probe_step(&stage, &probe_spent_ms)) {
+        no_network = true;   // no SIM, waiting will not help
+        return true;
+    }
+
+    // First answer at BAUD: wait for the network on the slow link
+    if (was == GSM_STAGE_OFF && stage > GSM_STAGE_OFF) link_wait();
+
+    // Signal is meaningful once registered; the last sample is from the attached modem
+    if (stage >= GSM_STAGE_REGISTERED) sample_signal();
+
+    if (stage == GSM_STAGE_ATTACHED) {
+        stats.network_ready_ms = elapsed_ms();
+    } else {
+        t_next_probe = systick_ms() + PIPELINE_PROBE_MS;
+    }
+    return true;
+}
+
+/* Alerts and a nearly full record batch cannot wait for a better signal */
+static bool upload_urgent(void) {
+    return (mon_ok && mon.event_reason) || (reporting_reason() & REPORT_WHY_RECORDS);
+}
+
+/* Unknown signal does not block: better one upload at high power than none */
+static bool signal_ok(void) {
+    return stats.csq_last < 0 || stats.csq_last >= UPLOAD_CSQ_MIN;
+}
+
+static void defer_upload(void) {
+    uint32_t cap = recorder_time_left_s() * 1000UL;
+
+    backoff_ms = backoff_ms ? backoff_ms * 2 : UPLOAD_BACKOFF_MIN_MS;
+    if (backoff_ms > UPLOAD_BACKOFF_MAX_MS) backoff_ms = UPLOAD_BACKOFF_MAX_MS;
+    // retry before the batch overflows; by then it is urgent anyway
+    if (backoff_ms > cap) backoff_ms = cap;
+
+    stats.outcome = PIPE_OUT_DEFERRED;
+}
+
+static void log_session(void) {
+    if (n_sessions == PIPELINE_SESSION_LOG) {
+        for (uint8_t i = 1; i < PIPELINE_SESSION_LOG; i++) sessions[i - 1] = sessions[i];
+        n_sessions--;
+    }
+    session_t *s = &sessions[n_sessions++];
+    s->csq_min = stats.csq_min;
+    s->csq_max = stats.csq_max;
+    s->awake_s = (uint16_t)(stats.awake_ms / 1000UL);
+    s->outcome = stats.outcome;
+    s->modem_s = (uint16_t)(stats.modem_ms / 1000UL);
+    s->at_cmds = (stats.at_cmds > 0xFFFF) ? 0xFFFF : (uint16_t)stats.at_cmds;
+    s->tx_bytes = stats.tx_bytes;
+    s->rx_bytes = stats.rx_bytes;
+}
+
+static uint32_t probe_wait_ms(void) {
+    if (stage >= GSM_STAGE_ATTACHED || no_network) return PIPELINE_NETWORK_TIMEOUT_MS;
+    int32_t left = (int32_t)(t_next_probe - systick_ms());
+    return (left > 0) ? (uint32_t)left : 0;
+}
+
+/* Time until a pending read or probe becomes due */
+static uint32_t collect_wait_ms(void) {
+    uint32_t wait = probe_wait_ms();
+
+    if (sampler_busy() && sampler_wait_ms() < wait) {
+        wait = sampler_wait_ms();
+    }
+    return wait;
+}
+
+void pipeline_start(void) {
+    t_start = systick_ms();
+    stats = (pipeline_stats_t){ .csq_min = -1, .csq_max = -1, .csq_last = -1,
+                                .outcome = PIPE_OUT_NO_NETWORK };
+    stage = GSM_STAGE_OFF;
+    no_network = false;
+    jobs_done = 0;
+    mon_ok = false;
+    probe_spent_ms = 0;
+    idle_ms = 0;
+    link_baud = BAUD;
+    clock_clear_residency();
+    state = PIPE_SENSORS_START;
+}
+
+pipeline_state_t pipeline_step(void) {
+    switch (state) {
+    case PIPE_SENSORS_START:
+        // Last sample of the interval; DS18B20 converts during the PWRKEY pulse
+        sampler_start();
+        state = PIPE_MODEM_ON;
+        break;
+
+    case PIPE_MODEM_ON:
+        at0 = gsm_at_count();
+        tx0 = UART_tx_total();
+        rx0 = UART_rx_total();
+        modem0 = power_on_time_ms(RAIL_GSM);
+        power_acquire(RAIL_GSM);
+        t_next_probe = systick_ms();
+        state = PIPE_COLLECT;
+        break;
+
+    case PIPE_COLLECT:
+        idle_ms = 0;
+        if (collect_one() || probe_network()) break;
+
+        if (!(jobs_done & JOB_PAYLOAD)) {
+            idle_ms = collect_wait_ms();
+            break;
+        }
+        if (stage == GSM_STAGE_ATTACHED) {
+            if (signal_ok() || upload_urgent()) {
+                state = PIPE_UPLOAD;
+            } else {
+                defer_upload();
+                state = PIPE_DONE;
+            }
+        } else if (no_network || elapsed_ms() >= PIPELINE_NETWORK_TIMEOUT_MS) {
+            state = PIPE_DONE;
+        } else {
+            idle_ms = probe_wait_ms();
+        }
+        break;
+
+    case PIPE_UPLOAD:
+        gsm_disable_echo(1000);
+        link_fast();
+        config_delta_init(&delta);
+        ota_offer_reset();
+        if (transport->open(on_response, &delta)) {
+            stats.uploaded = transport->send(TRANSPORT_REPORT, write_report, NULL, payload_len);
+            if (stats.uploaded && transport->records_apart) send_records();
+            transport->close();
+        }
+#if OTA_ENABLE
+        // Still at the fast rate; the switch itself waits for PIPE_DONE
+        if (stats.uploaded && ota_offered()) {
+            stats.ota_tried = true;
+            stats.ota = ota_download();
+        }
+#endif
+        link_restore();
+        stats.upload_done_ms = elapsed_ms();
+        timing_store_session_done();
+        stats.outcome = stats.uploaded ? PIPE_OUT_UPLOADED : PIPE_OUT_FAILED;
+        backoff_ms = 0;
+        if (stats.uploaded) {
+            // New interval only now: a failed or deferred upload keeps the counts
+            if (mon_ok) monitor_reset();
+            n_sessions = 0;
+            sampler_reset_metrics();   // otherwise keep aggregating
+            if (rec_sent) recorder_reset();
+            reporting_commit();
+            duty_sent = duty_now;
+            stats.config_applied = settings_apply_delta(&delta);
+        }
+        state = PIPE_DONE;
+        break;
+
+    case PIPE_DONE:
+    case PIPE_IDLE:
+    default:
+        return state;
+    }
+
+    if (state == PIPE_DONE) {
+        // Back to BAUD: some modems keep AT+IPR across power cycles
+        link_set(BAUD);
+        power_release(RAIL_GSM);
+        stats.modem_ms = power_on_time_ms(RAIL_GSM) - modem0;
+        stats.at_cmds = gsm_at_count() - at0;
+        stats.tx_bytes = UART_tx_total() - tx0;
+        stats.rx_bytes = UART_rx_total() - rx0;
+        stats.awake_ms = elapsed_ms();
+        stats.full_speed_ms = clock_residency_ms(0);
+        stats.cpu_uas = clock_charge_uas();
+        stats.cpu_uas_fixed = stats.awake_ms / 1000UL * (F_CPU / 1000000UL) * CLOCK_UA_PER_MHZ
+                            + stats.awake_ms % 1000UL * (F_CPU / 1000000UL) * CLOCK_UA_PER_MHZ / 1000UL;
+        last_stats = stats;
+        log_session();
+        if (stats.ota == OTA_DONE) ota_reboot();   // bootloader copies the new image
+    }
+    return state;
+}
+
+void pipeline_run(void) {
+    pipeline_start();
+    while (pipeline_step() != PIPE_DONE) { }
+}
+
+uint32_t pipeline_idle_ms(void) {
+    return (state == PIPE_COLLECT) ? idle_ms : 0;
+}
+
+uint32_t pipeline_retry_ms(void) {
+    return (last_stats.outcome == PIPE_OUT_DEFERRED) ? backoff_ms : 0;
+}
+
+const pipeline_stats_t *pipeline_last_stats(void) {
+    return &last_stats;
+}
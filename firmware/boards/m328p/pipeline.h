@@ -0,0 +1,149 @@
+/**
+ * @file pipeline.h
+ * @brief One measurement/upload cycle of the main AVR as a state machine.
+ *
+ * The modem needs 10-30 s to register, so the cycle does not run
+ * serially. It starts a last sensor sample (sampler.h), then switches
+ * the modem on. While the network comes up (probed about once a second),
+ * it finishes the sample, reads the monitoring AVR and sizes the
+ * payload (a counting pass, stream_writer.h). Upload starts as soon as
+ * the bearer is attached; the payload is only then written, straight
+ * into the modem's UART, and is never held in RAM.
+ *
+ * The payload carries one [count, min, max, mean, stddev] record per
+ * metric for the whole interval; the aggregates are cleared only after a
+ * successful upload, which also makes the sent values the new deadband
+ * reference (reporting.h). "why" carries the trigger mask of the upload.
+ * The response body is read in the same session and a config delta in it
+ * is applied to the EEPROM settings; "cfg" reports their version.
+ *
+ * Once registered, every probe also samples AT+CSQ. With the bearer up
+ * but the signal below UPLOAD_CSQ_MIN, a non-urgent upload is deferred
+ * (the modem would transmit at full power and retry): the cycle ends and
+ * pipeline_retry_ms() gives an exponential backoff, capped by the time
+ * left before the record batch fills up. Monitor alerts and a nearly full
+ * batch upload regardless. Each session's signal, duration and outcome,
+ * with its modem-on time, AT command count and UART bytes each way, goes
+ * into the next payload ("sess") for tuning.
+ *
+ * For battery and panel sizing the payload also carries duty-cycle
+ * counters over the time since the last successful upload: "duty" is
+ * [active, idle, power-down, modem on] in ms (systick.h, power.h) and
+ * "acq" the acquisition ms of each sensor (sampler.h). The monitoring AVR
+ * adds its own active, idle and ADC noise reduction time ("m_act",
+ * "m_slp", "m_adc", its Timer1 ticks of 1024 CPU clocks). "rst" is the
+ * MCUSR cause of the last reset and "wr" the warm restarts since the
+ * last cold boot (warm.h).
+ *
+ * The upload goes through transport.h: one HTTP POST, or with
+ * UPLOAD_MQTT a single MQTT connection that publishes the report and then
+ * the record batch as a separate binary message (QoS 1 each, the batch is
+ * kept until its own PUBACK).
+ *
+ * The reply may also offer another firmware build ("ota", against the
+ * running one in "fw"); it is downloaded into the staging region right
+ * after the upload and switched to by a reset at the end of the cycle
+ * (ota.h). A failed attempt reports its result in the next "ota".
+ *
+ * Once the modem answers, the link drops to the fastest rate that stays
+ * clean at F_CPU >> CLOCK_SLOW_DIV (9600 at 1 MHz), so the CPU can run
+ * slow while registration is pending (clock.h). The upload itself runs at
+ * the highest baud rate the modem and F_CPU agree on (gsm_best_baud()),
+ * with RTS/CTS flow control, and the link is put back to BAUD before the
+ * modem is switched off. "uart" reports the rate, the RX high-water mark
+ * and dropped bytes of the previous upload.
+ *
+ * pipeline_step() does one short piece of work and returns, so the cycle
+ * can be driven from a scheduler task (pipeline_idle_ms() tells how long
+ * it can sleep); pipeline_run() just loops it.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    PIPE_IDLE = 0,
+    PIPE_SENSORS_START,     /**< Last sample of the interval started */
+    PIPE_MODEM_ON,          /**< PWRKEY pulse (blocking) */
+    PIPE_COLLECT,           /**< Sensor/monitor reads interleaved with network probes */
+    PIPE_UPLOAD,            /**< HTTP POST of the prepared payload */
+    PIPE_DONE               /**< Rails released, timings final */
+} pipeline_state_t;
+
+/** How a cycle ended (session log). */
+typedef enum {
+    PIPE_OUT_UPLOADED = 0,
+    PIPE_OUT_DEFERRED,      /**< Weak signal, retry after pipeline_retry_ms() */
+    PIPE_OUT_FAILED,        /**< HTTP POST failed */
+    PIPE_OUT_NO_NETWORK     /**< Not attached within PIPELINE_NETWORK_TIMEOUT_MS */
+} pipeline_outcome_t;
+
+/** Cycle timings (ms from the start of the cycle). */
+typedef struct {
+    uint32_t payload_ready_ms;   /**< All data read and payload length counted */
+    uint32_t network_ready_ms;   /**< Bearer attached (0 = never) */
+    uint32_t upload_done_ms;     /**< HTTP POST finished */
+    uint32_t awake_ms;           /**< Whole cycle */
+    uint32_t full_speed_ms;      /**< Part of it at F_CPU (clock.h) */
+    uint32_t cpu_uas;            /**< Estimated CPU charge with clock scaling, µA·s */
+    uint32_t cpu_uas_fixed;      /**< Same cycle estimated at a fixed F_CPU */
+    bool     uploaded;           /**< HTTP status 2xx/3xx */
+    bool     config_applied;     /**< Response carried a new config delta (settings.h) */
+    uint8_t  outcome;            /**< pipeline_outcome_t */
+    int8_t   csq_min;            /**< AT+CSQ over the session (-1 = none) */
+    int8_t   csq_max;
+    int8_t   csq_last;           /**< Sample the upload decision was made on */
+    uint32_t baud;               /**< Modem link rate during the upload (0 = no upload) */
+    uint8_t  rx_high;            /**< RX buffer high-water mark during the upload */
+    uint16_t rx_ovf;             /**< Bytes dropped on a full RX buffer during the upload */
+    bool     ota_tried;          /**< Reply offered another build, download attempted (ota.h) */
+    uint8_t  ota;                /**< Its ota_result_t; OTA_DONE resets into the bootloader */
+    uint32_t modem_ms;           /**< Modem rail on during the cycle */
+    uint32_t at_cmds;            /**< AT commands sent (round trips) */
+    uint32_t tx_bytes;           /**< UART bytes to the modem */
+    uint32_t rx_bytes;           /**< UART bytes from the modem */
+} pipeline_stats_t;
+
+/**
+ * @brief Start a new cycle. The previous cycle's stats go into this payload.
+ */
+void pipeline_start(void);
+
+/**
+ * @brief Do the next piece of work of the current cycle.
+ * @return State after the step (PIPE_DONE once the cycle is over).
+ */
+pipeline_state_t pipeline_step(void);
+
+/**
+ * @brief After a step that did nothing: ms until there is work again.
+ */
+uint32_t pipeline_idle_ms(void);
+
+/**
+ * @brief Run a whole cycle (pipeline_start + pipeline_step until done).
+ */
+void pipeline_run(void);
+
+/**
+ * @brief After a deferred cycle: ms until the retry, 0 otherwise.
+ */
+uint32_t pipeline_retry_ms(void);
+
+/**
+ * @brief Timings of the last finished cycle.
+ */
+const pipeline_stats_t *pipeline_last_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PIPELINE_H */
@@ -0,0 +1,59 @@
+/**
+ * @file rails.c
+ * @brief Rail table for the main AVR board.
+ */
+
+#include <avr/io.h>
+#include "config.h"
+#include "rails.h"
+#include "gsm_module.h"
+#include "scheduler.h"
+#include "clock.h"
+
+static bool gsm_on(void) {
+    // Modem talks over UART at any time: no power-down while it is on
+    sched_hold_clock();
+    clock_uart_active(true);
+    return gsm_power_on();
+}
+
+static void gsm_off(void) {
+    // The power-off attempt itself talks to the modem
+    clock_uart_active(true);
+    gsm_power_off();
+    clock_uart_active(false);
+    sched_release_clock();
+}
+
+static bool sensors_on(void) {
+    SENSOR_RAIL_PORT |= (1 << SENSOR_RAIL_PIN);
+    return true;
+}
+
+static void sensors_off(void) {
+    SENSOR_RAIL_PORT &= ~(1 << SENSOR_RAIL_PIN);
+}
+
+static bool onewire_on(void) {
+    ONE_WIRE_PULLUP_PORT |= (1 << ONE_WIRE_PULLUP_PIN);
+    return true;
+}
+
+static void onewire_off(void) {
+    ONE_WIRE_PULLUP_PORT &= ~(1 << ONE_WIRE_PULLUP_PIN);
+}
+
+static const power_rail_desc_t rails[RAIL_COUNT] = {
+    // Modem readiness is probed separately, the rail is usable right away
+    [RAIL_GSM]     = { gsm_on,       gsm_off,       0,  POWER_NO_PARENT },
+    // BME280 start-up time is 2 ms, DS18B20 needs the bus idle high
+    [RAIL_SENSORS] = { sensors_on,   sensors_off,   10, POWER_NO_PARENT },
+    [RAIL_ONEWIRE] = { onewire_on,   onewire_off,   1,  RAIL_SENSORS },
+};
+
+void rails_init(uint8_t known_off) {
+    SENSOR_RAIL_DDR |= (1 << SENSOR_RAIL_PIN);
+    ONE_WIRE_PULLUP_DDR |= (1 << ONE_WIRE_PULLUP_PIN);
+
+    power_init(rails, RAIL_COUNT, known_off);
+}
@@ -0,0 +1,30 @@
+/**
+ * @file rails.h
+ * @brief Power rails of the main AVR board (see power.h).
+ *
+ *  - RAIL_GSM      : A7670E modem, switched with PWRKEY after a state probe
+ *  - RAIL_SENSORS  : MOSFET feeding BME280 / DS18B20
+ *  - RAIL_ONEWIRE  : 1-Wire pull-up resistor supply (needs RAIL_SENSORS)
+ */
+
+#ifndef RAILS_H
+#define RAILS_H
+
+#include "power.h"
+
+enum {
+    RAIL_GSM,
+    RAIL_SENSORS,
+    RAIL_ONEWIRE,
+    RAIL_COUNT
+};
+
+/**
+ * @brief Configure rail pins and register the rail table with power_init().
+ * @param known_off (1 << RAIL_*) mask of rails not to switch off here, e.g.
+ *                  the modem after a warm restart (skips its AT probe; one
+ *                  saved as on is switched off by the cycle that follows).
+ */
+void rails_init(uint8_t known_off);
+
+#endif /* RAILS_H */
@@ -0,0 +1,89 @@
+/**
+ * @file recorder.c
+ * @brief Record batch of the main AVR and its seconds clock.
+ *
+ * Dependencies:
+ *  - tscodec.h : bit-packed encoder
+ *  - sampler.h : latest sample of each metric
+ *  - systick.h : millisecond clock (wraps after 49 days, seconds do not)
+ */
+
+#include "config.h"
+#include "recorder.h"
+#include "tscodec.h"
+#include "sampler.h"
+#include "systick.h"
+
+// Header room in front, so recorder_packet() needs no copy
+static uint8_t packet[RECORD_HDR_SZ + RECORD_BUF_SZ];
+static uint8_t *const batch = packet + RECORD_HDR_SZ;
+static tsc_encoder_t enc;
+
+static uint32_t uptime_s;
+static uint32_t uptime_ms_ref;
+static uint32_t last_record_s;
+static bool has_record;
+
+uint32_t recorder_uptime_s(void) {
+    uint32_t now = systick_ms();
+    uint32_t whole = (now - uptime_ms_ref) / 1000UL;
+
+    uptime_s += whole;
+    uptime_ms_ref += whole * 1000UL;   // keep the remainder for the next call
+    return uptime_s;
+}
+
+void recorder_resume(uint32_t s) {
+    uptime_s = s;
+    uptime_ms_ref = systick_ms();
+}
+
+void recorder_reset(void) {
+    tsc_init(&enc, batch, RECORD_BUF_SZ, METRIC_COUNT);
+}
+
+void recorder_sample(void) {
+    uint32_t now = recorder_uptime_s();
+
+    // Records sit on a fixed grid (the sample is the latest one, at most a
+    // sample period late); regular timestamps cost one bit each
+    if (!has_record) {
+        last_record_s = now;
+        has_record = true;
+    } else {
+        if (now - last_record_s < RECORD_PERIOD_S) return;
+        last_record_s += RECORD_PERIOD_S;
+        if (now - last_record_s >= RECORD_PERIOD_S) last_record_s = now;   // slots missed
+    }
+
+    tsc_append(&enc, last_record_s, sampler_last);
+}
+
+uint8_t recorder_fill_pct(void) {
+    return (uint8_t)(tsc_bytes(&enc) * 100UL / RECORD_BUF_SZ);
+}
+
+uint32_t recorder_time_left_s(void) {
+    uint16_t used = tsc_bytes(&enc);
+    uint16_t per_record = enc.count ? (used + enc.count - 1) / enc.count : 8;   // first records are the largest
+
+    return (uint32_t)(RECORD_BUF_SZ - used) / per_record * RECORD_PERIOD_S;
+}
+
+const uint8_t *recorder_batch(uint16_t *count, uint16_t *len) {
+    *count = enc.count;
+    *len = tsc_bytes(&enc);
+    return batch;
+}
+
+const uint8_t *recorder_packet(uint16_t *len) {
+    uint32_t now = recorder_uptime_s();
+
+    packet[0] = (uint8_t)enc.count;
+    packet[1] = (uint8_t)(enc.count >> 8);
+    packet[2] = METRIC_COUNT;
+    for (uint8_t i = 0; i < 4; i++) packet[3 + i] = (uint8_t)(now >> (8 * i));
+
+    *len = enc.count ? RECORD_HDR_SZ + tsc_bytes(&enc) : 0;
+    return packet;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file recorder.h
+ * @brief Compressed batch of sensor records between uploads (tscodec.h).
+ *
+ * Every RECORD_PERIOD_S the latest sample of each metric is appended
+ * with a timestamp in seconds since start-up. The batch goes into the
+ * payload as base64, or as its own binary message (recorder_packet())
+ * where the transport allows it, and is started anew only after a
+ * successful upload;
+ * once it is full further records are dropped, and reporting.h asks for
+ * an upload well before that.
+ */
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Header of recorder_packet(): count (u16 LE), channels (u8), now (u32 LE). */
+#define RECORD_HDR_SZ 7
+
+/**
+ * @brief Start an empty batch.
+ */
+void recorder_reset(void);
+
+/**
+ * @brief Append the latest sample if RECORD_PERIOD_S has passed since the last record.
+ */
+void recorder_sample(void);
+
+/**
+ * @brief Seconds since start-up (clock of the record timestamps).
+ */
+uint32_t recorder_uptime_s(void);
+
+/**
+ * @brief Continue the seconds clock from a saved value (warm restart,
+ *        warm.h), so timestamps stay monotonic across the reset.
+ */
+void recorder_resume(uint32_t uptime_s);
+
+/**
+ * @brief Batch bytes used, in percent of RECORD_BUF_SZ.
+ */
+uint8_t recorder_fill_pct(void);
+
+/**
+ * @brief Estimated seconds until the batch is full, at its average bytes per record.
+ */
+uint32_t recorder_time_left_s(void);
+
+/**
+ * @brief The batch for the payload.
+ * @param count Records in it.
+ * @param len   Bytes in it.
+ */
+const uint8_t *recorder_batch(uint16_t *count, uint16_t *len);
+
+/**
+ * @brief The batch as a self-contained binary message: RECORD_HDR_SZ
+ *        header with "now" taken at this call, then the batch bytes.
+ * @param len Bytes in it (0 if there are no records).
+ */
+const uint8_t *recorder_packet(uint16_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RECORDER_H */
@@ -0,0 +1,69 @@
+/**
+ * @file reporting.c
+ * @brief Channel values of the station and the deadband state.
+ *
+ * Dependencies:
+ *  - settings.h    : deadbands and silence limit
+ *  - sampler.h     : latest sensor sample
+ *  - monitor_avr.h : wind mean and rain count since the last upload
+ *  - recorder.h    : record batch fill
+ */
+
+#include <stddef.h>
+#include "reporting.h"
+#include "deadband.h"
+#include "settings.h"
+#include "sampler.h"
+#include "systick.h"
+#include "recorder.h"
+#include "config.h"
+
+static deadband_t db;
+static int32_t snapshot[DB_CHANNELS];
+static uint8_t snapshot_reason;
+
+/* Without a monitor block the wind/rain channels keep their last sent value */
+static void collect(int32_t v[DB_CHANNELS], const monitor_block_t *mon) {
+    v[DB_AIR_TEMP]    = sampler_last[METRIC_AIR_TEMP];
+    v[DB_GROUND_TEMP] = sampler_last[METRIC_GROUND_TEMP];
+    v[DB_PRESSURE]    = sampler_last[METRIC_PRESSURE];
+    v[DB_HUMIDITY]    = sampler_last[METRIC_HUMIDITY];
+    v[DB_WIND]        = mon ? (int32_t)mon->wind_mean : db.sent[DB_WIND];
+    v[DB_RAIN]        = mon ? (int32_t)mon->rain_count : 0;
+}
+
+void reporting_init(void) {
+    deadband_reset(&db);
+}
+
+bool reporting_due(void) {
+    monitor_block_t mon;
+    int32_t v[DB_CHANNELS];
+
+    if (recorder_fill_pct() >= RECORD_FLUSH_PCT) return true;
+
+    collect(v, monitor_read(&mon) ? &mon : NULL);
+    return deadband_check(&db, &settings.deadband, v, systick_ms()) != 0;
+}
+
+void reporting_snapshot(const monitor_block_t *mon) {
+    collect(snapshot, mon);
+    snapshot_reason = deadband_check(&db, &settings.deadband, snapshot, systick_ms());
+    if (recorder_fill_pct() >= RECORD_FLUSH_PCT) snapshot_reason |= REPORT_WHY_RECORDS;
+}
+
+void reporting_commit(void) {
+    deadband_commit(&db, snapshot, systick_ms());
+}
+
+uint8_t reporting_reason(void) {
+    return snapshot_reason;
+}
+
+const deadband_t *reporting_state(void) {
+    return &db;
+}
+
+void reporting_resume(const deadband_t *d) {
+    db = *d;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file reporting.h
+ * @brief Decides when the main AVR uploads (deadband.h over the station channels).
+ *
+ * A cheap check (latest sensor sample + monitor block over I2C, no
+ * modem) runs every check_period_min; the upload cycle starts only when
+ * a channel left its deadband or the station was silent for too long.
+ * The pipeline snapshots the values it sends and commits them once the
+ * upload succeeded. A record batch (recorder.h) filled past
+ * RECORD_FLUSH_PCT also asks for an upload, before records get dropped.
+ */
+
+#ifndef REPORTING_H
+#define REPORTING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "monitor_avr.h"
+#include "deadband.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Trigger bit on top of the deadband_check() mask: record batch nearly full. */
+#define REPORT_WHY_RECORDS (1 << 7)
+
+/**
+ * @brief Forget the last upload; the first check triggers.
+ */
+void reporting_init(void);
+
+/**
+ * @brief Read the monitoring AVR and compare against the last upload.
+ * @return true if an upload is due.
+ */
+bool reporting_due(void);
+
+/**
+ * @brief Values going into the payload being built.
+ * @param mon Monitor block of this cycle, NULL if it could not be read.
+ */
+void reporting_snapshot(const monitor_block_t *mon);
+
+/**
+ * @brief The snapshot was uploaded: it becomes the new reference.
+ */
+void reporting_commit(void);
+
+/**
+ * @brief Trigger mask of the snapshot (deadband_check() bits, REPORT_WHY_RECORDS).
+ */
+uint8_t reporting_reason(void);
+
+/**
+ * @brief The reference of the last upload (warm restart, warm.h).
+ */
+const deadband_t *reporting_state(void);
+
+/**
+ * @brief Continue from a saved reference instead of reporting_init().
+ */
+void reporting_resume(const deadband_t *d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REPORTING_H */
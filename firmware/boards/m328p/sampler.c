@@ -0,0 +1,123 @@
+/**
+ * @file sampler.c
+ * @brief Sensor sample state (which conversions are still pending).
+ *
+ * Dependencies:
+ *  - rails.h   : sensor and 1-Wire pull-up rails
+ *  - clock.h   : full speed for 1-Wire timing and float compensation
+ *  - systick.h : DS18B20 conversion time, acquisition time per sensor
+ *  - recorder.h: fed once a sample is complete, whichever caller polled it
+ */
+
+#include "sampler.h"
+#include "rails.h"
+#include "clock.h"
+#include "systick.h"
+#include "bme280.h"
+#include "ds18b20.h"
+#include "recorder.h"
+
+#define PENDING_BME280  (1 << 0)
+#define PENDING_DS18B20 (1 << 1)
+
+#define DS18B20_ERROR -1000
+
+agg_t metrics[METRIC_COUNT];
+int32_t sampler_last[METRIC_COUNT];
+uint32_t sampler_acq_ms[SENSOR_COUNT];
+
+static uint8_t pending = 0;
+static uint32_t t_start;
+static uint32_t t_ds_start;
+
+static void add_sample(uint8_t metric, int32_t value) {
+    agg_add(&metrics[metric], value);
+    sampler_last[metric] = value;
+}
+
+/* Last result in: the sample task and the upload cycle both poll, the
+   record must not depend on which of them got there first */
+static void done(uint8_t which) {
+    pending &= ~which;
+    if (!pending) recorder_sample();
+}
+
+void sampler_reset_metrics(void) {
+    for (uint8_t i = 0; i < METRIC_COUNT; i++) {
+        agg_reset(&metrics[i]);
+    }
+}
+
+void sampler_start(void) {
+    if (pending) return;
+
+    t_start = systick_ms();
+
+    // 1-Wire bit timing and bme280_init() delays need the full clock
+    clock_boost();
+
+    // 1-Wire pull-up rail pulls in the sensor rail as its parent
+    power_acquire(RAIL_SENSORS);
+    power_acquire(RAIL_ONEWIRE);
+    power_wait_ready(RAIL_SENSORS);
+    power_wait_ready(RAIL_ONEWIRE);
+
+    pending = PENDING_BME280;
+
+    t_ds_start = systick_ms();
+    if (ds18b20_startConversion()) {
+        pending |= PENDING_DS18B20;
+    } else {
+        power_release(RAIL_ONEWIRE);
+        sampler_acq_ms[SENSOR_DS18B20] += systick_ms() - t_start;
+    }
+
+    // Fresh power-up: reload calibration, then one forced measurement
+    bme280_init();
+    bme280_startForced();
+
+    clock_unboost();
+}
+
+bool sampler_poll(void) {
+    if ((pending & PENDING_BME280) && !bme280_isMeasuring()) {
+        clock_boost();
+        add_sample(METRIC_AIR_TEMP, (int32_t)(bme280_readTemperature() * 100.0f));
+        add_sample(METRIC_PRESSURE, (int32_t)(bme280_readPressure() * 100.0f));
+        add_sample(METRIC_HUMIDITY, (int32_t)(bme280_readHumidity() * 100.0f));
+        clock_unboost();
+
+        power_release(RAIL_SENSORS);
+        sampler_acq_ms[SENSOR_BME280] += systick_ms() - t_start;
+        done(PENDING_BME280);
+        return true;
+    }
+
+    if ((pending & PENDING_DS18B20) && systick_ms() - t_ds_start >= DS18B20_CONVERSION_MS) {
+        clock_boost();
+        int16_t raw = ds18b20_readScratchpad();
+        clock_unboost();
+
+        if (raw != DS18B20_ERROR) {
+            add_sample(METRIC_GROUND_TEMP, (int32_t)raw * 25 / 4);   // 1/16 -> 0.01 °C
+        }
+        power_release(RAIL_ONEWIRE);
+        sampler_acq_ms[SENSOR_DS18B20] += systick_ms() - t_start;
+        done(PENDING_DS18B20);
+        return true;
+    }
+
+    return false;
+}
+
+bool sampler_busy(void) {
+    return pending != 0;
+}
+
+uint32_t sampler_wait_ms(void) {
+    if (pending & PENDING_BME280) return 1;   // forced conversion ~10 ms, poll the status bit
+    if (!(pending & PENDING_DS18B20)) return 0;
+
+    uint32_t since = systick_ms() - t_ds_start;
+    return (since < DS18B20_CONVERSION_MS) ? DS18B20_CONVERSION_MS - since : 0;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file sampler.h
+ * @brief One non-blocking sensor sample (BME280 + DS18B20) feeding the interval aggregates.
+ *
+ * sampler_start() powers the sensors and starts both conversions;
+ * sampler_poll() reads whichever one has finished and adds it to the
+ * metric's aggregator; the poll that completes a sample also offers it
+ * to the record batch (recorder.h). Used by the periodic sampling task
+ * and by the upload cycle, which takes one last sample before formatting
+ * and may finish one the task started.
+ */
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "aggregator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    METRIC_AIR_TEMP,      /**< BME280, 0.01 °C */
+    METRIC_PRESSURE,      /**< BME280, Pa */
+    METRIC_HUMIDITY,      /**< BME280, 0.01 %RH */
+    METRIC_GROUND_TEMP,   /**< DS18B20, 0.01 °C */
+    METRIC_COUNT
+};
+
+/** Sensors timed by sampler_acq_ms. */
+enum {
+    SENSOR_BME280,
+    SENSOR_DS18B20,
+    SENSOR_COUNT
+};
+
+/** Aggregates of the current upload interval. */
+extern agg_t metrics[METRIC_COUNT];
+
+/** Most recent value of each metric (same units), kept across resets. */
+extern int32_t sampler_last[METRIC_COUNT];
+
+/** ms from sampler_start() (rails switched on) until each sensor was read
+    and released, summed since reset (wraps). */
+extern uint32_t sampler_acq_ms[SENSOR_COUNT];
+
+/**
+ * @brief Clear all aggregates (after a successful upload).
+ */
+void sampler_reset_metrics(void);
+
+/**
+ * @brief Power the sensors and start both conversions.
+ */
+void sampler_start(void);
+
+/**
+ * @brief Read one finished conversion, if any.
+ * @return true if something was read (call again), false if nothing is ready.
+ */
+bool sampler_poll(void);
+
+/**
+ * @brief true until both results are in and the rails are released.
+ */
+bool sampler_busy(void);
+
+/**
+ * @brief ms until the next result is expected (valid while busy).
+ */
+uint32_t sampler_wait_ms(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLER_H */
@@ -0,0 +1,110 @@
+/**
+ * @file settings.c
+ * @brief EEPROM copy of settings_t with version and CRC.
+ */
+
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "config.h"
+#include "settings.h"
+
+typedef struct __attribute__((packed)) {
+    uint8_t    version;
+    settings_t data;
+    uint8_t    crc;
+} stored_settings_t;
+
+static stored_settings_t EEMEM ee_settings;
+
+settings_t settings;
+
+static const settings_t defaults = {
+    .config_version   = 0,
+    .sample_period_s  = SAMPLE_PERIOD_MS / 1000UL,
+    .check_period_min = REPORT_CHECK_MIN,
+    .deadband = {
+        .band = {
+            [DB_AIR_TEMP]    = DEADBAND_AIR_TEMP,
+            [DB_GROUND_TEMP] = DEADBAND_GROUND_TEMP,
+            [DB_PRESSURE]    = DEADBAND_PRESSURE,
+            [DB_HUMIDITY]    = DEADBAND_HUMIDITY,
+            [DB_WIND]        = DEADBAND_WIND,
+            [DB_RAIN]        = DEADBAND_RAIN,
+        },
+        .max_silence_min = REPORT_MAX_SILENCE_MIN,
+    },
+};
+
+static uint8_t crc_of(const settings_t *s) {
+    const uint8_t *bytes = (const uint8_t *)s;
+    uint8_t crc = SETTINGS_VERSION;
+
+    for (uint8_t i = 0; i < sizeof(settings_t); i++) {
+        crc = _crc8_ccitt_update(crc, bytes[i]);
+    }
+    return crc;
+}
+
+bool settings_load(void) {
+    stored_settings_t s;
+    eeprom_read_block(&s, &ee_settings, sizeof(s));
+
+    if (s.version == SETTINGS_VERSION && s.crc == crc_of(&s.data)) {
+        settings = s.data;
+        return true;
+    }
+    settings = defaults;
+    return false;
+}
+
+void settings_save(void) {
+    stored_settings_t s = { SETTINGS_VERSION, settings, crc_of(&settings) };
+
+    // update_block skips unchanged bytes: a resend of the same value costs no wear
+    eeprom_update_block(&s, &ee_settings, sizeof(s));
+}
+
+static bool set_in(settings_t *s, uint8_t key, uint16_t value) {
+    switch (key) {
+    case SETTING_SAMPLE_PERIOD_S:
+        if (value < 5) return false;   // BME280 + DS18B20 take ~1 s, leave them idle most of the time
+        s->sample_period_s = value;
+        return true;
+
+    case SETTING_CHECK_PERIOD_MIN:
+        if (value == 0) return false;
+        s->check_period_min = value;
+        return true;
+
+    case SETTING_MAX_SILENCE_MIN:
+        if (value == 0) return false;   // a station that never calls in cannot be reconfigured
+        s->deadband.max_silence_min = value;
+        return true;
+
+    default:
+        if (key >= SETTING_COUNT) return false;
+        s->deadband.band[key - SETTING_DEADBAND_FIRST] = value;
+        return true;
+    }
+}
+
+bool settings_set(uint8_t key, uint16_t value) {
+    return set_in(&settings, key, value);
+}
+
+bool settings_apply_delta(const config_delta_t *d) {
+    if (!config_delta_complete(d) || d->version == settings.config_version) return false;
+
+    // A revision lists every value that differs from config.h: whatever it
+    // leaves out goes back to the default, so a key removed on the server
+    // does not stay on the station
+    settings_t next = defaults;
+    for (uint8_t i = 0; i < d->count; i++) {
+        if (!set_in(&next, d->keys[i], d->values[i])) return false;
+    }
+    next.config_version = d->version;
+
+    settings = next;
+    settings_save();
+    return true;
+}
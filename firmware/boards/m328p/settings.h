@@ -0,0 +1,80 @@
+/**
+ * @file settings.h
+ * @brief Run-time settings of the main AVR kept in EEPROM.
+ *
+ * The block is stored with a layout version and a CRC; on a blank or
+ * corrupted EEPROM (or after a layout change) the config.h defaults are
+ * used. settings_set() changes one value by key, so a remote update only
+ * needs to carry (key, value) pairs; settings_save() writes back just
+ * the bytes that changed.
+ *
+ * Remote updates come as a config delta in the ingest response
+ * (config_delta.h). config_version is the server's revision of the
+ * settings; the station reports it with every upload and the server
+ * answers with a delta only when it is behind. The delta carries the
+ * whole revision relative to the config.h defaults, and a key it does
+ * not list is set back to its default.
+ */
+
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "deadband.h"
+#include "config_delta.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Bump when the layout of settings_t changes. */
+#define SETTINGS_VERSION 2
+
+typedef struct __attribute__((packed)) {
+    uint16_t config_version;      /**< Server revision these settings came from (0 = defaults) */
+    uint16_t sample_period_s;     /**< Sensor sample for the aggregates */
+    uint16_t check_period_min;    /**< Deadband check of the latest values */
+    deadband_config_t deadband;   /**< Upload triggers (deadband.h) */
+} settings_t;
+
+/** Keys for settings_set(). */
+typedef enum {
+    SETTING_SAMPLE_PERIOD_S,
+    SETTING_CHECK_PERIOD_MIN,
+    SETTING_MAX_SILENCE_MIN,
+    SETTING_DEADBAND_FIRST,       /**< + DB_* channel */
+    SETTING_COUNT = SETTING_DEADBAND_FIRST + DB_CHANNELS
+} setting_key_t;
+
+/** Active settings. */
+extern settings_t settings;
+
+/**
+ * @brief Load the settings from EEPROM, or the defaults if they are not valid.
+ * @return true if the EEPROM copy was used.
+ */
+bool settings_load(void);
+
+/**
+ * @brief Write the active settings to EEPROM.
+ */
+void settings_save(void);
+
+/**
+ * @brief Change one setting in RAM (call settings_save() to keep it).
+ * @return false for an unknown key or a value out of range.
+ */
+bool settings_set(uint8_t key, uint16_t value);
+
+/**
+ * @brief Replace the settings with the defaults plus a parsed delta, all-or-nothing, and save them.
+ * @return false if it was incomplete or any pair was rejected (nothing changed).
+ */
+bool settings_apply_delta(const config_delta_t *d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SETTINGS_H */
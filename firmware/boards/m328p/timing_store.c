@@ -0,0 +1,50 @@
+/**
+ * @file timing_store.c
+ * @brief gsm_latency[] in EEPROM with a class count and CRC.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "timing_store.h"
+#include "gsm_module.h"
+
+typedef struct __attribute__((packed)) {
+    uint8_t   classes;      /**< GSM_T_COUNT when written */
+    latency_t latency[GSM_T_COUNT];
+    uint8_t   crc;
+} stored_timing_t;
+
+static stored_timing_t EEMEM ee_timing;
+static uint8_t sessions;
+
+static uint8_t crc_of(const stored_timing_t *s) {
+    const uint8_t *bytes = (const uint8_t *)s;
+    uint8_t crc = 0;
+
+    for (uint8_t i = 0; i < offsetof(stored_timing_t, crc); i++) {
+        crc = _crc8_ccitt_update(crc, bytes[i]);
+    }
+    return crc;
+}
+
+bool timing_store_load(void) {
+    stored_timing_t s;
+    eeprom_read_block(&s, &ee_timing, sizeof(s));
+
+    if (s.classes != GSM_T_COUNT || s.crc != crc_of(&s)) return false;
+    memcpy(gsm_latency, s.latency, sizeof(gsm_latency));
+    return true;
+}
+
+void timing_store_session_done(void) {
+    if (++sessions < TIMING_SAVE_SESSIONS) return;
+    sessions = 0;
+
+    stored_timing_t s;
+    s.classes = GSM_T_COUNT;
+    memcpy(s.latency, gsm_latency, sizeof(s.latency));
+    s.crc = crc_of(&s);
+    eeprom_update_block(&s, &ee_timing, sizeof(s));
+}
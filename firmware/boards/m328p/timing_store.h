@@ -0,0 +1,37 @@
+/**
+ * @file timing_store.h
+ * @brief EEPROM copy of the modem's learned command latencies (gsm_latency).
+ *
+ * Loaded at start-up so the timeouts do not fall back to the worst
+ * cases after every reset. Every HTTP session changes the estimates, so
+ * they are written only every TIMING_SAVE_SESSIONS sessions to spare the
+ * EEPROM (about 7000 writes per year at one session an hour).
+ */
+
+#ifndef TIMING_STORE_H
+#define TIMING_STORE_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TIMING_SAVE_SESSIONS 4
+
+/**
+ * @brief Load gsm_latency from EEPROM, or leave it zeroed if not valid.
+ * @return true if the EEPROM copy was used.
+ */
+bool timing_store_load(void);
+
+/**
+ * @brief Count an HTTP session; saves every TIMING_SAVE_SESSIONS sessions.
+ */
+void timing_store_session_done(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMING_STORE_H */
@@ -0,0 +1,67 @@
+/**
+ * @file transport.c
+ * @brief HTTP and MQTT upload transports.
+ *
+ * Dependencies:
+ *  - gsm_module.h : gsm_http_post_stream()
+ *  - gsm_mqtt.h   : AT+CMQTT* client
+ */
+
+#include "config.h"
+#include "transport.h"
+#include "gsm_module.h"
+#include "gsm_mqtt.h"
+
+static gsm_http_body_cb reply_cb;
+static void *reply_ctx;
+
+/* ---------------- HTTP ---------------- */
+
+static bool http_open(gsm_http_body_cb on_reply, void *ctx) {
+    reply_cb = on_reply;
+    reply_ctx = ctx;
+    return true;
+}
+
+static bool http_send(transport_msg_t msg, sw_fill_fn fill, void *ctx, uint16_t len) {
+    if (msg != TRANSPORT_REPORT) return false;   // records travel inside the report
+
+    return gsm_http_post_stream(UPLOAD_URL, "application/json", fill, ctx, len,
+                                /*HTTPDATA timeout s*/5, /*ACTION timeout ms*/120000,
+                                reply_cb, reply_ctx);
+}
+
+static void http_close(void) {
+}
+
+const transport_t transport_http = { http_open, http_send, http_close, false };
+
+/* ---------------- MQTT ---------------- */
+
+static const char *const mqtt_topics[] = {
+    [TRANSPORT_REPORT]  = MQTT_TOPIC_BASE "/report",
+    [TRANSPORT_RECORDS] = MQTT_TOPIC_BASE "/rec",
+};
+
+static bool mqtt_open(gsm_http_body_cb on_reply, void *ctx) {
+    if (!gsm_mqtt_open(MQTT_BROKER, MQTT_CLIENT_ID, MQTT_KEEPALIVE_S, on_reply, ctx)) return false;
+
+    // The retained config comes in while the messages go out
+    if (!gsm_mqtt_subscribe(MQTT_TOPIC_BASE "/cfg")) {
+        gsm_mqtt_close();
+        return false;
+    }
+    return true;
+}
+
+static bool mqtt_send(transport_msg_t msg, sw_fill_fn fill, void *ctx, uint16_t len) {
+    return gsm_mqtt_publish_stream(mqtt_topics[msg], fill, ctx, len);
+}
+
+static void mqtt_close(void) {
+    // No retained message seen yet: give it a moment (none may exist)
+    if (!gsm_mqtt_received()) (void)gsm_mqtt_poll(MQTT_REPLY_WAIT_MS);
+    gsm_mqtt_close();
+}
+
+const transport_t transport_mqtt = { mqtt_open, mqtt_send, mqtt_close, true };
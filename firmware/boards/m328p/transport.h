@@ -0,0 +1,55 @@
+/**
+ * @file transport.h
+ * @brief Upload transports of the main AVR: HTTP per message or one MQTT session.
+ *
+ * An upload is open(), one or more send() and close(). The HTTP
+ * transport runs the whole AT+HTTP* exchange for every send(); the MQTT
+ * transport connects once in open() (gsm_mqtt.h), publishes every
+ * message with QoS 1 on the same connection and disconnects in close().
+ *
+ * A message is written by a fill function (stream_writer.h) straight
+ * into the modem's UART; len is what sw_measure() gave for it.
+ *
+ * send() returns true only once the server has the message (HTTP
+ * 2xx/3xx, MQTT PUBACK); until then the caller keeps the data, so an
+ * unacknowledged message goes again in the next session.
+ *
+ * Replies reach on_reply: the HTTP response body, or the retained
+ * message on MQTT_TOPIC_BASE "/cfg" (both carry the config delta).
+ */
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gsm_module.h"
+#include "stream_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    TRANSPORT_REPORT = 0,   /**< JSON payload */
+    TRANSPORT_RECORDS       /**< recorder_packet(), only if records_apart */
+} transport_msg_t;
+
+typedef struct {
+    bool (*open)(gsm_http_body_cb on_reply, void *ctx);
+    bool (*send)(transport_msg_t msg, sw_fill_fn fill, void *ctx, uint16_t len);
+    void (*close)(void);
+    bool records_apart;     /**< Records go as their own binary message, not base64 in the report */
+} transport_t;
+
+/** AT+HTTP* POST of every message to UPLOAD_URL. */
+extern const transport_t transport_http;
+
+/** MQTT over the modem's TCP stack (AT+CMQTT*), kept up for the whole upload. */
+extern const transport_t transport_mqtt;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRANSPORT_H */
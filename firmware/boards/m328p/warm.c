@@ -0,0 +1,140 @@
+/**
+ * @file warm.c
+ * @brief CRC-checked snapshot in .noinit and the reset cause.
+ *
+ * Dependencies:
+ *  - scheduler.h : task deadlines
+ *  - systick.h   : ms count, continued across the reset
+ *  - sampler.h   : interval aggregates and last samples
+ *  - recorder.h  : seconds clock of the record timestamps
+ *  - reporting.h : deadband reference
+ *  - rails.h     : modem rail
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/wdt.h>
+#include <util/crc16.h>
+#include "config.h"
+#include "warm.h"
+#include "scheduler.h"
+#include "systick.h"
+#include "sampler.h"
+#include "recorder.h"
+#include "reporting.h"
+#include "rails.h"
+#include "bootloader/boot_api.h"
+
+#define WARM_MAGIC 0x574DU   // "WM"
+
+typedef struct {
+    uint16_t   magic;
+    uint16_t   len;                         /**< sizeof(warm_t), catches layout changes */
+    uint8_t    restarts;                    /**< Resumes without WARM_STABLE_MS in between */
+    uint16_t   total;                       /**< Resumes since the last cold boot */
+    bool       modem_on;
+    uint32_t   ms;
+    uint32_t   uptime_s;
+    uint32_t   next_ms[SCHED_MAX_TASKS];
+    agg_t      metrics[METRIC_COUNT];
+    int32_t    last[METRIC_COUNT];
+    deadband_t db;
+    uint16_t   crc;
+} warm_t;
+
+/* Neither is touched by the C start-up code */
+static warm_t snap __attribute__((section(".noinit")));
+static uint8_t reset_cause __attribute__((section(".noinit")));
+
+static uint32_t resumed_ms;
+static uint32_t saved_ms;
+static bool saved;
+
+/* Before .bss is cleared and main() runs: with WDRF left set the
+   watchdog stays on at 15 ms and the start-up would never finish */
+static void read_reset_cause(void) __attribute__((naked, used, section(".init3")));
+static void read_reset_cause(void) {
+    reset_cause = MCUSR | BOOT_RESET_CAUSE;
+    MCUSR = 0;
+    wdt_disable();
+}
+
+static uint16_t crc_of(const warm_t *w) {
+    const uint8_t *bytes = (const uint8_t *)w;
+    uint16_t crc = 0xFFFF;
+
+    for (uint16_t i = 0; i < offsetof(warm_t, crc); i++) {
+        crc = _crc_ccitt_update(crc, bytes[i]);
+    }
+    return crc;
+}
+
+uint8_t warm_reset_cause(void) {
+    return reset_cause;
+}
+
+bool warm_check(void) {
+    bool ok = !(reset_cause & (1 << PORF))
+           && snap.magic == WARM_MAGIC && snap.len == sizeof(warm_t) && snap.crc == crc_of(&snap)
+           && snap.restarts < WARM_MAX_RESTARTS;
+
+    // Cold: an old snapshot must not be picked up by the next reset either
+    if (!ok) warm_discard();
+    return ok;
+}
+
+bool warm_modem_on(void) {
+    return snap.modem_on;
+}
+
+void warm_resume(void) {
+    systick_resume(snap.ms);
+    resumed_ms = snap.ms;
+
+    for (int8_t i = 0; i < SCHED_MAX_TASKS; i++) sched_wake(i, snap.next_ms[i]);
+    memcpy(metrics, snap.metrics, sizeof(metrics));
+    memcpy(sampler_last, snap.last, sizeof(sampler_last));
+    recorder_resume(snap.uptime_s);
+    reporting_resume(&snap.db);
+
+    snap.restarts++;
+    snap.total++;
+    snap.crc = crc_of(&snap);
+}
+
+void warm_save(void) {
+    uint32_t now = systick_ms();
+    bool modem_on = power_is_on(RAIL_GSM);
+
+    if (saved && now - saved_ms < WARM_SAVE_MS && modem_on == snap.modem_on) return;
+
+    // A cold boot starts the counts over; a long enough run ends a crash loop
+    if (!saved && snap.magic != WARM_MAGIC) {
+        snap.restarts = 0;
+        snap.total = 0;
+    }
+    if (now - resumed_ms >= WARM_STABLE_MS) snap.restarts = 0;
+
+    snap.magic = WARM_MAGIC;
+    snap.len = sizeof(warm_t);
+    snap.modem_on = modem_on;
+    snap.ms = now;
+    snap.uptime_s = recorder_uptime_s();
+    for (int8_t i = 0; i < SCHED_MAX_TASKS; i++) snap.next_ms[i] = sched_next_ms(i);
+    memcpy(snap.metrics, metrics, sizeof(metrics));
+    memcpy(snap.last, sampler_last, sizeof(sampler_last));
+    snap.db = *reporting_state();
+    snap.crc = crc_of(&snap);
+
+    saved_ms = now;
+    saved = true;
+}
+
+void warm_discard(void) {
+    snap.magic = 0;
+}
+
+uint16_t warm_restarts(void) {
+    return snap.total;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file warm.h
+ * @brief Warm restart: runtime state kept in .noinit RAM across a reset.
+ *
+ * A cold boot forgets the interval aggregates, the deadband reference
+ * (the first check uploads) and the task deadlines, and probes the modem
+ * to switch it off. SRAM survives a watchdog, brown-out or reset-pin
+ * reset, so after every scheduler pass that ran a task (sched_on_pass())
+ * a snapshot of that state goes into .noinit with a CRC: at most every
+ * WARM_SAVE_MS, at once when the modem rail changed.
+ *
+ * At start-up the reset cause comes from MCUSR, or from BOOT_RESET_CAUSE
+ * when the OTA bootloader ran first and cleared MCUSR itself. Power-on
+ * always boots cold (SRAM is undefined); any other cause resumes from a
+ * snapshot that passes its CRC and layout check. The snapshot is taken
+ * between task steps, so a reset in the middle of one returns to the
+ * state before it. More than WARM_MAX_RESTARTS resumes without
+ * WARM_STABLE_MS of uptime in between count as a crash loop and the next
+ * boot is cold. ota_reboot() discards the snapshot: a new image may lay
+ * out RAM differently.
+ *
+ * Kept: systick ms, task deadlines, aggregates and last samples, the
+ * recorder's seconds clock, the deadband reference and the modem rail.
+ * Not kept: the record batch itself (RAM), an upload cycle in progress
+ * and the modem session. A modem saved as on was in the middle of a
+ * cycle: it is left alone at boot and the cycle starts over right after
+ * the resume, finding the modem up and switching it off at its end. The
+ * firmware has no sequence numbers to keep: records are stamped with the
+ * recorder's clock, and MQTT packet ids belong to the modem's session.
+ */
+
+#ifndef WARM_H
+#define WARM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief MCUSR bits of the last reset (PORF, EXTRF, BORF, WDRF).
+ */
+uint8_t warm_reset_cause(void);
+
+/**
+ * @brief Check whether this boot can resume from the saved snapshot.
+ * @return false for a cold boot (power-on, no valid snapshot, crash loop).
+ */
+bool warm_check(void);
+
+/**
+ * @brief Modem rail as saved (valid after warm_check() returned true).
+ */
+bool warm_modem_on(void);
+
+/**
+ * @brief Restore the saved state. Call after all modules are initialised
+ *        and the tasks added, in the same order as before the reset.
+ */
+void warm_resume(void);
+
+/**
+ * @brief Snapshot the state (sched_on_pass() hook).
+ */
+void warm_save(void);
+
+/**
+ * @brief Invalidate the snapshot, the next boot is cold.
+ */
+void warm_discard(void);
+
+/**
+ * @brief Warm restarts since the last cold boot.
+ */
+uint16_t warm_restarts(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WARM_H */
@@ -0,0 +1,119 @@
+/**
+ * @file adc_scan.c
+ * @brief ADC_vect driven oversampling scan with noise reduction sleep.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include "adc_scan.h"
+
+#define ADC_REF_MASK 0xC0   // REFS1:0, everything below is MUX
+
+static uint8_t scan_channels[ADC_SCAN_MAX_CHANNELS];
+static uint8_t scan_count = 0;
+
+static volatile uint32_t acc[ADC_SCAN_MAX_CHANNELS];
+static volatile uint16_t results[ADC_SCAN_MAX_CHANNELS];
+static volatile uint8_t slot = 0;
+static volatile int8_t sample = 0;     // -1 = settling sample after MUX change
+static volatile uint8_t busy = 0;
+
+static void select_channel(uint8_t index) {
+    ADMUX = (ADMUX & ADC_REF_MASK) | scan_channels[index];
+    sample = -1;
+}
+
+void adc_scan_init(const uint8_t *channels, uint8_t count) {
+    if (count > ADC_SCAN_MAX_CHANNELS) {
+        count = ADC_SCAN_MAX_CHANNELS;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        scan_channels[i] = channels[i];
+
+        // Analog only, the digital input buffer just wastes current
+        if (channels[i] < 8) {
+            DIDR0 |= (1 << channels[i]);
+        }
+    }
+    scan_count = count;
+
+    // Enable ADC + interrupt, prescaler 64 (125 kHz ADC clock at 8 MHz)
+    ADCSRA = (1 << ADEN) | (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1);
+}
+
+void adc_scan_start(void) {
+    if (busy || scan_count == 0) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < scan_count; i++) {
+        acc[i] = 0;
+    }
+    slot = 0;
+    select_channel(0);
+    busy = 1;
+}
+
+uint8_t adc_scan_busy(void) {
+    return busy;
+}
+
+void adc_scan_wait(void) {
+    set_sleep_mode(SLEEP_MODE_ADC);
+
+    while (busy) {
+        cli();
+        if (busy) {
+            // Entering ADC Noise Reduction mode starts the next conversion
+            sleep_enable();
+            sei();
+            sleep_cpu();
+            sleep_disable();
+        }
+        sei();
+    }
+}
+
+uint32_t adc_scan_cycles(void) {
+    return (uint32_t)scan_count * (ADC_OVERSAMPLE + 1) * ADC_CONV_CYCLES;
+}
+
+uint16_t adc_scan_result(uint8_t index) {
+    uint16_t value;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        value = results[index];
+    }
+    return value;
+}
+
+ISR(ADC_vect) {
+    uint16_t value = ADC;
+
+    if (!busy) {
+        return;
+    }
+
+    if (sample < 0) {
+        // Discard the first conversion after a MUX change
+        sample = 0;
+        return;
+    }
+
+    acc[slot] += value;
+
+    if (++sample < ADC_OVERSAMPLE) {
+        return;
+    }
+
+    // Decimate: sum of 4^n samples >> n
+    results[slot] = (uint16_t)(acc[slot] >> ADC_EXTRA_BITS);
+
+    if (++slot < scan_count) {
+        select_channel(slot);
+    } else {
+        busy = 0;
+    }
+}
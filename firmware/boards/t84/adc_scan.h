@@ -0,0 +1,81 @@
+/**
+ * @file adc_scan.h
+ * @brief Interrupt-driven, oversampled ADC channel scan (ATtiny84).
+ *
+ * A scan converts every configured channel 4^ADC_EXTRA_BITS times
+ * (plus one discarded sample after each MUX change) from ADC_vect and
+ * accumulates the samples. Decimating the sum by 2^ADC_EXTRA_BITS gives
+ * ADC_EXTRA_BITS more bits of effective resolution.
+ *
+ * While a scan runs, adc_scan_wait() keeps the CPU in ADC Noise Reduction
+ * sleep, so each conversion starts with the CPU and I/O clocks stopped.
+ * Timer1 halts during those conversions too (a few ms per scan); the
+ * caller adds adc_scan_cycles() to the timebase with timebase_advance().
+ */
+
+#ifndef ADC_SCAN_H
+#define ADC_SCAN_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Extra resolution bits gained by oversampling (16 samples for 2 bits). */
+#ifndef ADC_EXTRA_BITS
+#define ADC_EXTRA_BITS        2
+#endif
+
+#define ADC_OVERSAMPLE        (1 << (2 * ADC_EXTRA_BITS))
+
+/** Maximum decimated result (10-bit full scale shifted by the extra bits). */
+#define ADC_SCAN_MAX          (1023U << ADC_EXTRA_BITS)
+
+/** CPU clocks per conversion: 13 ADC clocks at prescaler 64. */
+#define ADC_CONV_CYCLES       (13UL * 64UL)
+
+/** Maximum number of channels in one scan. */
+#define ADC_SCAN_MAX_CHANNELS 4
+
+/**
+ * @brief Enable the ADC with its interrupt and store the channel list.
+ * @param channels ADC MUX values, results are indexed in the same order.
+ * @param count    Number of channels (<= ADC_SCAN_MAX_CHANNELS).
+ */
+void adc_scan_init(const uint8_t *channels, uint8_t count);
+
+/**
+ * @brief Start a scan of all channels. Ignored if one is already running.
+ */
+void adc_scan_start(void);
+
+/**
+ * @brief Non-zero while a scan is in progress.
+ */
+uint8_t adc_scan_busy(void);
+
+/**
+ * @brief Sleep in ADC Noise Reduction mode until the running scan completes.
+ */
+void adc_scan_wait(void);
+
+/**
+ * @brief CPU clocks the conversions of one full scan take (settling
+ *        samples included), i.e. its time in noise reduction sleep.
+ *        Timer1 does not see that time, it is stopped as well.
+ */
+uint32_t adc_scan_cycles(void);
+
+/**
+ * @brief Decimated result of the last completed scan.
+ * @param slot Index into the channel list given to adc_scan_init().
+ * @return Value in 0..ADC_SCAN_MAX.
+ */
+uint16_t adc_scan_result(uint8_t slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADC_SCAN_H */
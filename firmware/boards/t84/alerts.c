@@ -0,0 +1,106 @@
+/**
+ * @file alerts.c
+ * @brief Rain / gust / solar thresholds with a latched, active-low alert line.
+ */
+
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "config.h"
+#include "timebase.h"
+#include "alerts.h"
+
+volatile monitor_thresholds_t alert_thresholds;
+
+static volatile uint8_t latched = 0;
+static uint8_t armed = MONITOR_EVENT_RAIN | MONITOR_EVENT_GUST | MONITOR_EVENT_SOLAR_LOW;
+
+static uint8_t solar_low = 0;      // power currently below threshold
+static uint32_t solar_low_since = 0;
+
+static void line_assert(void) {
+    // Open drain: drive low
+    ALERT_PORT &= ~(1 << ALERT_PIN);
+    ALERT_DDR |= (1 << ALERT_PIN);
+}
+
+static void line_release(void) {
+    // Open drain: high-Z, the main AVR pull-up takes the line high
+    ALERT_DDR &= ~(1 << ALERT_PIN);
+    ALERT_PORT &= ~(1 << ALERT_PIN);
+}
+
+/* Fire `bit` on a rising condition, re-arm once the condition clears. */
+static void evaluate(uint8_t bit, uint8_t active) {
+    if (!active) {
+        armed |= bit;
+        return;
+    }
+    if (armed & bit) {
+        armed &= ~bit;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            latched |= bit;
+            line_assert();
+        }
+    }
+}
+
+/* The USI interrupt replaces the thresholds at any time; 16-bit fields need a consistent copy */
+static monitor_thresholds_t thresholds(void) {
+    monitor_thresholds_t th;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        th = alert_thresholds;
+    }
+    return th;
+}
+
+void alerts_init(void) {
+    line_release();
+
+    alert_thresholds.rain_tips_per_min = ALERT_RAIN_TIPS_PER_MIN;
+    alert_thresholds.gust_cm_s = ALERT_GUST_CM_S;
+    alert_thresholds.solar_low_mw = ALERT_SOLAR_LOW_MW;
+    alert_thresholds.solar_low_hold_s = ALERT_SOLAR_LOW_HOLD_S;
+}
+
+uint8_t alerts_check_weather(uint16_t rain_tips_min, uint16_t gust_cm_s) {
+    monitor_thresholds_t th = thresholds();
+    uint8_t rain_limit = th.rain_tips_per_min;
+    uint16_t gust_limit = th.gust_cm_s;
+
+    evaluate(MONITOR_EVENT_RAIN, rain_limit && rain_tips_min >= rain_limit);
+    evaluate(MONITOR_EVENT_GUST, gust_limit && gust_cm_s >= gust_limit);
+
+    return latched;
+}
+
+uint8_t alerts_check_solar(uint16_t power_mw, uint32_t now) {
+    monitor_thresholds_t th = thresholds();
+    uint16_t limit = th.solar_low_mw;
+
+    if (!limit || power_mw >= limit) {
+        solar_low = 0;
+        evaluate(MONITOR_EVENT_SOLAR_LOW, 0);
+        return latched;
+    }
+
+    if (!solar_low) {
+        solar_low = 1;
+        solar_low_since = now;
+    }
+
+    evaluate(MONITOR_EVENT_SOLAR_LOW,
+             (now - solar_low_since) >= S_TO_TICKS(th.solar_low_hold_s));
+
+    return latched;
+}
+
+void alerts_ack(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        latched = 0;
+        line_release();
+    }
+}
+
+uint8_t alerts_latched(void) {
+    return latched;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file alerts.h
+ * @brief Threshold engine driving the alert line to the main AVR (ATtiny84).
+ *
+ * Each condition fires once when it crosses its threshold and re-arms
+ * only after it has dropped back, so a long storm raises one alert rather
+ * than a stream. Fired reasons stay latched (and the line stays low)
+ * until the main AVR acknowledges them with MONITOR_CMD_ACK.
+ */
+
+#ifndef ALERTS_H
+#define ALERTS_H
+
+#include <stdint.h>
+#include "../../peripherals/monitor_avr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Active thresholds (defaults from config.h, replaced over I2C). */
+extern volatile monitor_thresholds_t alert_thresholds;
+
+/**
+ * @brief Release the alert line and load default thresholds.
+ */
+void alerts_init(void);
+
+/**
+ * @brief Evaluate rain and gust conditions and latch newly crossed ones.
+ * @param rain_tips_min Rain tips in the last minute.
+ * @param gust_cm_s     Current 3 s gust.
+ * @return Latched MONITOR_EVENT_* bits.
+ */
+uint8_t alerts_check_weather(uint16_t rain_tips_min, uint16_t gust_cm_s);
+
+/**
+ * @brief Evaluate the solar condition after an energy update.
+ * @param power_mw Current panel power.
+ * @param now      Tick count of the sample.
+ * @return Latched MONITOR_EVENT_* bits.
+ */
+uint8_t alerts_check_solar(uint16_t power_mw, uint32_t now);
+
+/**
+ * @brief Clear latched reasons and release the line. Safe from the USI ISR.
+ */
+void alerts_ack(void);
+
+/**
+ * @brief Latched MONITOR_EVENT_* bits.
+ */
+uint8_t alerts_latched(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ALERTS_H */
@@ -1,3 +1,43 @@
 #ifndef F_CPU
     #define F_CPU 8000000UL  // Default if not defined
 #endif
+
+
+/* Minimum time between two accepted pulses (reed switch debounce) */
+#ifndef WIND_DEADTIME_MS
+    #define WIND_DEADTIME_MS 5
+#endif
+
+#ifndef RAIN_DEADTIME_MS
+    #define RAIN_DEADTIME_MS 100
+#endif
+
+/* Alert line to the main AVR (active low, open drain) */
+#ifndef ALERT_PIN
+    #define ALERT_PIN PB2
+#endif
+
+#ifndef ALERT_PORT
+    #define ALERT_PORT PORTB
+#endif
+
+#ifndef ALERT_DDR
+    #define ALERT_DDR DDRB
+#endif
+
+/* Default alert thresholds, 0 disables a condition */
+#ifndef ALERT_RAIN_TIPS_PER_MIN
+    #define ALERT_RAIN_TIPS_PER_MIN 6      // ~100 mm/h
+#endif
+
+#ifndef ALERT_GUST_CM_S
+    #define ALERT_GUST_CM_S 1500           // 15 m/s
+#endif
+
+#ifndef ALERT_SOLAR_LOW_MW
+    #define ALERT_SOLAR_LOW_MW 50
+#endif
+
+#ifndef ALERT_SOLAR_LOW_HOLD_S
+    #define ALERT_SOLAR_LOW_HOLD_S 3600
+#endif
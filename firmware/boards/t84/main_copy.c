@@ -3,9 +3,19 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <avr/interrupt.h>
+#include <avr/sleep.h>
 #include <util/twi.h>
 #include <math.h>
 
+#include "config.h"
+#include "timebase.h"
+#include "pulse_capture.h"
+#include "adc_scan.h"
+#include "solar_energy.h"
+#include "alerts.h"
+#include "usi_slave.h"
+#include "../../peripherals/monitor_avr.h"
+
 // Updated pin definitions for ATtiny84
 #define WIND_BUTTON_PIN        PB0
 #define RAIN_BUTTON_PIN        PB1
@@ -14,10 +24,21 @@
 #define SOLAR_CURRENT_CHANNEL  1
 #define SOLAR_VOLTAGE_CHANNEL  2
 
-#define READINGS_NR            5
+// Full-scale ADC reading (2.56 V) in panel units
+#define SOLAR_MV_FULL_SCALE    30720UL   // 12x divider: 12 * 2560 mV
+#define SOLAR_UA_FULL_SCALE    853333UL  // R = 0.1 Ω, G = 30x: 2.56 V / 3 Ω
+
 #define WIND_DIR_READINGS      110
 #define TIMER_LENGTH           5
-#define I2C_SLAVE_ADDRESS      0x42
+#define TIMER_PERIOD_TICKS     S_TO_TICKS(TIMER_LENGTH)
+#define I2C_SLAVE_ADDRESS      MONITOR_I2C_ADDRESS
+
+// Main loop events, set from ISRs
+#define EVENT_PULSE            (1 << 0)
+#define EVENT_ENERGY           (1 << 1)
+#define EVENT_WIND_DIR         (1 << 2)
+#define EVENT_RESET            (1 << 3)
+#define EVENT_TICK             (1 << 4)
 
 // CONSTANTS
 
@@ -47,35 +68,48 @@ const WindDir wind_table[] = {
 
 #define WIND_TABLE_LEN (sizeof(wind_table) / sizeof(wind_table[0]))
 
-typedef union {
-    float f;
-    uint8_t bytes[4];
-} FloatUnion;
+// ADC scan list, results are read back by slot
+enum {
+    ADC_SLOT_VANE,
+    ADC_SLOT_SOLAR_VOLTAGE,
+    ADC_SLOT_SOLAR_CURRENT,
+    ADC_SLOTS
+};
+
+const uint8_t adc_channels[ADC_SLOTS] = {
+    WIND_VANE_CHANNEL,
+    SOLAR_VOLTAGE_CHANNEL,
+    SOLAR_CURRENT_CHANNEL
+};
 
 // VARIABLES
 
 volatile uint8_t wind_dir_idx = 0;
 volatile uint8_t timers = 0;
 
-volatile uint8_t energy_update_flag = 0;
-volatile uint8_t wind_dir_update_flag = 0;
+volatile uint8_t events = 0;
 uint16_t wind_dir[WIND_DIR_READINGS] = {0};
+SolarEnergy solar;
 
-uint8_t tx_index = 0;
+volatile uint8_t last_pins = 0xFF;
+volatile uint16_t interval_wind_count = 0;
 
-typedef struct {
-    uint16_t rain_count;
-    uint16_t wind_count;
-    uint16_t interval_wind_count;
-    uint16_t max_interval_wind_count;
-    uint16_t avg_wind_dir;
-    FloatUnion energy_generated;
-} Data;
+// I2C data block (layout shared with the main AVR), sent byte by byte followed by a checksum
+typedef monitor_block_t Data;
 
 volatile Data data;
 
+// Threshold write in progress ('T' + monitor_thresholds_t)
+monitor_thresholds_t thresholds_rx;
+uint8_t thresholds_rx_left = 0;
+
+#define DATA_LEN sizeof(Data)
+
 // HELPER FUNCTIONS
 
+uint8_t block_tx(uint8_t index);
+void command_rx(uint8_t index, uint8_t b);
+
 void init(uint8_t i2c_address) {
     // PIN INIT
     // Set WIND_BUTTON_PIN (PCINT0) and RAIN_BUTTON_PIN (PCINT1) as inputs with pull-ups
@@ -88,39 +122,24 @@ void init(uint8_t i2c_address) {
 
     // ADC INIT
     ADMUX = (1 << REFS1) | (1 << REFS0); // Internal 2.56V Vref
-    ADCSRA = (1 << ADEN)                 // Enable ADC
-           | (1 << ADPS1) | (1 << ADPS0); // Prescaler 8
+    adc_scan_init(adc_channels, ADC_SLOTS);
 
-    // USI (I2C) INIT - ATtiny84 uses USI for TWI
-    // Note: USI implementation is different from standard TWI
-    // This is a simplified initialization
-    USICR = (1 << USIWM1) | (1 << USICS1) | (1 << USICS0); // I2C mode, external clock
-    USIDR = 0xFF; // Release SDA
-    USISR = (1 << USISIF) | (1 << USIOIF) | (1 << USIPF) | (1 << USIDC);
-    DDRB &= ~((1 << PB0) | (1 << PB1)); // Ensure SDA and SCL are inputs
+    // USI (I2C) INIT - slave on PA4/PA6, the START interrupt wakes the CPU from any sleep mode
+    usi_slave_init(i2c_address, block_tx, command_rx);
 
     // TIMER INIT
-    // CTC mode: WGM12 = 1
-    TCCR1B |= (1 << WGM12);
-    TCCR1A = 0;
-
-    // Prescaler = 1024
-    TCCR1B |= (1 << CS12) | (1 << CS10);
-
-    // OCR1A = (F_CPU / prescaler) * seconds - 1
-    OCR1A = (F_CPU / 1024) * TIMER_LENGTH - 1;
+    // Free-running Timer1 (prescaler 1024) doubles as the pulse timestamp clock
+    timebase_init();
+    pulse_init(0);
+    last_pins = PINB;
 
-    // Enable Timer1 compare match A interrupt
+    // Compare match A every TIMER_LENGTH seconds, re-armed in the ISR
+    OCR1A = TIMER_PERIOD_TICKS;
     TIMSK1 |= (1 << OCIE1A);
 }
 
-uint16_t ADC_read(uint8_t channel) {
-    // Keep internal Vref, set ADC channel
-    ADMUX = (ADMUX & 0xF0) | (channel & 0x0F); 
-    _delay_us(10); // Small delay for Vref to settle
-    ADCSRA |= (1 << ADSC); // Start conversion
-    while (ADCSRA & (1 << ADSC)); // Wait
-    return ADC;
+float adc_to_voltage(uint8_t slot) {
+    return (adc_scan_result(slot) / (float)ADC_SCAN_MAX) * 2.56f;
 }
 
 uint8_t crc8(uint8_t *data, uint8_t length) {
@@ -142,31 +161,43 @@ uint8_t crc8(uint8_t *data, uint8_t length) {
 
 uint8_t calculate_checksum() {
     uint8_t checksum = 0;
-    
-    checksum += (uint8_t)data.rain_count;  // LSB of rain_count
-    checksum += (uint8_t)(data.rain_count >> 8);  // MSB of rain_count
-    checksum += (uint8_t)data.wind_count;  // LSB of wind_count
-    checksum += (uint8_t)(data.wind_count >> 8);  // MSB of wind_count
-    checksum += (uint8_t)data.max_interval_wind_count;  // LSB of max_interval_wind_count
-    checksum += (uint8_t)(data.max_interval_wind_count >> 8);  // MSB of max_interval_wind_count
-    checksum += (uint8_t)data.avg_wind_dir;  // LSB of avg_wind_dir
-    checksum += (uint8_t)(data.avg_wind_dir >> 8);  // MSB of avg_wind_dir
-    checksum += data.energy_generated.bytes[0];  // XLSB of energy_generated
-    checksum += data.energy_generated.bytes[1];  // LSB of energy_generated
-    checksum += data.energy_generated.bytes[2];  // MSB of energy_generated
-    checksum += data.energy_generated.bytes[3];  // XMSB of energy_generated
-    
+    const volatile uint8_t *bytes = (const volatile uint8_t *)&data;
+
+    // Sum of all data block bytes (little endian fields)
+    for (uint8_t i = 0; i < DATA_LEN; i++) {
+        checksum += bytes[i];
+    }
+
     return checksum;
 }
 
 // WIND SPEED
 
 void update_max_wind_interval() {
-    if (data.max_interval_wind_count < data.interval_wind_count) {
-        data.max_interval_wind_count = data.interval_wind_count;
+    if (data.max_interval_wind_count < interval_wind_count) {
+        data.max_interval_wind_count = interval_wind_count;
     }
 
-    data.interval_wind_count = 0;
+    interval_wind_count = 0;
+}
+
+void update_wind_rain_stats() {
+    uint32_t now = timebase_now();
+    pulse_update(now);
+
+    uint16_t gust = pulse_wind_gust();
+    uint16_t mean = pulse_wind_mean();
+    uint16_t rate = pulse_rain_rate(now);
+    (void)alerts_check_weather(pulse_rain_tips_minute(), pulse_wind_gust_now());
+
+    // USI ISR reads the block byte by byte. The latch is read under the
+    // same lock: an ACK between the check and here must not be undone
+    cli();
+    data.wind_gust = gust;
+    data.wind_mean = mean;
+    data.rain_rate = rate;
+    data.event_reason = alerts_latched();
+    sei();
 }
 
 // WIND DIRECTION
@@ -226,180 +257,219 @@ float direction_from_voltage(float voltage) {
 }
 
 void update_wind_dir_readings() {
-    uint16_t adc_val;
-    float adc_voltage;
-    uint16_t readings[READINGS_NR];
-
     if (wind_dir_idx >= WIND_DIR_READINGS) {
         return;
     }
 
-    for (uint8_t i = 0; i < READINGS_NR; i++) {
-        adc_val = ADC_read(WIND_VANE_CHANNEL);
-        adc_voltage = (adc_val / 1023.0) * 2.56;
-
-        readings[i] = angle_to_int(direction_from_voltage(adc_voltage));
-
-        _delay_ms(200);
-    }
+    // One oversampled vane reading per update (averaged over ~2 ms)
+    float adc_voltage = adc_to_voltage(ADC_SLOT_VANE);
+    wind_dir[wind_dir_idx++] = angle_to_int(direction_from_voltage(adc_voltage));
 
-    wind_dir[wind_dir_idx++] = get_average(readings, READINGS_NR);
-    data.avg_wind_dir = angle_to_int(get_average(wind_dir, wind_dir_idx + 1));
+    // get_average() already returns hundredths of a degree
+    data.avg_wind_dir = (uint16_t)get_average(wind_dir, wind_dir_idx);
 }
 
 // SOLAR ENERGY
 
 void update_energy_generated() {
-    float total_voltage = 0;
-    float total_current = 0;
-
-    for (uint8_t i = 0; i < READINGS_NR; i++) {
-        uint16_t adc_val_voltage = ADC_read(SOLAR_VOLTAGE_CHANNEL); // Voltage input on ADC2 (PA2)
-        uint16_t adc_val_current = ADC_read(SOLAR_CURRENT_CHANNEL); // Current input on ADC1 (PA1)
-
-        float voltage = 12000 * ((adc_val_voltage / 1023.0) * 2.56) / 1000; // V
-
-        float voltage_current = (adc_val_current / 1023.0) * 2.56;
-        float current = (voltage_current * 1000.0) / (0.1 * 30000.0);  // A (R = 0.1Ω, G = 30x)
-
-        total_voltage += voltage;
-        total_current += current;
-
-        _delay_ms(100);
-    }
-
-    float avg_voltage = total_voltage / READINGS_NR;
-    float avg_current = total_current / READINGS_NR;
-
-    float power_w = avg_voltage * avg_current;
-    float energy_wh = power_w * (5.5 / 3600.0); // 5 sec → hours
-
-    data.energy_generated.f += energy_wh * 1000;
+    // Oversampled readings from the last ADC scan
+    uint16_t voltage_mv = (uint16_t)(adc_scan_result(ADC_SLOT_SOLAR_VOLTAGE) * SOLAR_MV_FULL_SCALE / ADC_SCAN_MAX); // ADC2, PA2
+    uint32_t current_ua = adc_scan_result(ADC_SLOT_SOLAR_CURRENT) * SOLAR_UA_FULL_SCALE / ADC_SCAN_MAX;               // ADC1, PA1
+
+    // Weighted by the ticks that really passed since the previous update
+    uint32_t now = timebase_now();
+    solar_energy_update(&solar, voltage_mv, current_ua, now);
+    (void)alerts_check_solar((uint16_t)(solar.last_power_uw / 1000), now);
+
+    // Latch read under the lock, as in update_wind_rain_stats()
+    cli();
+    data.energy_generated = solar.energy_uwh;
+    data.peak_power = (uint16_t)(solar.peak_power_uw / 1000);
+    data.min_voltage = solar.min_voltage_mv;
+    data.max_voltage = solar.max_voltage_mv;
+    data.event_reason = alerts_latched();
+    sei();
 }
 
 // INTERRUPTS
 
 ISR(PCINT0_vect) {
-    // Check which pin triggered the interrupt
-    if (!(PINB & (1 << WIND_BUTTON_PIN))) {
+    uint32_t now = timebase_now_isr();
+    uint8_t pins = PINB;
+
+    // Only count falling edges on the pin that actually changed
+    uint8_t falling = (last_pins ^ pins) & ~pins;
+    last_pins = pins;
+
+    if ((falling & (1 << WIND_BUTTON_PIN)) && pulse_accept_isr(PULSE_WIND, now)) {
         data.wind_count++;
-        data.interval_wind_count++;
+        interval_wind_count++;
+        events |= EVENT_PULSE;
     }
-    
-    if (!(PINB & (1 << RAIN_BUTTON_PIN))) {
+
+    if ((falling & (1 << RAIN_BUTTON_PIN)) && pulse_accept_isr(PULSE_RAIN, now)) {
         data.rain_count++;
+        events |= EVENT_PULSE;
     }
 }
 
 ISR(TIM1_COMPA_vect) {
+    OCR1A += TIMER_PERIOD_TICKS;
     timers++;
     update_max_wind_interval();
 
-    energy_update_flag = 0;
+    events |= EVENT_TICK | EVENT_ENERGY;
 
     if (timers % 2 == 0) {
-        wind_dir_update_flag = 1;
+        events |= EVENT_WIND_DIR;
     }
 }
 
-ISR(USI_STR_vect) {
-    // USI Start Condition Interrupt
-    // Handle I2C start condition
-    USISR |= (1 << USIOIF); // Clear interrupt flag
+// I2C: a read returns the block and its checksum, a write carries a command
+uint8_t block_tx(uint8_t index) {
+    if (index < DATA_LEN) {
+        return ((const volatile uint8_t *)&data)[index];
+    } else if (index == DATA_LEN) {
+        return calculate_checksum();
+    }
+    return 0xFF;  // Default value
 }
 
-ISR(USI_OVF_vect) {
-    // USI Overflow Interrupt - used for I2C data transfer
-    uint8_t usi_data = USIDR;
-    uint8_t checksum = calculate_checksum();
-    
-    if (USISR & (1 << USIPF)) {
-        // Stop condition detected
-        USISR |= (1 << USIPF); // Clear stop flag
-    } else {
-        // Handle data transfer
-        if (usi_data == 'R') {
-            // Reset command
-            timers = 0;
-            TCNT1 = 0;
-
-            data.rain_count = 0;
-            data.wind_count = 0;
-            data.interval_wind_count = 0;
-            data.max_interval_wind_count = 0;
-            for (uint8_t i = 0; i < wind_dir_idx; i++) {
-                wind_dir[i] = 0;
-            }
-            wind_dir_idx = 0;
-            data.energy_generated.f = 0.0f;
-        } else {
-            // Data request
-            switch (tx_index) {
-                case 0:
-                    USIDR = (uint8_t)data.rain_count; // LSB
-                    break;
-                case 1:
-                    USIDR = (uint8_t)(data.rain_count >> 8); // MSB
-                    break;
-                case 2:
-                    USIDR = (uint8_t)data.wind_count; // LSB
-                    break;
-                case 3:
-                    USIDR = (uint8_t)(data.wind_count >> 8); // MSB
-                    break;
-                case 4:
-                    USIDR = (uint8_t)data.max_interval_wind_count; // LSB
-                    break;
-                case 5:
-                    USIDR = (uint8_t)(data.max_interval_wind_count >> 8); // MSB
-                    break;
-                case 6:
-                    USIDR = (uint8_t)(data.avg_wind_dir); // LSB
-                    break;
-                case 7:
-                    USIDR = (uint8_t)(data.avg_wind_dir >> 8); // MSB
-                    break;
-                case 8:
-                    USIDR = data.energy_generated.bytes[0]; // XLSB
-                    break;
-                case 9:
-                    USIDR = data.energy_generated.bytes[1]; // LSB
-                    break;
-                case 10:
-                    USIDR = data.energy_generated.bytes[2]; // MSB
-                    break;
-                case 11:
-                    USIDR = data.energy_generated.bytes[3]; // XMSB
-                    break;
-                case 12:
-                    USIDR = checksum;  // Send checksum byte
-                    break;
-                default:
-                    USIDR = 0xFF;  // Default value
-                    break;
+void command_rx(uint8_t index, uint8_t usi_data) {
+    if (index > 0) {
+        // Payload of a threshold write, applied once complete; other commands take none
+        if (thresholds_rx_left) {
+            ((uint8_t *)&thresholds_rx)[index - 1] = usi_data;
+            if (--thresholds_rx_left == 0) {
+                alert_thresholds = thresholds_rx;
             }
-            tx_index++;
         }
+        return;
+    }
+
+    // The first byte of a write is the command
+    thresholds_rx_left = 0;
+    if (usi_data == MONITOR_CMD_THRESHOLDS) {
+        thresholds_rx_left = sizeof(thresholds_rx);
+    } else if (usi_data == MONITOR_CMD_ACK) {
+        // Main AVR has read event_reason, release the alert line
+        alerts_ack();
+        data.event_reason = 0;
+    } else if (usi_data == MONITOR_CMD_RESET) {
+        // Reset command (Timer1 keeps running, it is the timestamp clock)
+        timers = 0;
+        OCR1A = TCNT1 + TIMER_PERIOD_TICKS;
+        events |= EVENT_RESET;
+
+        data.rain_count = 0;
+        data.wind_count = 0;
+        interval_wind_count = 0;
+        data.max_interval_wind_count = 0;
+        for (uint8_t i = 0; i < wind_dir_idx; i++) {
+            wind_dir[i] = 0;
+        }
+        wind_dir_idx = 0;
+        data.energy_generated = 0;
+        data.peak_power = 0;
+        data.min_voltage = 0xFFFF;
+        data.max_voltage = 0;
+        data.sleep_ticks = 0;
+        data.active_ticks = 0;
+        data.adc_sleep_ticks = 0;
+    }
+}
+
+// SLEEP
+
+uint16_t adc_sleep_cycles = 0;
+
+// End of the last sleep, start of the current active stretch
+uint32_t awake_since = 0;
+
+// Timer1 is stopped in ADC noise reduction sleep: charge the scan's
+// conversion time instead (a tick is 1024 clocks), carrying the remainder,
+// and move the timebase over it so pulse timestamps and the solar
+// interval keep real time. The scan follows the compare ISR, a whole
+// period before OCR1A, so the full step always applies.
+void count_adc_sleep() {
+    uint32_t cycles = adc_sleep_cycles + adc_scan_cycles();
+    uint16_t ticks = timebase_advance((uint16_t)(cycles >> 10));
+
+    cli();
+    data.adc_sleep_ticks += ticks;
+    awake_since += ticks;   // not active time either
+    sei();
+    adc_sleep_cycles = (uint16_t)(cycles & 1023);
+}
+
+// Sleep until an ISR posts an event. Returns the pending events (cleared).
+uint8_t wait_for_events() {
+    uint8_t pending;
+
+    // Idle keeps Timer1 running: it is both the timestamp clock and a wake source
+    set_sleep_mode(SLEEP_MODE_IDLE);
+
+    cli();
+    while (!(pending = events)) {
+        uint32_t start = timebase_now_isr();
+        data.active_ticks += start - awake_since;
+
+        // sei() takes effect after the next instruction, so no event can
+        // slip in between the check above and sleep_cpu()
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+
+        cli();
+        awake_since = timebase_now_isr();
+        data.sleep_ticks += awake_since - start;
     }
-    
-    USISR |= (1 << USIOIF); // Clear overflow flag
+    events = 0;
+    sei();
+
+    return pending;
 }
 
 // MAIN LOOP
 
 int main(void) {
     init(I2C_SLAVE_ADDRESS);
+    alerts_init();
+    solar_energy_reset(&solar);
+    data.min_voltage = 0xFFFF;
+
+    // Timer0 and the analog comparator are unused
+    PRR |= (1 << PRTIM0);
+    ACSR |= (1 << ACD);
+
     sei(); // Enable global interrupts
 
     while (1) {
-        if (energy_update_flag) {
-            energy_update_flag = 0;
+        uint8_t pending = wait_for_events();
+
+        if (pending & EVENT_RESET) {
+            pulse_reset(timebase_now());
+            solar_energy_reset(&solar);
+        }
+
+        if (pending & (EVENT_PULSE | EVENT_TICK)) {
+            update_wind_rain_stats();
+        }
+
+        if (pending & (EVENT_ENERGY | EVENT_WIND_DIR)) {
+            // Convert all channels once, CPU sleeps in ADC noise reduction mode
+            adc_scan_start();
+            adc_scan_wait();
+            count_adc_sleep();
+        }
+
+        if (pending & EVENT_ENERGY) {
             update_energy_generated();
         }
 
-        if (wind_dir_update_flag) {
-            wind_dir_update_flag = 0;
+        if (pending & EVENT_WIND_DIR) {
             update_wind_dir_readings();
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,226 @@
+/**
+ * @file pulse_capture.c
+ * @brief Pulse debouncing, timestamp ring and wind/rain statistics.
+ */
+
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "config.h"
+#include "timebase.h"
+#include "pulse_capture.h"
+
+#define PULSE_RING_MASK (PULSE_RING_SIZE - 1)
+
+#if (PULSE_RING_SIZE & PULSE_RING_MASK) != 0
+    #error "PULSE_RING_SIZE must be a power of two"
+#endif
+
+typedef struct {
+    uint32_t ts;
+    uint8_t  source;
+} PulseEvent;
+
+/* Sliding window made of equal bins; bins[idx] is the open bin. */
+typedef struct {
+    uint32_t bin_end;   // tick at which the open bin closes
+    uint16_t sum;       // pulses in all bins (including the open one)
+    uint16_t last;      // pulses in the last completed window
+    uint16_t peak;      // highest completed window since the last clear
+    uint8_t  idx;       // open bin
+    uint8_t  filled;    // closed bins since start, saturates at bin count
+} Window;
+
+// RING (written by PCINT ISR, read by main loop)
+
+static volatile PulseEvent ring[PULSE_RING_SIZE];
+static volatile uint8_t ring_head = 0;
+static volatile uint8_t ring_tail = 0;
+static volatile uint16_t ring_drops = 0;
+
+static uint32_t last_accepted[PULSE_SOURCES];
+static const uint32_t deadtime[PULSE_SOURCES] = {
+    MS_TO_TICKS(WIND_DEADTIME_MS),
+    MS_TO_TICKS(RAIN_DEADTIME_MS)
+};
+
+// STATISTICS (main loop only)
+
+static uint16_t gust_bins[GUST_BINS];
+static uint16_t mean_bins[MEAN_BINS];
+static uint16_t rain_bins[RAIN_BINS];
+static Window gust_window;
+static Window mean_window;
+static Window rain_window;
+
+static uint32_t rain_last_tip = 0;
+static uint32_t rain_prev_tip = 0;
+static uint8_t  rain_tips = 0;      // saturates at 2, only "have interval" matters
+
+uint8_t pulse_accept_isr(uint8_t source, uint32_t now) {
+    if ((now - last_accepted[source]) < deadtime[source]) {
+        return 0; // bounce
+    }
+    last_accepted[source] = now;
+
+    uint8_t next = (ring_head + 1) & PULSE_RING_MASK;
+    if (next == ring_tail) {
+        ring_drops++;  // still counted in totals, only lost for statistics
+    } else {
+        ring[ring_head].ts = now;
+        ring[ring_head].source = source;
+        ring_head = next;
+    }
+
+    return 1;
+}
+
+static void window_start(Window *w, uint16_t *bins, uint8_t n, uint32_t bin_ticks, uint32_t now) {
+    for (uint8_t i = 0; i < n; i++) {
+        bins[i] = 0;
+    }
+    w->bin_end = now + bin_ticks;
+    w->sum = 0;
+    w->last = 0;
+    w->peak = 0;
+    w->idx = 0;
+    w->filled = 0;
+}
+
+/* Close every bin that ended before `now`, sliding the window one bin at a time. */
+static void window_advance(Window *w, uint16_t *bins, uint8_t n, uint32_t bin_ticks, uint32_t now) {
+    // Idle for longer than the whole window: every bin is empty now
+    if ((int32_t)(now - w->bin_end) >= (int32_t)(bin_ticks * n)) {
+        uint16_t peak = (w->sum > w->peak) ? w->sum : w->peak;
+        window_start(w, bins, n, bin_ticks, now);
+        w->peak = peak;
+        w->filled = n;
+        return;
+    }
+
+    while ((int32_t)(now - w->bin_end) >= 0) {
+        w->last = w->sum;
+        if (w->sum > w->peak) {
+            w->peak = w->sum;
+        }
+        if (w->filled < n) {
+            w->filled++;
+        }
+
+        w->idx = (w->idx + 1 < n) ? w->idx + 1 : 0;
+        w->sum -= bins[w->idx];
+        bins[w->idx] = 0;
+        w->bin_end += bin_ticks;
+    }
+}
+
+static void window_add(Window *w, uint16_t *bins) {
+    bins[w->idx]++;
+    w->sum++;
+}
+
+static void advance_windows(uint32_t now) {
+    window_advance(&gust_window, gust_bins, GUST_BINS, MS_TO_TICKS(GUST_BIN_MS), now);
+    window_advance(&mean_window, mean_bins, MEAN_BINS, S_TO_TICKS(MEAN_BIN_S), now);
+    window_advance(&rain_window, rain_bins, RAIN_BINS, S_TO_TICKS(RAIN_BIN_S), now);
+}
+
+void pulse_update(uint32_t now) {
+    for (;;) {
+        uint8_t tail = ring_tail;
+        if (tail == ring_head) {
+            break;
+        }
+
+        uint32_t ts = ring[tail].ts;
+        uint8_t source = ring[tail].source;
+        ring_tail = (tail + 1) & PULSE_RING_MASK;
+
+        if (source == PULSE_WIND) {
+            advance_windows(ts);
+            window_add(&gust_window, gust_bins);
+            window_add(&mean_window, mean_bins);
+        } else {
+            advance_windows(ts);
+            window_add(&rain_window, rain_bins);
+
+            rain_prev_tip = rain_last_tip;
+            rain_last_tip = ts;
+            if (rain_tips < 2) {
+                rain_tips++;
+            }
+        }
+    }
+
+    advance_windows(now);
+}
+
+void pulse_init(uint32_t now) {
+    window_start(&mean_window, mean_bins, MEAN_BINS, S_TO_TICKS(MEAN_BIN_S), now);
+    window_start(&rain_window, rain_bins, RAIN_BINS, S_TO_TICKS(RAIN_BIN_S), now);
+    pulse_reset(now);
+}
+
+void pulse_reset(uint32_t now) {
+    // The 10 min mean and tips per minute are running values and survive interval resets
+    window_start(&gust_window, gust_bins, GUST_BINS, MS_TO_TICKS(GUST_BIN_MS), now);
+    rain_tips = 0;
+}
+
+static uint16_t gust_to_cm_s(uint16_t pulses) {
+    // Pulses per 3 s -> Hz -> cm/s
+    return (uint16_t)((uint32_t)pulses * WIND_CM_S_PER_HZ_X100 * 10UL
+                      / ((uint32_t)GUST_BINS * GUST_BIN_MS));
+}
+
+uint16_t pulse_wind_gust(void) {
+    return gust_to_cm_s(gust_window.peak);
+}
+
+uint16_t pulse_wind_gust_now(void) {
+    return gust_to_cm_s(gust_window.last);
+}
+
+uint16_t pulse_wind_mean(void) {
+    uint16_t seconds = (uint16_t)mean_window.filled * MEAN_BIN_S;
+    if (seconds == 0) {
+        return 0;
+    }
+    return (uint16_t)((uint32_t)mean_window.last * WIND_CM_S_PER_HZ_X100 / 100UL / seconds);
+}
+
+uint16_t pulse_rain_rate(uint32_t now) {
+    if (rain_tips < 2) {
+        return 0;
+    }
+
+    uint32_t interval = rain_last_tip - rain_prev_tip;
+    uint32_t since_last = now - rain_last_tip;
+
+    if (since_last >= S_TO_TICKS(RAIN_RATE_TIMEOUT_S)) {
+        return 0;
+    }
+    // Let the rate decay while no further tip arrives
+    if (since_last > interval) {
+        interval = since_last;
+    }
+    if (interval == 0) {
+        return 0xFFFF;
+    }
+
+    // 0.01 mm per tip * tips per hour
+    uint32_t rate = (RAIN_UM_PER_TIP * 360UL * TICKS_PER_SECOND) / interval;
+    return (rate > 0xFFFF) ? 0xFFFF : (uint16_t)rate;
+}
+
+uint16_t pulse_rain_tips_minute(void) {
+    // Open bin included, so a tip counts as soon as it is drained
+    return rain_window.sum;
+}
+
+uint16_t pulse_ring_drops(void) {
+    uint16_t drops;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        drops = ring_drops;
+    }
+    return drops;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file pulse_capture.h
+ * @brief Timestamped anemometer / rain gauge pulses (ATtiny84).
+ *
+ * The pin change ISR timestamps every edge with the Timer1 tick counter,
+ * rejects bounces shorter than the per-source dead-time and queues the
+ * accepted pulse in a small lock-free ring (ISR = producer, main = consumer).
+ *
+ * The main loop drains the ring with pulse_update() and derives:
+ *  - the WMO 3 s gust (max 3 s running mean, sampled every 250 ms),
+ *  - the 10 min running mean wind speed,
+ *  - the rain rate from the interval between the last two bucket tips,
+ *  - the number of bucket tips in the last minute.
+ */
+
+#ifndef PULSE_CAPTURE_H
+#define PULSE_CAPTURE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Pulse sources */
+#define PULSE_WIND             0
+#define PULSE_RAIN             1
+#define PULSE_SOURCES          2
+
+/** Ring size in events (must be a power of two). */
+#define PULSE_RING_SIZE        8
+
+/* SparkFun weather meter: 1 Hz = 2.4 km/h = 66.67 cm/s, 1 tip = 0.2794 mm */
+#define WIND_CM_S_PER_HZ_X100  6667UL
+#define RAIN_UM_PER_TIP        279UL
+
+/* Averaging windows */
+#define GUST_BIN_MS            250
+#define GUST_BINS              12     /* 12 x 250 ms = 3 s */
+#define MEAN_BIN_S             60
+#define MEAN_BINS              10     /* 10 x 60 s = 10 min */
+#define RAIN_BIN_S             10
+#define RAIN_BINS              6      /* 6 x 10 s = 1 min */
+
+/** Rain rate drops to 0 after this long without a tip. */
+#define RAIN_RATE_TIMEOUT_S    3600
+
+/**
+ * @brief Debounce and queue one falling edge. Call from the PCINT ISR only.
+ * @param source PULSE_WIND or PULSE_RAIN.
+ * @param now    Tick count from timebase_now_isr().
+ * @return 1 if the pulse was accepted, 0 if it fell inside the dead-time.
+ */
+uint8_t pulse_accept_isr(uint8_t source, uint32_t now);
+
+/**
+ * @brief Drain queued pulses and advance the averaging windows to now.
+ */
+void pulse_update(uint32_t now);
+
+/**
+ * @brief Start the averaging windows. Call once after timebase_init().
+ */
+void pulse_init(uint32_t now);
+
+/**
+ * @brief Clear gust maximum and rain history (interval reset from master).
+ */
+void pulse_reset(uint32_t now);
+
+/** @brief Highest 3 s gust since the last reset, cm/s. */
+uint16_t pulse_wind_gust(void);
+
+/** @brief Most recent complete 3 s gust, cm/s. */
+uint16_t pulse_wind_gust_now(void);
+
+/** @brief 10 min running mean wind speed, cm/s. */
+uint16_t pulse_wind_mean(void);
+
+/** @brief Current rain rate in 0.01 mm/h. */
+uint16_t pulse_rain_rate(uint32_t now);
+
+/** @brief Rain gauge tips in the last minute (10 s resolution). */
+uint16_t pulse_rain_tips_minute(void);
+
+/** @brief Pulses lost because the ring was full. */
+uint16_t pulse_ring_drops(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PULSE_CAPTURE_H */
@@ -0,0 +1,40 @@
+/**
+ * @file solar_energy.c
+ * @brief Trapezoidal µWh integration weighted by measured elapsed ticks.
+ */
+
+#include "solar_energy.h"
+
+void solar_energy_reset(SolarEnergy *s) {
+    s->energy_uwh = 0;
+    s->remainder = 0;
+    s->last_power_uw = 0;
+    s->last_ts = 0;
+    s->peak_power_uw = 0;
+    s->min_voltage_mv = 0xFFFF;
+    s->max_voltage_mv = 0;
+    s->has_sample = 0;
+}
+
+void solar_energy_update(SolarEnergy *s, uint16_t voltage_mv, uint32_t current_ua, uint32_t now) {
+    uint32_t power_uw = (uint32_t)(((uint64_t)voltage_mv * current_ua) / 1000);
+
+    if (voltage_mv < s->min_voltage_mv) s->min_voltage_mv = voltage_mv;
+    if (voltage_mv > s->max_voltage_mv) s->max_voltage_mv = voltage_mv;
+    if (power_uw > s->peak_power_uw)    s->peak_power_uw = power_uw;
+
+    if (s->has_sample) {
+        uint32_t elapsed = now - s->last_ts;
+
+        // Mean power over the interval (trapezoid) times real elapsed ticks
+        uint64_t uw_ticks = ((uint64_t)s->last_power_uw + power_uw) * elapsed / 2
+                          + s->remainder;
+
+        s->energy_uwh += (uint32_t)(uw_ticks / SOLAR_TICKS_PER_HOUR);
+        s->remainder   = (uint32_t)(uw_ticks % SOLAR_TICKS_PER_HOUR);
+    }
+
+    s->last_power_uw = power_uw;
+    s->last_ts = now;
+    s->has_sample = 1;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file solar_energy.h
+ * @brief Fixed-point solar energy accounting (ATtiny84, host buildable).
+ *
+ * Power is integrated with the trapezoidal rule over the real number of
+ * Timer1 ticks between two samples. Energy is kept in whole µWh plus a
+ * remainder in µW·ticks, so the total does not drift with rounding however
+ * long the accumulator runs. Also tracks peak power and min/max voltage.
+ *
+ * No AVR headers are used here, so the same code can be replayed on a PC
+ * (see testing/solar_replay.c).
+ */
+
+#ifndef SOLAR_ENERGY_H
+#define SOLAR_ENERGY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Timer1 ticks per hour: 3600 * F_CPU / 1024 (28 125 000 at 8 MHz). */
+#define SOLAR_TICKS_PER_HOUR  ((uint32_t)(F_CPU * 225UL / 64UL))
+
+typedef struct {
+    uint32_t energy_uwh;      /**< Accumulated energy, µWh */
+    uint32_t remainder;       /**< Sub-µWh part, µW·ticks (< SOLAR_TICKS_PER_HOUR) */
+    uint32_t last_power_uw;   /**< Power at the previous sample */
+    uint32_t last_ts;         /**< Tick of the previous sample */
+    uint32_t peak_power_uw;   /**< Highest power since reset */
+    uint16_t min_voltage_mv;  /**< Lowest voltage since reset (0xFFFF = none) */
+    uint16_t max_voltage_mv;  /**< Highest voltage since reset */
+    uint8_t  has_sample;      /**< last_ts/last_power_uw are valid */
+} SolarEnergy;
+
+/**
+ * @brief Clear energy and statistics. The next sample only sets the start point.
+ */
+void solar_energy_reset(SolarEnergy *s);
+
+/**
+ * @brief Add one voltage/current sample taken at tick `now`.
+ * @param voltage_mv Panel voltage in mV.
+ * @param current_ua Panel current in µA.
+ * @param now        Timer1 tick count of the sample.
+ */
+void solar_energy_update(SolarEnergy *s, uint16_t voltage_mv, uint32_t current_ua, uint32_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOLAR_ENERGY_H */
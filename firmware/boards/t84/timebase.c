@@ -0,0 +1,68 @@
+/**
+ * @file timebase.c
+ * @brief Timer1 based 32-bit tick counter (ATtiny84).
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "timebase.h"
+
+static volatile uint16_t timer1_overflows = 0;
+
+void timebase_init(void) {
+    // Normal mode, prescaler = 1024
+    TCCR1A = 0;
+    TCCR1B = (1 << CS12) | (1 << CS10);
+    TCNT1 = 0;
+
+    // Enable overflow interrupt (upper 16 bits of the tick counter)
+    TIFR1 = (1 << TOV1);
+    TIMSK1 |= (1 << TOIE1);
+}
+
+uint32_t timebase_now_isr(void) {
+    uint16_t lo = TCNT1;
+    uint16_t hi = timer1_overflows;
+
+    // Overflow happened but its ISR has not run yet
+    if ((TIFR1 & (1 << TOV1)) && lo < 0x8000) {
+        hi++;
+    }
+
+    return ((uint32_t)hi << 16) | lo;
+}
+
+uint32_t timebase_now(void) {
+    uint32_t now;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        now = timebase_now_isr();
+    }
+    return now;
+}
+
+uint16_t timebase_advance(uint16_t ticks) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        uint16_t lo = TCNT1;
+
+        // A write blocks the compare on the next timer clock: stop two
+        // ticks short of OCR1A rather than stepping over the match
+        uint16_t to_compare = OCR1A - lo;
+        if (ticks + 2UL > to_compare) {
+            ticks = to_compare > 2 ? to_compare - 2 : 0;
+        }
+
+        uint16_t next = lo + ticks;
+        TCNT1 = next;
+
+        // Writing TCNT1 does not set TOV1, count the wrap here
+        if (next < lo) {
+            timer1_overflows++;
+        }
+    }
+    return ticks;
+}
+
+ISR(TIM1_OVF_vect) {
+    timer1_overflows++;
+}
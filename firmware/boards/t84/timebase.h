@@ -0,0 +1,57 @@
+/**
+ * @file timebase.h
+ * @brief Free-running 32-bit tick counter for the monitoring ATtiny84.
+ *
+ * Timer1 runs in normal mode with prescaler 1024 and its overflow
+ * interrupt extends TCNT1 to 32 bits. Compare A is left to the caller
+ * for periodic work (re-arm it with OCR1A += period in the ISR).
+ * Time spent with the timer stopped is added with timebase_advance().
+ */
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Timer1 ticks per second (F_CPU / 1024, 7812 at 8 MHz). */
+#define TICKS_PER_SECOND   (F_CPU / 1024UL)
+
+/** Convert milliseconds to Timer1 ticks. */
+#define MS_TO_TICKS(ms)    ((uint32_t)(ms) * TICKS_PER_SECOND / 1000UL)
+
+/** Convert seconds to Timer1 ticks. */
+#define S_TO_TICKS(s)      ((uint32_t)(s) * TICKS_PER_SECOND)
+
+/**
+ * @brief Start Timer1 free-running (normal mode, /1024) with overflow IRQ.
+ */
+void timebase_init(void);
+
+/**
+ * @brief Current tick count. Must be called with interrupts disabled (ISR).
+ */
+uint32_t timebase_now_isr(void);
+
+/**
+ * @brief Current tick count (safe to call from the main loop).
+ */
+uint32_t timebase_now(void);
+
+/**
+ * @brief Move the tick count forward over time Timer1 did not see
+ *        (it is stopped in ADC Noise Reduction sleep).
+ * @param ticks Ticks that passed with the timer stopped.
+ * @return Ticks applied: fewer only if the step would pass OCR1A, whose
+ *         compare match must not be skipped.
+ */
+uint16_t timebase_advance(uint16_t ticks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMEBASE_H */
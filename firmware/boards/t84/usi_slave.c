@@ -0,0 +1,123 @@
+/**
+ * @file usi_slave.c
+ * @brief USI two-wire slave state machine (START, address, data and ACK bits).
+ */
+
+#include "../../hal/hal.h"
+#include "usi_slave.h"
+
+/* Flags cleared (USIDC is read-only), counter set for 8 bits (16 edges) or one ACK bit */
+#define USISR_CLEAR  ((1 << USISIF) | (1 << USIOIF) | (1 << USIPF) | (1 << USIDC))
+#define USISR_BYTE   (USISR_CLEAR | 0x0)
+#define USISR_BIT    (USISR_CLEAR | 0xE)
+
+/* Two-wire mode, shift on the external clock. WAIT: only the START detector,
+   SCL is not held on overflow. ACTIVE: overflow interrupt, SCL held low
+   after each overflow until USIOIF is cleared. */
+#define USICR_WAIT   ((1 << USISIE) | (1 << USIWM1) | (1 << USICS1))
+#define USICR_ACTIVE ((1 << USISIE) | (1 << USIOIE) | (1 << USIWM1) | (1 << USIWM0) | (1 << USICS1))
+
+typedef enum {
+    USI_ADDRESS,        // address byte shifted in
+    USI_SEND,           // ACK shifted: load the next byte to send
+    USI_SEND_DONE,      // byte sent: release SDA for the master's ACK
+    USI_SEND_ACKED,     // master's ACK/NACK shifted in
+    USI_RECV,           // ACK shifted: release SDA for the next byte
+    USI_RECV_DONE,      // byte received: hand it over and ACK it
+} usi_state_t;
+
+static uint8_t own_addr;
+static usi_tx_fn on_tx;
+static usi_rx_fn on_rx;
+static volatile uint8_t state = USI_ADDRESS;
+static uint8_t pos;
+
+/* Back to waiting for a START (NACKed address, end of a read) */
+static void wait_for_start(void) {
+    HAL_CLEAR(USI_DDR, 1 << USI_SDA);
+    HAL_WRITE(USICR, USICR_WAIT);
+    HAL_WRITE(USISR, USISR_CLEAR & ~(1 << USISIF));   // a START already seen stays pending
+}
+
+static void send_ack(void) {
+    HAL_WRITE(USIDR, 0);
+    HAL_SET(USI_DDR, 1 << USI_SDA);
+    HAL_WRITE(USISR, USISR_BIT);
+}
+
+void usi_slave_init(uint8_t addr, usi_tx_fn tx, usi_rx_fn rx) {
+    own_addr = addr;
+    on_tx = tx;
+    on_rx = rx;
+
+    // Released lines: PORT high, SCL driven by the USI (open drain in two-wire mode)
+    HAL_SET(USI_PORT, (1 << USI_SCL) | (1 << USI_SDA));
+    HAL_SET(USI_DDR, 1 << USI_SCL);
+    HAL_CLEAR(USI_DDR, 1 << USI_SDA);
+
+    HAL_WRITE(USIDR, 0xFF);
+    HAL_WRITE(USICR, USICR_WAIT);
+    HAL_WRITE(USISR, USISR_CLEAR);
+}
+
+HAL_ISR(USI_STR_vect) {
+    state = USI_ADDRESS;
+    pos = 0;
+    HAL_CLEAR(USI_DDR, 1 << USI_SDA);
+
+    // The START is complete once SCL is low; SDA high again means it was a STOP
+    uint8_t pins;
+    while (((pins = HAL_READ(USI_PIN)) & (1 << USI_SCL)) && !(pins & (1 << USI_SDA))) { }
+
+    HAL_WRITE(USICR, (pins & (1 << USI_SDA)) ? USICR_WAIT : USICR_ACTIVE);
+    HAL_WRITE(USISR, USISR_BYTE);
+}
+
+HAL_ISR(USI_OVF_vect) {
+    switch (state) {
+    case USI_ADDRESS: {
+        uint8_t a = HAL_READ(USIDR);
+        if ((a >> 1) != own_addr) {
+            wait_for_start();
+            return;
+        }
+        state = (a & 1) ? USI_SEND : USI_RECV;
+        send_ack();
+        break;
+    }
+
+    case USI_SEND_ACKED:
+        if (HAL_READ(USIDR) & 1) {      // NACK: the master has what it wanted
+            wait_for_start();
+            return;
+        }
+        // fall through
+    case USI_SEND:
+        HAL_WRITE(USIDR, on_tx(pos));
+        if (pos < 0xFF) pos++;
+        HAL_SET(USI_DDR, 1 << USI_SDA);
+        HAL_WRITE(USISR, USISR_BYTE);
+        state = USI_SEND_DONE;
+        break;
+
+    case USI_SEND_DONE:
+        HAL_WRITE(USIDR, 0);
+        HAL_CLEAR(USI_DDR, 1 << USI_SDA);
+        HAL_WRITE(USISR, USISR_BIT);
+        state = USI_SEND_ACKED;
+        break;
+
+    case USI_RECV:
+        HAL_CLEAR(USI_DDR, 1 << USI_SDA);
+        HAL_WRITE(USISR, USISR_BYTE);
+        state = USI_RECV_DONE;
+        break;
+
+    case USI_RECV_DONE:
+        on_rx(pos, HAL_READ(USIDR));
+        if (pos < 0xFF) pos++;
+        state = USI_RECV;
+        send_ack();
+        break;
+    }
+}
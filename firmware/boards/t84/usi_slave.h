@@ -0,0 +1,56 @@
+/**
+ * @file usi_slave.h
+ * @brief I2C slave on the USI in two-wire mode (ATtiny84), after Atmel AVR312.
+ *
+ * The start condition detector runs without the CPU clock, so USI_STR_vect
+ * wakes the CPU from every sleep mode; SCL is held low until the handler
+ * has cleared the flag, and after each counter overflow until the next
+ * byte or ACK bit is set up, so the master simply waits for a slave that
+ * was asleep.
+ *
+ * The R/W bit of the address byte decides the direction of the whole
+ * transaction. In a read (master receives) the bytes come from the tx
+ * callback, indexed from the START, until the master NACKs. In a write
+ * every received byte goes to the rx callback with its index. Bytes the
+ * slave shifts out are never handed to rx, so block data that happens to
+ * equal a command byte cannot act as one.
+ *
+ * Both callbacks run in the USI interrupt. Built with hal.h, so the host
+ * tests drive it through hal/host/sim_usi.h.
+ */
+
+#ifndef USI_SLAVE_H
+#define USI_SLAVE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* USI pins of the ATtiny84: SCL = USCK = PA4, SDA = DI = PA6 */
+#define USI_DDR     DDRA
+#define USI_PORT    PORTA
+#define USI_PIN     PINA
+#define USI_SCL     PA4
+#define USI_SDA     PA6
+
+/** Byte to send at index (0 = first byte after the address). */
+typedef uint8_t (*usi_tx_fn)(uint8_t index);
+
+/** Byte received at index (0 = first byte after the address). */
+typedef void (*usi_rx_fn)(uint8_t index, uint8_t b);
+
+/**
+ * @brief Release both lines and wait for a START.
+ * @param addr 7-bit slave address.
+ * @param tx   Bytes for read transactions.
+ * @param rx   Bytes of write transactions.
+ */
+void usi_slave_init(uint8_t addr, usi_tx_fn tx, usi_rx_fn rx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USI_SLAVE_H */
@@ -2,27 +2,33 @@
  * @file i2c.c
  * @brief I²C/TWI implementation for AVR (blocking).
  *
- * Uses hardware TWI registers (TWBR, TWCR, TWDR, etc.).
+ * Uses hardware TWI registers (TWBR, TWCR, TWDR, etc.) through hal.h.
  */
 
-#include <avr/io.h>
+#include "../hal/hal.h"
 #include "i2c.h"
 
 void I2C_init(void) {
-    TWSR = 0x00;          // Prescaler = 1
-    TWBR = 32;            // Bit rate (adjust for F_CPU)
-    TWCR = (1 << TWEN);   // Enable TWI
+    HAL_WRITE(TWSR, 0x00);          // Prescaler = 1
+    I2C_set_clock(F_CPU); // Bit rate
+    HAL_WRITE(TWCR, (1 << TWEN));   // Enable TWI
+}
+
+void I2C_set_clock(uint32_t cpu_hz) {
+    // SCL = cpu_hz / (16 + 2 * TWBR)
+    uint32_t div = cpu_hz / I2C_SCL_HZ;
+    HAL_WRITE(TWBR, (div > 16) ? (uint8_t)((div - 16) / 2) : 0);
 }
 
 void I2C_start(void) {
-    TWCR = (1 << TWSTA) | (1 << TWEN) | (1 << TWINT);
-    while (!(TWCR & (1 << TWINT)));  // Wait for START sent
+    HAL_WRITE(TWCR, (1 << TWSTA) | (1 << TWEN) | (1 << TWINT));
+    while (!(HAL_READ(TWCR) & (1 << TWINT)));  // Wait for START sent
 }
 
 void I2C_write(uint8_t data) {
-    TWDR = data;
-    TWCR = (1 << TWEN) | (1 << TWINT);
-    while (!(TWCR & (1 << TWINT)));  // Wait for transmission complete
+    HAL_WRITE(TWDR, data);
+    HAL_WRITE(TWCR, (1 << TWEN) | (1 << TWINT));
+    while (!(HAL_READ(TWCR) & (1 << TWINT)));  // Wait for transmission complete
 }
 
 void I2C_start_with_address(uint8_t address, uint8_t read) {
@@ -31,17 +37,17 @@ void I2C_start_with_address(uint8_t address, uint8_t read) {
 }
 
 void I2C_stop(void) {
-    TWCR = (1 << TWSTO) | (1 << TWEN) | (1 << TWINT);
+    HAL_WRITE(TWCR, (1 << TWSTO) | (1 << TWEN) | (1 << TWINT));
 }
 
 uint8_t I2C_read_ack(void) {
-    TWCR = (1 << TWEN) | (1 << TWINT) | (1 << TWEA);
-    while (!(TWCR & (1 << TWINT)));
-    return TWDR;
+    HAL_WRITE(TWCR, (1 << TWEN) | (1 << TWINT) | (1 << TWEA));
+    while (!(HAL_READ(TWCR) & (1 << TWINT)));
+    return HAL_READ(TWDR);
 }
 
 uint8_t I2C_read_nack(void) {
-    TWCR = (1 << TWEN) | (1 << TWINT);
-    while (!(TWCR & (1 << TWINT)));
-    return TWDR;
+    HAL_WRITE(TWCR, (1 << TWEN) | (1 << TWINT));
+    while (!(HAL_READ(TWCR) & (1 << TWINT)));
+    return HAL_READ(TWDR);
 }
@@ -16,13 +16,25 @@
 extern "C" {
 #endif
 
+/** @brief Target SCL frequency (TWBR = 32 at F_CPU = 16 MHz). */
+#ifndef I2C_SCL_HZ
+#define I2C_SCL_HZ 200000UL
+#endif
+
 /**
  * @brief Initialize I²C (TWI) hardware.
  *
- * Prescaler set to 1, bit rate default corresponds to ~100 kHz at F_CPU=16 MHz.
+ * Prescaler set to 1, bit rate for I2C_SCL_HZ at F_CPU.
  */
 void I2C_init(void);
 
+/**
+ * @brief Recompute TWBR for a new CPU clock (see clock.h).
+ *
+ * Below 16 * I2C_SCL_HZ the TWI runs at its fastest, cpu_hz / 16.
+ */
+void I2C_set_clock(uint32_t cpu_hz);
+
 /**
  * @brief Send START condition.
  */
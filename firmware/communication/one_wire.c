@@ -3,40 +3,41 @@
  * @brief 1-Wire bus implementation for AVR.
  *
  * Bit-banging with busy-wait delays. Timing follows DS18B20 datasheet.
+ * Pin and delay access go through hal.h.
  */
 
 #include "one_wire.h"
 
 void one_wire_setOutput(void) {
-    ONE_WIRE_DDR |= (1 << ONE_WIRE_PIN);
+    HAL_SET(ONE_WIRE_DDR, 1 << ONE_WIRE_PIN);
 }
 
 void one_wire_setInput(void) {
-    ONE_WIRE_DDR &= ~(1 << ONE_WIRE_PIN);
+    HAL_CLEAR(ONE_WIRE_DDR, 1 << ONE_WIRE_PIN);
 }
 
 void one_wire_pullLow(void) {
-    ONE_WIRE_PORT &= ~(1 << ONE_WIRE_PIN);
+    HAL_CLEAR(ONE_WIRE_PORT, 1 << ONE_WIRE_PIN);
 }
 
 void one_wire_release(void) {
-    ONE_WIRE_PORT |= (1 << ONE_WIRE_PIN);
+    HAL_SET(ONE_WIRE_PORT, 1 << ONE_WIRE_PIN);
 }
 
 uint8_t one_wire_readPin(void) {
-    return (ONE_WIRE_PIN_REG & (1 << ONE_WIRE_PIN));
+    return (HAL_READ(ONE_WIRE_PIN_REG) & (1 << ONE_WIRE_PIN));
 }
 
 uint8_t one_wire_reset(void) {
     one_wire_setOutput();
     one_wire_pullLow();
-    _delay_us(480);          // reset pulse
+    HAL_DELAY_US(480);          // reset pulse
     one_wire_release();
     one_wire_setInput();
 
-    _delay_us(70);           // wait for presence
+    HAL_DELAY_US(70);           // wait for presence
     uint8_t presence = !one_wire_readPin();
-    _delay_us(410);          // finish timeslot
+    HAL_DELAY_US(410);          // finish timeslot
 
     return presence;
 }
@@ -44,25 +45,25 @@ uint8_t one_wire_reset(void) {
 void one_wire_writeBit(uint8_t bit) {
     one_wire_setOutput();
     one_wire_pullLow();
-    _delay_us(2);
+    HAL_DELAY_US(2);
 
     if (bit) one_wire_release(); // release early for '1'
 
-    _delay_us(60);
+    HAL_DELAY_US(60);
     one_wire_release();
 }
 
 uint8_t one_wire_readBit(void) {
     one_wire_setOutput();
     one_wire_pullLow();
-    _delay_us(2);
+    HAL_DELAY_US(2);
 
     one_wire_release();
     one_wire_setInput();
-    _delay_us(10);
+    HAL_DELAY_US(10);
 
     uint8_t bit = one_wire_readPin();
-    _delay_us(50);
+    HAL_DELAY_US(50);
 
     return bit;
 }
@@ -3,14 +3,15 @@
  * @brief Low-level bit-banging driver for 1-Wire bus (AVR).
  *
  * Provides basic reset, bit and byte read/write functions.
- * Uses busy-wait delays to generate timing.
+ * Uses busy-wait delays to generate timing. Builds for the AVR or,
+ * against the simulated bus of hal/host, natively.
  */
 
 #ifndef ONE_WIRE_H
 #define ONE_WIRE_H
 
-#include <avr/io.h>
-#include <util/delay.h>
+#include <stdint.h>
+#include "../hal/hal.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -2,59 +2,171 @@
  * @file uart_isr.c
  * @brief AVR UART driver with RX interrupt and ring buffer.
  *
- * RX handled in ISR, data stored in uart_rx ring buffer.
- * TX functions are blocking.
+ * RX handled in ISR, data stored in the uart_rx ring buffer
+ * (uart_ring_*, see spsc_ring.h). TX functions are blocking.
  */
 
 #include "uart_isr.h"
 
 /* Global ring buffer instance */
-uart_rx_ring_t uart_rx = { .head=0, .tail=0, .err_fe=0, .err_dor=0, .err_upe=0 };
+uart_rx_ring_t uart_rx = { .ring = { .head=0, .tail=0, .dropped=0, .high_water=0 }, .err_fe=0, .err_dor=0, .err_upe=0 };
+
+/* TXC0 is only meaningful once something was sent */
+static volatile uint8_t tx_used = 0;
+
+static volatile uint8_t flow = 0;
+
+/* Traffic counters, main context only (the RX ISR stays as short as it was) */
+static uint32_t tx_total = 0;
+static uint32_t rx_total = 0;
+
+/* TX gives up waiting for CTS after this many polls (tens of ms), a dead peer must not hang the CPU */
+#define CTS_SPIN_MAX 0xFFFF
+
+/* Bytes dropped on a CTS timeout since UART_tx_clear_dropped(), main context only */
+static uint16_t tx_dropped = 0;
+
+static inline uint8_t rx_fill(void) {
+    return uart_ring_count(&uart_rx.ring);
+}
+
+static inline uint8_t cts_off(void) {
+    return HAL_READ(UART_CTS_PIN_REG) & (1 << UART_CTS_PIN);
+}
+
+static inline void rts_assert(void)   { HAL_CLEAR(UART_RTS_PORT, 1 << UART_RTS_PIN); }
+static inline void rts_deassert(void) { HAL_SET(UART_RTS_PORT, 1 << UART_RTS_PIN); }
 
 void UART_init_ISR(unsigned int ubrr) {
-    UCSR0A |= (1 << U2X0); // enable double speed mode
+    HAL_SET(UCSR0A, 1 << U2X0); // enable double speed mode
 
-    UBRR0H = (unsigned char)(ubrr >> 8);
-    UBRR0L = (unsigned char)ubrr;
+    UART_set_ubrr(ubrr);
 
-    UCSR0B = (1 << RXEN0) | (1 << TXEN0) | (1 << RXCIE0); // RX/TX + RX interrupt
-    UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);             // 8N1
+    HAL_WRITE(UCSR0B, (1 << RXEN0) | (1 << TXEN0) | (1 << RXCIE0)); // RX/TX + RX interrupt
+    HAL_WRITE(UCSR0C, (1 << UCSZ01) | (1 << UCSZ00)); // 8N1
+}
+
+uint16_t UART_ubrr_for(uint32_t hz, uint32_t baud, uint16_t *err_permil) {
+    // U2X: baud = hz / (8 * (UBRR + 1)), rounded divisor
+    uint32_t n = (hz + 4 * baud) / (8 * baud);
+    if (n == 0) n = 1;
+
+    if (err_permil) {
+        uint32_t actual = hz / (8 * n);
+        uint32_t err = (actual > baud) ? actual - baud : baud - actual;
+        *err_permil = (uint16_t)(err * 1000UL / baud);
+    }
+    return (uint16_t)(n - 1);
+}
+
+void UART_set_flow_control(uint8_t on) {
+    if (on) {
+        HAL_CLEAR(UART_CTS_DDR, 1 << UART_CTS_PIN);
+        HAL_SET(UART_CTS_PORT, 1 << UART_CTS_PIN); // pull-up: missing peer = stop
+        HAL_SET(UART_RTS_DDR, 1 << UART_RTS_PIN);
+        if (rx_fill() >= UART_RTS_HIGH) rts_deassert(); else rts_assert();
+    } else {
+        rts_assert();
+    }
+    flow = on;
+}
+
+void UART_clear_counters(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        uart_ring_clear_stats(&uart_rx.ring);
+    }
+}
+
+uint16_t UART_rx_dropped(void) {
+    uint16_t d;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {     // 16-bit counter of USART_RX_vect
+        d = uart_rx.ring.dropped;
+    }
+    return d;
+}
+
+void UART_set_ubrr(unsigned int ubrr) {
+    HAL_WRITE(UBRR0H, (unsigned char)(ubrr >> 8));
+    HAL_WRITE(UBRR0L, (unsigned char)ubrr);
+}
+
+uint8_t UART_tx_idle(void) {
+    if (!(HAL_READ(UCSR0A) & (1<<UDRE0))) return 0; // byte still waiting in UDR0
+    return !tx_used || (HAL_READ(UCSR0A) & (1<<TXC0)); // shift register empty
 }
 
 /* RX interrupt service routine */
-ISR(USART_RX_vect) {
-    uint8_t status = UCSR0A;
-    uint8_t data   = UDR0;
+HAL_ISR(USART_RX_vect) {
+    uint8_t status = HAL_READ(UCSR0A);
+    uint8_t data   = HAL_READ(UDR0);
 
     /* Record error flags */
     if (status & (1<<FE0))  uart_rx.err_fe++;
     if (status & (1<<DOR0)) uart_rx.err_dor++;
     if (status & (1<<UPE0)) uart_rx.err_upe++;
 
-    uint8_t next = (uart_rx.head + 1) % RX_BUF_SZ;
-    if (next != uart_rx.tail) { // not full
-        uart_rx.buf[uart_rx.head] = data;
-        uart_rx.head = next;
-    } else {
-        // overflow: could increment separate counter if needed
-    }
+    // Full: dropped and counted by the ring
+    if (uart_ring_push(&uart_rx.ring, data) && flow && rx_fill() >= UART_RTS_HIGH) rts_deassert();
 }
 
 uint8_t UART_data_available(void) {
-    return (uart_rx.head != uart_rx.tail);
+    return !uart_ring_empty(&uart_rx.ring);
 }
 
 int16_t UART_receive(void) {
-    if (uart_rx.head == uart_rx.tail) return -1;
+    uint8_t c;
+    if (!uart_ring_pop(&uart_rx.ring, &c)) return -1;
+    rx_total++;
 
-    uint8_t c = uart_rx.buf[uart_rx.tail];
-    uart_rx.tail = (uart_rx.tail + 1) % RX_BUF_SZ;
+    // Resume the peer only with room for a burst, not on every byte
+    if (flow && rx_fill() <= UART_RTS_LOW) rts_assert();
     return c;
 }
 
+uint8_t UART_rx_span(const uint8_t **data) {
+    return uart_ring_read_span(&uart_rx.ring, data);
+}
+
+void UART_rx_consume(uint8_t n) {
+    uart_ring_consume(&uart_rx.ring, n);
+    rx_total += n;
+
+    if (flow && rx_fill() <= UART_RTS_LOW) rts_assert();
+}
+
 void UART_send(char c) {
-    while(!(UCSR0A & (1<<UDRE0))); // wait until TX buffer empty
-    UDR0 = (uint8_t)c;
+    if (flow) {
+        // Once a byte was dropped the peer is stalled: no more full waits
+        uint16_t spin = tx_dropped ? 1 : CTS_SPIN_MAX;
+        while (cts_off() && --spin); // peer not ready
+
+        // Sending anyway would overrun it; the caller sees the count and aborts
+        if (cts_off()) {
+            if (tx_dropped != 0xFFFF) tx_dropped++;
+            return;
+        }
+    }
+    while(!(HAL_READ(UCSR0A) & (1<<UDRE0))); // wait until TX buffer empty
+    HAL_SET(UCSR0A, 1<<TXC0);      // clear "transmit complete" (write one)
+    tx_used = 1;
+    tx_total++;
+    HAL_WRITE(UDR0, (uint8_t)c);
+}
+
+uint16_t UART_tx_dropped(void) {
+    return tx_dropped;
+}
+
+void UART_tx_clear_dropped(void) {
+    tx_dropped = 0;
+}
+
+uint32_t UART_tx_total(void) {
+    return tx_total;
+}
+
+uint32_t UART_rx_total(void) {
+    return rx_total;
 }
 
 void UART_send_string(const char* s) {
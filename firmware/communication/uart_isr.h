@@ -2,16 +2,27 @@
  * @file uart_isr.h
  * @brief UART driver with RX interrupt and ring buffer (AVR).
  *
- * Provides interrupt-driven RX (256-byte ring buffer) and
- * blocking TX. Error counters are kept in the ring buffer struct.
+ * Provides interrupt-driven RX (256-byte SPSC ring, spsc_ring.h) and
+ * blocking TX. Error counters are kept next to the ring; the ring itself
+ * counts bytes dropped on a full buffer and its high-water mark.
+ *
+ * Bytes are taken one at a time (UART_receive()) or parsed in place
+ * (UART_rx_span() / UART_rx_consume()), which saves copying bulk data
+ * such as HTTP bodies out of the ring first.
+ *
+ * Optional RTS/CTS flow control (UART_set_flow_control()): RTS is
+ * deasserted when the ring fills up to UART_RTS_HIGH and asserted again
+ * once the reader has drained it to UART_RTS_LOW; TX waits while the
+ * peer holds CTS deasserted. Both lines are active low and driven in
+ * software, the ATmega328P USART has no hardware handshake.
  */
 
 #ifndef UART_ISR_H
 #define UART_ISR_H
 
-#include <avr/io.h>
-#include <avr/interrupt.h>
 #include <stdint.h>
+#include "../hal/hal.h"
+#include "../system/spsc_ring.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,11 +34,50 @@ extern "C" {
 /** RX buffer size in bytes. */
 #define RX_BUF_SZ 256
 
-/** RX ring buffer structure with error counters. */
+/* --- Flow control pins (override with -D) --- */
+#ifndef UART_RTS_PIN
+#define UART_RTS_PIN PD7
+#endif
+
+#ifndef UART_RTS_PORT
+#define UART_RTS_PORT PORTD
+#endif
+
+#ifndef UART_RTS_DDR
+#define UART_RTS_DDR DDRD
+#endif
+
+#ifndef UART_CTS_PIN
+#define UART_CTS_PIN PB2
+#endif
+
+#ifndef UART_CTS_PORT
+#define UART_CTS_PORT PORTB
+#endif
+
+#ifndef UART_CTS_PIN_REG
+#define UART_CTS_PIN_REG PINB
+#endif
+
+#ifndef UART_CTS_DDR
+#define UART_CTS_DDR DDRB
+#endif
+
+/** Fill level that deasserts RTS. The headroom covers what the peer still sends after seeing it. */
+#ifndef UART_RTS_HIGH
+#define UART_RTS_HIGH (RX_BUF_SZ - 48)
+#endif
+
+/** Fill level that asserts RTS again. */
+#ifndef UART_RTS_LOW
+#define UART_RTS_LOW (RX_BUF_SZ / 4)
+#endif
+
+SPSC_RING(uart_ring, uint8_t, RX_BUF_SZ)
+
+/** RX ring buffer with error counters. */
 typedef struct {
-    volatile uint8_t buf[RX_BUF_SZ];
-    volatile uint8_t head;
-    volatile uint8_t tail;
+    uart_ring_t ring;           /**< Received bytes; ring.dropped counts bytes lost on a full buffer */
     volatile uint16_t err_fe;   /**< Frame error counter */
     volatile uint16_t err_dor;  /**< Data overrun counter */
     volatile uint16_t err_upe;  /**< Parity error counter */
@@ -42,6 +92,70 @@ extern uart_rx_ring_t uart_rx;
  */
 void UART_init_ISR(unsigned int ubrr);
 
+/**
+ * @brief Change the baud divisor (e.g. after a CPU clock change).
+ * @param ubrr New value for UBRR0 (U2X stays enabled).
+ */
+void UART_set_ubrr(unsigned int ubrr);
+
+/**
+ * @brief Divisor for a baud rate at a CPU frequency (U2X).
+ * @param hz         CPU frequency.
+ * @param baud       Wanted baud rate.
+ * @param err_permil Out: baud rate error in 1/1000 (may be NULL).
+ * @return UBRR0 value.
+ */
+uint16_t UART_ubrr_for(uint32_t hz, uint32_t baud, uint16_t *err_permil);
+
+/**
+ * @brief Switch RTS/CTS flow control on or off.
+ *
+ * On: RTS is driven (asserted unless the buffer is above UART_RTS_HIGH)
+ * and CTS is read with a pull-up, so an unconnected line stalls TX.
+ * Off: RTS stays asserted and CTS is ignored.
+ */
+void UART_set_flow_control(uint8_t on);
+
+/**
+ * @brief Zero ring.dropped and ring.high_water (start of a measured transfer).
+ */
+void UART_clear_counters(void);
+
+/**
+ * @brief ring.dropped read with the RX interrupt held off.
+ */
+uint16_t UART_rx_dropped(void);
+
+/**
+ * @brief Bytes UART_send() dropped since UART_tx_clear_dropped() because
+ *        CTS stayed off past the spin limit (flow control on). After the
+ *        first one, bytes are dropped without the full wait; a command
+ *        with drops is corrupt and the caller must abort it.
+ */
+uint16_t UART_tx_dropped(void);
+
+/**
+ * @brief Zero the dropped count (start of the next command).
+ */
+void UART_tx_clear_dropped(void);
+
+/**
+ * @brief Bytes sent since reset (wraps), for per-session traffic deltas.
+ */
+uint32_t UART_tx_total(void);
+
+/**
+ * @brief Bytes taken out of the RX buffer since reset (wraps). Dropped
+ *        bytes are counted in ring.dropped instead.
+ */
+uint32_t UART_rx_total(void);
+
+/**
+ * @brief Check that the transmitter has shifted out its last byte.
+ * @return Non-zero if nothing is being sent.
+ */
+uint8_t UART_tx_idle(void);
+
 /**
  * @brief Check if RX buffer has data.
  * @return Non-zero if data available.
@@ -55,7 +169,20 @@ uint8_t UART_data_available(void);
 int16_t UART_receive(void);
 
 /**
- * @brief Send one character (blocking).
+ * @brief Received bytes that can be read in place, up to the ring's wrap.
+ * @param data Out: first byte, valid until UART_rx_consume().
+ * @return Contiguous bytes available (0 if empty; more may follow the wrap).
+ */
+uint8_t UART_rx_span(const uint8_t **data);
+
+/**
+ * @brief Release n bytes of the span from UART_rx_span().
+ */
+void UART_rx_consume(uint8_t n);
+
+/**
+ * @brief Send one character (blocking). With flow control on, a byte CTS
+ *        holds off past the spin limit is dropped (UART_tx_dropped()).
  */
 void UART_send(char c);
 
@@ -0,0 +1,39 @@
+/**
+ * @file hal.h
+ * @brief Register access, delays and ISR definitions for the drivers, on the AVR or on a host.
+ *
+ * Drivers include this instead of <avr/io.h> and <util/delay.h> and go
+ * through the macros below for every register they touch. Built for the
+ * AVR (avr-gcc defines __AVR__) they are the plain register expressions,
+ * so the generated code is the same as before. Built natively, the
+ * host backend (host/hal_host.h) keeps the registers in variables and
+ * passes each access to simulated peripherals: TWI slaves, a 1-Wire bus
+ * and a UART byte stream. Delays advance a virtual clock instead of
+ * spinning, so timing is measured, not waited for.
+ *
+ *   HAL_WRITE(reg, v)   reg = v
+ *   HAL_READ(reg)       value of reg
+ *   HAL_SET(reg, mask)  reg |= mask
+ *   HAL_CLEAR(reg, mask) reg &= ~mask
+ *   HAL_DELAY_US(us), HAL_DELAY_MS(ms)   busy waits (compile-time constants)
+ *   HAL_DELAY_LOOP4(n)  busy wait of n 4-cycle iterations (run-time n, any
+ *                       CPU clock divider)
+ *   HAL_WDT_RESET()     watchdog reset
+ *   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)   as in <util/atomic.h>
+ *   HAL_ISR(vector)     interrupt handler; on the host a plain function
+ *                       the simulator calls
+ *
+ * Registers are named as in <avr/io.h>; the host backend provides the
+ * ones of the ATmega328P that the drivers use.
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+#if defined(__AVR__)
+#include "hal_avr.h"
+#else
+#include "host/hal_host.h"
+#endif
+
+#endif /* HAL_H */
@@ -0,0 +1,28 @@
+/**
+ * @file hal_avr.h
+ * @brief AVR backend of hal.h: direct register access, avr-libc delays and ISR().
+ */
+
+#ifndef HAL_AVR_H
+#define HAL_AVR_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/wdt.h>
+#include <util/atomic.h>
+#include <util/delay.h>
+#include <util/delay_basic.h>
+
+#define HAL_WRITE(reg, v)       ((reg) = (v))
+#define HAL_READ(reg)           (reg)
+#define HAL_SET(reg, mask)      ((reg) |= (mask))
+#define HAL_CLEAR(reg, mask)    ((reg) &= ~(mask))
+
+#define HAL_DELAY_US(us)        _delay_us(us)
+#define HAL_DELAY_MS(ms)        _delay_ms(ms)
+#define HAL_DELAY_LOOP4(n)      _delay_loop_2(n)
+#define HAL_WDT_RESET()         wdt_reset()
+
+#define HAL_ISR(vector)         ISR(vector)
+
+#endif /* HAL_AVR_H */
@@ -0,0 +1,92 @@
+/**
+ * @file hal_host.c
+ * @brief Register storage, hook dispatch, the virtual clock and the CPU clock prescaler.
+ */
+
+#include <stddef.h>
+#include "hal_host.h"
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+volatile uint8_t TWBR, TWSR, TWAR, TWDR, TWCR;
+volatile uint8_t UCSR0A, UCSR0B, UCSR0C, UBRR0H, UBRR0L, UDR0;
+volatile uint8_t PINB, DDRB, PORTB, PINC, DDRC, PORTC, PIND, DDRD, PORTD;
+volatile uint8_t USICR, USISR, USIDR, PINA, DDRA, PORTA;
+volatile uint8_t CLKPR;
+
+volatile bool hal_host_irq_on;
+
+#define MAX_HOOKS 16
+
+typedef struct {
+    volatile uint8_t *reg;
+    hal_write_hook on_write;
+    hal_read_hook on_read;
+    void *ctx;
+} hook_t;
+
+static hook_t hooks[MAX_HOOKS];
+static uint8_t n_hooks;
+static uint64_t now_ns;
+static uint8_t clk_div;
+static bool clk_change;
+
+static volatile uint8_t *const REGS[] = {
+    &TWBR, &TWSR, &TWAR, &TWDR, &TWCR,
+    &UCSR0A, &UCSR0B, &UCSR0C, &UBRR0H, &UBRR0L, &UDR0,
+    &PINB, &DDRB, &PORTB, &PINC, &DDRC, &PORTC, &PIND, &DDRD, &PORTD,
+    &USICR, &USISR, &USIDR, &PINA, &DDRA, &PORTA,
+    &CLKPR,
+};
+
+void hal_host_write(volatile uint8_t *reg, uint8_t v) {
+    uint8_t old = *reg;
+
+    *reg = v;
+    if (reg == &CLKPR) {
+        // Timed sequence: CLKPCE, then the divider with CLKPCE clear
+        if (!(v & (1 << CLKPCE)) && clk_change) clk_div = v & 0x0F;
+        clk_change = (v & (1 << CLKPCE)) != 0;
+    }
+    for (uint8_t i = 0; i < n_hooks; i++) {
+        if (hooks[i].reg == reg && hooks[i].on_write) hooks[i].on_write(reg, old, hooks[i].ctx);
+    }
+}
+
+uint8_t hal_host_read(volatile uint8_t *reg) {
+    uint8_t v = *reg;
+
+    for (uint8_t i = 0; i < n_hooks; i++) {
+        if (hooks[i].reg == reg && hooks[i].on_read) v = hooks[i].on_read(reg, v, hooks[i].ctx);
+    }
+    return v;
+}
+
+bool hal_host_hook(volatile uint8_t *reg, hal_write_hook on_write, hal_read_hook on_read, void *ctx) {
+    if (n_hooks == MAX_HOOKS) return false;
+    hooks[n_hooks++] = (hook_t){ reg, on_write, on_read, ctx };
+    return true;
+}
+
+void hal_host_reset(void) {
+    for (size_t i = 0; i < sizeof(REGS) / sizeof(REGS[0]); i++) *REGS[i] = 0;
+    n_hooks = 0;
+    now_ns = 0;
+    clk_div = 0;
+    clk_change = false;
+    hal_host_irq_on = false;
+}
+
+uint32_t hal_host_cpu_hz(void) {
+    return (uint32_t)(F_CPU >> clk_div);
+}
+
+uint64_t hal_host_ns(void) {
+    return now_ns;
+}
+
+void hal_host_advance_ns(uint64_t ns) {
+    now_ns += ns;
+}
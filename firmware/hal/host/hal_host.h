@@ -0,0 +1,176 @@
+/**
+ * @file hal_host.h
+ * @brief Host backend of hal.h: ATmega328P registers as variables, access hooks, virtual time.
+ *
+ * Every HAL_WRITE/HAL_SET/HAL_CLEAR stores the new value and then calls
+ * the write hooks of that register; every HAL_READ passes the stored
+ * value through its read hooks. Simulated peripherals (sim_twi.h,
+ * sim_onewire.h, sim_uart.h) hook the registers they model; registers
+ * without hooks behave as plain memory.
+ *
+ * Delays do not spin: they advance a virtual clock in nanoseconds, which
+ * the bus models use for their timing (a 1-Wire slot, the TWI bit rate)
+ * and which tests read back as the bus time of an operation. CLKPR is
+ * modelled: a divider written after CLKPCE slows HAL_DELAY_LOOP4.
+ */
+
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* --- Registers (ATmega328P names, plus the ATtiny84 USI and port A) --- */
+extern volatile uint8_t TWBR, TWSR, TWAR, TWDR, TWCR;
+extern volatile uint8_t UCSR0A, UCSR0B, UCSR0C, UBRR0H, UBRR0L, UDR0;
+extern volatile uint8_t PINB, DDRB, PORTB, PINC, DDRC, PORTC, PIND, DDRD, PORTD;
+extern volatile uint8_t USICR, USISR, USIDR, PINA, DDRA, PORTA;
+extern volatile uint8_t CLKPR;
+
+/* TWCR */
+#define TWINT  7
+#define TWEA   6
+#define TWSTA  5
+#define TWSTO  4
+#define TWWC   3
+#define TWEN   2
+#define TWIE   0
+/* TWSR */
+#define TWPS1  1
+#define TWPS0  0
+
+/* UCSR0A */
+#define RXC0   7
+#define TXC0   6
+#define UDRE0  5
+#define FE0    4
+#define DOR0   3
+#define UPE0   2
+#define U2X0   1
+#define MPCM0  0
+/* UCSR0B */
+#define RXCIE0 7
+#define TXCIE0 6
+#define UDRIE0 5
+#define RXEN0  4
+#define TXEN0  3
+#define UCSZ02 2
+/* UCSR0C */
+#define UCSZ01 2
+#define UCSZ00 1
+
+/* CLKPR */
+#define CLKPCE 7
+
+/* USICR */
+#define USISIE 7
+#define USIOIE 6
+#define USIWM1 5
+#define USIWM0 4
+#define USICS1 3
+#define USICS0 2
+#define USICLK 1
+#define USITC  0
+/* USISR */
+#define USISIF 7
+#define USIOIF 6
+#define USIPF  5
+#define USIDC  4
+
+#define PA0 0
+#define PA1 1
+#define PA2 2
+#define PA3 3
+#define PA4 4
+#define PA5 5
+#define PA6 6
+#define PA7 7
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+/* --- Access --- */
+
+/** Called after reg was written; old is the value before. */
+typedef void (*hal_write_hook)(volatile uint8_t *reg, uint8_t old, void *ctx);
+
+/** Called on a read; returns value with the hook's bits filled in. */
+typedef uint8_t (*hal_read_hook)(volatile uint8_t *reg, uint8_t value, void *ctx);
+
+void    hal_host_write(volatile uint8_t *reg, uint8_t v);
+uint8_t hal_host_read(volatile uint8_t *reg);
+
+/**
+ * @brief Attach hooks to a register (either may be NULL); several may share one.
+ * @return false if the hook table is full.
+ */
+bool hal_host_hook(volatile uint8_t *reg, hal_write_hook on_write, hal_read_hook on_read, void *ctx);
+
+/**
+ * @brief All registers to 0, hooks removed, clock to 0, interrupts off.
+ */
+void hal_host_reset(void);
+
+#define HAL_WRITE(reg, v)       hal_host_write(&(reg), (uint8_t)(v))
+#define HAL_READ(reg)           hal_host_read(&(reg))
+#define HAL_SET(reg, mask)      hal_host_write(&(reg), (uint8_t)((reg) | (mask)))
+#define HAL_CLEAR(reg, mask)    hal_host_write(&(reg), (uint8_t)((reg) & ~(mask)))
+
+/* --- Virtual time --- */
+
+uint64_t hal_host_ns(void);
+void     hal_host_advance_ns(uint64_t ns);
+
+#define HAL_DELAY_US(us)        hal_host_advance_ns((uint64_t)((us) * 1000.0))
+#define HAL_DELAY_MS(ms)        hal_host_advance_ns((uint64_t)((ms) * 1000000.0))
+#define HAL_DELAY_LOOP4(n)      hal_host_advance_ns(4000000000ULL * (n) / hal_host_cpu_hz())
+#define HAL_WDT_RESET()         ((void)0)
+
+/**
+ * @brief CPU clock: F_CPU (16 MHz if undefined) divided as the last
+ *        CLKPCE-then-divider write sequence to CLKPR set it.
+ */
+uint32_t hal_host_cpu_hz(void);
+
+/* --- Interrupts --- */
+
+/** Global interrupt flag (SREG I); the models deliver only while it is set. */
+extern volatile bool hal_host_irq_on;
+
+#define HAL_ISR(vector)         void vector(void)
+#define sei()                   (hal_host_irq_on = true)
+#define cli()                   (hal_host_irq_on = false)
+
+/* <util/atomic.h>: the interrupt flag is off inside and restored after */
+#define ATOMIC_RESTORESTATE     0
+#define ATOMIC_BLOCK(type)      for (bool hal_irq_ = hal_host_irq_on, hal_once_ = (cli(), true); \
+                                     hal_once_; hal_host_irq_on = hal_irq_, hal_once_ = false)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_HOST_H */
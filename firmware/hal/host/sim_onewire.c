@@ -0,0 +1,141 @@
+/**
+ * @file sim_onewire.c
+ * @brief 1-Wire slot timing and the DS18B20 command set.
+ */
+
+#include <string.h>
+#include "hal_host.h"
+#include "sim_onewire.h"
+
+#define US 1000ULL
+
+enum { ST_IDLE, ST_ROM, ST_FUNCTION, ST_SENDING };
+
+uint8_t sim_onewire_crc8(const uint8_t *data, uint8_t len) {
+    uint8_t crc = 0;
+
+    while (len--) {
+        uint8_t b = *data++;
+        for (uint8_t i = 0; i < 8; i++) {
+            uint8_t mix = (crc ^ b) & 1;
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            b >>= 1;
+        }
+    }
+    return crc;
+}
+
+static void fill_scratchpad(sim_onewire_t *w) {
+    bool ready = w->conversions && hal_host_ns() >= w->conv_done_ns;
+    int16_t t = ready ? w->temp_raw : 0x0550;       /* 85 °C: power-on value */
+
+    if (w->conversions && !ready) w->early_reads++;
+    w->scratch[0] = (uint8_t)t;
+    w->scratch[1] = (uint8_t)((uint16_t)t >> 8);
+    w->scratch[2] = 0x4B;                           /* TH */
+    w->scratch[3] = 0x46;                           /* TL */
+    w->scratch[4] = 0x7F;                           /* 12 bit */
+    w->scratch[5] = 0xFF;
+    w->scratch[6] = 0x0C;
+    w->scratch[7] = 0x10;
+    w->scratch[8] = sim_onewire_crc8(w->scratch, 8);
+}
+
+static void command(sim_onewire_t *w, uint8_t cmd) {
+    if (w->state == ST_ROM) {
+        w->state = (cmd == 0xCC) ? ST_FUNCTION : ST_IDLE;   /* only Skip ROM */
+        return;
+    }
+    switch (cmd) {
+    case 0x44:
+        w->conversions++;
+        w->conv_done_ns = hal_host_ns() + w->conv_ms * 1000000ULL;
+        w->state = ST_IDLE;
+        break;
+    case 0xBE:
+        fill_scratchpad(w);
+        w->tx_pos = 0;
+        w->state = ST_SENDING;
+        break;
+    default:
+        w->state = ST_IDLE;
+        break;
+    }
+}
+
+static bool driving_low(const sim_onewire_t *w) {
+    return (*w->ddr & (1 << w->bit)) && !(*w->port & (1 << w->bit));
+}
+
+/* Master pulled the line low: a slot or a reset begins */
+static void falling(sim_onewire_t *w, uint64_t now) {
+    w->fall_ns = now;
+    if (w->state == ST_SENDING && w->tx_pos < 72) {
+        uint8_t bit = (w->scratch[w->tx_pos / 8] >> (w->tx_pos % 8)) & 1;
+        w->pull_from_ns = now;
+        w->pull_until_ns = bit ? now : now + 30 * US;
+    }
+}
+
+/* Master released the line: classify what it was */
+static void rising(sim_onewire_t *w, uint64_t now) {
+    uint64_t low = now - w->fall_ns;
+
+    if (low >= 480 * US) {
+        w->resets++;
+        w->state = w->present ? ST_ROM : ST_IDLE;
+        w->shift = 0;
+        w->nbits = 0;
+        if (w->present) {
+            w->pull_from_ns = now + 30 * US;
+            w->pull_until_ns = now + 150 * US;
+        }
+        return;
+    }
+    w->slots++;
+    if (w->state == ST_SENDING) {
+        if (++w->tx_pos == 72) w->state = ST_IDLE;
+    } else if (w->state == ST_ROM || w->state == ST_FUNCTION) {
+        w->shift = (uint8_t)((w->shift >> 1) | (low < 15 * US ? 0x80 : 0));
+        if (++w->nbits == 8) {
+            w->nbits = 0;
+            command(w, w->shift);
+        }
+    }
+}
+
+static void pin_written(volatile uint8_t *reg, uint8_t old, void *ctx) {
+    sim_onewire_t *w = ctx;
+    bool low = driving_low(w);
+    (void)reg; (void)old;
+
+    if (low == w->master_low) return;
+    w->master_low = low;
+    if (low) falling(w, hal_host_ns());
+    else rising(w, hal_host_ns());
+}
+
+static uint8_t pin_read(volatile uint8_t *reg, uint8_t value, void *ctx) {
+    sim_onewire_t *w = ctx;
+    uint64_t now = hal_host_ns();
+    bool low = w->master_low || (now >= w->pull_from_ns && now < w->pull_until_ns);
+    (void)reg;
+
+    return low ? (uint8_t)(value & ~(1 << w->bit)) : (uint8_t)(value | (1 << w->bit));
+}
+
+void sim_onewire_attach(sim_onewire_t *w, volatile uint8_t *ddr, volatile uint8_t *port,
+                        volatile uint8_t *pin, uint8_t bit) {
+    memset(w, 0, sizeof(*w));
+    w->present = true;
+    w->temp_raw = 0x0159;
+    w->conv_ms = 750;
+    w->ddr = ddr;
+    w->port = port;
+    w->pin = pin;
+    w->bit = bit;
+    (void)hal_host_hook(ddr, pin_written, NULL, w);
+    (void)hal_host_hook(port, pin_written, NULL, w);
+    (void)hal_host_hook(pin, NULL, pin_read, w);
+}
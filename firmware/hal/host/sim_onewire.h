@@ -0,0 +1,72 @@
+/**
+ * @file sim_onewire.h
+ * @brief Simulated 1-Wire bus with one DS18B20, driven by the pin registers.
+ *
+ * The model watches the DDR and PORT bits of the bus pin and answers
+ * reads of its PIN bit. The line is low while the master drives it
+ * (output, PORT bit 0) or the device pulls it; otherwise the pull-up
+ * keeps it high. From the virtual clock at each edge it tells a reset
+ * pulse (>= 480 us low) from a time slot (short low = 1, >= 15 us = 0),
+ * answers with the presence pulse 15..60 us after the reset ends and, in
+ * read slots, holds the line low for a 0 bit during the first 30 us.
+ *
+ * The DS18B20 understands Skip ROM (0xCC), Convert T (0x44) and Read
+ * Scratchpad (0xBE). A conversion takes conv_ms of virtual time; the
+ * scratchpad shows the power-on value 85 °C until one has finished.
+ */
+
+#ifndef SIM_ONEWIRE_H
+#define SIM_ONEWIRE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    /* device, set by the test */
+    bool     present;       /**< false: nothing answers the reset */
+    int16_t  temp_raw;      /**< Next conversion result, 1/16 °C */
+    uint16_t conv_ms;       /**< Conversion time (750 at 12 bit) */
+
+    /* pin */
+    volatile uint8_t *ddr, *port, *pin;
+    uint8_t  bit;
+
+    /* bus state */
+    bool     master_low;
+    uint64_t fall_ns;       /**< Master pulled the line low */
+    uint64_t pull_from_ns;  /**< Device holds the line low in [from, until) */
+    uint64_t pull_until_ns;
+    uint64_t conv_done_ns;
+    uint8_t  state;
+    uint8_t  shift;         /**< Byte being received */
+    uint8_t  nbits;
+    uint8_t  scratch[9];
+    uint8_t  tx_pos;        /**< Bit index into scratch while sending */
+
+    /* statistics */
+    uint32_t resets;
+    uint32_t slots;
+    uint32_t conversions;
+    uint32_t early_reads;   /**< Scratchpad read before the conversion finished */
+} sim_onewire_t;
+
+/**
+ * @brief Hook the pin registers (after hal_host_reset()).
+ *
+ * The device starts present, at 21.5625 °C (0x0159), with conv_ms 750.
+ */
+void sim_onewire_attach(sim_onewire_t *w, volatile uint8_t *ddr, volatile uint8_t *port,
+                        volatile uint8_t *pin, uint8_t bit);
+
+/** Dallas/Maxim CRC-8 (polynomial 0x31 reflected), as in the scratchpad. */
+uint8_t sim_onewire_crc8(const uint8_t *data, uint8_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_ONEWIRE_H */
@@ -0,0 +1,174 @@
+/**
+ * @file sim_twi.c
+ * @brief TWI master state machine with ATmega328P status codes, register-file slave.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "hal_host.h"
+#include "sim_twi.h"
+
+/* TWSR status codes (master) */
+#define TW_START        0x08
+#define TW_REP_START    0x10
+#define TW_MT_SLA_ACK   0x18
+#define TW_MT_SLA_NACK  0x20
+#define TW_MT_DATA_ACK  0x28
+#define TW_MT_DATA_NACK 0x30
+#define TW_MR_SLA_ACK   0x40
+#define TW_MR_SLA_NACK  0x48
+#define TW_MR_DATA_ACK  0x50
+#define TW_MR_DATA_NACK 0x58
+#define TW_NO_INFO      0xF8
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+enum { IDLE, ADDRESS, WRITING, READING, REJECTED };
+
+sim_twi_stats_t sim_twi_stats;
+
+static sim_twi_slave_t *slaves;
+static sim_twi_slave_t *active;
+static uint8_t phase;
+
+uint32_t sim_twi_scl_hz(uint32_t f_cpu) {
+    static const uint8_t PRESCALE[4] = { 1, 4, 16, 64 };
+    return f_cpu / (16UL + 2UL * TWBR * PRESCALE[TWSR & 3]);
+}
+
+/* Bus time of n SCL periods */
+static void bus_time(uint8_t periods) {
+    uint64_t ns = periods * 1000000000ULL / sim_twi_scl_hz(F_CPU);
+
+    sim_twi_stats.bus_ns += ns;
+    hal_host_advance_ns(ns);
+}
+
+static void status(uint8_t code) {
+    TWSR = (uint8_t)(code | (TWSR & 3));
+}
+
+static void address(uint8_t sla) {
+    bool read = sla & 1;
+
+    active = NULL;
+    for (sim_twi_slave_t *s = slaves; s; s = s->next) {
+        if (s->addr == (sla >> 1)) { active = s; break; }
+    }
+    bool ack = active && active->start(active, read);
+    if (!ack) {
+        active = NULL;
+        sim_twi_stats.nacks++;
+        phase = REJECTED;
+    } else {
+        phase = read ? READING : WRITING;
+    }
+    status(read ? (ack ? TW_MR_SLA_ACK : TW_MR_SLA_NACK) : (ack ? TW_MT_SLA_ACK : TW_MT_SLA_NACK));
+}
+
+static void twcr_written(volatile uint8_t *reg, uint8_t old, void *ctx) {
+    uint8_t v = TWCR;
+    (void)reg; (void)old; (void)ctx;
+
+    if (!(v & (1 << TWEN))) return;
+
+    if (v & (1 << TWSTO)) {
+        if (active) active->stop(active);
+        active = NULL;
+        phase = IDLE;
+        bus_time(1);
+        TWCR = (uint8_t)(v & ~((1 << TWSTO) | (1 << TWINT)));   /* STOP sets no TWINT */
+        status(TW_NO_INFO);
+        return;
+    }
+    if (!(v & (1 << TWINT))) return;        /* writing 0 to TWINT starts nothing */
+
+    if (v & (1 << TWSTA)) {
+        sim_twi_stats.starts++;
+        status(phase == IDLE ? TW_START : TW_REP_START);
+        phase = ADDRESS;
+        active = NULL;
+        bus_time(1);
+    } else {
+        sim_twi_stats.bytes++;
+        bus_time(9);
+        switch (phase) {
+        case ADDRESS:
+            address(TWDR);
+            break;
+        case WRITING: {
+            bool ack = active->write(active, TWDR);
+            if (!ack) sim_twi_stats.nacks++;
+            status(ack ? TW_MT_DATA_ACK : TW_MT_DATA_NACK);
+            break;
+        }
+        case READING: {
+            bool ack = v & (1 << TWEA);
+            TWDR = active->read(active, ack);
+            status(ack ? TW_MR_DATA_ACK : TW_MR_DATA_NACK);
+            break;
+        }
+        default:                            /* bus not addressed: the line reads high */
+            TWDR = 0xFF;
+            status(TW_NO_INFO);
+            break;
+        }
+    }
+    TWCR = (uint8_t)(v | (1 << TWINT));     /* operation complete */
+}
+
+void sim_twi_attach(void) {
+    slaves = NULL;
+    active = NULL;
+    phase = IDLE;
+    memset(&sim_twi_stats, 0, sizeof(sim_twi_stats));
+    (void)hal_host_hook(&TWCR, twcr_written, NULL, NULL);
+}
+
+void sim_twi_add(sim_twi_slave_t *s) {
+    s->next = slaves;
+    slaves = s;
+}
+
+/* ---------------- register file ---------------- */
+
+static bool rf_start(sim_twi_slave_t *s, bool read) {
+    ((sim_regfile_t *)s)->ptr_next = !read;
+    return true;
+}
+
+static bool rf_write(sim_twi_slave_t *s, uint8_t b) {
+    sim_regfile_t *r = (sim_regfile_t *)s;
+
+    if (r->ptr_next) {
+        r->ptr = b;
+        r->ptr_next = false;
+    } else {
+        uint8_t at = r->ptr++;
+        r->reg[at] = b;
+        r->writes++;
+        if (r->on_write) r->on_write(r, at, b);
+    }
+    return true;
+}
+
+static uint8_t rf_read(sim_twi_slave_t *s, bool ack) {
+    sim_regfile_t *r = (sim_regfile_t *)s;
+    (void)ack;
+    return r->reg[r->ptr++];
+}
+
+static void rf_stop(sim_twi_slave_t *s) {
+    (void)s;
+}
+
+void sim_regfile_init(sim_regfile_t *r, uint8_t addr) {
+    memset(r, 0, sizeof(*r));
+    r->dev.addr = addr;
+    r->dev.start = rf_start;
+    r->dev.write = rf_write;
+    r->dev.read = rf_read;
+    r->dev.stop = rf_stop;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file sim_twi.h
+ * @brief Simulated TWI master (TWCR/TWSR/TWDR) and the slaves on its bus.
+ *
+ * Each operation the driver starts by writing TWCR with TWINT set (START,
+ * address, data byte, read) runs at once: the slave is asked, TWSR gets
+ * the status code the ATmega328P would report and TWINT is set again.
+ * STOP ends the transfer. The time the bus would take at the rate set by
+ * TWBR and the prescaler is added to the virtual clock.
+ *
+ * Slaves implement the four callbacks of sim_twi_slave_t; sim_regfile_t
+ * is a ready one for the usual register-file devices (BME280, DS3231):
+ * the first byte written sets the register pointer, further bytes are
+ * stored there, reads return from it, both with auto-increment.
+ */
+
+#ifndef SIM_TWI_H
+#define SIM_TWI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sim_twi_slave sim_twi_slave_t;
+
+struct sim_twi_slave {
+    uint8_t addr;                                       /**< 7-bit address */
+    bool    (*start)(sim_twi_slave_t *s, bool read);    /**< Addressed; false = NACK */
+    bool    (*write)(sim_twi_slave_t *s, uint8_t b);    /**< Byte from master; false = NACK */
+    uint8_t (*read)(sim_twi_slave_t *s, bool ack);      /**< Byte to master; ack = more wanted */
+    void    (*stop)(sim_twi_slave_t *s);                /**< STOP (not called on repeated START) */
+    sim_twi_slave_t *next;
+};
+
+typedef struct {
+    uint32_t starts;        /**< START and repeated START */
+    uint32_t bytes;         /**< Address and data bytes */
+    uint32_t nacks;         /**< Address or data bytes not acknowledged */
+    uint64_t bus_ns;        /**< Bus time at the configured SCL rate */
+} sim_twi_stats_t;
+
+extern sim_twi_stats_t sim_twi_stats;
+
+/** Hook TWCR (after hal_host_reset()); no slaves, zero stats. */
+void sim_twi_attach(void);
+
+/** Put a slave on the bus. */
+void sim_twi_add(sim_twi_slave_t *s);
+
+/** SCL frequency the registers currently give at f_cpu. */
+uint32_t sim_twi_scl_hz(uint32_t f_cpu);
+
+/* ---- Register-file slave ---- */
+
+typedef struct sim_regfile sim_regfile_t;
+
+struct sim_regfile {
+    sim_twi_slave_t dev;        /**< First member: the bus sees this */
+    uint8_t reg[256];
+    uint8_t ptr;                /**< Register pointer */
+    bool    ptr_next;           /**< Next written byte is the pointer */
+    uint32_t writes;            /**< Register writes (not pointer bytes) */
+    /** Called after a register was written; may change other registers. */
+    void (*on_write)(sim_regfile_t *r, uint8_t reg, uint8_t v);
+};
+
+/** Register file at addr, all registers 0; put it on the bus with sim_twi_add(&r->dev). */
+void sim_regfile_init(sim_regfile_t *r, uint8_t addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TWI_H */
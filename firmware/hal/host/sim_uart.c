@@ -0,0 +1,71 @@
+/**
+ * @file sim_uart.c
+ * @brief USART0 registers, frame timing and the handshake lines.
+ */
+
+#include <string.h>
+#include "hal_host.h"
+#include "sim_uart.h"
+#include "uart_isr.h"
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+sim_uart_t sim_uart;
+
+uint32_t sim_uart_baud(uint32_t f_cpu) {
+    uint32_t div = (UCSR0A & (1 << U2X0)) ? 8 : 16;
+    return f_cpu / (div * ((((uint32_t)UBRR0H << 8) | UBRR0L) + 1));
+}
+
+bool sim_uart_rts(void) {
+    return !(UART_RTS_PORT & (1 << UART_RTS_PIN));
+}
+
+static uint8_t ucsr0a_read(volatile uint8_t *reg, uint8_t value, void *ctx) {
+    (void)reg; (void)ctx;
+    return (uint8_t)(value | (1 << UDRE0) | (1 << TXC0));
+}
+
+static void udr0_written(volatile uint8_t *reg, uint8_t old, void *ctx) {
+    (void)reg; (void)old; (void)ctx;
+    if (sim_uart.tx_len < SIM_UART_TX_CAP) sim_uart.tx[sim_uart.tx_len++] = UDR0;
+    hal_host_advance_ns(10 * 1000000000ULL / sim_uart_baud(F_CPU));
+}
+
+static uint8_t cts_read(volatile uint8_t *reg, uint8_t value, void *ctx) {
+    (void)reg; (void)ctx;
+    return sim_uart.cts_ready ? (uint8_t)(value & ~(1 << UART_CTS_PIN))
+                              : (uint8_t)(value | (1 << UART_CTS_PIN));
+}
+
+void sim_uart_attach(void) {
+    memset(&sim_uart, 0, sizeof(sim_uart));
+    sim_uart.cts_ready = true;
+    (void)hal_host_hook(&UCSR0A, NULL, ucsr0a_read, NULL);
+    (void)hal_host_hook(&UDR0, udr0_written, NULL, NULL);
+    (void)hal_host_hook(&UART_CTS_PIN_REG, NULL, cts_read, NULL);
+}
+
+void sim_uart_rx_flags(uint8_t b, uint8_t flags) {
+    const uint8_t on = (1 << RXEN0) | (1 << RXCIE0);
+    const uint8_t errors = (1 << FE0) | (1 << DOR0) | (1 << UPE0);
+
+    hal_host_advance_ns(10 * 1000000000ULL / sim_uart_baud(F_CPU));
+    if ((UCSR0B & on) != on || !hal_host_irq_on) {
+        sim_uart.rx_lost++;
+        return;
+    }
+    UDR0 = b;
+    UCSR0A = (uint8_t)((UCSR0A & ~errors) | (flags & errors) | (1 << RXC0));
+    sim_uart.rx_delivered++;
+    USART_RX_vect();
+    UCSR0A &= (uint8_t)~(errors | (1 << RXC0));
+}
+
+void sim_uart_rx(const void *data, uint16_t len) {
+    const uint8_t *p = data;
+
+    while (len--) sim_uart_rx_flags(*p++, 0);
+}
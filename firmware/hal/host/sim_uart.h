@@ -0,0 +1,63 @@
+/**
+ * @file sim_uart.h
+ * @brief Simulated USART0 byte stream: RX injection through the ISR, TX capture, RTS/CTS.
+ *
+ * sim_uart_rx() delivers bytes the way the line would: each one is put
+ * in UDR0 (with optional FE0/DOR0/UPE0 flags in UCSR0A) and
+ * USART_RX_vect is called, provided the receiver, its interrupt and the
+ * global interrupt flag are enabled; otherwise the byte is lost, as it
+ * would be on the chip. Every byte advances the virtual clock by its
+ * frame time at the baud rate UBRR0/U2X0 give.
+ *
+ * Bytes written to UDR0 are captured. The transmitter is always ready
+ * (UDRE0 and TXC0 read as set). CTS (PINB bit PB2 by default) reads as
+ * the test sets it; RTS is read back from its PORT bit.
+ */
+
+#ifndef SIM_UART_H
+#define SIM_UART_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SIM_UART_TX_CAP
+#define SIM_UART_TX_CAP 4096
+#endif
+
+typedef struct {
+    uint8_t  tx[SIM_UART_TX_CAP];
+    uint16_t tx_len;        /**< Captured bytes (saturates at the capacity) */
+    uint32_t rx_delivered;  /**< Bytes handed to the ISR */
+    uint32_t rx_lost;       /**< Bytes sent while RX or its interrupt was off */
+    bool     cts_ready;     /**< Peer accepts data (CTS asserted, line low) */
+} sim_uart_t;
+
+extern sim_uart_t sim_uart;
+
+/** The RX interrupt handler the driver defines with HAL_ISR(). */
+void USART_RX_vect(void);
+
+/** Hook UCSR0A, UDR0 and the CTS pin (after hal_host_reset()). CTS starts ready. */
+void sim_uart_attach(void);
+
+/** Deliver len bytes to the receiver. */
+void sim_uart_rx(const void *data, uint16_t len);
+
+/** Deliver one byte with UCSR0A error flags (1 << FE0 etc.). */
+void sim_uart_rx_flags(uint8_t b, uint8_t flags);
+
+/** Baud rate the registers currently give at f_cpu. */
+uint32_t sim_uart_baud(uint32_t f_cpu);
+
+/** Level of the RTS output: true = asserted (low, send more). */
+bool sim_uart_rts(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_UART_H */
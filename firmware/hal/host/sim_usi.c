@@ -0,0 +1,104 @@
+/**
+ * @file sim_usi.c
+ * @brief Bit-level I2C master against the USI shift register and 4-bit counter.
+ */
+
+#include <string.h>
+#include "hal_host.h"
+#include "sim_usi.h"
+
+/* The slave's handlers (usi_slave.c) */
+void USI_STR_vect(void);
+void USI_OVF_vect(void);
+
+#define SCL_PERIOD_NS 10000ULL      // 100 kHz
+#define SDA_BIT       6             // PA6
+
+sim_usi_stats_t sim_usi_stats;
+
+/* Flags clear by writing one, USIDC is not stored, the counter is written as is */
+static void usisr_written(volatile uint8_t *reg, uint8_t old, void *ctx) {
+    uint8_t v = *reg;
+    (void)ctx;
+    *reg = (uint8_t)((old & 0xE0 & ~(v & 0xE0)) | (v & 0x0F));
+}
+
+static void raise(uint8_t flag, uint8_t enable, void (*vector)(void), uint32_t *count) {
+    USISR |= (uint8_t)(1 << flag);
+    if ((USICR & (1 << enable)) && hal_host_irq_on) {
+        (*count)++;
+        vector();
+    }
+}
+
+/* One bit: the line is low if either side pulls it low */
+static uint8_t clock_bit(uint8_t master) {
+    uint8_t slave = (DDRA & (1 << SDA_BIT)) ? (uint8_t)(USIDR >> 7) : 1;
+    uint8_t line = master & slave & 1;
+
+    USIDR = (uint8_t)((USIDR << 1) | line);
+    hal_host_advance_ns(SCL_PERIOD_NS);
+    for (uint8_t edge = 0; edge < 2; edge++) {
+        uint8_t count = (uint8_t)((USISR + 1) & 0x0F);
+        USISR = (uint8_t)((USISR & 0xF0) | count);
+        if (count == 0) raise(USIOIF, USIOIE, USI_OVF_vect, &sim_usi_stats.ovf_irqs);
+    }
+    return line;
+}
+
+static uint8_t clock_byte(uint8_t master) {
+    uint8_t seen = 0;
+
+    for (uint8_t i = 0; i < 8; i++) {
+        seen = (uint8_t)((seen << 1) | clock_bit((uint8_t)(master >> 7)));
+        master = (uint8_t)(master << 1);
+    }
+    sim_usi_stats.bytes++;
+    return seen;
+}
+
+/* Byte from the master, then the slave's ACK bit */
+static bool send(uint8_t b) {
+    (void)clock_byte(b);
+    bool ack = clock_bit(1) == 0;
+    if (!ack) sim_usi_stats.nacks++;
+    return ack;
+}
+
+static void start(void) {
+    sim_usi_stats.starts++;
+    raise(USISIF, USISIE, USI_STR_vect, &sim_usi_stats.str_irqs);
+}
+
+static void stop(void) {
+    USISR |= (uint8_t)(1 << USIPF);
+}
+
+void sim_usi_attach(void) {
+    memset(&sim_usi_stats, 0, sizeof(sim_usi_stats));
+    (void)hal_host_hook(&USISR, usisr_written, NULL, NULL);
+}
+
+int sim_usi_write(uint8_t addr, const uint8_t *data, uint8_t len) {
+    int n = -1;
+
+    start();
+    if (send((uint8_t)(addr << 1))) {
+        for (n = 0; n < len && send(data[n]); n++) { }
+    }
+    stop();
+    return n;
+}
+
+bool sim_usi_read(uint8_t addr, uint8_t *data, uint8_t len) {
+    start();
+    bool ok = send((uint8_t)((addr << 1) | 1));
+    if (ok) {
+        for (uint8_t i = 0; i < len; i++) {
+            data[i] = clock_byte(0xFF);                 // SDA released
+            (void)clock_bit(i + 1 < len ? 0 : 1);       // ACK, NACK after the last
+        }
+    }
+    stop();
+    return ok;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file sim_usi.h
+ * @brief Simulated I2C master on the bus of a USI two-wire slave (ATtiny84 USICR/USISR/USIDR).
+ *
+ * The transfer runs bit by bit as the USI sees it. A START sets USISIF;
+ * each clocked bit shifts the wired-AND of the master's bit and the
+ * slave's (USIDR bit 7 while the slave drives SDA, i.e. its DDRA bit is
+ * set) into USIDR and counts two edges in the USISR counter; when the
+ * counter wraps USIOIF is set. A set flag calls the slave's handler
+ * (USI_STR_vect / USI_OVF_vect) at once if USICR enables it and the
+ * global interrupt flag is on. That models SCL held low after a START or
+ * an overflow: the next bit only comes once the handler has returned.
+ * USISR's flags clear by writing one, USIDC reads as zero.
+ *
+ * A STOP only sets USIPF. Every bit advances the virtual clock by one
+ * period of a 100 kHz SCL.
+ */
+
+#ifndef SIM_USI_H
+#define SIM_USI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t starts;        /**< START conditions */
+    uint32_t bytes;         /**< Address and data bytes */
+    uint32_t nacks;         /**< Address or data bytes not acknowledged */
+    uint32_t str_irqs;      /**< USI_STR_vect calls */
+    uint32_t ovf_irqs;      /**< USI_OVF_vect calls */
+} sim_usi_stats_t;
+
+extern sim_usi_stats_t sim_usi_stats;
+
+/** Hook USISR (after hal_host_reset()), zero stats. */
+void sim_usi_attach(void);
+
+/**
+ * @brief START, address with W, the bytes, STOP.
+ * @return Bytes acknowledged (stops at the first NACK), -1 if the address was not.
+ */
+int sim_usi_write(uint8_t addr, const uint8_t *data, uint8_t len);
+
+/**
+ * @brief START, address with R, len bytes (all ACKed but the last), STOP.
+ * @return false if the address was not acknowledged.
+ */
+bool sim_usi_read(uint8_t addr, uint8_t *data, uint8_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_USI_H */
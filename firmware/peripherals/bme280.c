@@ -12,7 +12,7 @@
 
 #include "bme280.h"
 #include "../communication/i2c.h"
-#include <util/delay.h>
+#include "../hal/hal.h"
 
 /* Calibration coefficients */
 uint16_t dig_T1, dig_P1;
@@ -113,7 +113,7 @@ void bme280_init(void) {
     I2C_write(BME280_REGISTER_SOFTRESET);
     I2C_write(BME280_REGISTER_POWERONRESET);
     I2C_stop();
-    _delay_ms(10);
+    HAL_DELAY_MS(10);
 
     /* Humidity oversampling = x1 (must write ctrl_hum before ctrl_meas) */
     I2C_start_with_address(BME280_I2C_ADDRSS, 0);
@@ -133,20 +133,32 @@ void bme280_init(void) {
     I2C_write((0x01 << 5) | (0x01 << 2) | 0x03); /* osrs_t=1, osrs_p=1, mode=3 */
     I2C_stop();
 
-    _delay_ms(100);
+    HAL_DELAY_MS(100);
 
     /* Load calibration */
     bme280_readCoefficients();
 }
 
+void bme280_startForced(void) {
+    /* ctrl_meas: temp x1, press x1, forced mode (one measurement, then sleep) */
+    I2C_start_with_address(BME280_I2C_ADDRSS, 0);
+    I2C_write(BME280_REGISTER_CONTROL);
+    I2C_write((0x01 << 5) | (0x01 << 2) | 0x01); /* osrs_t=1, osrs_p=1, mode=1 */
+    I2C_stop();
+}
+
+uint8_t bme280_isMeasuring(void) {
+    return (bme280_read1Byte(BME280_REGISTER_STATUS) & 0x08) != 0; /* status.measuring */
+}
+
 float bme280_readTemperature(void) {
     /* Read uncompensated temperature (20-bit) */
     uint32_t adc_T = bme280_read3Byte(BME280_REGISTER_TEMPDATA) >> 4;
 
     /* Compensation (datasheet §4.2.3) */
     int32_t var1 = ((((int32_t)adc_T >> 3) - ((int32_t)dig_T1 << 1)) * (int32_t)dig_T2) >> 11;
-    int32_t var2 = (((((int32_t)adc_T >> 4) - (int32_t)dig_T1) *
-                      (((int32_t)adc_T >> 4) - (int32_t)dig_T1)) >> 12) * (int32_t)dig_T3) >> 14;
+    int32_t dT   = ((int32_t)adc_T >> 4) - (int32_t)dig_T1;
+    int32_t var2 = (((dT * dT) >> 12) * (int32_t)dig_T3) >> 14;
 
     t_fine = var1 + var2;
     int32_t T  = (t_fine * 5 + 128) >> 8; /* °C * 100 */
@@ -189,7 +201,7 @@ float bme280_readHumidity(void) {
     v_x1_u32r = (((((adc_H << 14) - (((int32_t)dig_H4) << 20)
                    - (((int32_t)dig_H5) * v_x1_u32r)) + ((int32_t)16384)) >> 15)
                  * (((((((v_x1_u32r * ((int32_t)dig_H6)) >> 10)
-                        * ((v_x1_u32r * ((int32_t)dig_H3)) >> 11) + ((int32_t)32768))) >> 10)
+                        * (((v_x1_u32r * ((int32_t)dig_H3)) >> 11) + ((int32_t)32768))) >> 10)
                       + ((int32_t)2097152)) * ((int32_t)dig_H2) + 8192) >> 14));
     v_x1_u32r = v_x1_u32r - (((((v_x1_u32r >> 15) * (v_x1_u32r >> 15)) >> 7)
                               * ((int32_t)dig_H1)) >> 4);
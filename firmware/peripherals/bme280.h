@@ -63,6 +63,19 @@ extern "C" {
  */
 void bme280_init(void);
 
+/**
+ * @brief Start a single forced-mode measurement (about 10 ms at x1 oversampling).
+ *
+ * Lets the caller do other work during the conversion; poll
+ * bme280_isMeasuring() and then use the bme280_read* functions.
+ */
+void bme280_startForced(void);
+
+/**
+ * @brief Non-zero while a conversion is running.
+ */
+uint8_t bme280_isMeasuring(void);
+
 /**
  * @brief Read temperature in degrees Celsius.
  */
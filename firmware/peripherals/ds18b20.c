@@ -7,18 +7,19 @@
  */
 
 #include "ds18b20.h"
-#include <util/delay.h> // for _delay_ms
+#include "../hal/hal.h"
 
-int16_t ds18b20_readTemperature(void) {
+uint8_t ds18b20_startConversion(void) {
     // Reset bus and check presence
-    if (!one_wire_reset()) return -1000;
+    if (!one_wire_reset()) return 0;
 
     // Skip ROM (single device assumed), start conversion
     one_wire_writeByte(0xCC);
     one_wire_writeByte(0x44);
+    return 1;
+}
 
-    _delay_ms(750); // wait for conversion (12-bit resolution)
-
+int16_t ds18b20_readScratchpad(void) {
     // Reset and prepare to read scratchpad
     if (!one_wire_reset()) return -1000;
 
@@ -29,4 +30,12 @@ int16_t ds18b20_readTemperature(void) {
     uint8_t msb = one_wire_readByte();
 
     return (int16_t)((msb << 8) | lsb); // raw 1/16 °C units
-}
\ No newline at end of file
+}
+
+int16_t ds18b20_readTemperature(void) {
+    if (!ds18b20_startConversion()) return -1000;
+
+    HAL_DELAY_MS(DS18B20_CONVERSION_MS); // wait for conversion (12-bit resolution)
+
+    return ds18b20_readScratchpad();
+}
@@ -16,6 +16,25 @@
 extern "C" {
 #endif
 
+/** Worst-case conversion time at 12-bit resolution (ms). */
+#define DS18B20_CONVERSION_MS 750
+
+/**
+ * @brief Start a temperature conversion (SKIP ROM + CONVERT T) and return.
+ *
+ * Read the result with ds18b20_readScratchpad() once
+ * DS18B20_CONVERSION_MS have passed.
+ *
+ * @return 1 if a device answered the reset pulse, 0 otherwise.
+ */
+uint8_t ds18b20_startConversion(void);
+
+/**
+ * @brief Read the temperature of a finished conversion (SKIP ROM + READ SCRATCHPAD).
+ * @return Raw signed 16-bit temperature (1/16 °C), or -1000 on bus error.
+ */
+int16_t ds18b20_readScratchpad(void);
+
 /**
  * @brief Read temperature from DS18B20.
  *
@@ -1,46 +1,64 @@
 #include <string.h>
-#include <stdio.h>
 #include <ctype.h>
 #include "gsm_module.h"
 #include "../communication/uart_isr.h"
 #include <string.h>
-#include <util/delay.h>
+#include "../system/clock.h"
 
 /* -------------------- NARZĘDZIA RX/TX -------------------- */
 
+/* Ile czekało ostatnie wait_for_tokens() (== timeout, gdy nic nie przyszło) */
+static uint32_t last_wait_ms;
+
+/* Ile tokenów najwyżej w jednym wait_for_tokens() (must i fatal osobno) */
+#define WAIT_MAX_TOKENS 2
+
+/* Dopasowanie znak po znaku: ile znaków tokenu już pasuje. Wystarcza dla
+   tokenów bez powtórzonego prefiksu ("OK", "ERROR", "DOWNLOAD", ...). */
+static bool token_feed(const char *tok, uint8_t *matched, char c) {
+    if(c == tok[*matched]) {
+        if(tok[++*matched] == '\0') { *matched = 0; return true; }
+    } else {
+        *matched = (c == tok[0]) ? 1 : 0;
+    }
+    return false;
+}
+
+/* Czeka aż przyjdą wszystkie must (w dowolnej kolejności) albo którykolwiek
+   fatal. Bez okna na odpowiedź: tylko liczniki dopasowania na stosie. */
 static bool wait_for_tokens(const char **must, uint8_t n_must, const char **fatal, uint8_t n_fatal, uint32_t timeout_ms) {
-    char acc[256]; size_t acc_len = 0;
-    acc[0] = '\0';
+    uint8_t must_at[WAIT_MAX_TOKENS] = { 0 }, fatal_at[WAIT_MAX_TOKENS] = { 0 };
+    bool seen[WAIT_MAX_TOKENS] = { false };
+
+    if(n_must > WAIT_MAX_TOKENS) n_must = WAIT_MAX_TOKENS;
+    if(n_fatal > WAIT_MAX_TOKENS) n_fatal = WAIT_MAX_TOKENS;
 
     for(uint32_t t=0; t<timeout_ms; ++t){
+        int8_t result = -1;
         int16_t ch;
+        /* paczka czytana do końca, jak wcześniej: reszta nie zostaje dla następnej komendy */
         while((ch = UART_receive()) >= 0){
-            if(acc_len+1 < sizeof(acc)){
-                acc[acc_len++] = (char)ch;
-                acc[acc_len] = '\0';
-            } else {
-                /* przesuwamy okno, żeby trzymać tylko koniec */
-                memmove(acc, acc+1, --acc_len);
-                acc[acc_len++] = (char)ch;
-                acc[acc_len] = '\0';
-            }
-        }
+            if(result >= 0) continue;
 
-        /* najpierw fatale */
-        for(uint8_t i=0; i<n_fatal; ++i){
-            if(fatal[i] && strstr(acc, fatal[i])) return false;
-        }
+            /* najpierw fatale */
+            for(uint8_t i=0; i<n_fatal; ++i){
+                if(fatal[i] && token_feed(fatal[i], &fatal_at[i], (char)ch)) result = 0;
+            }
+            if(result >= 0) continue;
 
-        /* potem sprawdź czy wszystkie must już są */
-        bool all = true;
-        for(uint8_t i=0; i<n_must; ++i){
-            if(!must[i]) continue;
-            if(!strstr(acc, must[i])) { all = false; break; }
+            /* potem sprawdź czy wszystkie must już są */
+            bool all = true;
+            for(uint8_t i=0; i<n_must; ++i){
+                if(must[i] && !seen[i]) seen[i] = token_feed(must[i], &must_at[i], (char)ch);
+                if(must[i] && !seen[i]) all = false;
+            }
+            if(all) result = 1;
         }
-        if(all) return true;
+        if(result >= 0) { last_wait_ms = t; return result; }
 
-        _delay_ms(1);
+        clock_delay_ms(1);
     }
+    last_wait_ms = timeout_ms;
     return false;
 }
 
@@ -50,32 +68,140 @@ bool gsm_wait_prompt_gt(uint32_t timeout_ms) {
         while((ch = UART_receive()) >= 0){
             if((char)ch == '>') return true;
         }
-        _delay_ms(1);
+        clock_delay_ms(1);
     }
     return false;
 }
 
-bool gsm_cmd_ok(const char* cmd, uint32_t timeout_ms) {
-    static const char* MUST[]  = { "OK" };
-    static const char* FATAL[] = { "ERROR" };
+/* Licznik komend AT (gsm_at_count()) */
+static uint32_t at_count;
 
-    /* Wyczyść ogon z poprzednich URC, wyślij komendę */
+bool gsm_tx_ok(void) {
+    bool ok = UART_tx_dropped() == 0;
+    UART_tx_clear_dropped();
+    return ok;
+}
+
+bool gsm_at_end(void) {
+    UART_send_string("\r\n");
+    at_count++;
+    return gsm_tx_ok();
+}
+
+uint32_t gsm_at_count(void) {
+    return at_count;
+}
+
+/* Komenda składana w locie prosto do UART: liczby przez stream_writer,
+   bez bufora i snprintf. at_write() zaczyna, CRLF kończy. */
+static void at_write(sw_t* w, const char* head) {
+    sw_init_sink(w, UART_send, 0);
+    sw_str(w, head);
+}
+
+/* at_write() po wyczyszczeniu ogona z poprzednich URC */
+static void at_start(sw_t* w, const char* head) {
     for(uint8_t i = 0; i < 10; i++){
         while (UART_data_available()) {
             (void) UART_receive();
-            _delay_ms(1);
+            clock_delay_ms(1);
         }
     }
-    UART_send_string(cmd); UART_send_string("\r\n");
+    at_write(w, head);
+}
 
-    /* Czekamy aż pojawi się OK albo ERROR (w jednej pętli) */
+/* Kończy komendę i czeka aż pojawi się OK albo ERROR (w jednej pętli) */
+static bool at_ok(uint32_t timeout_ms) {
+    static const char* MUST[]  = { "OK" };
+    static const char* FATAL[] = { "ERROR" };
+
+    if(!gsm_at_end()) return false;            /* modem nie przyjął całej komendy (CTS) */
     return wait_for_tokens(MUST, 1, FATAL, 1, timeout_ms);
 }
 
+bool gsm_cmd_ok(const char* cmd, uint32_t timeout_ms) {
+    sw_t w;
+    at_start(&w, cmd);
+    return at_ok(timeout_ms);
+}
+
 bool gsm_ping(uint16_t timeout_ms) {
     return gsm_cmd_ok("AT", timeout_ms);
 }
 
+/* -------------------- PRĘDKOŚĆ ŁĄCZA -------------------- */
+
+/* Prędkości AT+IPR wspólne dla SIM800/SIM7600/A7670, od najwyższej */
+static const uint32_t IPR_RATES[] = { 921600UL, 460800UL, 230400UL, 115200UL, 57600UL, 38400UL, 19200UL, 9600UL };
+
+uint32_t gsm_best_baud(uint32_t hz, uint16_t max_err_permil) {
+    for(uint8_t i = 0; i < sizeof(IPR_RATES)/sizeof(IPR_RATES[0]); ++i){
+        uint16_t err;
+        if(IPR_RATES[i] > GSM_BAUD_MAX) continue;
+        (void)UART_ubrr_for(hz, IPR_RATES[i], &err);
+        if(err <= max_err_permil) return IPR_RATES[i];
+    }
+    return 0;
+}
+
+bool gsm_set_baud(uint32_t from, uint32_t to) {
+    sw_t w;
+    if(from == to) return true;
+
+    at_start(&w, "AT+IPR="); sw_u32(&w, to);
+    if(!at_ok(1000)) return false;             /* "OK" przychodzi jeszcze w starej prędkości */
+
+    clock_set_baud(to);
+    clock_delay_ms(20);                         /* modem przełącza się po OK */
+    for(uint8_t i = 0; i < 3; i++){
+        if(gsm_ping(300)) return true;
+    }
+
+    /* Nie słychać go w nowej prędkości: wracamy (modem mógł nie przełączyć) */
+    clock_set_baud(from);
+    return false;
+}
+
+bool gsm_set_flow_control(bool on) {
+    if(!gsm_cmd_ok(on ? "AT+IFC=2,2" : "AT+IFC=0,0", 1000)) {
+        UART_set_flow_control(0);
+        return false;
+    }
+    UART_set_flow_control(on);
+    return true;
+}
+
+/* -------------------- ZASILANIE -------------------- */
+
+static void pwrkey_pulse(void) {
+    HAL_SET(GSM_PWRKEY_DDR, 1 << GSM_PWRKEY_PIN);
+    HAL_SET(GSM_PWRKEY_PORT, 1 << GSM_PWRKEY_PIN);
+    clock_delay_ms(GSM_PWRKEY_PULSE_MS);
+    HAL_CLEAR(GSM_PWRKEY_PORT, 1 << GSM_PWRKEY_PIN);
+}
+
+bool gsm_is_powered(void) {
+#ifdef GSM_STATUS_PIN
+    return (HAL_READ(GSM_STATUS_PIN_REG) & (1 << GSM_STATUS_PIN)) != 0;
+#else
+    /* dwie krótkie próby — pierwsza bywa zjedzona przez autobaud */
+    return gsm_ping(300) || gsm_ping(300);
+#endif
+}
+
+bool gsm_power_on(void) {
+    if(gsm_is_powered()) return true;   /* nigdy nie przełączaj "na ślepo" */
+    pwrkey_pulse();
+    return true;
+}
+
+void gsm_power_off(void) {
+    if(!gsm_is_powered()) return;
+
+    /* łagodne wyłączenie; impuls tylko gdy modem nie przyjął komendy */
+    if(!gsm_cmd_ok("AT+CPOF", 3000)) pwrkey_pulse();
+}
+
 /* -------------------- INICJALIZACJA / ECHO -------------------- */
 
 bool gsm_wait_ready(uint32_t total_timeout_ms) {
@@ -100,7 +226,7 @@ bool gsm_wait_ready(uint32_t total_timeout_ms) {
                 if(got_atready && got_cpin && got_sms) return true;
             }
         }
-        _delay_ms(1);
+        clock_delay_ms(1);
     }
     return false;
 }
@@ -109,96 +235,439 @@ bool gsm_disable_echo(uint16_t timeout_ms) {
     return gsm_cmd_ok("ATE0", timeout_ms);
 }
 
+/* -------------------- SZYBKA GOTOWOŚĆ (SONDA) -------------------- */
+
+/* Odstęp między kolejnymi zapytaniami, gdy etap jeszcze nie jest gotowy */
+#define PROBE_POLL_MS 1000
+
+/* Wysyła komendę i zbiera odpowiedź (z echem i URC) do "OK"/"ERROR".
+   Zwraca true dla "OK"; czas oczekiwania dopisuje do *spent. */
+static bool probe_cmd(const char* cmd, char* acc, size_t acc_sz, uint16_t timeout_ms, uint32_t* spent) {
+    size_t acc_len = 0;
+    acc[0] = '\0';
+
+    while(UART_receive() >= 0) { }
+    UART_send_string(cmd);
+    if(!gsm_at_end()) return false;
+
+    for(uint16_t t=0; t<timeout_ms; ++t){
+        int16_t ch;
+        while((ch = UART_receive()) >= 0){
+            if(acc_len+1 < acc_sz){
+                acc[acc_len++] = (char)ch;
+                acc[acc_len] = '\0';
+            }
+        }
+        if(strstr(acc, "\r\nOK")) { *spent += t; return true; }
+        if(strstr(acc, "ERROR"))  { *spent += t; return false; }
+        clock_delay_ms(1);
+    }
+    *spent += timeout_ms;
+    return false;
+}
+
+/* Liczba po prefiksie, po pominięciu `skip` przecinków (np. "+CREG: 0,1" -> 1). -1 gdy brak. */
+static int16_t probe_field(const char* acc, const char* prefix, uint8_t skip) {
+    const char* p = strstr(acc, prefix);
+    if(!p) return -1;
+    p += strlen(prefix);
+    while(skip){
+        if(*p == '\0') return -1;
+        if(*p++ == ',') --skip;
+    }
+    if(!isdigit((unsigned char)*p)) return -1;
+
+    int16_t n = 0;
+    while(isdigit((unsigned char)*p) && n < 1000) n = n*10 + (*p++ - '0');
+    return n;
+}
+
+/* Czeka max_ms na URC (NULL = zwykła pauza); wraca wcześniej, gdy się pojawi. */
+static void probe_listen(const char* urc, uint16_t max_ms, uint32_t* spent) {
+    char acc[64]; size_t acc_len = 0;
+    acc[0] = '\0';
+
+    for(uint16_t t=0; t<max_ms; ++t){
+        int16_t ch;
+        while((ch = UART_receive()) >= 0){
+            if(acc_len+1 >= sizeof(acc)) { memmove(acc, acc+1, --acc_len); }
+            acc[acc_len++] = (char)ch;
+            acc[acc_len] = '\0';
+        }
+        if(urc && strstr(acc, urc)) { *spent += t; return; }
+        clock_delay_ms(1);
+    }
+    *spent += max_ms;
+}
+
+static bool probe_registered(const char* cmd, const char* prefix, char* acc, size_t acc_sz, uint32_t* spent) {
+    if(!probe_cmd(cmd, acc, acc_sz, 3000, spent)) return false;
+    int16_t stat = probe_field(acc, prefix, 1);
+    return stat == 1 || stat == 5;   /* 1 = sieć domowa, 5 = roaming */
+}
+
+/* Ostatnia odpowiedź sondy (także do wykrycia URC, który wpadł w trakcie) */
+static char probe_acc[96];
+
+bool gsm_probe_step(gsm_stage_t* stage, uint32_t* spent_ms) {
+    char* acc = probe_acc;
+    const size_t acc_sz = sizeof(probe_acc);
+    bool advanced = false;
+
+    acc[0] = '\0';
+    switch(*stage){
+    case GSM_STAGE_OFF:
+        advanced = probe_cmd("AT", acc, acc_sz, 300, spent_ms);
+        break;
+    case GSM_STAGE_AT:
+        advanced = probe_cmd("AT+CPIN?", acc, acc_sz, 5000, spent_ms)
+                && strstr(acc, "+CPIN: READY");
+        break;
+    case GSM_STAGE_SIM:
+        /* A7670E: LTE (CEREG), starsze sieci (CREG) */
+        advanced = probe_registered("AT+CEREG?", "+CEREG: ", acc, acc_sz, spent_ms)
+                || probe_registered("AT+CREG?",  "+CREG: ",  acc, acc_sz, spent_ms);
+        break;
+    case GSM_STAGE_REGISTERED:
+        advanced = probe_cmd("AT+CGATT?", acc, acc_sz, 3000, spent_ms)
+                && probe_field(acc, "+CGATT: ", 0) == 1;
+        break;
+    default:
+        break;
+    }
+
+    if(advanced) (*stage)++;
+    /* brak karty się nie naprawi — nie ma sensu czekać do końca */
+    return strstr(acc, "SIM not inserted") == NULL;
+}
+
+int8_t gsm_csq(uint32_t* spent_ms) {
+    if(!probe_cmd("AT+CSQ", probe_acc, sizeof(probe_acc), 2000, spent_ms)) return -1;
+    int16_t rssi = probe_field(probe_acc, "+CSQ: ", 0);
+    return (rssi >= 0 && rssi <= 31) ? (int8_t)rssi : -1;
+}
+
+gsm_stage_t gsm_probe_ready(uint32_t total_timeout_ms, gsm_stage_t target) {
+    /* URC, na który warto czekać zamiast odpytywać, dla każdego etapu */
+    static const char* const LISTEN[] = {
+        [GSM_STAGE_OFF]        = "*ATREADY",
+        [GSM_STAGE_AT]         = "+CPIN: READY",
+        [GSM_STAGE_SIM]        = NULL,
+        [GSM_STAGE_REGISTERED] = NULL,
+    };
+
+    uint32_t spent = 0;
+    gsm_stage_t stage = GSM_STAGE_OFF;
+
+    while(stage < target && spent < total_timeout_ms){
+        gsm_stage_t before = stage;
+
+        if(!gsm_probe_step(&stage, &spent)) break;
+        if(stage != before) continue;
+
+        /* URC przyszedł w trakcie zapytania — od razu pytaj ponownie */
+        if(LISTEN[stage] && strstr(probe_acc, LISTEN[stage])) continue;
+        if(spent < total_timeout_ms) probe_listen(LISTEN[stage], PROBE_POLL_MS, &spent);
+    }
+    return stage;
+}
+
 /* Zastępuje: wait_cmgs_result(...) i wszędzie gdzie było kilka stream_find po kolei */
 static bool wait_cmgs_ok(uint32_t timeout_ms) {
-    char acc[256]; size_t acc_len=0; acc[0]='\0';
-    bool got_cmgs=false, got_ok=false;
+    return wait_for_tokens((const char*[]){"+CMGS:", "OK"},2,(const char*[]){"ERROR"},1,timeout_ms);
+}
+
+/* -------------------- HTTP POST -------------------- */
+
+/* Dotychczasowe stałe: górna granica dla uczonych timeoutów */
+static const uint32_t WORST_MS[GSM_T_COUNT] = {
+    [GSM_T_HTTPINIT]   = 3000,
+    [GSM_T_HTTPPARA]   = 5000,
+    [GSM_T_HTTPDATA]   = 10000,
+    [GSM_T_HTTPACTION] = 120000,
+    [GSM_T_HTTPREAD]   = 3000,
+    [GSM_T_HTTPTERM]   = 3000,
+};
+
+latency_t gsm_latency[GSM_T_COUNT];
+
+uint32_t gsm_timeout_ms(gsm_cmd_class_t c) {
+    return latency_timeout(&gsm_latency[c], GSM_TIMEOUT_FLOOR_MS, WORST_MS[c]);
+}
+
+/* Brak odpowiedzi liczy się jako czas równy timeoutowi: wolniejsza sieć
+   podnosi oszacowanie zamiast kończyć się błędem za każdym razem. */
+static void learn(gsm_cmd_class_t c, uint32_t waited_ms) {
+    latency_observe(&gsm_latency[c], waited_ms);
+}
+
+/* at_ok() z timeoutem klasy; uczy się na czasie odpowiedzi */
+static bool timed_ok(gsm_cmd_class_t c) {
+    bool ok = at_ok(gsm_timeout_ms(c));
+    learn(c, last_wait_ms);
+    return ok;
+}
+
+static bool timed_cmd(gsm_cmd_class_t c, const char* cmd) {
+    sw_t w;
+    at_start(&w, cmd);
+    return timed_ok(c);
+}
+
+/* Czeka na "+HTTPREAD: <n>\r\n" i zwraca n (0 = koniec danych), -1 przy timeoucie.
+   Dopasowanie znak po znaku, bez bufora na całą linię. */
+static int32_t http_read_header(uint32_t timeout_ms) {
+    static const char HDR[] = "+HTTPREAD: ";
+    uint8_t matched = 0;
+    int32_t n = -1;
 
     for(uint32_t t=0; t<timeout_ms; ++t){
         int16_t ch;
         while((ch = UART_receive()) >= 0){
-            if(acc_len+1 < sizeof(acc)){
-                acc[acc_len++] = (char)ch; acc[acc_len]='\0';
-            } else {
-                memmove(acc, acc+1, --acc_len);
-                acc[acc_len++] = (char)ch; acc[acc_len]='\0';
+            char c = (char)ch;
+            if(HDR[matched] != '\0'){
+                if(c == HDR[matched]) ++matched;
+                else matched = (c == HDR[0]) ? 1 : 0;
+            } else if(isdigit((unsigned char)c)){
+                n = (n < 0 ? 0 : n*10) + (c - '0');
+            } else if(c == '\n'){
+                last_wait_ms = t;
+                return n;            /* po "\r\n" od razu idą dane */
+            } else if(c != '\r'){
+                matched = 0; n = -1; /* to nie był nagłówek HTTPREAD */
             }
         }
-        if(strstr(acc, "ERROR")) return false;
-        if(strstr(acc, "+CMGS:")) got_cmgs = true;
-        if(strstr(acc, "OK"))     got_ok   = true;
+        clock_delay_ms(1);
+    }
+    last_wait_ms = timeout_ms;
+    return -1;
+}
+
+/* Jeden AT+HTTPREAD: treść do on_body prosto z bufora odbiorczego UART
+   (UART_rx_span(), bez kopii), w porcjach do zawinięcia pierścienia.
+   Zwraca liczbę bajtów (mniej niż want na końcu treści), -1 przy błędzie. */
+static int32_t http_read_chunk(uint32_t offset, uint32_t want, gsm_http_body_cb on_body, void* ctx) {
+    sw_t w;
+    at_write(&w, "AT+HTTPREAD="); sw_u32(&w, offset); sw_char(&w, ','); sw_u32(&w, want);
+    if(!gsm_at_end()) return -1;
+
+    int32_t n = http_read_header(gsm_timeout_ms(GSM_T_HTTPREAD));
+    learn(GSM_T_HTTPREAD, last_wait_ms);
+    if(n <= 0) return -1;
+
+    uint16_t idle = 0;
+    for(int32_t left = n; left > 0; ){
+        const uint8_t* span;
+        uint8_t got = UART_rx_span(&span);
+        if(got == 0){
+            if(++idle > 1000) return -1;
+            clock_delay_ms(1);
+            continue;
+        }
+        idle = 0;
+        if(got > left) got = (uint8_t)left;
+        on_body((const char*)span, got, ctx);
+        UART_rx_consume(got);   /* dopiero teraz ISR może nadpisać te bajty */
+        left -= got;
+    }
+
+    /* zamykające "+HTTPREAD: 0" (lub samo OK w starszym FW) */
+    (void)wait_for_tokens((const char*[]){"+HTTPREAD: 0"},1,(const char*[]){"ERROR"},1,1000);
+    return n;
+}
+
+/* Czyta całą treść odpowiedzi kawałkami i oddaje do on_body. */
+static bool http_read_body(uint32_t body_len, gsm_http_body_cb on_body, void* ctx) {
+    uint32_t offset = 0;
 
-        if(got_cmgs && got_ok) return true;
-        _delay_ms(1);
+    while(offset < body_len){
+        uint32_t want = body_len - offset;
+        if(want > GSM_HTTP_READ_CHUNK) want = GSM_HTTP_READ_CHUNK;
+
+        int32_t n = http_read_chunk(offset, want, on_body, ctx);
+        if(n <= 0) return false;
+        offset += (uint32_t)n;
     }
-    return false;
+    return true;
 }
 
-/* -------------------- HTTP POST -------------------- */
+/* "+HTTPACTION: <m>,<status>,<len>" oraz linie "OK" i "...ERROR..." czytane
+   znak po znaku: bez okna 256 B i bez sscanf */
+typedef struct {
+    uint8_t  col;        /* kolumna w bieżącej linii (nasyca się) */
+    uint8_t  field;      /* numer pola po prefiksie */
+    uint8_t  ok;         /* ile znaków "OK" pasuje od początku linii */
+    uint8_t  err;        /* ile znaków "ERROR" pasuje w linii */
+    bool     other;      /* linia to nie URC HTTPACTION */
+    bool     got_ok, got_error, done;
+    uint32_t num[3];
+} action_scan_t;
+
+static void action_feed(action_scan_t* s, char c) {
+    static const char HDR[] = "+HTTPACTION: ";
+    static const char ERR[] = "ERROR";
+
+    if(c == '\r') return;
+    if(c == '\n'){
+        if(!s->other && s->col > sizeof(HDR)-1 && s->field >= 1) s->done = true;
+        if(s->col == 2 && s->ok == 2) s->got_ok = true;
+        s->col = 0; s->err = 0; s->other = false;
+        if(!s->done){ s->field = 0; s->num[0] = s->num[1] = s->num[2] = 0; }
+        return;
+    }
+
+    if(c == ERR[s->err]){
+        if(ERR[++s->err] == '\0') s->got_error = true;
+    } else {
+        s->err = (c == ERR[0]) ? 1 : 0;
+    }
+
+    if(s->col == 0)                        s->ok = (c == 'O');
+    else if(s->col == 1 && s->ok && c=='K') s->ok = 2;
+    else                                   s->ok = 0;
+
+    if(s->col < sizeof(HDR)-1){
+        if(c != HDR[s->col]) s->other = true;
+    } else if(!s->other){
+        if(isdigit((unsigned char)c))    s->num[s->field] = s->num[s->field]*10 + (uint8_t)(c - '0');
+        else if(c == ',' && s->field < 2) s->field++;
+        else                              s->other = true;
+    }
+    if(s->col < 255) s->col++;
+}
+
+/* AT+HTTPACTION=<method> i czekanie na URC z wynikiem. true dla 2xx/3xx. */
+static bool http_action(uint8_t method, uint32_t action_timeout_ms, uint32_t* body_len) {
+    sw_t w;
+    at_write(&w, "AT+HTTPACTION="); sw_u32(&w, method);
+    if(!gsm_at_end()) return false;
+
+    /* Czekamy na URC z wynikiem */
+    action_scan_t scan;
+    memset(&scan, 0, sizeof(scan));
+    uint32_t ms=0;
+    uint32_t action_ms = gsm_timeout_ms(GSM_T_HTTPACTION);
+    if(action_ms > action_timeout_ms) action_ms = action_timeout_ms;
+
+    while(ms < action_ms){
+        int16_t ch;
+        while(!scan.done && (ch = UART_receive()) >= 0) action_feed(&scan, (char)ch);
+        if(scan.done || scan.got_error) break;
+        clock_delay_ms(1); ++ms;
+    }
+    learn(GSM_T_HTTPACTION, ms);
+
+    /* "OK" na samo AT+HTTPACTION zwykle przyszło już przed URC; jeśli nie,
+       doczytujemy tym samym skanerem */
+    for(uint16_t t=0; scan.done && !scan.got_ok && !scan.got_error && t<3000; ++t){
+        int16_t ch;
+        while(!scan.got_ok && !scan.got_error && (ch = UART_receive()) >= 0) action_feed(&scan, (char)ch);
+        if(!scan.got_ok) clock_delay_ms(1);
+    }
+
+    uint32_t http_status = scan.done ? scan.num[1] : 0;
+    *body_len = scan.num[2];
+    return http_status >= 200 && http_status < 400; /* uznaj 2xx/3xx jako sukces */
+}
 
 bool gsm_http_post(const char* url,
                    const char* content_type,
                    const char* data,
                    uint32_t    data_len,
                    uint16_t    httpdata_timeout_s,
-                   uint32_t    action_timeout_ms) {
-    if(!gsm_cmd_ok("AT+HTTPINIT", 3000)) return false;
+                   uint32_t    action_timeout_ms,
+                   gsm_http_body_cb on_body,
+                   void*       ctx) {
+    sw_mem_body_t body = { data, (uint16_t)data_len };
+    if(data_len > 0xFFFF) return false;
+
+    return gsm_http_post_stream(url, content_type, sw_fill_mem, &body, body.len,
+                                httpdata_timeout_s, action_timeout_ms, on_body, ctx);
+}
 
-    {   char cmd[256];
-        snprintf(cmd, sizeof(cmd), "AT+HTTPPARA=\"URL\",\"%s\"", url);
-        if(!gsm_cmd_ok(cmd, 5000)) { (void)gsm_cmd_ok("AT+HTTPTERM", 2000); return false; }
-    }
-    {   char cmd[160];
-        snprintf(cmd, sizeof(cmd), "AT+HTTPPARA=\"CONTENT\",\"%s\"",
-                 content_type ? content_type : "application/json");
-        if(!gsm_cmd_ok(cmd, 3000)) { (void)gsm_cmd_ok("AT+HTTPTERM", 2000); return false; }
-    }
+bool gsm_http_post_stream(const char* url,
+                          const char* content_type,
+                          sw_fill_fn  fill,
+                          void*       fill_ctx,
+                          uint16_t    data_len,
+                          uint16_t    httpdata_timeout_s,
+                          uint32_t    action_timeout_ms,
+                          gsm_http_body_cb on_body,
+                          void*       ctx) {
+    sw_t w;
+
+    if(!timed_cmd(GSM_T_HTTPINIT, "AT+HTTPINIT")) return false;
+
+    at_start(&w, "AT+HTTPPARA=\"URL\",\""); sw_str(&w, url); sw_char(&w, '"');
+    if(!timed_ok(GSM_T_HTTPPARA)) { (void)timed_cmd(GSM_T_HTTPTERM, "AT+HTTPTERM"); return false; }
+
+    at_start(&w, "AT+HTTPPARA=\"CONTENT\",\"");
+    sw_str(&w, content_type ? content_type : "application/json"); sw_char(&w, '"');
+    if(!timed_ok(GSM_T_HTTPPARA)) { (void)timed_cmd(GSM_T_HTTPTERM, "AT+HTTPTERM"); return false; }
 
-    {   char cmd[64];
-        snprintf(cmd, sizeof(cmd), "AT+HTTPDATA=%lu,%u",
-                 (unsigned long)data_len, (unsigned)(httpdata_timeout_s*1000U));
-        UART_send_string(cmd); UART_send_string("\r\n");
+    {   at_write(&w, "AT+HTTPDATA="); sw_u32(&w, data_len); sw_char(&w, ',');
+        sw_u32(&w, httpdata_timeout_s*1000UL);
+        if(!gsm_at_end()) { (void)timed_cmd(GSM_T_HTTPTERM, "AT+HTTPTERM"); return false; }
 
         /* prompt: "DOWNLOAD" lub '>' */
         bool got_prompt = wait_for_tokens((const char*[]){"DOWNLOAD"},1,(const char*[]) {NULL},0,5000)
                        || gsm_wait_prompt_gt(5000);
-        if(!got_prompt) { (void)gsm_cmd_ok("AT+HTTPTERM", 2000); return false; }
+        if(!got_prompt) { (void)timed_cmd(GSM_T_HTTPTERM, "AT+HTTPTERM"); return false; }
 
-        UART_send_string(data);
+        /* dokładnie data_len bajtów, nawet gdy fill napisze inaczej niż przy liczeniu */
+        (void)sw_send(UART_send, fill, fill_ctx, data_len);
         UART_send_string("\r\n");
+        if(!gsm_tx_ok()) { (void)timed_cmd(GSM_T_HTTPTERM, "AT+HTTPTERM"); return false; }
         /* większość FW po danych daje "OK" — ale niektóre nie; tutaj spróbujmy chwilę poczekać, ale nie traktujmy braku OK jako błąd krytyczny */
-        (void)wait_for_tokens((const char*[]){"OK"},1,(const char*[]){"ERROR"},1,10000);
+        (void)wait_for_tokens((const char*[]){"OK"},1,(const char*[]){"ERROR"},1,gsm_timeout_ms(GSM_T_HTTPDATA));
+        learn(GSM_T_HTTPDATA, last_wait_ms);
     }
 
-    UART_send_string("AT+HTTPACTION=1\r\n");
+    uint32_t body_len;
+    bool ok = http_action(1, action_timeout_ms, &body_len);
 
-    /* Czekamy na URC z wynikiem; parsowanie statusu opcjonalne */
-    char acc[256]; size_t acc_len=0; acc[0]='\0';
-    int http_status = -1;
-    uint32_t ms=0;
-
-    while(ms < action_timeout_ms){
-        int16_t ch;
-        while((ch = UART_receive()) >= 0){
-            if(acc_len+1 < sizeof(acc)){ acc[acc_len++]=(char)ch; acc[acc_len]='\0'; }
-            else { memmove(acc, acc+1, --acc_len); acc[acc_len++]=(char)ch; acc[acc_len]='\0'; }
-        }
-        char *p = strstr(acc, "+HTTPACTION:");
-        if(p){
-            /* próbuj sparsować ",<status>," */
-            int m1, m2;
-            if(sscanf(p, "+HTTPACTION: %d,%d,%d", &m1, &http_status, &m2) >= 2){
-                /* opcjonalnie doczekaj jeszcze na "OK", ale nie wymagaj */
-                (void)wait_for_tokens((const char*[]){"OK"},1,(const char*[]){"ERROR"},1,3000);
-                break;
-            }
-        }
-        if(strstr(acc,"ERROR")) { (void)gsm_cmd_ok("AT+HTTPTERM", 2000); return false; }
-        _delay_ms(1); ++ms;
+    /* odpowiedź serwera w tej samej sesji; błąd odczytu nie zmienia wyniku wysyłki */
+    if(ok && on_body && body_len > 0 && body_len <= GSM_HTTP_BODY_MAX){
+        (void)http_read_body(body_len, on_body, ctx);
     }
 
-    (void)gsm_cmd_ok("AT+HTTPTERM", 3000);
-    return (http_status >= 200 && http_status < 400); /* uznaj 2xx/3xx jako sukces */
+    (void)timed_cmd(GSM_T_HTTPTERM, "AT+HTTPTERM");
+    return ok;
+}
+
+/* -------------------- HTTP GET (treść czytana przez wołającego) -------------------- */
+
+bool gsm_http_get(const char* url, uint32_t action_timeout_ms, uint32_t* body_len) {
+    sw_t w;
+
+    *body_len = 0;
+    if(!timed_cmd(GSM_T_HTTPINIT, "AT+HTTPINIT")) return false;
+
+    at_start(&w, "AT+HTTPPARA=\"URL\",\""); sw_str(&w, url); sw_char(&w, '"');
+    if(timed_ok(GSM_T_HTTPPARA) && http_action(0, action_timeout_ms, body_len)) return true;
+
+    gsm_http_term();
+    return false;
+}
+
+/* Kopiuje kolejne porcje do bufora wołającego (nadmiar od modemu odpada) */
+typedef struct { uint8_t* buf; uint16_t used, cap; } copy_ctx_t;
+
+static void copy_body(const char* chunk, uint16_t len, void* ctx) {
+    copy_ctx_t* c = (copy_ctx_t*)ctx;
+    if(len > c->cap - c->used) len = c->cap - c->used;
+    memcpy(c->buf + c->used, chunk, len);
+    c->used += len;
+}
+
+int32_t gsm_http_read(uint32_t offset, uint8_t* buf, uint16_t want) {
+    copy_ctx_t c = { buf, 0, want };
+    int32_t n = http_read_chunk(offset, want, copy_body, &c);
+    return (n > (int32_t)want) ? -1 : n;
+}
+
+void gsm_http_term(void) {
+    (void)timed_cmd(GSM_T_HTTPTERM, "AT+HTTPTERM");
 }
 
 /* -------------------- UTF-8 → UCS2 (big-endian) -------------------- */
@@ -219,19 +688,16 @@ static uint16_t utf8_next_ucs2(const char* s, size_t* consumed){
     return (uint16_t)'?';
 }
 
-static void utf8_to_ucs2_hex(const char* text, char* out_hex, size_t out_sz, size_t* out_bytes){
-    size_t i=0, bytes=0;
-    char* p = out_hex;
+static void utf8_to_ucs2_hex(sw_t* w, const char* text){
+    size_t i=0;
 
-    while(text[i] && (size_t)(p - out_hex) < (out_sz - 4)){
+    while(text[i]){
         size_t cns=0;
         uint16_t u = utf8_next_ucs2(&text[i], &cns);
         i += cns;
-        p += sprintf(p, "%02X%02X", (u>>8)&0xFF, u&0xFF);
-        bytes += 2;
+        sw_hex8(w, (uint8_t)(u>>8));
+        sw_hex8(w, (uint8_t)u);
     }
-    *p = '\0';
-    if(out_bytes) *out_bytes = bytes;
 }
 
 /* -------------------- Numer → BCD (swapped) -------------------- */
@@ -245,15 +711,12 @@ static void sanitize_msisdn(char* dst, size_t dst_sz, const char* src){
     dst[j]='\0';
 }
 
-static void msisdn_to_bcd_swapped(const char* msisdn, char* out_hex, size_t out_sz){
+static void msisdn_to_bcd_swapped(sw_t* w, const char* msisdn){
     size_t nlen = strlen(msisdn);
-    char* p = out_hex;
-    for(size_t i=0; i<nlen && (size_t)(p - out_hex) < out_sz-2; i+=2){
-        char d1 = msisdn[i];
-        char d2 = (i+1<nlen) ? msisdn[i+1] : 'F';
-        p += sprintf(p, "%c%c", d2, d1);
+    for(size_t i=0; i<nlen; i+=2){
+        sw_char(w, (i+1<nlen) ? msisdn[i+1] : 'F');
+        sw_char(w, msisdn[i]);
     }
-    *p = '\0';
 }
 
 /* -------------------- Budowa PDU (UCS2) -------------------- */
@@ -265,38 +728,34 @@ size_t gsm_build_pdu_submit_ucs2(const char* msisdn_e164,
 {
     char num[32]; sanitize_msisdn(num, sizeof(num), msisdn_e164);
     size_t nlen = strlen(num);
-    if(nlen==0) return 0;
-
-    char ud_hex[560]; size_t ud_bytes=0; /* 280 znaków UCS2 max → 560 bajtów, ale SMS zwykle 70 znaków UCS2 */
-    utf8_to_ucs2_hex(text_utf8, ud_hex, sizeof(ud_hex), &ud_bytes);
+    if(nlen==0 || out_hex_sz < 2) return 0;
 
-    char bcd[64]="";
-    msisdn_to_bcd_swapped(num, bcd, sizeof(bcd));
+    /* UDL idzie przed treścią: najpierw przebieg liczący */
+    sw_t w;
+    sw_init_count(&w);
+    utf8_to_ucs2_hex(&w, text_utf8);
+    size_t ud_bytes = w.len / 2;
+    if(ud_bytes > 140) return 0;   /* więcej nie zmieści się w jednym SMS */
 
     /* SMSC = 00 (domyślne centrum operatora) */
     /* TPDU: 11 | MR=00 | DA_len | DA_type=91 | DA(bcd) | PID=00 | DCS=08 | VP=AA | UDL | UDH */
-    int written = snprintf(out_hex, out_hex_sz,
-        "00"        /* SMSC */
-        "11"        /* SMS-SUBMIT, TP-RD=0 */
-        "00"        /* TP-MR */
-        "%02X"      /* TP-DA length (digits) */
-        "91"        /* Type-of-Address: international */
-        "%s"        /* TP-DA digits in BCD swapped */
-        "00"        /* PID */
-        "08"        /* DCS = UCS2 */
-        "AA"        /* Validity (rel) ~4 dni */
-        "%02X"      /* UDL (bytes of UCS2) */
-        "%s",       /* User Data UCS2 hex */
-        (unsigned)(nlen),
-        bcd,
-        (unsigned)ud_bytes,
-        ud_hex
-    );
-    if(written <= 0) return 0;
+    sw_init_buf(&w, out_hex, out_hex_sz > 0xFFFF ? 0xFFFF : (uint16_t)out_hex_sz);
+    sw_str(&w, "00");                   /* SMSC */
+    sw_str(&w, "11");                   /* SMS-SUBMIT, TP-RD=0 */
+    sw_str(&w, "00");                   /* TP-MR */
+    sw_hex8(&w, (uint8_t)nlen);         /* TP-DA length (digits) */
+    sw_str(&w, "91");                   /* Type-of-Address: international */
+    msisdn_to_bcd_swapped(&w, num);     /* TP-DA digits in BCD swapped */
+    sw_str(&w, "00");                   /* PID */
+    sw_str(&w, "08");                   /* DCS = UCS2 */
+    sw_str(&w, "AA");                   /* Validity (rel) ~4 dni */
+    sw_hex8(&w, (uint8_t)ud_bytes);     /* UDL (bytes of UCS2) */
+    utf8_to_ucs2_hex(&w, text_utf8);    /* User Data UCS2 hex */
+    if(sw_overflow(&w)) return 0;
 
     /* Długość TPDU (dla AT+CMGS) = całość bez pierwszego pola SMSC ("00").
        Czyli: (strlen(out_hex)/2) - 1 bajt */
-    size_t total_octets = (size_t)strlen(out_hex)/2;
+    size_t total_octets = (size_t)w.len/2;
     if(total_octets == 0) return 0;
     size_t tpdu_len = total_octets - 1;
 
@@ -306,16 +765,17 @@ size_t gsm_build_pdu_submit_ucs2(const char* msisdn_e164,
 /* -------------------- Wysyłka SMS (UCS2) -------------------- */
 
 static bool sms_send_pdu_once(const char* pdu_hex, size_t tpdu_len, uint32_t timeouts_ms){
-    char cmd[32];
+    sw_t w;
     if(!gsm_cmd_ok("AT+CMGF=0", 3000)) return false;
 
-    snprintf(cmd, sizeof(cmd), "AT+CMGS=%lu", (unsigned long)tpdu_len);
-    UART_send_string(cmd); UART_send_string("\r\n");
+    at_write(&w, "AT+CMGS="); sw_u32(&w, (uint32_t)tpdu_len);
+    if(!gsm_at_end()) return false;
 
     if(!gsm_wait_prompt_gt(5000)) return false;
 
     UART_send_string(pdu_hex);
     UART_send(0x1A); /* Ctrl+Z */
+    if(!gsm_tx_ok()) return false;
 
     return wait_cmgs_ok(timeouts_ms);
 }
@@ -333,7 +793,7 @@ bool gsm_sms_send_ucs2(const char* msisdn_e164,
     for(uint8_t i=0; i<(max_retries?max_retries:1); ++i){
         if(gsm_ping(1000) && sms_send_pdu_once(pdu, tpdu_len, per_try)) return true;
         /* krótka przerwa między próbami */
-        for(uint8_t d=0; d<10; ++d) _delay_ms(100);
+        for(uint8_t d=0; d<10; ++d) clock_delay_ms(100);
     }
     return false;
 }
@@ -1,9 +1,40 @@
+#ifndef GSM_MODULE_H
+#define GSM_MODULE_H
+
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include "../hal/hal.h"
+#include "../telemetry/latency.h"
+#include "../telemetry/stream_writer.h"
 
 /* Wymaga: uart_isr.h (TX/RX ring) i zainicjalizowanego UART-a. */
 
+/* ------------- Piny zasilania (nadpisz przez -D: sterownik nie włącza config.h płytki) ------------- */
+
+/* PWRKEY sterowany przez tranzystor: stan wysoki = klawisz wciśnięty. */
+#ifndef GSM_PWRKEY_PIN
+#define GSM_PWRKEY_PIN  PB1
+#endif
+
+#ifndef GSM_PWRKEY_PORT
+#define GSM_PWRKEY_PORT PORTB
+#endif
+
+#ifndef GSM_PWRKEY_DDR
+#define GSM_PWRKEY_DDR  DDRB
+#endif
+
+/* Długość impulsu PWRKEY (włączenie i wyłączenie awaryjne). */
+#ifndef GSM_PWRKEY_PULSE_MS
+#define GSM_PWRKEY_PULSE_MS 3000
+#endif
+
+/* Opcjonalny pin STATUS modemu (stan wysoki = włączony). Bez niego stan
+   sprawdzany jest zapytaniem "AT":
+   #define GSM_STATUS_PIN     PD6
+   #define GSM_STATUS_PIN_REG PIND */
+
 /* ------------- Inicjalizacja / echo / gotowość ------------- */
 
 /* Czeka na zestaw URC po starcie modemu:
@@ -11,14 +42,111 @@
    Zwraca true, gdy komplet w czasie <= total_timeout_ms. */
 bool gsm_wait_ready(uint32_t total_timeout_ms);
 
+/* Etapy gotowości modemu, w kolejności. */
+typedef enum {
+    GSM_STAGE_OFF = 0,      /* brak odpowiedzi na "AT" */
+    GSM_STAGE_AT,           /* odpowiada na "AT" */
+    GSM_STAGE_SIM,          /* +CPIN: READY */
+    GSM_STAGE_REGISTERED,   /* +CEREG/+CREG: sieć domowa lub roaming (SMS) */
+    GSM_STAGE_ATTACHED      /* +CGATT: 1 (dane pakietowe, HTTP) */
+} gsm_stage_t;
+
+/* Sonda gotowości: "AT", AT+CPIN?, AT+CEREG?/AT+CREG?, AT+CGATT? aż do
+   etapu `target`. Wraca od razu, gdy modem już działa (np. był włączony
+   wcześniej i URC przepadły); URC ("*ATREADY", "+CPIN: READY") słucha
+   tylko między zapytaniami, gdy etap nie jest jeszcze gotowy.
+   Zwraca osiągnięty etap (== target przy sukcesie). */
+gsm_stage_t gsm_probe_ready(uint32_t total_timeout_ms, gsm_stage_t target);
+
+/* Jedno zapytanie sondy dla etapu *stage (bez czekania na URC); przy
+   sukcesie przesuwa *stage o jeden. Do wywoływania co ~1 s z pętli, która
+   w międzyczasie robi coś innego. Czas oczekiwania dopisuje do *spent_ms.
+   Zwraca false, gdy dalsze próby nie mają sensu (brak karty SIM). */
+bool gsm_probe_step(gsm_stage_t* stage, uint32_t* spent_ms);
+
+/* AT+CSQ: RSSI 0..31 (0 = -113 dBm, 31 = -51 dBm i więcej, co 2 dB),
+   -1 gdy nieznane (99) albo brak odpowiedzi. Czas dopisuje do *spent_ms. */
+int8_t gsm_csq(uint32_t* spent_ms);
+
 /* Wyłącza echo ATE0 i czeka na "OK". */
 bool gsm_disable_echo(uint16_t timeout_ms);
 
 /* Prosty "AT" ping (dla diagnostyki). */
 bool gsm_ping(uint16_t timeout_ms);
 
+/* ------------- Prędkość łącza / kontrola przepływu ------------- */
+
+/* Najwyższa prędkość, o którą pytamy modem (AT+IPR) */
+#ifndef GSM_BAUD_MAX
+#define GSM_BAUD_MAX 921600UL
+#endif
+
+/* Najwyższa prędkość AT+IPR (<= GSM_BAUD_MAX), którą UART przy `hz`
+   (U2X) trafia z błędem <= max_err_permil; 0 gdy żadna. */
+uint32_t gsm_best_baud(uint32_t hz, uint16_t max_err_permil);
+
+/* AT+IPR=<to> wysłane przy `from`, potem przełączenie UART (clock_set_baud)
+   i sprawdzenie "AT". Gdy modem nie odpowiada, UART wraca na `from`.
+   Bez AT&W: po wyłączeniu modem wraca do swojej prędkości, ale moduły,
+   które zapisują IPR same, trzeba przed wyłączeniem przestawić z powrotem. */
+bool gsm_set_baud(uint32_t from, uint32_t to);
+
+/* AT+IFC=2,2 / AT+IFC=0,0 i RTS/CTS po stronie UART (uart_isr.h). */
+bool gsm_set_flow_control(bool on);
+
+/* ------------- Zasilanie modemu ------------- */
+
+/* Czy modem jest włączony: pin STATUS albo odpowiedź na "AT". */
+bool gsm_is_powered(void);
+
+/* Impuls PWRKEY tylko wtedy, gdy modem jest wyłączony.
+   Zwraca true, gdy modem był już włączony albo impuls został wysłany. */
+bool gsm_power_on(void);
+
+/* AT+CPOF (a gdy modem nie odpowiada — impuls PWRKEY), tylko gdy jest włączony. */
+void gsm_power_off(void);
+
 /* ------------- HTTP POST (AT+HTTP...) ------------- */
 
+/* Treść odpowiedzi czytana kawałkami po tyle bajtów (AT+HTTPREAD=<offset>,<n>) */
+#ifndef GSM_HTTP_READ_CHUNK
+#define GSM_HTTP_READ_CHUNK 64
+#endif
+
+/* Dłuższej odpowiedzi nie czytamy wcale (to nie jest odpowiedź /ingest) */
+#ifndef GSM_HTTP_BODY_MAX
+#define GSM_HTTP_BODY_MAX 512
+#endif
+
+/* Klasy komend HTTP z uczonym timeoutem (latency.h). Najgorsze przypadki
+   (dotychczasowe stałe): 3 s, 5 s, 10 s, 120 s, 3 s, 3 s. */
+typedef enum {
+    GSM_T_HTTPINIT,
+    GSM_T_HTTPPARA,
+    GSM_T_HTTPDATA,         /* "OK" po wysłaniu danych */
+    GSM_T_HTTPACTION,       /* URC +HTTPACTION */
+    GSM_T_HTTPREAD,         /* nagłówek +HTTPREAD: <n> */
+    GSM_T_HTTPTERM,
+    GSM_T_COUNT
+} gsm_cmd_class_t;
+
+/* Najkrótszy timeout, jaki może wyjść z uczenia */
+#ifndef GSM_TIMEOUT_FLOOR_MS
+#define GSM_TIMEOUT_FLOOR_MS 300
+#endif
+
+/* Obserwowane czasy odpowiedzi na klasę. Płytka może je zapisać w EEPROM
+   i wczytać po starcie; wyzerowane = najgorsze przypadki. */
+extern latency_t gsm_latency[GSM_T_COUNT];
+
+/* Bieżący timeout klasy: średnia + K·odchylenie, między GSM_TIMEOUT_FLOOR_MS
+   a najgorszym przypadkiem. */
+uint32_t gsm_timeout_ms(gsm_cmd_class_t c);
+
+/* Odbiorca treści odpowiedzi: dostaje kolejne kawałki w miarę przychodzenia z UART,
+   bez buforowania całości. */
+typedef void (*gsm_http_body_cb)(const char* chunk, uint16_t len, void* ctx);
+
 /* Wysyła:
    AT+HTTPINIT
    AT+HTTPPARA="URL","<url>"
@@ -27,8 +155,12 @@ bool gsm_ping(uint16_t timeout_ms);
    <data>\r\n
    AT+HTTPACTION=1
    (czeka na "+HTTPACTION: 1,<status>,<len>" oraz "OK")
+   AT+HTTPREAD=<offset>,<n> ...   (tylko gdy on_body != NULL i jest treść)
    AT+HTTPTERM
 
+   Treść odpowiedzi trafia do on_body w tej samej sesji, przed HTTPTERM.
+   Timeouty poszczególnych kroków: gsm_timeout_ms() (action_timeout_ms
+   ogranicza dodatkowo HTTPACTION); każda odpowiedź uczy gsm_latency.
    Uwaga: wiele modułów po HTTPDATA oczekuje promptu "DOWNLOAD".
 */
 bool gsm_http_post(const char* url,
@@ -36,14 +168,43 @@ bool gsm_http_post(const char* url,
                    const char* data,
                    uint32_t    data_len,
                    uint16_t    httpdata_timeout_s,
-                   uint32_t    action_timeout_ms);
+                   uint32_t    action_timeout_ms,
+                   gsm_http_body_cb on_body,
+                   void*       ctx);
+
+/* Jak gsm_http_post(), ale treść pisze fill prosto do UART (stream_writer.h),
+   bez bufora na całość. data_len musi pochodzić z sw_measure() na tym samym
+   fill; gdy fill napisze inaczej, nadmiar jest ucinany, a brak dopełniany
+   spacjami — modem dostaje dokładnie tyle, ile zapowiada AT+HTTPDATA. */
+bool gsm_http_post_stream(const char* url,
+                          const char* content_type,
+                          sw_fill_fn  fill,
+                          void*       fill_ctx,
+                          uint16_t    data_len,
+                          uint16_t    httpdata_timeout_s,
+                          uint32_t    action_timeout_ms,
+                          gsm_http_body_cb on_body,
+                          void*       ctx);
+
+/* GET z treścią czytaną przez wołającego, np. do pliku większego niż RAM:
+     gsm_http_get()  AT+HTTPINIT, AT+HTTPPARA="URL", AT+HTTPACTION=0;
+                     true dla 2xx/3xx, długość treści w *body_len
+     gsm_http_read() jeden AT+HTTPREAD=<offset>,<want> do buf;
+                     liczba bajtów albo -1 (modem milczy, dopóki nie
+                     poprosimy o następny kawałek — można wtedy np. pisać flash)
+     gsm_http_term() AT+HTTPTERM; po udanym gsm_http_get() zawsze
+   Przy błędzie gsm_http_get() sam kończy sesję. */
+bool    gsm_http_get(const char* url, uint32_t action_timeout_ms, uint32_t* body_len);
+int32_t gsm_http_read(uint32_t offset, uint8_t* buf, uint16_t want);
+void    gsm_http_term(void);
 
 /* ------------- SMS PDU (UCS2, polskie znaki) ------------- */
 
 /* Buduje PDU (TPDU + pusty SMSC "00") w buforze out_hex (ASCII-HEX).
    msisdn_e164: np. "48660123456" (bez plusa; jeśli masz "+48...", możesz pominąć '+')
    text_utf8:   tekst z polskimi znakami (UTF-8)
-   Zwraca liczbę bajtów TPDU (wartość pod AT+CMGS=<len>) lub 0 przy błędzie.
+   Zwraca liczbę bajtów TPDU (wartość pod AT+CMGS=<len>) lub 0 przy błędzie
+   (także gdy tekst przekracza 140 bajtów UCS2 albo out_hex jest za mały).
 */
 size_t gsm_build_pdu_submit_ucs2(const char* msisdn_e164,
                                  const char* text_utf8,
@@ -70,4 +231,18 @@ bool gsm_cmd_ok(const char* cmd, uint32_t timeout_ms);
 bool gsm_stream_find(const char* needle, uint32_t timeout_ms);
 
 /* Czyta aż zobaczy znak '>' (np. po CMGS lub HTTPDATA). */
-bool gsm_wait_prompt_gt(uint32_t timeout_ms);
\ No newline at end of file
+bool gsm_wait_prompt_gt(uint32_t timeout_ms);
+
+/* Kończy komendę AT (CRLF) i liczy ją jako jedną wymianę z modemem.
+   false, gdy UART zgubił bajt komendy (CTS trzymany za długo, uart_isr.h):
+   modem dostał ją uciętą, wymianę trzeba przerwać. */
+bool gsm_at_end(void);
+
+/* Czy od poprzedniego sprawdzenia UART nie zgubił bajtu (np. po bloku
+   danych po '>'); zeruje licznik. */
+bool gsm_tx_ok(void);
+
+/* Komendy AT wysłane od startu (licznik się zawija); różnica na sesję. */
+uint32_t gsm_at_count(void);
+
+#endif /* GSM_MODULE_H */
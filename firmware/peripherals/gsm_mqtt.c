@@ -0,0 +1,203 @@
+#include <string.h>
+#include <ctype.h>
+#include "gsm_mqtt.h"
+#include "../communication/uart_isr.h"
+#include "../system/clock.h"
+
+/* Wynik wait_for() */
+enum { MQ_TIMEOUT = 0, MQ_MATCH, MQ_PROMPT, MQ_ERROR, MQ_MESSAGE };
+
+static gsm_http_body_cb on_msg;
+static void* msg_ctx;
+static uint8_t received;
+
+/* Stan czytnika między wywołaniami: po +CMQTTRXTOPIC / +CMQTTRXPAYLOAD
+   idzie tyle surowych bajtów (mogą zawierać "\r\n") */
+static uint16_t skip_left;
+static uint16_t body_left;
+static char piece[16];
+static uint8_t used;
+
+static char line[48];
+static uint8_t line_len;
+
+/* Ostatnia liczba w linii ("+CMQTTPUB: 0,11" -> 11), -1 gdy jej brak */
+static int16_t last_number(const char* s) {
+    const char* end = s + strlen(s);
+    const char* p = end;
+    while(p > s && isdigit((unsigned char)p[-1])) --p;
+    if(p == end) return -1;
+
+    int16_t n = 0;
+    while(p < end) n = n*10 + (*p++ - '0');
+    return n;
+}
+
+static void body_flush(void) {
+    if(used && on_msg) on_msg(piece, used, msg_ctx);
+    used = 0;
+}
+
+/* Czyta odpowiedzi aż do:
+   - linii zaczynającej się od `prefix` (zostaje w line[]),
+   - znaku zachęty '>' na początku linii (prompt == true),
+   - końca przychodzącej wiadomości (prefix == NULL i !prompt).
+   Wiadomości przychodzące obsługuje po drodze. */
+static uint8_t wait_for(const char* prefix, bool prompt, uint32_t timeout_ms) {
+    for(uint32_t t=0; t<timeout_ms; ++t){
+        int16_t ch;
+        while((ch = UART_receive()) >= 0){
+            char c = (char)ch;
+
+            if(skip_left){ --skip_left; continue; }
+            if(body_left){
+                piece[used++] = c;
+                if(--body_left == 0 || used == sizeof(piece)) body_flush();
+                continue;
+            }
+
+            if(prompt && line_len == 0 && c == '>') return MQ_PROMPT;
+            if(c == '\r') continue;
+            if(c != '\n'){
+                if(line_len < sizeof(line)-1) line[line_len++] = c;
+                continue;
+            }
+            if(line_len == 0) continue;
+            line[line_len] = '\0';
+            line_len = 0;
+
+            if(strncmp(line, "+CMQTTRXTOPIC:", 14) == 0){
+                int16_t n = last_number(line);
+                skip_left = (n > 0) ? (uint16_t)n : 0;
+            } else if(strncmp(line, "+CMQTTRXPAYLOAD:", 16) == 0){
+                int16_t n = last_number(line);
+                body_left = (n > 0) ? (uint16_t)n : 0;
+            } else if(strncmp(line, "+CMQTTRXEND:", 12) == 0){
+                if(received < 255) ++received;
+                if(!prefix && !prompt) return MQ_MESSAGE;
+            } else if(prefix && strncmp(line, prefix, strlen(prefix)) == 0){
+                return MQ_MATCH;
+            } else if(strstr(line, "ERROR")){
+                return MQ_ERROR;
+            }
+        }
+        clock_delay_ms(1);
+    }
+    return MQ_TIMEOUT;
+}
+
+/* Komendy składane w locie prosto do UART (stream_writer.h): cmd() zaczyna,
+   a wait_ok() / wait_result() / block() wysyłają CRLF i czekają */
+static sw_t* cmd(const char* head) {
+    static sw_t w;
+    sw_init_sink(&w, UART_send, 0);
+    sw_str(&w, head);
+    return &w;
+}
+
+/* Nie gsm_cmd_ok(): tamto czyści RX przed wysłaniem i zgubiłoby wiadomości */
+static bool wait_ok(uint32_t timeout_ms) {
+    if(!gsm_at_end()) return false;
+    return wait_for("OK", false, timeout_ms) == MQ_MATCH;
+}
+
+/* Wynik w URC: "<urc> 0,<err>" albo "<urc> <err>", 0 = sukces */
+static bool wait_result(const char* urc, uint32_t timeout_ms) {
+    if(!gsm_at_end()) return false;
+    return wait_for(urc, false, timeout_ms) == MQ_MATCH && last_number(line) == 0;
+}
+
+static bool cmd_ok(const char* head, uint32_t timeout_ms) {
+    (void)cmd(head);
+    return wait_ok(timeout_ms);
+}
+
+static bool cmd_result(const char* head, const char* urc, uint32_t timeout_ms) {
+    (void)cmd(head);
+    return wait_result(urc, timeout_ms);
+}
+
+/* '>' i blok danych (temat, treść) dokładnie len bajtów, potem "OK" */
+static bool block(sw_fill_fn fill, void* ctx, uint16_t len) {
+    if(!gsm_at_end()) return false;
+    if(wait_for(NULL, true, 3000) != MQ_PROMPT) return false;
+
+    (void)sw_send(UART_send, fill, ctx, len);
+    if(!gsm_tx_ok()) return false;
+    return wait_for("OK", false, 3000) == MQ_MATCH;
+}
+
+static void topic_fill(sw_t* w, void* ctx) {
+    sw_str(w, (const char*)ctx);
+}
+
+bool gsm_mqtt_open(const char* broker,
+                   const char* client_id,
+                   uint16_t    keepalive_s,
+                   gsm_http_body_cb cb,
+                   void*       ctx) {
+    sw_t* w;
+
+    on_msg = cb; msg_ctx = ctx;
+    received = 0;
+    skip_left = body_left = 0;
+    used = 0; line_len = 0;
+
+    if(!cmd_result("AT+CMQTTSTART", "+CMQTTSTART:", 12000)) { gsm_mqtt_close(); return false; }
+
+    w = cmd("AT+CMQTTACCQ=0,\""); sw_str(w, client_id); sw_str(w, "\",0");
+    if(!wait_ok(3000)) { gsm_mqtt_close(); return false; }
+
+    /* clean session: stan po stronie brokera nie jest potrzebny, konfiguracja jest retained */
+    w = cmd("AT+CMQTTCONNECT=0,\""); sw_str(w, broker); sw_str(w, "\","); sw_u32(w, keepalive_s); sw_str(w, ",1");
+    if(!wait_result("+CMQTTCONNECT:", GSM_MQTT_CONNECT_MS)) { gsm_mqtt_close(); return false; }
+
+    return true;
+}
+
+bool gsm_mqtt_subscribe(const char* topic) {
+    uint16_t n = (uint16_t)strlen(topic);
+    sw_t* w = cmd("AT+CMQTTSUB=0,"); sw_u32(w, n); sw_str(w, ",1");
+    if(!block(topic_fill, (void*)topic, n)) return false;
+
+    return wait_for("+CMQTTSUB:", false, 10000) == MQ_MATCH && last_number(line) == 0;
+}
+
+bool gsm_mqtt_publish(const char* topic, const uint8_t* data, uint16_t len) {
+    sw_mem_body_t body = { data, len };
+    return gsm_mqtt_publish_stream(topic, sw_fill_mem, &body, len);
+}
+
+bool gsm_mqtt_publish_stream(const char* topic, sw_fill_fn fill, void* ctx, uint16_t len) {
+    uint16_t n = (uint16_t)strlen(topic);
+
+    for(uint8_t attempt=0; attempt<=GSM_MQTT_RETRIES; ++attempt){
+        sw_t* w;
+
+        /* modem czyści temat i treść po każdym AT+CMQTTPUB: przy powtórce podajemy je znowu */
+        w = cmd("AT+CMQTTTOPIC=0,"); sw_u32(w, n);
+        if(!block(topic_fill, (void*)topic, n)) continue;
+
+        w = cmd("AT+CMQTTPAYLOAD=0,"); sw_u32(w, len);
+        if(!block(fill, ctx, len)) continue;
+
+        /* QoS 1, bez retained, DUP przy powtórce */
+        w = cmd("AT+CMQTTPUB=0,1,"); sw_u32(w, GSM_MQTT_PUB_TIMEOUT_S); sw_str(w, attempt ? ",0,1" : ",0,0");
+        if(wait_result("+CMQTTPUB:", GSM_MQTT_PUB_TIMEOUT_S * 1000UL + 2000)) return true;
+    }
+    return false;
+}
+
+bool gsm_mqtt_poll(uint32_t timeout_ms) {
+    return wait_for(NULL, false, timeout_ms) == MQ_MESSAGE;
+}
+
+uint8_t gsm_mqtt_received(void) {
+    return received;
+}
+
+void gsm_mqtt_close(void) {
+    (void)cmd_result("AT+CMQTTDISC=0,60", "+CMQTTDISC:", 5000);
+    (void)cmd_ok("AT+CMQTTREL=0", 3000);
+    (void)cmd_result("AT+CMQTTSTOP", "+CMQTTSTOP:", 5000);
+}
@@ -0,0 +1,65 @@
+#ifndef GSM_MQTT_H
+#define GSM_MQTT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gsm_module.h"
+
+/* Klient MQTT modemu A7670 (AT+CMQTT*), jedno połączenie (client 0).
+   Wymaga: uart_isr.h i modemu z aktywnym PDP (gsm_probe_step do
+   GSM_STAGE_ATTACHED).
+
+   Połączenie zostaje otwarte na kilka publikacji w jednej sesji: jeden
+   AT+CMQTTCONNECT zamiast pełnego AT+HTTPINIT..HTTPTERM na każdą wiadomość.
+   Publikacja jest QoS 1: gsm_mqtt_publish() zwraca true dopiero po PUBACK
+   (+CMQTTPUB: 0,0), więc dane trzeba trzymać u siebie do tego momentu.
+
+   Wiadomości z subskrypcji (np. retained na temacie konfiguracji) przychodzą
+   jako URC w dowolnej chwili i są czytane w trakcie każdego oczekiwania;
+   treść trafia kawałkami do on_msg (temat jest pomijany — jest jedna
+   subskrypcja). */
+
+#ifndef GSM_MQTT_CONNECT_MS
+#define GSM_MQTT_CONNECT_MS 30000UL
+#endif
+
+/* Czas na PUBACK jednej próby (pub_timeout w AT+CMQTTPUB) */
+#ifndef GSM_MQTT_PUB_TIMEOUT_S
+#define GSM_MQTT_PUB_TIMEOUT_S 20
+#endif
+
+/* Ile razy publikować ponownie (z flagą DUP) bez PUBACK */
+#ifndef GSM_MQTT_RETRIES
+#define GSM_MQTT_RETRIES 2
+#endif
+
+/* AT+CMQTTSTART, AT+CMQTTACCQ, AT+CMQTTCONNECT (clean session).
+   broker: "tcp://host:port". Przy błędzie sam zwalnia klienta. */
+bool gsm_mqtt_open(const char* broker,
+                   const char* client_id,
+                   uint16_t    keepalive_s,
+                   gsm_http_body_cb on_msg,
+                   void*       ctx);
+
+/* AT+CMQTTSUB, QoS 1. Czeka na SUBACK (+CMQTTSUB: 0,0). */
+bool gsm_mqtt_subscribe(const char* topic);
+
+/* AT+CMQTTTOPIC, AT+CMQTTPAYLOAD, AT+CMQTTPUB QoS 1; powtarza do
+   GSM_MQTT_RETRIES razy. true po PUBACK. Dane binarne (dowolne bajty). */
+bool gsm_mqtt_publish(const char* topic, const uint8_t* data, uint16_t len);
+
+/* Jak gsm_mqtt_publish(), ale treść pisze fill prosto do UART (przy każdej
+   próbie od nowa); len z sw_measure() na tym samym fill. */
+bool gsm_mqtt_publish_stream(const char* topic, sw_fill_fn fill, void* ctx, uint16_t len);
+
+/* Czyta URC przez timeout_ms albo do końca najbliższej przychodzącej
+   wiadomości. true, gdy wiadomość się skończyła. */
+bool gsm_mqtt_poll(uint32_t timeout_ms);
+
+/* Liczba wiadomości odebranych od gsm_mqtt_open(). */
+uint8_t gsm_mqtt_received(void);
+
+/* AT+CMQTTDISC, AT+CMQTTREL, AT+CMQTTSTOP (bez sprawdzania wyniku). */
+void gsm_mqtt_close(void);
+
+#endif /* GSM_MQTT_H */
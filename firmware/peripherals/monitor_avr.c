@@ -0,0 +1,84 @@
+/**
+ * @file monitor_avr.c
+ * @brief Main AVR side of the monitoring AVR link (blocking I2C + INT1 alert).
+ *
+ * Dependencies:
+ *  - i2c.h         : blocking TWI master primitives
+ *  - event_queue.h : EVENT_MONITOR_ALERT is posted from the INT1 ISR
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "monitor_avr.h"
+#include "../communication/i2c.h"
+#include "../system/event_queue.h"
+#include "../system/events.h"
+
+static volatile uint8_t alert_pending = 0;
+
+bool monitor_read(monitor_block_t *out) {
+    uint8_t *bytes = (uint8_t *)out;
+    uint8_t checksum = 0;
+
+    I2C_start_with_address(MONITOR_I2C_ADDRESS, 1);
+    for (uint8_t i = 0; i < sizeof(monitor_block_t); i++) {
+        bytes[i] = I2C_read_ack();
+        checksum += bytes[i];
+    }
+    uint8_t expected = I2C_read_nack();
+    I2C_stop();
+
+    return checksum == expected;
+}
+
+void monitor_command(uint8_t cmd) {
+    I2C_start_with_address(MONITOR_I2C_ADDRESS, 0);
+    I2C_write(cmd);
+    I2C_stop();
+}
+
+void monitor_reset(void) {
+    monitor_command(MONITOR_CMD_RESET);
+}
+
+void monitor_ack_events(void) {
+    monitor_command(MONITOR_CMD_ACK);
+
+    // Line is released by now, safe to listen for the next alert
+    alert_pending = 0;
+    EIFR = (1 << INTF1);
+    EIMSK |= (1 << INT1);
+}
+
+void monitor_set_thresholds(const monitor_thresholds_t *t) {
+    const uint8_t *bytes = (const uint8_t *)t;
+
+    I2C_start_with_address(MONITOR_I2C_ADDRESS, 0);
+    I2C_write(MONITOR_CMD_THRESHOLDS);
+    for (uint8_t i = 0; i < sizeof(monitor_thresholds_t); i++) {
+        I2C_write(bytes[i]);
+    }
+    I2C_stop();
+}
+
+void monitor_alert_init(void) {
+    // INT1 (PD3) input with pull-up, alert is active low (open drain on the ATtiny)
+    DDRD &= ~(1 << PD3);
+    PORTD |= (1 << PD3);
+
+    // Low level trigger: the only INT1 mode that wakes from power-down
+    EICRA &= ~((1 << ISC11) | (1 << ISC10));
+    EIFR = (1 << INTF1);
+    EIMSK |= (1 << INT1);
+}
+
+uint8_t monitor_alert_pending(void) {
+    return alert_pending;
+}
+
+ISR(INT1_vect) {
+    // Level interrupt keeps firing while the line is low: mask until acknowledged
+    EIMSK &= ~(1 << INT1);
+    alert_pending = 1;
+    event_post_isr(EVENT_MONITOR_ALERT, 0);
+}
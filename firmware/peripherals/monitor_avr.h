@@ -0,0 +1,107 @@
+/**
+ * @file monitor_avr.h
+ * @brief Monitoring AVR (ATtiny84) as an I2C peripheral of the main AVR.
+ *
+ * Shared by both boards: the ATtiny84 fills monitor_block_t and sends it
+ * byte by byte (little endian) followed by an additive checksum; the main
+ * AVR reads it back with monitor_read().
+ *
+ * The monitoring AVR also pulls an alert line low when one of its
+ * thresholds is crossed (heavy rain, gust, low solar power). The line is
+ * wired to INT1 on the main AVR; the reason stays latched in
+ * event_reason until it is acknowledged with monitor_ack_events().
+ */
+
+#ifndef MONITOR_AVR_H
+#define MONITOR_AVR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Monitoring AVR I2C address */
+#ifndef MONITOR_I2C_ADDRESS
+#define MONITOR_I2C_ADDRESS     0x42
+#endif
+
+/* Single byte commands written by the master */
+#define MONITOR_CMD_RESET       'R'   /**< Clear counters for a new interval */
+#define MONITOR_CMD_ACK         'A'   /**< Clear event_reason, release alert line */
+#define MONITOR_CMD_THRESHOLDS  'T'   /**< Followed by monitor_thresholds_t */
+
+/* event_reason bits */
+#define MONITOR_EVENT_RAIN      (1 << 0)   /**< Rain tips per minute above threshold */
+#define MONITOR_EVENT_GUST      (1 << 1)   /**< 3 s gust above threshold */
+#define MONITOR_EVENT_SOLAR_LOW (1 << 2)   /**< Solar power below threshold for too long */
+
+/** Data block sent by the monitoring AVR. */
+typedef struct __attribute__((packed)) {
+    uint16_t rain_count;               /**< Rain gauge tips since reset */
+    uint16_t wind_count;               /**< Anemometer pulses since reset */
+    uint16_t max_interval_wind_count;  /**< Most pulses in one 5 s interval */
+    uint16_t avg_wind_dir;             /**< Mean direction, 0.01 deg */
+    uint32_t energy_generated;         /**< Solar energy since reset, µWh */
+    uint16_t wind_gust;                /**< Highest 3 s gust since reset, cm/s */
+    uint16_t wind_mean;                /**< 10 min running mean, cm/s */
+    uint16_t rain_rate;                /**< 0.01 mm/h */
+    uint16_t peak_power;               /**< mW */
+    uint16_t min_voltage;              /**< mV, 0xFFFF until the first sample */
+    uint16_t max_voltage;              /**< mV */
+    uint32_t sleep_ticks;              /**< Ticks (F_CPU/1024) in idle sleep since reset */
+    uint32_t active_ticks;             /**< Ticks with the CPU running since reset */
+    uint32_t adc_sleep_ticks;          /**< Ticks in ADC noise reduction sleep (estimated, Timer1 halts there) */
+    uint8_t  event_reason;             /**< Latched MONITOR_EVENT_* bits */
+} monitor_block_t;
+
+/** Alert thresholds, 0 disables a condition. */
+typedef struct __attribute__((packed)) {
+    uint8_t  rain_tips_per_min;        /**< Tips in the last minute */
+    uint16_t gust_cm_s;                /**< Current 3 s gust */
+    uint16_t solar_low_mw;             /**< Panel power below this ... */
+    uint16_t solar_low_hold_s;         /**< ... for this long */
+} monitor_thresholds_t;
+
+/**
+ * @brief Read the data block and verify its checksum.
+ * @return true if the checksum matched.
+ */
+bool monitor_read(monitor_block_t *out);
+
+/**
+ * @brief Send one of the MONITOR_CMD_* single byte commands.
+ */
+void monitor_command(uint8_t cmd);
+
+/**
+ * @brief Start a new interval on the monitoring AVR (counters, gust, energy).
+ */
+void monitor_reset(void);
+
+/**
+ * @brief Acknowledge latched events and re-arm the alert interrupt.
+ */
+void monitor_ack_events(void);
+
+/**
+ * @brief Replace the alert thresholds on the monitoring AVR.
+ */
+void monitor_set_thresholds(const monitor_thresholds_t *t);
+
+/**
+ * @brief Configure the alert line (INT1, low level, wakes from power-down).
+ */
+void monitor_alert_init(void);
+
+/**
+ * @brief Non-zero once the alert line went low (cleared by monitor_ack_events).
+ */
+uint8_t monitor_alert_pending(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONITOR_AVR_H */
@@ -0,0 +1,147 @@
+/**
+ * @file clock.c
+ * @brief CLKPR switching with per-frequency UART, TWI and systick settings.
+ *
+ * Dependencies:
+ *  - uart_isr.h : UART_set_ubrr(), UART_ubrr_for(), UART_tx_idle()
+ *  - i2c.h      : I2C_set_clock()
+ *  - systick.h  : systick_rescale(), residency timing
+ */
+
+#include "../hal/hal.h"
+#include "clock.h"
+#include "systick.h"
+#include "../communication/uart_isr.h"
+#include "../communication/i2c.h"
+
+static uint8_t cur_div = 0;
+static uint8_t slow_div = 0;
+static uint8_t boosts = 0;
+static bool uart_active = false;
+
+static uint16_t ubrr[CLOCK_MAX_DIV + 1];
+static bool uart_ok[CLOCK_MAX_DIV + 1];
+
+static uint32_t since_ms = 0;
+static uint32_t residency[CLOCK_MAX_DIV + 1];
+
+static void account(void) {
+    uint32_t now = systick_ms();
+    residency[cur_div] += now - since_ms;
+    since_ms = now;
+}
+
+static void apply(uint8_t div) {
+    if (div == cur_div) return;
+
+    // A byte in the shift register would be cut at the wrong bit time
+    while (!UART_tx_idle());
+
+    account();
+
+    uint32_t hz = F_CPU >> div;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        HAL_WRITE(CLKPR, 1 << CLKPCE);   // timed sequence, 4 cycles
+        HAL_WRITE(CLKPR, div);
+        cur_div = div;
+
+        UART_set_ubrr(ubrr[div]);
+        I2C_set_clock(hz);
+        systick_rescale(hz);
+    }
+}
+
+/* Deepest allowed divider when nothing is boosted */
+static uint8_t target(void) {
+    if (boosts) return 0;
+
+    uint8_t div = slow_div;
+    while (div && uart_active && !uart_ok[div]) div--;
+    return div;
+}
+
+static void uart_tables(uint32_t uart_baud) {
+    for (uint8_t d = 0; d <= CLOCK_MAX_DIV; d++) {
+        uint16_t err;
+        ubrr[d] = UART_ubrr_for(F_CPU >> d, uart_baud, &err);
+        uart_ok[d] = err <= CLOCK_UART_MAX_ERR_PERMIL;
+    }
+}
+
+void clock_init(uint32_t uart_baud, uint8_t slow) {
+    uart_tables(uart_baud);
+    for (uint8_t d = 0; d <= CLOCK_MAX_DIV; d++) residency[d] = 0;
+
+    slow_div = (slow > CLOCK_MAX_DIV) ? CLOCK_MAX_DIV : slow;
+    boosts = 0;
+    cur_div = 0;
+    since_ms = systick_ms();
+    apply(target());
+}
+
+void clock_set_baud(uint32_t uart_baud) {
+    while (!UART_tx_idle());
+
+    uart_tables(uart_baud);
+    uint8_t div = target();
+    if (div != cur_div) {
+        apply(div);   // sets the new divisor on the way
+    } else {
+        UART_set_ubrr(ubrr[cur_div]);
+    }
+}
+
+void clock_boost(void) {
+    boosts++;
+    apply(0);
+}
+
+void clock_unboost(void) {
+    if (boosts) boosts--;
+    apply(target());
+}
+
+void clock_uart_active(bool active) {
+    uart_active = active;
+    apply(target());
+}
+
+uint32_t clock_hz(void) {
+    return F_CPU >> cur_div;
+}
+
+uint8_t clock_div(void) {
+    return cur_div;
+}
+
+void clock_delay_ms(uint16_t ms) {
+    // 4 cycles per count
+    uint16_t per_ms = (uint16_t)(clock_hz() / 4000UL);
+    while (ms--) {
+        HAL_DELAY_LOOP4(per_ms);
+        HAL_WDT_RESET();   // a bounded wait is progress (scheduler.h)
+    }
+}
+
+uint32_t clock_residency_ms(uint8_t div) {
+    if (div > CLOCK_MAX_DIV) return 0;
+    account();
+    return residency[div];
+}
+
+uint32_t clock_charge_uas(void) {
+    uint32_t uas = 0;
+
+    account();
+    for (uint8_t d = 0; d <= CLOCK_MAX_DIV; d++) {
+        // ms * MHz * µA/MHz / 1000 = µA·s, split so it cannot overflow
+        uint32_t ua = ((F_CPU / 1000000UL) >> d) * CLOCK_UA_PER_MHZ;
+        uas += (residency[d] / 1000UL) * ua + (residency[d] % 1000UL) * ua / 1000UL;
+    }
+    return uas;
+}
+
+void clock_clear_residency(void) {
+    account();
+    for (uint8_t d = 0; d <= CLOCK_MAX_DIV; d++) residency[d] = 0;
+}
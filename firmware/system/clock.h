@@ -0,0 +1,108 @@
+/**
+ * @file clock.h
+ * @brief Run-time CPU clock scaling with CLKPR (ATmega328P).
+ *
+ * The CPU runs at F_CPU / 2^div. Code that needs full speed (bit-banged
+ * 1-Wire timing, float compensation, payload formatting) brackets itself
+ * with clock_boost() / clock_unboost(); otherwise the clock drops to the
+ * slow divider. On every change the UART divisor, the TWI bit rate and
+ * the 1 ms systick are recomputed for the new frequency.
+ *
+ * The UART only allows dividers where the baud rate stays within
+ * CLOCK_UART_MAX_ERR_PERMIL. At 115200 baud that is full speed only.
+ * Lower baud rates (e.g. 9600 down to 1 MHz) let modem waits run slow:
+ * pipeline.c switches the modem to such a rate (clock_set_baud() after
+ * AT+IPR) while it waits for the network.
+ *
+ * _delay_ms()/_delay_us() are compiled for F_CPU and are only exact at
+ * full speed. Use clock_delay_ms() in code that may run slow, and boost
+ * around code that depends on _delay_us() timing.
+ */
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Deepest divider used (2^4: 1 MHz at F_CPU = 16 MHz, systick still exact). */
+#define CLOCK_MAX_DIV 4
+
+/** Largest accepted UART baud error, 1/1000. */
+#ifndef CLOCK_UART_MAX_ERR_PERMIL
+#define CLOCK_UART_MAX_ERR_PERMIL 25
+#endif
+
+/**
+ * Typical active supply current per MHz at 5 V (datasheet curves), for
+ * clock_charge_uas(). Only this figure is estimated: the residencies it
+ * multiplies are counted, and testing/host/test_clock.c runs a sample and
+ * an upload cycle with and without scaling to compare them.
+ */
+#ifndef CLOCK_UA_PER_MHZ
+#define CLOCK_UA_PER_MHZ 550UL
+#endif
+
+/**
+ * @brief Start at full speed and set the baud rate used for UART checks.
+ * @param slow_div Divider used when nothing is boosted (<= CLOCK_MAX_DIV).
+ */
+void clock_init(uint32_t uart_baud, uint8_t slow_div);
+
+/**
+ * @brief Change the UART baud rate (e.g. after AT+IPR), at the current
+ *        and at every later divider. Waits for TX to finish first.
+ */
+void clock_set_baud(uint32_t uart_baud);
+
+/**
+ * @brief Require full speed until the matching clock_unboost(). Nested.
+ */
+void clock_boost(void);
+void clock_unboost(void);
+
+/**
+ * @brief Tell whether the UART is in use (limits the slow divider).
+ */
+void clock_uart_active(bool active);
+
+/**
+ * @brief Current CPU frequency in Hz.
+ */
+uint32_t clock_hz(void);
+
+/**
+ * @brief Current divider (0 = F_CPU).
+ */
+uint8_t clock_div(void);
+
+/**
+ * @brief Busy-wait that is correct at any divider.
+ */
+void clock_delay_ms(uint16_t ms);
+
+/**
+ * @brief Time spent at each divider since the last clear, ms.
+ */
+uint32_t clock_residency_ms(uint8_t div);
+
+/**
+ * @brief Estimated CPU charge since the last clear, µA·s, from
+ *        residency × frequency × CLOCK_UA_PER_MHZ (config.h).
+ */
+uint32_t clock_charge_uas(void);
+
+/**
+ * @brief Zero residency counters (start of an instrumented cycle).
+ */
+void clock_clear_residency(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOCK_H */
@@ -0,0 +1,41 @@
+/**
+ * @file event_queue.c
+ * @brief SPSC event ring (spsc_ring.h) with 8-bit indices.
+ */
+
+#include <util/atomic.h>
+#include "event_queue.h"
+#include "spsc_ring.h"
+
+SPSC_RING(event_ring, event_t, EVENT_QUEUE_SIZE)
+
+static event_ring_t ring;
+
+bool event_post_isr(uint8_t type, uint8_t arg) {
+    return event_ring_push(&ring, (event_t){ .type = type, .arg = arg });
+}
+
+bool event_post(uint8_t type, uint8_t arg) {
+    bool ok;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ok = event_post_isr(type, arg);
+    }
+    return ok;
+}
+
+bool event_get(event_t *ev) {
+    return event_ring_pop(&ring, ev);
+}
+
+bool event_pending(void) {
+    return !event_ring_empty(&ring);
+}
+
+uint8_t event_dropped(void) {
+    uint16_t d;
+    // 16 bits written by the ISRs: two byte loads that one could split
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        d = ring.dropped;
+    }
+    return d > 0xFF ? 0xFF : (uint8_t)d;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file event_queue.h
+ * @brief Lock-free single-producer/single-consumer event queue (ISR -> main loop).
+ *
+ * The producer side is interrupt context: AVR ISRs do not nest, so all
+ * ISRs together act as one producer. The consumer is the scheduler in
+ * the main loop. The ring is an spsc_ring.h instance: head and tail are
+ * single bytes, so each side updates its index with one atomic store and
+ * no locking is needed.
+ *
+ * Code running with interrupts enabled must post with event_post(),
+ * which blocks interrupts around the producer side.
+ */
+
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Queue length, power of two. */
+#define EVENT_QUEUE_SIZE 16
+
+typedef struct {
+    uint8_t type;   /**< EVENT_* id, see events.h */
+    uint8_t arg;    /**< Event specific */
+} event_t;
+
+/**
+ * @brief Post from an ISR (or with interrupts disabled).
+ * @return false if the queue was full (counted in event_dropped()).
+ */
+bool event_post_isr(uint8_t type, uint8_t arg);
+
+/**
+ * @brief Post from main-loop code (interrupts enabled).
+ */
+bool event_post(uint8_t type, uint8_t arg);
+
+/**
+ * @brief Take the oldest event. Main loop only.
+ * @return false if the queue is empty.
+ */
+bool event_get(event_t *ev);
+
+/**
+ * @brief true if events are waiting (used before going to sleep).
+ */
+bool event_pending(void);
+
+/**
+ * @brief Events lost because the queue was full.
+ */
+uint8_t event_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENT_QUEUE_H */
@@ -0,0 +1,16 @@
+/**
+ * @file events.h
+ * @brief Event ids of the main AVR (event_queue.h / scheduler.h).
+ *
+ * At most 16 ids: tasks subscribe with a 16-bit mask, see SCHED_EVENT().
+ */
+
+#ifndef EVENTS_H
+#define EVENTS_H
+
+enum {
+    EVENT_MONITOR_ALERT = 0,   /**< Alert line from the monitoring AVR (INT1) */
+    EVENT_COUNT
+};
+
+#endif /* EVENTS_H */
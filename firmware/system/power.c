@@ -0,0 +1,111 @@
+/**
+ * @file power.c
+ * @brief Power rail reference counting and on-time accounting.
+ *
+ * Dependencies:
+ *  - systick.h : millisecond time base
+ */
+
+#include "power.h"
+#include "systick.h"
+
+typedef struct {
+    uint8_t  refs;
+    uint8_t  on;
+    uint32_t on_since_ms;
+    uint32_t ready_at_ms;
+    uint32_t on_total_ms;
+} rail_state_t;
+
+static const power_rail_desc_t *desc = 0;
+static uint8_t rail_count = 0;
+static rail_state_t state[POWER_MAX_RAILS];
+
+void power_init(const power_rail_desc_t *rails, uint8_t count, uint8_t known_off) {
+    desc = rails;
+    rail_count = (count > POWER_MAX_RAILS) ? POWER_MAX_RAILS : count;
+
+    for (uint8_t i = 0; i < rail_count; i++) {
+        state[i].refs = 0;
+        state[i].on = 0;
+        state[i].on_total_ms = 0;
+        if (!(known_off & (1 << i))) desc[i].off();
+    }
+}
+
+bool power_acquire(uint8_t rail) {
+    if (rail >= rail_count) return false;
+
+    rail_state_t *s = &state[rail];
+    if (s->refs) {
+        s->refs++;
+        return true;
+    }
+
+    // Parent first, and it must be usable before this rail is switched
+    uint8_t parent = desc[rail].parent;
+    if (parent != POWER_NO_PARENT) {
+        if (!power_acquire(parent)) return false;
+        power_wait_ready(parent);
+    }
+
+    if (!desc[rail].on()) {
+        if (parent != POWER_NO_PARENT) power_release(parent);
+        return false;
+    }
+
+    uint32_t now = systick_ms();
+    s->refs = 1;
+    s->on = 1;
+    s->on_since_ms = now;
+    s->ready_at_ms = now + desc[rail].settle_ms;
+    return true;
+}
+
+void power_release(uint8_t rail) {
+    if (rail >= rail_count) return;
+
+    rail_state_t *s = &state[rail];
+    if (s->refs == 0) return;
+    if (--s->refs) return;
+
+    desc[rail].off();
+    s->on = 0;
+    s->on_total_ms += systick_ms() - s->on_since_ms;
+
+    // Children off before parents
+    if (desc[rail].parent != POWER_NO_PARENT) {
+        power_release(desc[rail].parent);
+    }
+}
+
+bool power_ready(uint8_t rail) {
+    if (rail >= rail_count || !state[rail].on) return false;
+    return (int32_t)(systick_ms() - state[rail].ready_at_ms) >= 0;
+}
+
+void power_wait_ready(uint8_t rail) {
+    while (power_is_on(rail) && !power_ready(rail));
+}
+
+bool power_is_on(uint8_t rail) {
+    return rail < rail_count && state[rail].on;
+}
+
+uint32_t power_on_time_ms(uint8_t rail) {
+    if (rail >= rail_count) return 0;
+
+    uint32_t total = state[rail].on_total_ms;
+    if (state[rail].on) {
+        total += systick_ms() - state[rail].on_since_ms;
+    }
+    return total;
+}
+
+void power_clear_counters(void) {
+    uint32_t now = systick_ms();
+    for (uint8_t i = 0; i < rail_count; i++) {
+        state[i].on_total_ms = 0;
+        state[i].on_since_ms = now;
+    }
+}
@@ -0,0 +1,88 @@
+/**
+ * @file power.h
+ * @brief Reference-counted power rails with sequencing and on-time accounting.
+ *
+ * Every job that needs a rail acquires it and releases it when done; the
+ * rail is switched on by the first user and off by the last one. A rail
+ * may depend on a parent rail, which is acquired before it and released
+ * after it. After switching on, a rail is only "ready" once its settle
+ * time has passed.
+ *
+ * The rail table (switch hooks, settle times, parents) is provided by the
+ * board, see power_init().
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of rails. */
+#define POWER_MAX_RAILS 4
+
+/** No parent rail. */
+#define POWER_NO_PARENT 0xFF
+
+/** Board description of one rail. */
+typedef struct {
+    bool     (*on)(void);    /**< Switch on, false if the rail failed to come up */
+    void     (*off)(void);   /**< Switch off */
+    uint16_t settle_ms;      /**< Time from on() until the rail is usable */
+    uint8_t  parent;         /**< Rail that must be up first, or POWER_NO_PARENT */
+} power_rail_desc_t;
+
+/**
+ * @brief Register the board's rail table. All rails start switched off.
+ * @param rails     Table indexed by rail number (kept by reference).
+ * @param count     Number of rails (<= POWER_MAX_RAILS).
+ * @param known_off Bit mask of rails known to be off already (e.g. after a
+ *                  warm restart); their off() hook is not called.
+ */
+void power_init(const power_rail_desc_t *rails, uint8_t count, uint8_t known_off);
+
+/**
+ * @brief Take a reference on a rail, switching it (and its parent) on if needed.
+ * @return false if the rail could not be switched on (reference not taken).
+ */
+bool power_acquire(uint8_t rail);
+
+/**
+ * @brief Drop a reference; the last one switches the rail off.
+ */
+void power_release(uint8_t rail);
+
+/**
+ * @brief true once the rail is on and its settle time has passed.
+ */
+bool power_ready(uint8_t rail);
+
+/**
+ * @brief Block until power_ready() (returns immediately if the rail is off).
+ */
+void power_wait_ready(uint8_t rail);
+
+/**
+ * @brief true while the rail is switched on.
+ */
+bool power_is_on(uint8_t rail);
+
+/**
+ * @brief Total time the rail has been on, including the current period (ms).
+ */
+uint32_t power_on_time_ms(uint8_t rail);
+
+/**
+ * @brief Zero all on-time counters (e.g. after they were uploaded).
+ */
+void power_clear_counters(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POWER_H */
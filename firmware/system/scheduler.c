@@ -0,0 +1,210 @@
+/**
+ * @file scheduler.c
+ * @brief Task slots, event dispatch and deadline-driven sleep.
+ *
+ * Dependencies:
+ *  - systick.h     : millisecond time base, time per sleep mode
+ *  - event_queue.h : events posted by ISRs
+ *
+ * Owns the watchdog: supervision in reset mode, wake-up timer in power-down.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#include "scheduler.h"
+#include "event_queue.h"
+#include "systick.h"
+
+typedef struct {
+    sched_task_fn fn;
+    uint32_t wake_at;
+    uint16_t subscribe;
+    uint16_t pending;
+    bool     timed;
+} task_t;
+
+static task_t tasks[SCHED_MAX_TASKS];
+static uint8_t clock_holds = 0;
+static volatile bool wdt_fired = false;
+static void (*pass_hook)(void) = 0;
+
+static void set_next(task_t *t, uint32_t delay_ms) {
+    if (delay_ms == SCHED_WAIT_EVENT) {
+        t->timed = false;
+    } else {
+        t->timed = true;
+        t->wake_at = systick_ms() + delay_ms;
+    }
+}
+
+void sched_init(void) {
+    for (uint8_t i = 0; i < SCHED_MAX_TASKS; i++) {
+        tasks[i].fn = 0;
+    }
+    clock_holds = 0;
+}
+
+int8_t sched_add(sched_task_fn fn, uint16_t subscribe, uint32_t delay_ms) {
+    for (uint8_t i = 0; i < SCHED_MAX_TASKS; i++) {
+        if (tasks[i].fn) continue;
+
+        tasks[i].fn = fn;
+        tasks[i].subscribe = subscribe;
+        tasks[i].pending = 0;
+        set_next(&tasks[i], delay_ms);
+        return (int8_t)i;
+    }
+    return -1;
+}
+
+void sched_wake(int8_t id, uint32_t delay_ms) {
+    if (id < 0 || id >= SCHED_MAX_TASKS || !tasks[id].fn) return;
+    set_next(&tasks[id], delay_ms);
+}
+
+uint32_t sched_next_ms(int8_t id) {
+    if (id < 0 || id >= SCHED_MAX_TASKS || !tasks[id].fn || !tasks[id].timed) return SCHED_WAIT_EVENT;
+
+    int32_t left = (int32_t)(tasks[id].wake_at - systick_ms());
+    return (left > 0) ? (uint32_t)left : 0;
+}
+
+void sched_on_pass(void (*hook)(void)) {
+    pass_hook = hook;
+}
+
+void sched_hold_clock(void) {
+    clock_holds++;
+}
+
+void sched_release_clock(void) {
+    if (clock_holds) clock_holds--;
+}
+
+/* Watchdog periods are 16 ms << n, n = 0..9; pick the longest <= ms */
+static uint8_t wdt_period(uint32_t ms, uint16_t *period_ms) {
+    uint8_t n = 0;
+    while (n < 9 && ((uint32_t)SCHED_PWR_DOWN_MIN_MS << (n + 1)) <= ms) n++;
+    *period_ms = (uint16_t)(SCHED_PWR_DOWN_MIN_MS << n);
+    return n;
+}
+
+static void wdt_interrupt_start(uint8_t n) {
+    uint8_t wdp = (n & 0x07) | ((n & 0x08) ? (1 << WDP3) : 0);
+
+    wdt_reset();
+    WDTCSR = (1 << WDCE) | (1 << WDE);   // timed sequence, 4 cycles
+    WDTCSR = (1 << WDIE) | wdp;          // interrupt only, no reset
+}
+
+static void wdt_interrupt_stop(void) {
+    wdt_reset();
+    MCUSR &= ~(1 << WDRF);
+    WDTCSR = (1 << WDCE) | (1 << WDE);
+    WDTCSR = 0;
+}
+
+/* Reset mode: a loop that stops kicking it restarts the CPU */
+static void wdt_supervise(void) {
+    wdt_enable(SCHED_WDT_TIMEOUT);
+}
+
+static void sleep_until_due(uint32_t now) {
+    bool timed = false;
+    uint32_t remain = SCHED_WAIT_EVENT;
+
+    for (uint8_t i = 0; i < SCHED_MAX_TASKS; i++) {
+        if (!tasks[i].fn || !tasks[i].timed) continue;
+
+        int32_t left = (int32_t)(tasks[i].wake_at - now);
+        if (left <= 0) return;
+        if ((uint32_t)left < remain) remain = (uint32_t)left;
+        timed = true;
+    }
+
+    // Nothing may slip in between the last check and sleep_cpu()
+    cli();
+    if (event_pending()) {
+        sei();
+        return;
+    }
+
+    if (clock_holds || (timed && remain < SCHED_PWR_DOWN_MIN_MS)) {
+        // Timer2 and UART need clk_io; the systick wakes us within 1 ms
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        systick_set_state(SYSTICK_IDLE);
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+        systick_set_state(SYSTICK_ACTIVE);
+        return;
+    }
+
+    // Supervision would reset a sleep longer than its timeout
+    uint16_t period_ms = 0;
+    if (timed) {
+        wdt_fired = false;
+        wdt_interrupt_start(wdt_period(remain, &period_ms));
+    } else {
+        wdt_interrupt_stop();
+    }
+
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    systick_set_state(SYSTICK_PWR_DOWN);
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+
+    cli();
+    wdt_interrupt_stop();
+    wdt_supervise();
+    sei();
+    // Timer2 is stopped in power-down; an external wake-up before the
+    // watchdog leaves the clock behind by less than one period
+    if (timed && wdt_fired) systick_advance(period_ms);
+    systick_set_state(SYSTICK_ACTIVE);
+}
+
+void sched_run(void) {
+    wdt_supervise();
+
+    for (;;) {
+        wdt_reset();
+
+        event_t ev;
+        while (event_get(&ev)) {
+            uint16_t bit = SCHED_EVENT(ev.type);
+            for (uint8_t i = 0; i < SCHED_MAX_TASKS; i++) {
+                if (tasks[i].fn && (tasks[i].subscribe & bit)) tasks[i].pending |= bit;
+            }
+        }
+
+        uint32_t now = systick_ms();
+        bool ran = false;
+
+        for (uint8_t i = 0; i < SCHED_MAX_TASKS; i++) {
+            task_t *t = &tasks[i];
+            if (!t->fn) continue;
+            if (!t->pending && !(t->timed && (int32_t)(now - t->wake_at) >= 0)) continue;
+
+            uint16_t events = t->pending;
+            t->pending = 0;
+            set_next(t, t->fn(events));
+            ran = true;
+        }
+
+        if (!ran) {
+            sleep_until_due(now);
+        } else if (pass_hook) {
+            pass_hook();
+        }
+    }
+}
+
+ISR(WDT_vect) {
+    wdt_fired = true;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file scheduler.h
+ * @brief Cooperative run-to-completion scheduler with timed wake-ups (ATmega328P).
+ *
+ * Tasks are explicit state machines: each call does a short piece of
+ * work and returns when it wants to run again, in ms from now. A task may
+ * also subscribe to events; posting one (from an ISR, event_queue.h)
+ * makes the task runnable right away, with the events passed as a mask.
+ *
+ * When nothing is runnable the CPU sleeps as deeply as the nearest
+ * deadline allows:
+ *  - a deadline closer than SCHED_PWR_DOWN_MIN_MS, or a clock hold
+ *    (sched_hold_clock()), selects idle: the 1 ms systick and UART keep
+ *    running;
+ *  - a further deadline selects power-down, woken by the watchdog after
+ *    the longest WDT period that still fits. systick is advanced by that
+ *    period when the CPU wakes;
+ *  - with no deadline at all, power-down lasts until an external
+ *    interrupt.
+ *
+ * The time in each mode is charged by the systick (systick_state_ms());
+ * an untimed power-down stops Timer2 and is not seen there.
+ *
+ * sched_run() is supervised by the watchdog in reset mode: every pass and
+ * every clock_delay_ms()/systick_delay_ms() millisecond kicks it, so only
+ * code stuck without waiting (a dead bus, a spin on a flag) runs into
+ * SCHED_WDT_TIMEOUT. Power-down borrows the watchdog as its wake-up timer
+ * (or stops it when there is no deadline) and re-arms supervision after.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of task slots. */
+#define SCHED_MAX_TASKS 6
+
+/** Task return value: run again only when a subscribed event arrives. */
+#define SCHED_WAIT_EVENT 0xFFFFFFFFUL
+
+/** Shortest deadline worth a watchdog power-down (shortest WDT period is 16 ms). */
+#define SCHED_PWR_DOWN_MIN_MS 16
+
+/** Watchdog timeout of the supervised loop, a WDTO_* value (avr/wdt.h). */
+#ifndef SCHED_WDT_TIMEOUT
+#define SCHED_WDT_TIMEOUT WDTO_2S
+#endif
+
+/** Subscription mask bit of an event id. */
+#define SCHED_EVENT(id) ((uint16_t)1 << (id))
+
+/**
+ * @brief Task body.
+ * @param events SCHED_EVENT() bits that arrived since the last run (0 = timed run).
+ * @return Delay until the next timed run in ms, 0 = as soon as possible,
+ *         or SCHED_WAIT_EVENT.
+ */
+typedef uint32_t (*sched_task_fn)(uint16_t events);
+
+/**
+ * @brief Clear all task slots.
+ */
+void sched_init(void);
+
+/**
+ * @brief Put a task in a free slot.
+ * @param fn        Task body.
+ * @param subscribe SCHED_EVENT() mask of events that wake the task.
+ * @param delay_ms  First run, ms from now (or SCHED_WAIT_EVENT).
+ * @return Slot number, or -1 if all slots are taken.
+ */
+int8_t sched_add(sched_task_fn fn, uint16_t subscribe, uint32_t delay_ms);
+
+/**
+ * @brief Move a task's next timed run to delay_ms from now.
+ */
+void sched_wake(int8_t id, uint32_t delay_ms);
+
+/**
+ * @brief ms until a task's next timed run (0 if due), SCHED_WAIT_EVENT if
+ *        it only waits for events or the slot is empty.
+ */
+uint32_t sched_next_ms(int8_t id);
+
+/**
+ * @brief Call hook after every pass that ran a task, before the CPU sleeps
+ *        (all tasks are between steps there, e.g. to save state).
+ */
+void sched_on_pass(void (*hook)(void));
+
+/**
+ * @brief Keep the I/O clock running while asleep (idle only), e.g. while
+ *        the modem may send data over UART. Nested; pair with sched_release_clock().
+ */
+void sched_hold_clock(void);
+void sched_release_clock(void);
+
+/**
+ * @brief Start the watchdog, dispatch events, run due tasks and sleep.
+ *        Never returns.
+ */
+void sched_run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCHEDULER_H */
@@ -0,0 +1,168 @@
+/**
+ * @file spsc_ring.h
+ * @brief Lock-free single-producer/single-consumer ring, generated per element type (host buildable).
+ *
+ * SPSC_RING(name, type, size) defines name_t and its static inline
+ * operations, so each ring gets a compile-time mask and element size and
+ * the ISR side costs no call. size is a power of two from 2 to 256; the
+ * indices are single bytes and one slot stays free to tell full from
+ * empty, so a ring holds size - 1 elements.
+ *
+ * The producer writes head, dropped and high_water; the consumer writes
+ * tail. On AVR ISRs do not nest, so all ISRs feeding a ring act as one
+ * producer; main-loop code producing into a ring that an ISR also feeds
+ * must block interrupts around it. The slot is written before head is
+ * published and read before tail hands it back (SPSC_RELEASE /
+ * SPSC_ACQUIRE): a compiler barrier on AVR, where a byte store is atomic
+ * and there is one core, acquire/release atomics on the host, where the
+ * stress test runs the two sides on separate threads.
+ *
+ * Spans give direct access to the contiguous run of slots up to the wrap:
+ * the consumer parses in place and consumes what it used, the producer
+ * fills in place and commits. A span stays valid until it is consumed
+ * (committed); the other side never touches those slots.
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef __AVR__
+#define SPSC_ACQUIRE(x)    ({ uint8_t v_ = (x); __asm__ __volatile__("" ::: "memory"); v_; })
+#define SPSC_RELEASE(x, v) do { __asm__ __volatile__("" ::: "memory"); (x) = (v); } while (0)
+#else
+#define SPSC_ACQUIRE(x)    __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define SPSC_RELEASE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#endif
+
+#define SPSC_RING(name, type, size)                                                         \
+_Static_assert((size) >= 2 && (size) <= 256 && ((size) & ((size) - 1)) == 0,              \
+               #name ": size must be a power of two from 2 to 256");                      \
+                                                                                            \
+typedef struct {                                                                            \
+    volatile uint8_t  head;         /**< Next slot to write, producer only */              \
+    volatile uint8_t  tail;         /**< Next slot to read, consumer only */               \
+    volatile uint16_t dropped;      /**< Elements lost on a full ring (saturates) */       \
+    volatile uint8_t  high_water;   /**< Highest fill level seen */                        \
+    type buf[size];                                                                         \
+} name##_t;                                                                                 \
+                                                                                            \
+/* Empty, counters zeroed. Neither side may run. */                                         \
+static inline void name##_reset(name##_t *r) {                                              \
+    r->head = 0;                                                                            \
+    r->tail = 0;                                                                            \
+    r->dropped = 0;                                                                         \
+    r->high_water = 0;                                                                      \
+}                                                                                           \
+                                                                                            \
+/* Elements waiting; exact on either side, a lower bound seen from the consumer. */        \
+static inline uint8_t name##_count(const name##_t *r) {                                     \
+    return (uint8_t)((r->head - r->tail) & ((size) - 1));                                   \
+}                                                                                           \
+                                                                                            \
+static inline bool name##_empty(const name##_t *r) {                                        \
+    return r->head == r->tail;                                                              \
+}                                                                                           \
+                                                                                            \
+/* Producer: count n elements that did not fit. */                                         \
+static inline void name##_drop(name##_t *r, uint16_t n) {                                   \
+    uint16_t d = (uint16_t)(r->dropped + n);                                                \
+    r->dropped = (d < n) ? 0xFFFF : d;                                                      \
+}                                                                                           \
+                                                                                            \
+/* Producer: free contiguous slots from head, *p points at the first. */                   \
+static inline uint8_t name##_write_span(name##_t *r, type **p) {                            \
+    uint8_t h = r->head;                                                                    \
+    uint8_t t = SPSC_ACQUIRE(r->tail);                                                      \
+    uint16_t end = (t > h) ? (uint16_t)(t - 1) : (t == 0 ? (uint16_t)((size) - 1) : (size)); \
+    *p = &r->buf[h];                                                                        \
+    return (uint8_t)(end - h);                                                              \
+}                                                                                           \
+                                                                                            \
+/* Producer: publish n slots filled through write_span(). */                               \
+static inline void name##_commit(name##_t *r, uint8_t n) {                                  \
+    uint8_t next = (uint8_t)((r->head + n) & ((size) - 1));                                 \
+    SPSC_RELEASE(r->head, next);                                                            \
+    uint8_t fill = (uint8_t)((next - r->tail) & ((size) - 1));                              \
+    if (fill > r->high_water) r->high_water = fill;                                         \
+}                                                                                           \
+                                                                                            \
+/* Producer: append one element, false (and counted) if full. */                           \
+static inline bool name##_push(name##_t *r, type v) {                                       \
+    uint8_t h = r->head;                                                                    \
+    uint8_t next = (uint8_t)((h + 1) & ((size) - 1));                                       \
+    uint8_t t = SPSC_ACQUIRE(r->tail);                                                      \
+    if (next == t) {                                                                        \
+        name##_drop(r, 1);                                                                  \
+        return false;                                                                       \
+    }                                                                                       \
+    r->buf[h] = v;                                                                          \
+    SPSC_RELEASE(r->head, next);                                                            \
+    uint8_t fill = (uint8_t)((next - t) & ((size) - 1));                                    \
+    if (fill > r->high_water) r->high_water = fill;                                         \
+    return true;                                                                            \
+}                                                                                           \
+                                                                                            \
+/* Producer: append up to n elements, the rest is dropped. Returns the number stored. */  \
+static inline uint8_t name##_push_n(name##_t *r, const type *src, uint8_t n) {              \
+    uint8_t done = 0;                                                                       \
+    while (done < n) {                                                                      \
+        type *p;                                                                            \
+        uint8_t room = name##_write_span(r, &p);                                            \
+        if (room == 0) break;                                                               \
+        if (room > n - done) room = n - done;                                               \
+        memcpy(p, src + done, room * sizeof(type));                                         \
+        name##_commit(r, room);                                                             \
+        done += room;                                                                       \
+    }                                                                                       \
+    if (done < n) name##_drop(r, n - done);                                                 \
+    return done;                                                                            \
+}                                                                                           \
+                                                                                            \
+/* Consumer: waiting contiguous elements from tail, *p points at the first. */             \
+static inline uint8_t name##_read_span(name##_t *r, const type **p) {                       \
+    uint8_t t = r->tail;                                                                    \
+    uint8_t h = SPSC_ACQUIRE(r->head);                                                      \
+    *p = &r->buf[t];                                                                        \
+    return (uint8_t)((h >= t) ? h - t : (size) - t);                                        \
+}                                                                                           \
+                                                                                            \
+/* Consumer: hand back n slots read through read_span(). */                                \
+static inline void name##_consume(name##_t *r, uint8_t n) {                                 \
+    SPSC_RELEASE(r->tail, (uint8_t)((r->tail + n) & ((size) - 1)));                         \
+}                                                                                           \
+                                                                                            \
+/* Consumer: take the oldest element, false if empty. */                                   \
+static inline bool name##_pop(name##_t *r, type *v) {                                       \
+    uint8_t t = r->tail;                                                                    \
+    if (t == SPSC_ACQUIRE(r->head)) return false;                                           \
+    *v = r->buf[t];                                                                         \
+    SPSC_RELEASE(r->tail, (uint8_t)((t + 1) & ((size) - 1)));                               \
+    return true;                                                                            \
+}                                                                                           \
+                                                                                            \
+/* Consumer: take up to n elements. Returns the number copied. */                          \
+static inline uint8_t name##_pop_n(name##_t *r, type *dst, uint8_t n) {                     \
+    uint8_t done = 0;                                                                       \
+    while (done < n) {                                                                      \
+        const type *p;                                                                      \
+        uint8_t avail = name##_read_span(r, &p);                                            \
+        if (avail == 0) break;                                                              \
+        if (avail > n - done) avail = n - done;                                             \
+        memcpy(dst + done, p, avail * sizeof(type));                                        \
+        name##_consume(r, avail);                                                           \
+        done += avail;                                                                      \
+    }                                                                                       \
+    return done;                                                                            \
+}                                                                                           \
+                                                                                            \
+/* Zero dropped, high_water back to the current fill. The producer must be quiet. */       \
+static inline void name##_clear_stats(name##_t *r) {                                        \
+    r->dropped = 0;                                                                         \
+    r->high_water = name##_count(r);                                                        \
+}
+
+#endif /* SPSC_RING_H */
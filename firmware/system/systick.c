@@ -0,0 +1,83 @@
+/**
+ * @file systick.c
+ * @brief Timer2 CTC millisecond counter.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <avr/wdt.h>
+#include "systick.h"
+
+static volatile uint32_t ticks_ms = 0;
+static volatile uint8_t  cur_state = SYSTICK_ACTIVE;
+static volatile uint32_t state_ms[SYSTICK_STATES];
+
+void systick_init(void) {
+    TCCR2A = (1 << WGM21);              // CTC
+    TCCR2B = (1 << CS22);               // prescaler 64
+    OCR2A  = SYSTICK_OCR;
+    TCNT2  = 0;
+    TIFR2  = (1 << OCF2A);
+    TIMSK2 |= (1 << OCIE2A);
+}
+
+bool systick_rescale(uint32_t cpu_hz) {
+    // Timer2 prescalers and their CS22..CS20 bits
+    static const uint16_t div[] = { 8, 32, 64, 128, 256, 1024 };
+    static const uint8_t  cs[]  = { 2, 3,  4,  5,   6,   7 };
+
+    for (uint8_t i = 0; i < sizeof(div) / sizeof(div[0]); i++) {
+        uint32_t counts = cpu_hz / div[i];
+        if (counts % 1000UL || counts / 1000UL > 256) continue;
+
+        TCCR2B = cs[i];
+        OCR2A  = (uint8_t)(counts / 1000UL - 1);
+        TCNT2  = 0;    // old count may already be past the new OCR2A
+        return true;
+    }
+    return false;
+}
+
+uint32_t systick_ms(void) {
+    uint32_t now;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        now = ticks_ms;
+    }
+    return now;
+}
+
+void systick_advance(uint32_t ms) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ticks_ms += ms;
+        state_ms[cur_state] += ms;
+    }
+}
+
+void systick_resume(uint32_t ms) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ticks_ms = ms;
+    }
+}
+
+void systick_set_state(uint8_t state) {
+    cur_state = state;
+}
+
+uint32_t systick_state_ms(uint8_t state) {
+    uint32_t ms;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ms = state_ms[state];
+    }
+    return ms;
+}
+
+void systick_delay_ms(uint32_t ms) {
+    uint32_t start = systick_ms();
+    while ((systick_ms() - start) < ms) wdt_reset();
+}
+
+ISR(TIMER2_COMPA_vect) {
+    ticks_ms++;
+    state_ms[cur_state]++;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file systick.h
+ * @brief 1 ms system tick on Timer2 (ATmega328P).
+ *
+ * Timer2 runs in CTC mode with prescaler 64 and fires COMPA once per
+ * millisecond. The counter is the shared time base for rail on-time
+ * accounting, timeouts and scheduling.
+ *
+ * Each tick also charges its millisecond to the CPU state set with
+ * systick_set_state() (duty-cycle accounting): the ISR samples the state
+ * once per ms, so short idle sleeps and the active stretches between them
+ * average out without timestamping every wake-up. Time added with
+ * systick_advance() goes to the state current at that moment.
+ */
+
+#ifndef SYSTICK_H
+#define SYSTICK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Timer2 compare value for a 1 ms period at prescaler 64. */
+#define SYSTICK_OCR (F_CPU / 64UL / 1000UL - 1)
+
+/** CPU states for duty-cycle accounting. */
+typedef enum {
+    SYSTICK_ACTIVE = 0,     /**< Running code (default) */
+    SYSTICK_IDLE,           /**< SLEEP_MODE_IDLE */
+    SYSTICK_PWR_DOWN,       /**< SLEEP_MODE_PWR_DOWN (timed by the watchdog) */
+    SYSTICK_STATES
+} systick_state_t;
+
+/**
+ * @brief Start Timer2 as a 1 kHz tick.
+ */
+void systick_init(void);
+
+/**
+ * @brief Keep the 1 ms period after a CPU clock change (see clock.h).
+ *
+ * Picks the Timer2 prescaler that divides cpu_hz into a whole number of
+ * counts per millisecond. Exact for 16, 8, 4, 2 and 1 MHz.
+ * @return false if no prescaler fits (tick left unchanged).
+ */
+bool systick_rescale(uint32_t cpu_hz);
+
+/**
+ * @brief Milliseconds since systick_init() (wraps after ~49 days).
+ */
+uint32_t systick_ms(void);
+
+/**
+ * @brief Add time that passed while Timer2 was stopped (power-down).
+ */
+void systick_advance(uint32_t ms);
+
+/**
+ * @brief Continue the count from a saved value (warm restart). Not
+ *        charged to any state.
+ */
+void systick_resume(uint32_t ms);
+
+/**
+ * @brief Set the state the following milliseconds are charged to.
+ */
+void systick_set_state(uint8_t state);
+
+/**
+ * @brief Milliseconds spent in a state since systick_init() (wraps after ~49 days).
+ */
+uint32_t systick_state_ms(uint8_t state);
+
+/**
+ * @brief Busy-wait (with interrupts enabled) for ms milliseconds.
+ */
+void systick_delay_ms(uint32_t ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYSTICK_H */
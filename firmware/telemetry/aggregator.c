@@ -0,0 +1,76 @@
+/**
+ * @file aggregator.c
+ * @brief Integer Welford update and 64-bit integer square root.
+ */
+
+#include "aggregator.h"
+
+#define AGG_ONE ((int32_t)1 << AGG_FRAC_BITS)
+
+/* Division rounded to nearest, for either sign of num */
+static int32_t div_round(int32_t num, int32_t den) {
+    return (num >= 0) ? (num + den / 2) / den : -((-num + den / 2) / den);
+}
+
+static uint32_t isqrt64(uint64_t v) {
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+void agg_reset(agg_t *a) {
+    a->count = 0;
+    a->min = INT32_MAX;
+    a->max = INT32_MIN;
+    a->mean_q = 0;
+    a->m2_q = 0;
+}
+
+void agg_add(agg_t *a, int32_t x) {
+    if (a->count == UINT16_MAX) return;
+
+    if (x < a->min) a->min = x;
+    if (x > a->max) a->max = x;
+
+    a->count++;
+    int32_t x_q = x * AGG_ONE;
+    int32_t delta = x_q - a->mean_q;
+    a->mean_q += div_round(delta, a->count);
+    int32_t delta2 = x_q - a->mean_q;
+
+    // Same sign in exact arithmetic; rounding of the mean may flip a tiny one
+    int64_t inc = (int64_t)delta * delta2;
+    if (inc > 0) a->m2_q += inc;
+}
+
+void agg_record(const agg_t *a, agg_record_t *r) {
+    r->count = a->count;
+    if (a->count == 0) {
+        r->min = r->max = r->mean = 0;
+        r->stddev = 0;
+        return;
+    }
+
+    r->min = a->min;
+    r->max = a->max;
+    r->mean = div_round(a->mean_q, AGG_ONE);
+
+    if (a->count < 2) {
+        r->stddev = 0;
+    } else {
+        // sqrt(m2_q / (n - 1)) carries AGG_FRAC_BITS fractional bits
+        uint32_t sd_q = isqrt64((uint64_t)a->m2_q / (a->count - 1));
+        r->stddev = (sd_q + AGG_ONE / 2) >> AGG_FRAC_BITS;
+    }
+}
@@ -0,0 +1,65 @@
+/**
+ * @file aggregator.h
+ * @brief Streaming count/min/max/mean/stddev of one metric in fixed point (host buildable).
+ *
+ * Uses Welford's update, so the variance does not suffer from the
+ * cancellation of sum/sum-of-squares, and one sample costs one division.
+ * The mean is kept with AGG_FRAC_BITS fractional bits and the sum of
+ * squared deviations in 64 bits. Values are plain integers in the
+ * metric's own unit (e.g. 0.01 °C, Pa) within ±2^22, so that the
+ * deviation from the mean still fits 32 bits in fixed point; the sum of
+ * squared deviations has to stay below 2^47 (e.g. deviations under
+ * 46000 over a full count of 65535).
+ *
+ * No AVR headers are used here, so the same code runs on a PC.
+ */
+
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Fractional bits of the running mean. */
+#define AGG_FRAC_BITS 8
+
+typedef struct {
+    uint16_t count;
+    int32_t  min;
+    int32_t  max;
+    int32_t  mean_q;     /**< Mean << AGG_FRAC_BITS */
+    int64_t  m2_q;       /**< Sum of squared deviations << 2*AGG_FRAC_BITS */
+} agg_t;
+
+/** One aggregate, in the metric's unit. */
+typedef struct {
+    uint16_t count;
+    int32_t  min;
+    int32_t  max;
+    int32_t  mean;       /**< Rounded */
+    uint32_t stddev;     /**< Sample standard deviation, rounded (0 for count < 2) */
+} agg_record_t;
+
+/**
+ * @brief Start a new interval.
+ */
+void agg_reset(agg_t *a);
+
+/**
+ * @brief Add one sample (ignored once count would overflow).
+ */
+void agg_add(agg_t *a, int32_t x);
+
+/**
+ * @brief Summarise the interval so far.
+ */
+void agg_record(const agg_t *a, agg_record_t *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AGGREGATOR_H */
@@ -0,0 +1,105 @@
+/**
+ * @file config_delta.c
+ * @brief Character-level state machine for "cfg":"v<n>;<k>=<v>;...".
+ */
+
+#include "config_delta.h"
+
+enum {
+    ST_SEARCH,      /* looking for the key */
+    ST_VERSION_V,   /* expecting 'v' */
+    ST_VERSION,
+    ST_KEY,
+    ST_VALUE,
+    ST_DONE,
+    ST_ERROR
+};
+
+static const char KEY[] = "\"cfg\":\"";
+
+void config_delta_init(config_delta_t *d) {
+    d->state = ST_SEARCH;
+    d->matched = 0;
+    d->num = 0;
+    d->key = 0;
+    d->version = 0;
+    d->count = 0;
+}
+
+/* Adds a digit; false once the number no longer fits 16 bits */
+static bool digit(config_delta_t *d, char c) {
+    d->num = d->num * 10 + (uint8_t)(c - '0');
+    return d->num <= 0xFFFF;
+}
+
+static void feed_char(config_delta_t *d, char c) {
+    bool is_digit = (c >= '0' && c <= '9');
+
+    switch (d->state) {
+    case ST_SEARCH:
+        if (c == KEY[d->matched]) {
+            if (KEY[++d->matched] == '\0') d->state = ST_VERSION_V;
+        } else {
+            d->matched = (c == KEY[0]) ? 1 : 0;
+        }
+        break;
+
+    case ST_VERSION_V:
+        d->num = 0;
+        d->state = (c == 'v') ? ST_VERSION : ST_ERROR;
+        break;
+
+    case ST_VERSION:
+        if (is_digit) {
+            if (!digit(d, c)) d->state = ST_ERROR;
+        } else if (c == ';' || c == '"') {
+            d->version = (uint16_t)d->num;
+            d->num = 0;
+            d->state = (c == ';') ? ST_KEY : ST_DONE;
+        } else {
+            d->state = ST_ERROR;
+        }
+        break;
+
+    case ST_KEY:
+        if (is_digit) {
+            if (!digit(d, c) || d->num > 0xFF) d->state = ST_ERROR;
+        } else if (c == '=') {
+            d->key = (uint16_t)d->num;
+            d->num = 0;
+            d->state = ST_VALUE;
+        } else {
+            d->state = ST_ERROR;
+        }
+        break;
+
+    case ST_VALUE:
+        if (is_digit) {
+            if (!digit(d, c)) d->state = ST_ERROR;
+        } else if (c == ';' || c == '"') {
+            if (d->count == CONFIG_DELTA_MAX_PAIRS) {
+                d->state = ST_ERROR;
+                break;
+            }
+            d->keys[d->count] = (uint8_t)d->key;
+            d->values[d->count] = (uint16_t)d->num;
+            d->count++;
+            d->num = 0;
+            d->state = (c == ';') ? ST_KEY : ST_DONE;
+        } else {
+            d->state = ST_ERROR;
+        }
+        break;
+
+    default:
+        break;   // DONE / ERROR: ignore the rest of the body
+    }
+}
+
+void config_delta_feed(config_delta_t *d, const char *chunk, uint16_t len) {
+    while (len--) feed_char(d, *chunk++);
+}
+
+bool config_delta_complete(const config_delta_t *d) {
+    return d->state == ST_DONE;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file config_delta.h
+ * @brief Streaming parser of the config delta in the ingest response (host buildable).
+ *
+ * The server answers an upload with JSON that may carry
+ *
+ *     "cfg":"v<version>;<key>=<value>;<key>=<value>..."
+ *
+ * where keys are setting ids and values unsigned 16-bit numbers. The
+ * body is fed in whatever chunks AT+HTTPREAD delivers; only the pairs
+ * are kept, so the response never has to fit in RAM. Everything around
+ * the "cfg" string is skipped.
+ */
+
+#ifndef CONFIG_DELTA_H
+#define CONFIG_DELTA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONFIG_DELTA_MAX_PAIRS 12
+
+typedef struct {
+    uint8_t  state;
+    uint8_t  matched;              /**< Characters of the "cfg" key matched so far */
+    uint32_t num;
+    uint16_t key;
+    uint16_t version;
+    uint8_t  count;
+    uint8_t  keys[CONFIG_DELTA_MAX_PAIRS];
+    uint16_t values[CONFIG_DELTA_MAX_PAIRS];
+} config_delta_t;
+
+/**
+ * @brief Reset before a new response body.
+ */
+void config_delta_init(config_delta_t *d);
+
+/**
+ * @brief Parse the next piece of the body.
+ */
+void config_delta_feed(config_delta_t *d, const char *chunk, uint16_t len);
+
+/**
+ * @brief true if a whole, well-formed delta was seen.
+ */
+bool config_delta_complete(const config_delta_t *d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_DELTA_H */
@@ -0,0 +1,33 @@
+/**
+ * @file crc32.h
+ * @brief CRC-32 (IEEE 802.3, as zlib) byte by byte (host buildable).
+ *
+ * Nibble table: 64 bytes instead of 1 KiB, two lookups per byte. Small
+ * enough for the bootloader, which checks a whole application region
+ * before it switches to it.
+ *
+ * crc = CRC32_INIT; crc = crc32_update(crc, b)...; result = crc32_final(crc).
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CRC32_INIT 0xFFFFFFFFUL
+
+uint32_t crc32_update(uint32_t crc, uint8_t b);
+
+static inline uint32_t crc32_final(uint32_t crc) {
+    return ~crc;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRC32_H */
@@ -0,0 +1,42 @@
+/**
+ * @file deadband.c
+ * @brief Per-channel deadband and maximum-silence trigger.
+ */
+
+#include "deadband.h"
+
+/* Channels whose value restarts from zero after every upload */
+#define DB_ACCUMULATING (1 << DB_RAIN)
+
+void deadband_reset(deadband_t *d) {
+    for (uint8_t i = 0; i < DB_CHANNELS; i++) d->sent[i] = 0;
+    d->sent_ms = 0;
+    d->has_sent = false;
+}
+
+uint8_t deadband_check(const deadband_t *d, const deadband_config_t *cfg,
+                       const int32_t values[DB_CHANNELS], uint32_t now_ms) {
+    if (!d->has_sent) return 1 << DB_CHANNELS;
+
+    uint8_t fired = 0;
+    for (uint8_t i = 0; i < DB_CHANNELS; i++) {
+        if (!cfg->band[i]) continue;
+
+        int32_t ref = (DB_ACCUMULATING & (1 << i)) ? 0 : d->sent[i];
+        int32_t diff = values[i] - ref;
+        if (diff < 0) diff = -diff;
+        if (diff >= cfg->band[i]) fired |= 1 << i;
+    }
+
+    if (cfg->max_silence_min &&
+        now_ms - d->sent_ms >= (uint32_t)cfg->max_silence_min * 60000UL) {
+        fired |= 1 << DB_CHANNELS;
+    }
+    return fired;
+}
+
+void deadband_commit(deadband_t *d, const int32_t values[DB_CHANNELS], uint32_t now_ms) {
+    for (uint8_t i = 0; i < DB_CHANNELS; i++) d->sent[i] = values[i];
+    d->sent_ms = now_ms;
+    d->has_sent = true;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file deadband.h
+ * @brief Change detection between the sensors and the uploader (host buildable).
+ *
+ * Keeps the last transmitted value of each channel and asks for an
+ * upload only when a channel moved by at least its deadband, or when
+ * nothing was sent for max_silence_min. Rain is a count since the last
+ * upload, so it is compared against zero rather than the last value.
+ */
+
+#ifndef DEADBAND_H
+#define DEADBAND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    DB_AIR_TEMP,       /**< 0.01 °C */
+    DB_GROUND_TEMP,    /**< 0.01 °C */
+    DB_PRESSURE,       /**< Pa */
+    DB_HUMIDITY,       /**< 0.01 %RH */
+    DB_WIND,           /**< 10 min mean, cm/s */
+    DB_RAIN,           /**< Tips since the last upload */
+    DB_CHANNELS
+};
+
+/** Deadbands in channel units (0 = channel never triggers) and silence limit. */
+typedef struct __attribute__((packed)) {
+    uint16_t band[DB_CHANNELS];
+    uint16_t max_silence_min;
+} deadband_config_t;
+
+typedef struct {
+    int32_t  sent[DB_CHANNELS];   /**< Values of the last upload */
+    uint32_t sent_ms;             /**< Time of the last upload */
+    bool     has_sent;
+} deadband_t;
+
+/**
+ * @brief Forget the last upload; the next check always triggers.
+ */
+void deadband_reset(deadband_t *d);
+
+/**
+ * @brief Check whether the current values justify an upload.
+ * @param values Current value of each channel.
+ * @param now_ms Millisecond clock (wrap-safe differences).
+ * @return Bit mask of channels that crossed their deadband, plus
+ *         (1 << DB_CHANNELS) for the silence timer; 0 = stay quiet.
+ */
+uint8_t deadband_check(const deadband_t *d, const deadband_config_t *cfg,
+                       const int32_t values[DB_CHANNELS], uint32_t now_ms);
+
+/**
+ * @brief Record a successful upload of `values`.
+ */
+void deadband_commit(deadband_t *d, const int32_t values[DB_CHANNELS], uint32_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEADBAND_H */
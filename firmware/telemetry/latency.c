@@ -0,0 +1,38 @@
+/**
+ * @file latency.c
+ * @brief EWMA mean / mean deviation in fixed point.
+ */
+
+#include "latency.h"
+
+void latency_reset(latency_t *l) {
+    l->mean_q = 0;
+    l->dev_q = 0;
+    l->samples = 0;
+}
+
+void latency_observe(latency_t *l, uint32_t ms) {
+    if (ms > 0x0FFFFFFFUL) ms = 0x0FFFFFFFUL;   // keeps ms << 3 in range
+
+    if (l->samples == 0) {
+        // first answer: mean = x, deviation = x / 2 (RFC 6298 2.2)
+        l->mean_q = ms << 3;
+        l->dev_q = ms << 1;
+    } else {
+        int32_t err = (int32_t)ms - (int32_t)(l->mean_q >> 3);
+        uint32_t abs_err = (err < 0) ? (uint32_t)-err : (uint32_t)err;
+
+        l->mean_q = (uint32_t)((int32_t)l->mean_q + err);        // += err / 8, in q3
+        l->dev_q = l->dev_q - (l->dev_q >> 2) + abs_err;          // += (|err| - dev) / 4, in q2
+    }
+    if (l->samples < 255) l->samples++;
+}
+
+uint32_t latency_timeout(const latency_t *l, uint32_t floor_ms, uint32_t worst_ms) {
+    if (l->samples < LATENCY_MIN_SAMPLES) return worst_ms;
+
+    uint32_t t = (l->mean_q >> 3) + LATENCY_K * (l->dev_q >> 2);
+    if (t < floor_ms) t = floor_ms;
+    if (t > worst_ms) t = worst_ms;
+    return t;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file latency.h
+ * @brief Learned response-time estimate and timeout of one command class (host buildable).
+ *
+ * Exponentially weighted mean and mean deviation (alpha 1/8 and 1/4, as
+ * TCP's RTO estimator in RFC 6298). The deviation stands in for sigma:
+ * it needs no squares, which would overflow 32 bits for the two-minute
+ * HTTP actions, and for normally distributed latency it is 0.8 sigma.
+ * The timeout is mean + LATENCY_K * deviation, clamped between a floor
+ * and the caller's worst case; until LATENCY_MIN_SAMPLES answers have
+ * been seen the worst case is used as is.
+ *
+ * A command that timed out is recorded with the timeout as its latency,
+ * so a slower network raises the estimate instead of failing every time.
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LATENCY_K            4
+#define LATENCY_MIN_SAMPLES  5
+
+typedef struct __attribute__((packed)) {
+    uint32_t mean_q;    /**< Mean, ms << 3 */
+    uint32_t dev_q;     /**< Mean deviation, ms << 2 */
+    uint8_t  samples;   /**< Saturates at 255 */
+} latency_t;
+
+/**
+ * @brief Forget everything (worst-case timeouts again).
+ */
+void latency_reset(latency_t *l);
+
+/**
+ * @brief Add one observed latency.
+ */
+void latency_observe(latency_t *l, uint32_t ms);
+
+/**
+ * @brief Timeout for the next command of this class.
+ */
+uint32_t latency_timeout(const latency_t *l, uint32_t floor_ms, uint32_t worst_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LATENCY_H */
@@ -0,0 +1,184 @@
+/**
+ * @file ota_patch.c
+ * @brief Header check, literal/copy operations, page output, CRC-32 and SipHash-2-4.
+ */
+
+#include <string.h>
+#include "ota_patch.h"
+#include "crc32.h"
+
+enum { ST_HEADER, ST_OP, ST_LITERAL, ST_COPY, ST_END };
+
+/* ---------------- SipHash-2-4 ---------------- */
+
+static uint64_t rotl(uint64_t x, uint8_t b) {
+    return (x << b) | (x >> (64 - b));
+}
+
+static void sip_rounds(uint64_t v[4], uint8_t n) {
+    while (n--) {
+        v[0] += v[1]; v[1] = rotl(v[1], 13); v[1] ^= v[0]; v[0] = rotl(v[0], 32);
+        v[2] += v[3]; v[3] = rotl(v[3], 16); v[3] ^= v[2];
+        v[0] += v[3]; v[3] = rotl(v[3], 21); v[3] ^= v[0];
+        v[2] += v[1]; v[1] = rotl(v[1], 17); v[1] ^= v[2]; v[2] = rotl(v[2], 32);
+    }
+}
+
+static uint64_t le64(const uint8_t *b) {
+    uint64_t v = 0;
+    for (uint8_t i = 8; i--; ) v = (v << 8) | b[i];
+    return v;
+}
+
+static void mac_init(ota_mac_t *m, const uint8_t *key) {
+    uint64_t k0 = le64(key), k1 = le64(key + 8);
+
+    m->v[0] = k0 ^ 0x736f6d6570736575ULL;
+    m->v[1] = k1 ^ 0x646f72616e646f6dULL;
+    m->v[2] = k0 ^ 0x6c7967656e657261ULL;
+    m->v[3] = k1 ^ 0x7465646279746573ULL;
+    m->word = 0;
+    m->total = 0;
+}
+
+static void mac_byte(ota_mac_t *m, uint8_t b) {
+    m->word |= (uint64_t)b << (8 * (m->total & 7));
+    if ((++m->total & 7) == 0) {
+        m->v[3] ^= m->word;
+        sip_rounds(m->v, 2);
+        m->v[0] ^= m->word;
+        m->word = 0;
+    }
+}
+
+static uint64_t mac_final(ota_mac_t *m) {
+    uint64_t b = m->word | ((uint64_t)(m->total & 0xFF) << 56);
+
+    m->v[3] ^= b;
+    sip_rounds(m->v, 2);
+    m->v[0] ^= b;
+    m->v[2] ^= 0xFF;
+    sip_rounds(m->v, 4);
+    return m->v[0] ^ m->v[1] ^ m->v[2] ^ m->v[3];
+}
+
+/* ---------------- decoder ---------------- */
+
+static uint16_t le16(const uint8_t *b) {
+    return (uint16_t)(b[0] | (b[1] << 8));
+}
+
+static uint32_t le32(const uint8_t *b) {
+    return (uint32_t)le16(b) | ((uint32_t)le16(b + 2) << 16);
+}
+
+void ota_patch_init(ota_patch_t *p, const uint8_t *key, uint32_t base_crc,
+                    ota_read_fn read_old, ota_page_fn write_page) {
+    p->read_old = read_old;
+    p->write_page = write_page;
+    p->key = key;
+    p->base_crc = base_crc;
+    p->state = ST_HEADER;
+    p->result = OTA_MORE;
+    p->got = 0;
+    p->out = 0;
+    p->crc = CRC32_INIT;
+}
+
+static ota_result_t fail(ota_patch_t *p, ota_result_t r) {
+    p->state = ST_END;
+    p->result = r;
+    return r;
+}
+
+/* One byte of the new region; a full page goes to flash */
+static bool emit(ota_patch_t *p, uint8_t b) {
+    p->page[p->out % OTA_PAGE_SZ] = b;
+    p->crc = crc32_update(p->crc, b);
+    if (p->out < p->new_len) mac_byte(&p->mac, b);
+
+    if (++p->out % OTA_PAGE_SZ == 0) {
+        return p->write_page(p->out - OTA_PAGE_SZ, p->page);
+    }
+    return true;
+}
+
+/* Image complete: erased filler to the end of the region, then the checks */
+static ota_result_t finish(ota_patch_t *p) {
+    while (p->out < OTA_REGION_SZ) {
+        if (!emit(p, 0xFF)) return fail(p, OTA_ERR_WRITE);
+    }
+    if (crc32_final(p->crc) != p->new_crc) return fail(p, OTA_ERR_CRC);
+
+    uint64_t tag = mac_final(&p->mac);
+    if (tag != le64(p->hdr + 14)) return fail(p, OTA_ERR_TAG);
+
+    return fail(p, OTA_DONE);
+}
+
+static ota_result_t header(ota_patch_t *p) {
+    if (memcmp(p->hdr, "TSP1", 4) != 0) return fail(p, OTA_ERR_FORMAT);
+    if (le32(p->hdr + 4) != p->base_crc) return fail(p, OTA_ERR_BASE);
+
+    p->new_len = le16(p->hdr + 8);
+    p->new_crc = le32(p->hdr + 10);
+    if (p->new_len == 0 || p->new_len > OTA_REGION_SZ) return fail(p, OTA_ERR_FORMAT);
+
+    mac_init(&p->mac, p->key);
+    for (uint8_t i = 0; i < 14; i++) mac_byte(&p->mac, p->hdr[i]);
+    p->state = ST_OP;
+    return OTA_MORE;
+}
+
+static ota_result_t copy(ota_patch_t *p) {
+    uint16_t from = le16(p->arg);
+    uint16_t len = le16(p->arg + 2);
+
+    if (len == 0 || (uint32_t)from + len > OTA_REGION_SZ || (uint32_t)p->out + len > p->new_len) {
+        return fail(p, OTA_ERR_FORMAT);
+    }
+    while (len--) {
+        if (!emit(p, p->read_old(from++))) return fail(p, OTA_ERR_WRITE);
+    }
+    p->state = ST_OP;
+    return OTA_MORE;
+}
+
+ota_result_t ota_patch_feed(ota_patch_t *p, const uint8_t *data, uint16_t len) {
+    for (uint16_t i = 0; i < len && p->state != ST_END; i++) {
+        uint8_t b = data[i];
+
+        switch (p->state) {
+        case ST_HEADER:
+            p->hdr[p->got++] = b;
+            if (p->got == OTA_HDR_SZ) (void)header(p);
+            break;
+
+        case ST_OP:
+            if (b < 0x80) {
+                p->literal = b + 1;
+                if ((uint32_t)p->out + p->literal > p->new_len) return fail(p, OTA_ERR_FORMAT);
+                p->state = ST_LITERAL;
+            } else if (b == 0x80) {
+                p->got = 0;
+                p->state = ST_COPY;
+            } else {
+                return fail(p, OTA_ERR_FORMAT);
+            }
+            break;
+
+        case ST_LITERAL:
+            if (!emit(p, b)) return fail(p, OTA_ERR_WRITE);
+            if (--p->literal == 0) p->state = ST_OP;
+            break;
+
+        case ST_COPY:
+            p->arg[p->got++] = b;
+            if (p->got == sizeof(p->arg)) (void)copy(p);
+            break;
+        }
+
+        if (p->state == ST_OP && p->out == p->new_len) return finish(p);
+    }
+    return (ota_result_t)p->result;
+}
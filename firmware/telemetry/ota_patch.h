@@ -0,0 +1,117 @@
+/**
+ * @file ota_patch.h
+ * @brief Streaming decoder of signed firmware delta patches (host buildable).
+ *
+ * A patch turns the running image into a new one. It is fed in pieces
+ * as it arrives; the new image is produced in order and handed out a
+ * flash page at a time, so neither image nor patch is held in RAM (one
+ * page buffer only).
+ *
+ * Both images are whole regions of OTA_REGION_SZ bytes: the image, then
+ * 0xFF up to the end, as after a chip erase. Their CRC-32 therefore
+ * identifies a build without storing its length anywhere.
+ *
+ * Format (little endian), made by server/ota.js:
+ *
+ *     0  "TSP1"
+ *     4  u32  CRC-32 of the region the patch applies to
+ *     8  u16  length of the new image (the rest of the region is 0xFF)
+ *    10  u32  CRC-32 of the new region
+ *    14  u8[8] SipHash-2-4 tag, key OTA_KEY, of bytes 0..13 + new image
+ *    22  operations until the new image is complete:
+ *          0x00..0x7F  n+1 literal bytes follow
+ *          0x80        copy: u16 offset in the old region, u16 length
+ *
+ * The tag is the signature: a patch from anyone without the key, or for
+ * another build, or damaged on the way, ends in an error and the caller
+ * must not switch. It is a shared-key MAC, so the key has to stay
+ * secret on both the server and the stations.
+ */
+
+#ifndef OTA_PATCH_H
+#define OTA_PATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Flash page (SPM_PAGESIZE of the ATmega328P). */
+#ifndef OTA_PAGE_SZ
+#define OTA_PAGE_SZ 128
+#endif
+
+/** One application region; two of them and the bootloader fill the flash. */
+#ifndef OTA_REGION_SZ
+#define OTA_REGION_SZ 0x3C00U
+#endif
+
+#define OTA_HDR_SZ 22
+
+typedef enum {
+    OTA_MORE = 0,       /**< Feed the next piece */
+    OTA_DONE,           /**< Whole region written, CRC and tag match */
+    OTA_ERR_FORMAT,     /**< Bad magic, length or operation */
+    OTA_ERR_BASE,       /**< Patch is for another build */
+    OTA_ERR_WRITE,      /**< write_page() failed */
+    OTA_ERR_CRC,        /**< Result differs from the header's CRC */
+    OTA_ERR_TAG         /**< Signature does not match */
+} ota_result_t;
+
+/** Byte of the running (old) region. */
+typedef uint8_t (*ota_read_fn)(uint16_t offset);
+
+/** Programs one page of the new region at offset; false on failure. */
+typedef bool (*ota_page_fn)(uint16_t offset, const uint8_t *page);
+
+typedef struct {
+    uint64_t v[4];      /**< SipHash state */
+    uint64_t word;      /**< Message bytes not yet compressed */
+    uint32_t total;     /**< Message length */
+} ota_mac_t;
+
+typedef struct {
+    ota_read_fn read_old;
+    ota_page_fn write_page;
+    const uint8_t *key;
+    uint32_t base_crc;
+
+    uint8_t  state;
+    uint8_t  result;
+    uint8_t  hdr[OTA_HDR_SZ];
+    uint8_t  arg[4];        /**< Copy offset and length */
+    uint8_t  got;           /**< Header or argument bytes collected */
+    uint8_t  literal;       /**< Literal bytes still to come */
+    uint16_t new_len;
+    uint32_t new_crc;
+    uint16_t out;           /**< New region bytes produced */
+    uint32_t crc;
+    ota_mac_t mac;
+    uint8_t  page[OTA_PAGE_SZ];
+} ota_patch_t;
+
+/**
+ * @brief Start decoding a patch for the region whose CRC-32 is base_crc.
+ * @param key 16-byte SipHash key (kept by pointer)
+ */
+void ota_patch_init(ota_patch_t *p, const uint8_t *key, uint32_t base_crc,
+                    ota_read_fn read_old, ota_page_fn write_page);
+
+/**
+ * @brief Decode the next piece of the patch.
+ * @return OTA_MORE until the patch ends; then OTA_DONE or an error (sticky).
+ */
+ota_result_t ota_patch_feed(ota_patch_t *p, const uint8_t *data, uint16_t len);
+
+/** CRC-32 of the new region from the header (valid once past it). */
+static inline uint32_t ota_patch_new_crc(const ota_patch_t *p) {
+    return p->new_crc;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OTA_PATCH_H */
@@ -0,0 +1,122 @@
+/**
+ * @file stream_writer.h
+ * @brief Allocation-free text writer: numbers, hex, base64 and JSON (host buildable).
+ *
+ * Replaces printf-style formatting on the upload path. The same writer
+ * code runs in one of three modes, chosen at init:
+ *  - sink:  every character goes to a callback (UART_send), nothing is kept;
+ *  - buffer: characters go into a caller's array, NUL-terminated;
+ *  - count: nothing is written, only the length is computed.
+ *
+ * A body is written by a fill function (sw_fill_fn). Running it once in
+ * count mode gives the exact length a modem wants up front (AT+HTTPDATA,
+ * AT+CMQTTPAYLOAD); running it again into the sink sends it without the
+ * body ever being held in RAM. sw_send() caps the second pass at the
+ * counted length and pads a short one with spaces, so the modem gets
+ * exactly the announced number of bytes even if a value changed between
+ * the two passes.
+ *
+ * JSON helpers track the separators: sw_key() and sw_item() put the comma
+ * in front of every member but the first of its object or array.
+ */
+
+#ifndef STREAM_WRITER_H
+#define STREAM_WRITER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Deepest JSON nesting tracked (one bit of sw_t::first per level). */
+#define SW_MAX_DEPTH 7
+
+typedef struct {
+    void   (*sink)(char c); /**< Sink mode; NULL for buffer or count mode */
+    char    *buf;           /**< Buffer mode; NULL for sink or count mode */
+    uint16_t limit;         /**< Characters passed on at most, 0 = no limit */
+    uint16_t len;           /**< Characters written so far, also past the limit */
+    uint8_t  depth;         /**< Open objects/arrays */
+    uint8_t  first;         /**< Bit per level: no member written there yet */
+} sw_t;
+
+/** Writes a whole body into w; ctx is the caller's. */
+typedef void (*sw_fill_fn)(sw_t *w, void *ctx);
+
+/** Count mode: only w->len changes. */
+void sw_init_count(sw_t *w);
+
+/** Buffer mode: at most cap-1 characters, always NUL-terminated (cap >= 2). */
+void sw_init_buf(sw_t *w, char *buf, uint16_t cap);
+
+/** Sink mode: at most limit characters reach sink (0 = no limit). */
+void sw_init_sink(sw_t *w, void (*sink)(char c), uint16_t limit);
+
+/** @return true if more was written than the buffer or limit could take. */
+bool sw_overflow(const sw_t *w);
+
+void sw_char(sw_t *w, char c);
+void sw_str(sw_t *w, const char *s);
+void sw_mem(sw_t *w, const void *data, uint16_t len);
+
+void sw_u32(sw_t *w, uint32_t v);
+void sw_i32(sw_t *w, int32_t v);
+
+/**
+ * @brief Fixed point: v scaled by 10^decimals, e.g. (-5, 2) gives "-0.05".
+ */
+void sw_fixed(sw_t *w, int32_t v, uint8_t decimals);
+
+/** Two upper-case hex digits. */
+void sw_hex8(sw_t *w, uint8_t v);
+
+/** Standard base64 with '=' padding. */
+void sw_base64(sw_t *w, const uint8_t *src, uint16_t len);
+
+void sw_obj_begin(sw_t *w);
+void sw_obj_end(sw_t *w);
+void sw_arr_begin(sw_t *w);
+void sw_arr_end(sw_t *w);
+
+/** Separator if needed, then "key": (the value follows). Keys are not escaped. */
+void sw_key(sw_t *w, const char *key);
+
+/** Separator if needed, before an array element. */
+void sw_item(sw_t *w);
+
+void sw_kv_u32(sw_t *w, const char *key, uint32_t v);
+void sw_kv_i32(sw_t *w, const char *key, int32_t v);
+void sw_item_u32(sw_t *w, uint32_t v);
+void sw_item_i32(sw_t *w, int32_t v);
+
+/** A body already in memory, for callers that take a fill function. */
+typedef struct {
+    const void *data;
+    uint16_t    len;
+} sw_mem_body_t;
+
+/** sw_fill_fn writing the sw_mem_body_t given as ctx. */
+void sw_fill_mem(sw_t *w, void *ctx);
+
+/**
+ * @brief Length of what fill writes (count mode pass).
+ */
+uint16_t sw_measure(sw_fill_fn fill, void *ctx);
+
+/**
+ * @brief Writes exactly len characters of fill's output to sink.
+ *
+ * Output past len is dropped; if fill writes less, spaces make up the
+ * rest (harmless after JSON).
+ *
+ * @return Length fill actually wrote; != len means the body was cut or padded.
+ */
+uint16_t sw_send(void (*sink)(char c), sw_fill_fn fill, void *ctx, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STREAM_WRITER_H */
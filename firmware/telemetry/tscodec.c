@@ -0,0 +1,187 @@
+/**
+ * @file tscodec.c
+ * @brief Delta-of-delta / zig-zag varint bit packing of measurement records.
+ */
+
+#include "tscodec.h"
+
+/* Timestamp classes after the prefix: payload bits for '10', '110', '1110' */
+static const uint8_t TS_CLASS_BITS[] = { 7, 9, 12 };
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/* ---------------- writer ---------------- */
+
+/*
+ * Sets and clears explicitly, so a rolled back record leaves no stale bits.
+ * Walks a byte pointer and mask: AVR has no barrel shifter, and variable
+ * shifts per bit would make a 32-bit field quadratic.
+ */
+static bool put_bits(tsc_encoder_t *e, uint32_t value, uint8_t n) {
+    if ((uint32_t)e->bits + n > (uint32_t)e->cap * 8) return false;
+
+    uint8_t *byte = &e->buf[e->bits >> 3];
+    uint8_t mask = 0x80 >> (e->bits & 7);
+    e->bits += n;
+
+    value <<= 32 - n;
+    while (n--) {
+        if (value & 0x80000000UL) *byte |= mask;
+        else                      *byte &= ~mask;
+        value <<= 1;
+        mask >>= 1;
+        if (!mask) {
+            mask = 0x80;
+            byte++;
+        }
+    }
+    return true;
+}
+
+static bool put_varint(tsc_encoder_t *e, uint32_t zz) {
+    if (zz == 0) return put_bits(e, 0, 1);
+    if (!put_bits(e, 1, 1)) return false;
+
+    do {
+        uint8_t group = zz & 0x0F;
+        zz >>= 4;
+        if (!put_bits(e, ((uint32_t)group << 1) | (zz != 0), 5)) return false;
+    } while (zz);
+    return true;
+}
+
+static bool put_timestamp(tsc_encoder_t *e, uint32_t ts) {
+    if (e->count == 0) return put_bits(e, ts, 32);
+
+    int32_t delta = (int32_t)(ts - e->prev_ts);
+    uint32_t zz = zigzag(delta - e->prev_delta);
+    if (zz == 0) return put_bits(e, 0, 1);
+
+    uint8_t prefix = 0x02;   // '10'
+    for (uint8_t c = 0; c < sizeof(TS_CLASS_BITS); c++, prefix = (prefix << 1) | 0x02) {
+        if (zz < (1UL << TS_CLASS_BITS[c])) {
+            return put_bits(e, prefix, c + 2) && put_bits(e, zz, TS_CLASS_BITS[c]);
+        }
+    }
+    return put_bits(e, 0x0F, 4) && put_bits(e, zz, 32);
+}
+
+void tsc_init(tsc_encoder_t *e, uint8_t *buf, uint16_t cap, uint8_t channels) {
+    e->buf = buf;
+    e->cap = cap;
+    e->bits = 0;
+    e->count = 0;
+    e->channels = (channels > TSC_MAX_CHANNELS) ? TSC_MAX_CHANNELS : channels;
+    e->prev_ts = 0;
+    e->prev_delta = 0;
+    for (uint8_t i = 0; i < TSC_MAX_CHANNELS; i++) e->prev[i] = 0;
+}
+
+bool tsc_append(tsc_encoder_t *e, uint32_t ts, const int32_t *values) {
+    uint16_t start = e->bits;
+
+    bool ok = put_timestamp(e, ts);
+    for (uint8_t i = 0; ok && i < e->channels; i++) {
+        ok = put_varint(e, zigzag(values[i] - e->prev[i]));
+    }
+    if (!ok) {
+        e->bits = start;
+        return false;
+    }
+
+    if (e->count) e->prev_delta = (int32_t)(ts - e->prev_ts);
+    e->prev_ts = ts;
+    for (uint8_t i = 0; i < e->channels; i++) e->prev[i] = values[i];
+    e->count++;
+    return true;
+}
+
+uint16_t tsc_bytes(const tsc_encoder_t *e) {
+    return (e->bits + 7) >> 3;
+}
+
+/* ---------------- reader ---------------- */
+
+static bool get_bits(tsc_decoder_t *d, uint8_t n, uint32_t *out) {
+    if ((uint32_t)d->pos + n > d->bits) return false;
+
+    uint32_t v = 0;
+    while (n--) {
+        v = (v << 1) | ((d->buf[d->pos >> 3] >> (7 - (d->pos & 7))) & 1);
+        d->pos++;
+    }
+    *out = v;
+    return true;
+}
+
+static bool get_varint(tsc_decoder_t *d, uint32_t *zz) {
+    uint32_t bit, group;
+    if (!get_bits(d, 1, &bit)) return false;
+
+    *zz = 0;
+    for (uint8_t shift = 0; bit; shift += 4) {
+        if (shift > 28 || !get_bits(d, 5, &group)) return false;
+        *zz |= (group >> 1) << shift;
+        bit = group & 1;
+    }
+    return true;
+}
+
+static bool get_timestamp(tsc_decoder_t *d, bool first, uint32_t *zz) {
+    uint32_t bit;
+    if (first) return get_bits(d, 32, zz);
+
+    for (uint8_t c = 0; c <= sizeof(TS_CLASS_BITS); c++) {
+        if (!get_bits(d, 1, &bit)) return false;
+        if (!bit) {
+            if (c == 0) {
+                *zz = 0;
+                return true;
+            }
+            return get_bits(d, TS_CLASS_BITS[c - 1], zz);
+        }
+    }
+    return get_bits(d, 32, zz);
+}
+
+void tsc_decoder_init(tsc_decoder_t *d, const uint8_t *buf, uint16_t len,
+                      uint16_t count, uint8_t channels) {
+    d->buf = buf;
+    d->bits = (uint16_t)(len * 8U);
+    d->pos = 0;
+    d->left = count;
+    d->channels = (channels > TSC_MAX_CHANNELS) ? TSC_MAX_CHANNELS : channels;
+    d->prev_ts = 0;
+    d->prev_delta = 0;
+    for (uint8_t i = 0; i < TSC_MAX_CHANNELS; i++) d->prev[i] = 0;
+}
+
+bool tsc_next(tsc_decoder_t *d, uint32_t *ts, int32_t *values) {
+    if (d->left == 0) return false;
+
+    bool first = (d->pos == 0);
+    uint32_t zz;
+    if (!get_timestamp(d, first, &zz)) return false;
+
+    if (first) {
+        *ts = zz;
+    } else {
+        d->prev_delta += unzigzag(zz);
+        *ts = d->prev_ts + (uint32_t)d->prev_delta;
+    }
+    d->prev_ts = *ts;
+
+    for (uint8_t i = 0; i < d->channels; i++) {
+        if (!get_varint(d, &zz)) return false;
+        d->prev[i] += unzigzag(zz);
+        values[i] = d->prev[i];
+    }
+    d->left--;
+    return true;
+}
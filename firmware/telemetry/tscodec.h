@@ -0,0 +1,86 @@
+/**
+ * @file tscodec.h
+ * @brief Bit-packed time-series batch codec (host buildable).
+ *
+ * Records are (timestamp, N integer values). Each record is appended to
+ * a bit stream in a caller buffer:
+ *
+ *  - timestamp: delta-of-delta, zig-zag, in a prefix class
+ *      '0' (dod = 0), '10' + 7 bits, '110' + 9 bits, '1110' + 12 bits,
+ *      '1111' + 32 bits. The first record stores the raw 32-bit value.
+ *  - each value: delta to the previous record, zig-zag, then '0' for
+ *    zero or '1' followed by 4-bit groups (LSB first), each with a
+ *    continuation bit.
+ *
+ * Bits are written MSB first. A record that does not fit is rolled back
+ * whole, so the buffer always holds complete records. Decoding needs the
+ * record count and channel count only; server/tscodec.js mirrors it.
+ */
+
+#ifndef TSCODEC_H
+#define TSCODEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TSC_MAX_CHANNELS 6
+
+typedef struct {
+    uint8_t *buf;
+    uint16_t cap;           /**< Buffer size, bytes */
+    uint16_t bits;          /**< Bits used */
+    uint16_t count;         /**< Records in the buffer */
+    uint8_t  channels;
+    uint32_t prev_ts;
+    int32_t  prev_delta;
+    int32_t  prev[TSC_MAX_CHANNELS];
+} tsc_encoder_t;
+
+typedef struct {
+    const uint8_t *buf;
+    uint16_t bits;          /**< Bits available */
+    uint16_t pos;
+    uint16_t left;          /**< Records still to decode */
+    uint8_t  channels;
+    uint32_t prev_ts;
+    int32_t  prev_delta;
+    int32_t  prev[TSC_MAX_CHANNELS];
+} tsc_decoder_t;
+
+/**
+ * @brief Start an empty batch in `buf`.
+ */
+void tsc_init(tsc_encoder_t *e, uint8_t *buf, uint16_t cap, uint8_t channels);
+
+/**
+ * @brief Append one record.
+ * @return false if it does not fit (the batch is unchanged).
+ */
+bool tsc_append(tsc_encoder_t *e, uint32_t ts, const int32_t *values);
+
+/**
+ * @brief Bytes of the batch (last byte zero padded).
+ */
+uint16_t tsc_bytes(const tsc_encoder_t *e);
+
+/**
+ * @brief Start decoding `count` records from `len` bytes.
+ */
+void tsc_decoder_init(tsc_decoder_t *d, const uint8_t *buf, uint16_t len,
+                      uint16_t count, uint8_t channels);
+
+/**
+ * @brief Decode the next record.
+ * @return false at the end of the batch or on a truncated stream.
+ */
+bool tsc_next(tsc_decoder_t *d, uint32_t *ts, int32_t *values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TSCODEC_H */
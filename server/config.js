@@ -0,0 +1,50 @@
+// Zdalna konfiguracja stacji: delta w odpowiedzi na /ingest
+//
+// config.json: { "version": <n>, "settings": { "<nazwa>": <wartość>, ... } }
+// Stacja wysyła w każdym payloadzie "cfg" = wersję, którą ma w EEPROM.
+// Gdy jest inna niż version, odpowiedź dostaje pole
+//   "cfg": "v<version>;<id>=<wartość>;..."
+// ze wszystkimi ustawieniami z pliku (względem domyślnych z config.h).
+// Stacja buduje ustawienia od nowa z domyślnych i tej listy: klucz usunięty
+// z pliku wraca na stacji do wartości domyślnej przy następnej wersji.
+// Id muszą się zgadzać z setting_key_t w firmware/boards/m328p/settings.h.
+
+import { readFileSync } from "node:fs";
+
+export const SETTING_IDS = {
+  sample_period_s: 0,
+  check_period_min: 1,
+  max_silence_min: 2,
+  deadband_air_temp: 3,
+  deadband_ground_temp: 4,
+  deadband_pressure: 5,
+  deadband_humidity: 6,
+  deadband_wind: 7,
+  deadband_rain: 8,
+};
+
+// Czytane przy każdym żądaniu: zmiana pliku działa bez restartu serwera
+export function loadConfig(path) {
+  try {
+    return JSON.parse(readFileSync(path, "utf8"));
+  } catch (err) {
+    console.error("Config not loaded:", err.message);
+    return null;
+  }
+}
+
+// null gdy stacja jest aktualna albo nie ma czego wysłać
+export function configDelta(config, stationVersion) {
+  if (!config || !Number.isInteger(config.version) || config.version === stationVersion) return null;
+
+  const pairs = [];
+  for (const [name, value] of Object.entries(config.settings ?? {})) {
+    const id = SETTING_IDS[name];
+    if (id === undefined || !Number.isInteger(value) || value < 0 || value > 0xffff) {
+      console.error(`Config: skipping ${name}=${value}`);
+      continue;
+    }
+    pairs.push(`${id}=${value}`);
+  }
+  return [`v${config.version}`, ...pairs].join(";");
+}
@@ -0,0 +1,336 @@
+// Zastępczy broker MQTT 3.1.1 dla stacji z UPLOAD_MQTT=1 (testy bez sieci
+// komórkowej i bez zewnętrznego brokera). Tylko moduły Node.
+//
+// Obsługuje CONNECT, PUBLISH (QoS 0/1, PUBACK), SUBSCRIBE (wildcardy + i #),
+// wiadomości retained, PINGREQ i DISCONNECT. Do klientów wysyła z QoS 1,
+// ale nie ponawia bez PUBACK — to nie jest broker produkcyjny.
+//
+// Most do logiki /ingest z server.js, tematy <baza> = np. "troposense/1":
+//   <baza>/report  JSON jak w POST /ingest: log, a gdy stacja ma inną wersję
+//                  konfiguracji, delta {"cfg":"v<n>;..."} na <baza>/cfg
+//                  (retained: dojdzie też przy następnym połączeniu); tamże
+//                  oferta aktualizacji "ota" (ota.js), łatka i tak przez HTTP
+//   <baza>/rec     paczka rekordów binarnie: n (u16 LE), ch (u8), now (u32 LE),
+//                  potem bajty z tscodec.c
+//
+//   node mqtt_broker.js             (port MQTT_PORT, domyślnie 1883)
+//   node mqtt_broker.js --selftest  (klient testowy na losowym porcie)
+
+import net from "node:net";
+import { fileURLToPath } from "node:url";
+import { decodeBatch } from "./tscodec.js";
+import { loadConfig, configDelta } from "./config.js";
+import { otaOffer } from "./ota.js";
+
+const CONFIG_PATH = process.env.CONFIG_PATH || new URL("./config.json", import.meta.url);
+
+const CONNECT = 1, CONNACK = 2, PUBLISH = 3, PUBACK = 4, SUBSCRIBE = 8, SUBACK = 9;
+const PINGREQ = 12, PINGRESP = 13, DISCONNECT = 14;
+
+// ---------------- ramki ----------------
+
+function encodeLength(n) {
+  const out = [];
+  do {
+    let b = n % 128;
+    n = Math.floor(n / 128);
+    if (n > 0) b |= 0x80;
+    out.push(b);
+  } while (n > 0);
+  return Buffer.from(out);
+}
+
+function packet(type, flags, body) {
+  return Buffer.concat([Buffer.from([(type << 4) | flags]), encodeLength(body.length), body]);
+}
+
+function str(s) {
+  const b = Buffer.from(s, "utf8");
+  const len = Buffer.alloc(2);
+  len.writeUInt16BE(b.length);
+  return Buffer.concat([len, b]);
+}
+
+function u16(n) {
+  const b = Buffer.alloc(2);
+  b.writeUInt16BE(n);
+  return b;
+}
+
+function publishPacket(topic, payload, { qos = 0, retain = false, id = 0 } = {}) {
+  const parts = [str(topic)];
+  if (qos > 0) parts.push(u16(id));
+  parts.push(payload);
+  return packet(PUBLISH, (qos << 1) | (retain ? 1 : 0), Buffer.concat(parts));
+}
+
+// Wycina pełne ramki z bufora; zwraca [ramki, reszta]
+function splitFrames(buf) {
+  const frames = [];
+  let pos = 0;
+  for (;;) {
+    if (buf.length - pos < 2) break;
+    let len = 0;
+    let mul = 1;
+    let i = pos + 1;
+    let done = false;
+    for (; i < buf.length && i < pos + 5; i++) {
+      len += (buf[i] & 0x7f) * mul;
+      mul *= 128;
+      if (!(buf[i] & 0x80)) {
+        done = true;
+        i++;
+        break;
+      }
+    }
+    if (!done || buf.length < i + len) break;
+    frames.push({ type: buf[pos] >> 4, flags: buf[pos] & 0x0f, body: buf.subarray(i, i + len) });
+    pos = i + len;
+  }
+  return [frames, buf.subarray(pos)];
+}
+
+function readStr(body, pos) {
+  const len = body.readUInt16BE(pos);
+  return [body.toString("utf8", pos + 2, pos + 2 + len), pos + 2 + len];
+}
+
+export function topicMatches(filter, topic) {
+  const f = filter.split("/");
+  const t = topic.split("/");
+  for (let i = 0; i < f.length; i++) {
+    if (f[i] === "#") return true;
+    if (i >= t.length) return false;
+    if (f[i] !== "+" && f[i] !== t[i]) return false;
+  }
+  return f.length === t.length;
+}
+
+// ---------------- broker ----------------
+
+export function createBroker({ onPublish = () => {}, log = console.log } = {}) {
+  const clients = new Set();
+  const retained = new Map();
+  let nextId = 1;
+
+  function deliver(client, topic, payload, retain) {
+    const id = nextId;
+    nextId = (nextId % 0xffff) + 1;
+    client.socket.write(publishPacket(topic, payload, { qos: 1, retain, id }));
+  }
+
+  function publish(topic, payload, retain = false) {
+    if (retain) {
+      // pusta treść retained kasuje zapamiętaną wiadomość
+      if (payload.length) retained.set(topic, payload);
+      else retained.delete(topic);
+    }
+    for (const c of clients) {
+      if ([...c.subs].some((f) => topicMatches(f, topic))) deliver(c, topic, payload, false);
+    }
+  }
+
+  function handle(client, { type, flags, body }) {
+    switch (type) {
+      case CONNECT: {
+        let pos = 0;
+        [, pos] = readStr(body, pos); // "MQTT"
+        pos += 4; // poziom protokołu, flagi, keepalive
+        [client.id] = readStr(body, pos);
+        log(`MQTT connect: ${client.id}`);
+        client.socket.write(packet(CONNACK, 0, Buffer.from([0, 0])));
+        break;
+      }
+      case PUBLISH: {
+        const qos = (flags >> 1) & 3;
+        let [topic, pos] = readStr(body, 0);
+        if (qos > 0) {
+          client.socket.write(packet(PUBACK, 0, u16(body.readUInt16BE(pos))));
+          pos += 2;
+        }
+        const payload = Buffer.from(body.subarray(pos));
+        publish(topic, payload, !!(flags & 1));
+        onPublish(topic, payload, { client: client.id, dup: !!(flags & 8), publish });
+        break;
+      }
+      case SUBSCRIBE: {
+        const id = body.readUInt16BE(0);
+        const granted = [];
+        const filters = [];
+        for (let pos = 2; pos < body.length; ) {
+          let filter;
+          [filter, pos] = readStr(body, pos);
+          granted.push(Math.min(body[pos++] & 3, 1));
+          client.subs.add(filter);
+          filters.push(filter);
+        }
+        client.socket.write(packet(SUBACK, 0, Buffer.concat([u16(id), Buffer.from(granted)])));
+        for (const [topic, payload] of retained) {
+          if (filters.some((f) => topicMatches(f, topic))) deliver(client, topic, payload, true);
+        }
+        break;
+      }
+      case PINGREQ:
+        client.socket.write(packet(PINGRESP, 0, Buffer.alloc(0)));
+        break;
+      case DISCONNECT:
+        client.socket.end();
+        break;
+      default: // PUBACK od klienta itd.
+        break;
+    }
+  }
+
+  const server = net.createServer((socket) => {
+    const client = { socket, id: "?", subs: new Set() };
+    let pending = Buffer.alloc(0);
+    clients.add(client);
+
+    socket.on("data", (data) => {
+      let frames;
+      [frames, pending] = splitFrames(Buffer.concat([pending, data]));
+      for (const f of frames) {
+        try {
+          handle(client, f);
+        } catch (err) {
+          log(`MQTT bad packet from ${client.id}: ${err.message}`);
+          socket.destroy();
+          return;
+        }
+      }
+    });
+    socket.on("close", () => clients.delete(client));
+    socket.on("error", () => clients.delete(client));
+  });
+
+  return { server, publish, retained };
+}
+
+// ---------------- most do logiki /ingest ----------------
+
+export function ingestBridge({ configPath = CONFIG_PATH, log = console.log } = {}) {
+  return (topic, payload, { client, dup, publish }) => {
+    const base = topic.slice(0, topic.lastIndexOf("/"));
+    const kind = topic.slice(base.length + 1);
+
+    if (kind === "report") {
+      let body;
+      try {
+        body = JSON.parse(payload.toString("utf8"));
+      } catch (err) {
+        log(`Report parse error (${client}): ${err.message}`);
+        return;
+      }
+      log(`----- MQTT ${topic}${dup ? " (DUP)" : ""} -----`);
+      log("Body:", JSON.stringify(body, null, 2));
+
+      // Delta jak w odpowiedzi HTTP; pusta retained, gdy stacja jest aktualna
+      const config = loadConfig(configPath);
+      const cfg = configDelta(config, body?.cfg);
+      const ota = otaOffer(config, body?.fw);
+      if (cfg) log("Config delta:", cfg);
+      if (ota !== null) log("OTA offer:", body.fw, "->", ota);
+      const reply = {};
+      if (cfg) reply.cfg = cfg;
+      if (ota !== null) reply.ota = ota;
+      publish(`${base}/cfg`, Buffer.from(cfg || ota !== null ? JSON.stringify(reply) : ""), true);
+    } else if (kind === "rec") {
+      if (payload.length < 7) return;
+      const n = payload.readUInt16LE(0);
+      const ch = payload[2];
+      const now = payload.readUInt32LE(3);
+      try {
+        const received = Date.now() / 1000;
+        const records = decodeBatch(payload.subarray(7), n, ch).map((r) => ({
+          time: new Date((received - (now - r.ts)) * 1000).toISOString(),
+          values: r.values,
+        }));
+        log(`Records (${topic}):`, JSON.stringify(records));
+      } catch (err) {
+        log("Record batch error:", err.message);
+      }
+    }
+  };
+}
+
+// ---------------- test ----------------
+
+async function selftest() {
+  const lines = [];
+  const log = (...a) => lines.push(a.join(" "));
+  const { server } = createBroker({ onPublish: ingestBridge({ log }), log });
+  await new Promise((r) => server.listen(0, "127.0.0.1", r));
+  const port = server.address().port;
+
+  function client(id) {
+    const socket = net.connect(port, "127.0.0.1");
+    let pending = Buffer.alloc(0);
+    const waiters = [];
+    const frames = [];
+    socket.on("data", (d) => {
+      let got;
+      [got, pending] = splitFrames(Buffer.concat([pending, d]));
+      frames.push(...got);
+      while (waiters.length && frames.length) waiters.shift()(frames.shift());
+    });
+    const next = () =>
+      new Promise((resolve, reject) => {
+        if (frames.length) return resolve(frames.shift());
+        const t = setTimeout(() => reject(new Error("timeout")), 1000);
+        waiters.push((f) => {
+          clearTimeout(t);
+          resolve(f);
+        });
+      });
+    const connect = Buffer.concat([str("MQTT"), Buffer.from([4, 2]), u16(60), str(id)]);
+    socket.write(packet(CONNECT, 0, connect));
+    return { socket, next };
+  }
+
+  const check = (cond, what) => {
+    if (!cond) throw new Error(what);
+  };
+
+  // Stacja: subskrypcja konfiguracji, raport z nieaktualną wersją
+  const station = client("troposense-1");
+  check((await station.next()).type === CONNACK, "CONNACK");
+  station.socket.write(packet(SUBSCRIBE, 2, Buffer.concat([u16(1), str("troposense/1/cfg"), Buffer.from([1])])));
+  check((await station.next()).type === SUBACK, "SUBACK");
+
+  const report = JSON.stringify({ v: 1, cfg: 0xffff });
+  station.socket.write(publishPacket("troposense/1/report", Buffer.from(report), { qos: 1, id: 7 }));
+  const ack = await station.next();
+  check(ack.type === PUBACK && ack.body.readUInt16BE(0) === 7, "PUBACK for id 7");
+  const cfg = await station.next();
+  check(cfg.type === PUBLISH && cfg.body.toString().includes('"cfg":"v'), "config delta on /cfg");
+
+  // Następne połączenie dostaje ją jako retained
+  const late = client("late");
+  await late.next();
+  late.socket.write(packet(SUBSCRIBE, 2, Buffer.concat([u16(2), str("troposense/+/cfg"), Buffer.from([1])])));
+  await late.next();
+  const kept = await late.next();
+  check(kept.type === PUBLISH && (kept.flags & 1), "retained config for a later subscriber");
+
+  late.socket.write(packet(PINGREQ, 0, Buffer.alloc(0)));
+  check((await late.next()).type === PINGRESP, "PINGRESP");
+
+  station.socket.end();
+  late.socket.end();
+  server.close();
+  console.log(lines.filter((l) => !l.startsWith("Body")).join("\n"));
+  console.log("selftest passed");
+}
+
+if (process.argv[1] === fileURLToPath(import.meta.url)) {
+  if (process.argv.includes("--selftest")) {
+    selftest().catch((err) => {
+      console.error("selftest FAILED:", err.message);
+      process.exit(1);
+    });
+  } else {
+    const { server } = createBroker({ onPublish: ingestBridge() });
+    const PORT = process.env.MQTT_PORT || 1883;
+    server.listen(PORT, () => console.log(`MQTT stand-in listening on tcp://0.0.0.0:${PORT}`));
+  }
+}
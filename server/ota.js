@@ -0,0 +1,391 @@
+// Aktualizacje firmware przez GSM: podpisane łatki delta między dwoma
+// buildami .hex (format: firmware/telemetry/ota_patch.h)
+//
+// Build = region aplikacji 0x3C00 B: obraz z .hex, reszta 0xFF (jak po
+// kasowaniu flash). Jego CRC-32 identyfikuje build; stacja wysyła swój
+// w raporcie jako "fw".
+//
+// config.json: "firmware": "<plik .hex w OTA_DIR>" to build docelowy. Gdy
+// stacja ma inny, a jej własny też leży w OTA_DIR (bez niego nie ma z czego
+// liczyć delty), odpowiedź /ingest dostaje "ota": <CRC docelowego>, a stacja
+// pobiera GET /ota?fw=<swój CRC>.
+//
+// Podpis: SipHash-2-4, klucz OTA_KEY (32 znaki hex) — ten sam, z którym
+// zbudowano firmware (make OTA_KEY=... w firmware/boards/m328p). To klucz
+// wspólny: musi zostać tajny. Bez OTA_KEY w środowisku serwer nie oferuje
+// łatek; jawny klucz deweloperski służy tylko --selftest i --vectors.
+//
+//   node ota.js <stary.hex> <nowy.hex> <łatka.bin>   jedna łatka
+//   node ota.js --selftest                           generator + dekoder na losowych obrazach
+//   node ota.js --vectors <katalog>                  old.bin, new.bin, patch.bin dla testing/ota_apply.c
+
+import { readFileSync, writeFileSync, readdirSync, statSync, mkdirSync } from "node:fs";
+import { join } from "node:path";
+import { fileURLToPath } from "node:url";
+
+export const REGION_SZ = 0x3c00;
+const HDR_SZ = 22;
+const MIN_COPY = 6; // krótsza kopia (5 B) nie jest tańsza od literału
+const MAX_LITERAL = 128;
+const MAX_CANDIDATES = 32; // ile wcześniejszych pozycji z tym samym 4-bajtowym kluczem sprawdzać
+
+export const OTA_DIR = process.env.OTA_DIR || fileURLToPath(new URL("./firmware", import.meta.url));
+const DEV_KEY = Buffer.from("troposense-dev-k").toString("hex");
+export const OTA_KEY_SET = Boolean(process.env.OTA_KEY);
+export const OTA_KEY = Buffer.from(process.env.OTA_KEY || DEV_KEY, "hex");
+
+// Wyniki dekodera (ota_result_t w ota_patch.h), do logów
+export const OTA_RESULTS = ["more", "done", "format", "base", "write", "crc", "tag"];
+
+// ---------------- Intel HEX ----------------
+
+export function parseHex(text) {
+  const region = Buffer.alloc(REGION_SZ, 0xff);
+  let base = 0;
+  let len = 0;
+
+  for (const [i, raw] of text.split(/\r?\n/).entries()) {
+    const line = raw.trim();
+    if (!line) continue;
+    if (line[0] !== ":") throw new Error(`line ${i + 1}: no ':'`);
+    const rec = Buffer.from(line.slice(1), "hex");
+    if (rec.length < 5 || rec.length !== rec[0] + 5) throw new Error(`line ${i + 1}: bad length`);
+    if (rec.reduce((s, b) => (s + b) & 0xff, 0) !== 0) throw new Error(`line ${i + 1}: bad checksum`);
+
+    const addr = rec.readUInt16BE(1);
+    const data = rec.subarray(4, 4 + rec[0]);
+    switch (rec[3]) {
+      case 0x00: {
+        const at = base + addr;
+        if (at + data.length > REGION_SZ) throw new Error(`image over 0x${REGION_SZ.toString(16)} B`);
+        data.copy(region, at);
+        len = Math.max(len, at + data.length);
+        break;
+      }
+      case 0x01:
+        return { region, len };
+      case 0x02:
+        base = data.readUInt16BE(0) << 4;
+        break;
+      case 0x04:
+        base = data.readUInt16BE(0) << 16;
+        break;
+      default: // 03/05: adres startu, bez znaczenia dla obrazu
+    }
+  }
+  return { region, len };
+}
+
+// ---------------- CRC-32, SipHash-2-4 ----------------
+
+const CRC_TABLE = Array.from({ length: 256 }, (_, n) => {
+  let c = n;
+  for (let k = 0; k < 8; k++) c = c & 1 ? 0xedb88320 ^ (c >>> 1) : c >>> 1;
+  return c >>> 0;
+});
+
+export function crc32(buf) {
+  let c = 0xffffffff;
+  for (const b of buf) c = CRC_TABLE[(c ^ b) & 0xff] ^ (c >>> 8);
+  return (c ^ 0xffffffff) >>> 0;
+}
+
+const M64 = (1n << 64n) - 1n;
+const rotl = (x, b) => ((x << b) | (x >> (64n - b))) & M64;
+
+function sipRounds(v, n) {
+  for (let i = 0; i < n; i++) {
+    v[0] = (v[0] + v[1]) & M64; v[1] = rotl(v[1], 13n); v[1] ^= v[0]; v[0] = rotl(v[0], 32n);
+    v[2] = (v[2] + v[3]) & M64; v[3] = rotl(v[3], 16n); v[3] ^= v[2];
+    v[0] = (v[0] + v[3]) & M64; v[3] = rotl(v[3], 21n); v[3] ^= v[0];
+    v[2] = (v[2] + v[1]) & M64; v[1] = rotl(v[1], 17n); v[1] ^= v[2]; v[2] = rotl(v[2], 32n);
+  }
+}
+
+export function siphash24(key, msg) {
+  const k0 = key.readBigUInt64LE(0);
+  const k1 = key.readBigUInt64LE(8);
+  const v = [k0 ^ 0x736f6d6570736575n, k1 ^ 0x646f72616e646f6dn, k0 ^ 0x6c7967656e657261n, k1 ^ 0x7465646279746573n];
+  const full = msg.length & ~7;
+
+  for (let i = 0; i < full; i += 8) {
+    const m = msg.readBigUInt64LE(i);
+    v[3] ^= m;
+    sipRounds(v, 2);
+    v[0] ^= m;
+  }
+  let b = BigInt(msg.length & 0xff) << 56n;
+  for (let i = full; i < msg.length; i++) b |= BigInt(msg[i]) << BigInt(8 * (i - full));
+  v[3] ^= b;
+  sipRounds(v, 2);
+  v[0] ^= b;
+  v[2] ^= 0xffn;
+  sipRounds(v, 4);
+
+  const tag = Buffer.alloc(8);
+  tag.writeBigUInt64LE(v[0] ^ v[1] ^ v[2] ^ v[3]);
+  return tag;
+}
+
+// ---------------- łatka ----------------
+
+// Długość obrazu bez końcowych 0xFF (i tak są w regionie)
+function imageLength(region) {
+  let n = region.length;
+  while (n > 1 && region[n - 1] === 0xff) n--;
+  return n;
+}
+
+export function makePatch(oldRegion, newRegion, key = OTA_KEY) {
+  const newLen = imageLength(newRegion);
+  const header = Buffer.alloc(HDR_SZ);
+  header.write("TSP1", 0, "latin1");
+  header.writeUInt32LE(crc32(oldRegion), 4);
+  header.writeUInt16LE(newLen, 8);
+  header.writeUInt32LE(crc32(newRegion), 10);
+  siphash24(key, Buffer.concat([header.subarray(0, 14), newRegion.subarray(0, newLen)])).copy(header, 14);
+
+  // Indeks starego regionu: 4 bajty -> pozycje (najnowsze na końcu)
+  const index = new Map();
+  for (let i = 0; i + 4 <= oldRegion.length; i++) {
+    const k = oldRegion.readUInt32LE(i);
+    let list = index.get(k);
+    if (!list) index.set(k, (list = []));
+    list.push(i);
+    if (list.length > MAX_CANDIDATES) list.shift();
+  }
+
+  const ops = [];
+  let literal = [];
+  const flush = () => {
+    for (let i = 0; i < literal.length; i += MAX_LITERAL) {
+      const part = literal.slice(i, i + MAX_LITERAL);
+      ops.push(Buffer.from([part.length - 1, ...part]));
+    }
+    literal = [];
+  };
+
+  // Zachłannie: najdłuższe dopasowanie w starym obrazie, inaczej literał
+  for (let out = 0; out < newLen; ) {
+    let bestLen = 0;
+    let bestFrom = 0;
+    if (out + 4 <= newLen) {
+      for (const from of index.get(newRegion.readUInt32LE(out)) ?? []) {
+        let n = 0;
+        const max = Math.min(newLen - out, oldRegion.length - from, 0xffff);
+        while (n < max && oldRegion[from + n] === newRegion[out + n]) n++;
+        if (n > bestLen) [bestLen, bestFrom] = [n, from];
+      }
+    }
+    if (bestLen >= MIN_COPY) {
+      flush();
+      const op = Buffer.alloc(5);
+      op[0] = 0x80;
+      op.writeUInt16LE(bestFrom, 1);
+      op.writeUInt16LE(bestLen, 3);
+      ops.push(op);
+      out += bestLen;
+    } else {
+      literal.push(newRegion[out++]);
+    }
+  }
+  flush();
+  return Buffer.concat([header, ...ops]);
+}
+
+// Dekoder jak w ota_patch.c (selftest): { result, region }
+export function applyPatch(oldRegion, patch, key = OTA_KEY) {
+  if (patch.length < HDR_SZ || patch.toString("latin1", 0, 4) !== "TSP1") return { result: "format" };
+  if (patch.readUInt32LE(4) !== crc32(oldRegion)) return { result: "base" };
+  const newLen = patch.readUInt16LE(8);
+  if (newLen === 0 || newLen > REGION_SZ) return { result: "format" };
+
+  const region = Buffer.alloc(REGION_SZ, 0xff);
+  let out = 0;
+  for (let i = HDR_SZ; out < newLen; ) {
+    if (i >= patch.length) return { result: "more" };
+    const op = patch[i++];
+    if (op < 0x80) {
+      const n = op + 1;
+      if (out + n > newLen || i + n > patch.length) return { result: "format" };
+      patch.copy(region, out, i, i + n);
+      [i, out] = [i + n, out + n];
+    } else if (op === 0x80) {
+      if (i + 4 > patch.length) return { result: "more" };
+      const from = patch.readUInt16LE(i);
+      const n = patch.readUInt16LE(i + 2);
+      i += 4;
+      if (n === 0 || from + n > REGION_SZ || out + n > newLen) return { result: "format" };
+      oldRegion.copy(region, out, from, from + n);
+      out += n;
+    } else {
+      return { result: "format" };
+    }
+  }
+  if (crc32(region) !== patch.readUInt32LE(10)) return { result: "crc" };
+  const tag = siphash24(key, Buffer.concat([patch.subarray(0, 14), region.subarray(0, newLen)]));
+  if (!tag.equals(patch.subarray(14, 22))) return { result: "tag" };
+  return { result: "done", region };
+}
+
+// ---------------- buildy i oferty ----------------
+
+const builds = new Map(); // plik -> { mtimeMs, crc, region }
+const patches = new Map(); // "<stary>:<nowy>" -> Buffer
+
+// Wszystkie .hex z OTA_DIR (przeliczane tylko po zmianie pliku)
+function loadBuilds(dir) {
+  let files = [];
+  try {
+    files = readdirSync(dir).filter((f) => f.endsWith(".hex"));
+  } catch {
+    return [];
+  }
+  return files.flatMap((file) => {
+    const path = join(dir, file);
+    const { mtimeMs } = statSync(path);
+    let b = builds.get(path);
+    if (!b || b.mtimeMs !== mtimeMs) {
+      try {
+        const { region } = parseHex(readFileSync(path, "utf8"));
+        b = { file, mtimeMs, crc: crc32(region), region };
+        builds.set(path, b);
+      } catch (err) {
+        console.error(`OTA: ${file}: ${err.message}`);
+        return [];
+      }
+    }
+    return [b];
+  });
+}
+
+function target(config, dir) {
+  if (!config?.firmware) return null;
+  return loadBuilds(dir).find((b) => b.file === config.firmware) ?? null;
+}
+
+// CRC builda do zaoferowania stacji z "fw" = stationCrc, albo null
+export function otaOffer(config, stationCrc, dir = OTA_DIR) {
+  const t = target(config, dir);
+  if (t && !OTA_KEY_SET) {
+    console.error("OTA: no OTA_KEY set, not offering a patch signed with the public development key");
+    return null;
+  }
+  if (!t || !Number.isInteger(stationCrc) || stationCrc === t.crc) return null;
+  if (!loadBuilds(dir).some((b) => b.crc === stationCrc)) {
+    console.error(`OTA: station build ${stationCrc} not in ${dir}, no patch possible`);
+    return null;
+  }
+  return t.crc;
+}
+
+// Łatka ze stacji stationCrc do builda docelowego, albo null
+export function otaPatch(config, stationCrc, { dir = OTA_DIR, key = OTA_KEY } = {}) {
+  const t = target(config, dir);
+  const from = loadBuilds(dir).find((b) => b.crc === stationCrc);
+  if (!t || !from || from.crc === t.crc) return null;
+  if (key === OTA_KEY && !OTA_KEY_SET) return null;
+
+  const id = `${from.crc}:${t.crc}`;
+  if (!patches.has(id)) patches.set(id, makePatch(from.region, t.region, key));
+  return patches.get(id);
+}
+
+// ---------------- test ----------------
+
+// Losowy "kod" i jego nowa wersja: wstawki, usunięcia, zmiany bajtów
+function sampleImages(seed) {
+  let s = seed;
+  const rnd = (n) => ((s = (s * 1103515245 + 12345) >>> 0) >>> 8) % n;
+  const code = Buffer.from(Array.from({ length: 9000 }, () => rnd(256)));
+  const parts = [];
+  for (let i = 0; i < code.length; ) {
+    const n = 200 + rnd(800);
+    const r = rnd(4);
+    const part = Buffer.from(code.subarray(i, i + n));
+    if (r === 0) parts.push(Buffer.from(Array.from({ length: 1 + rnd(60) }, () => rnd(256))));
+    if (r === 2) part[rnd(part.length)] ^= 0x5a;
+    if (r !== 1) parts.push(part);
+    i += n;
+  }
+  const oldRegion = Buffer.alloc(REGION_SZ, 0xff);
+  const newRegion = Buffer.alloc(REGION_SZ, 0xff);
+  code.copy(oldRegion);
+  Buffer.concat(parts).copy(newRegion);
+  return { oldRegion, newRegion };
+}
+
+function toHex(region) {
+  const lines = [];
+  for (let a = 0; a < imageLength(region); a += 16) {
+    const data = region.subarray(a, a + 16);
+    const rec = Buffer.concat([Buffer.from([data.length, a >> 8, a & 0xff, 0]), data]);
+    const sum = (0x100 - (rec.reduce((x, b) => x + b, 0) & 0xff)) & 0xff;
+    lines.push(":" + Buffer.concat([rec, Buffer.from([sum])]).toString("hex").toUpperCase());
+  }
+  return lines.concat(":00000001FF").join("\n") + "\n";
+}
+
+function selftest() {
+  const check = (cond, what) => {
+    if (!cond) throw new Error(what);
+  };
+  const key = Buffer.from("000102030405060708090a0b0c0d0e0f", "hex");
+
+  // Wektory z publikacji SipHash (64-bitowy wynik, little endian)
+  check(siphash24(key, Buffer.alloc(0)).toString("hex") === "310e0edd47db6f72", "SipHash empty");
+  check(
+    siphash24(key, Buffer.from([...Array(15).keys()])).toString("hex") === "e545be4961ca29a1",
+    "SipHash 15 B",
+  );
+  check(crc32(Buffer.from("123456789")) === 0xcbf43926, "CRC-32 check value");
+
+  const { oldRegion, newRegion } = sampleImages(7);
+  check(parseHex(toHex(newRegion)).region.equals(newRegion), "Intel HEX round trip");
+
+  const patch = makePatch(oldRegion, newRegion, key);
+  const ok = applyPatch(oldRegion, patch, key);
+  check(ok.result === "done" && ok.region.equals(newRegion), "patch applies");
+
+  const bad = Buffer.from(patch);
+  bad[bad.length - 1] ^= 1;
+  check(applyPatch(oldRegion, bad, key).result !== "done", "tampered patch rejected");
+  check(applyPatch(newRegion, patch, key).result === "base", "wrong base rejected");
+  check(applyPatch(oldRegion, patch, OTA_KEY).result === "tag", "wrong key rejected");
+
+  console.log(
+    `patch ${patch.length} B for a ${imageLength(newRegion)} B image ` +
+      `(${((100 * patch.length) / imageLength(newRegion)).toFixed(1)} %)`,
+  );
+  console.log("selftest passed");
+  return { oldRegion, newRegion, patch, key };
+}
+
+if (process.argv[1] === fileURLToPath(import.meta.url)) {
+  const args = process.argv.slice(2);
+  try {
+    if (args[0] === "--selftest") {
+      selftest();
+    } else if (args[0] === "--vectors" && args[1]) {
+      const { oldRegion, newRegion, patch, key } = selftest();
+      mkdirSync(args[1], { recursive: true });
+      writeFileSync(join(args[1], "old.bin"), oldRegion);
+      writeFileSync(join(args[1], "new.bin"), newRegion);
+      writeFileSync(join(args[1], "patch.bin"), patch);
+      writeFileSync(join(args[1], "key.bin"), key);
+      console.log(`vectors in ${args[1]}`);
+    } else if (args.length === 3) {
+      const from = parseHex(readFileSync(args[0], "utf8")).region;
+      const to = parseHex(readFileSync(args[1], "utf8")).region;
+      const patch = makePatch(from, to);
+      writeFileSync(args[2], patch);
+      console.log(`${crc32(from)} -> ${crc32(to)}: ${patch.length} B`);
+    } else {
+      console.error("usage: node ota.js <old.hex> <new.hex> <out.bin> | --selftest | --vectors <dir>");
+      process.exit(2);
+    }
+  } catch (err) {
+    console.error("FAILED:", err.message);
+    process.exit(1);
+  }
+}
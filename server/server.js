@@ -1,5 +1,10 @@
 import express from "express";
 import morgan from "morgan";
+import { decodeBatch } from "./tscodec.js";
+import { loadConfig, configDelta } from "./config.js";
+import { otaOffer, otaPatch, OTA_RESULTS } from "./ota.js";
+
+const CONFIG_PATH = process.env.CONFIG_PATH || new URL("./config.json", import.meta.url);
 
 const app = express();
 
@@ -23,12 +28,51 @@ app.post("/ingest", (req, res) => {
   // Sam JSON (Express już sparsował)
   console.log("Body:", JSON.stringify(req.body, null, 2));
 
+  // Paczka rekordów: czasy w sekundach od startu stacji, "now" to chwila wysłania
+  const rec = req.body?.rec;
+  if (rec?.b64) {
+    try {
+      const received = Date.now() / 1000;
+      const records = decodeBatch(Buffer.from(rec.b64, "base64"), rec.n, rec.ch).map((r) => ({
+        time: new Date((received - (rec.now - r.ts)) * 1000).toISOString(),
+        values: r.values,
+      }));
+      console.log("Records:", JSON.stringify(records));
+    } catch (err) {
+      console.error("Record batch error:", err.message);
+    }
+  }
+
   // jeśli chcesz zweryfikować strukturę:
   // if (!req.body || typeof req.body !== "object" || !req.body.foo) {
   //   return res.status(400).json({ ok: false, error: "Missing field: foo" });
   // }
 
-  res.json({ ok: true });
+  // Delta konfiguracji tylko gdy stacja ma starszą wersję; krótka odpowiedź,
+  // stacja czyta ją AT+HTTPREAD w tej samej sesji
+  const config = loadConfig(CONFIG_PATH);
+  const cfg = configDelta(config, req.body?.cfg);
+  if (cfg) console.log("Config delta:", cfg);
+
+  // Inny build docelowy: stacja pobierze łatkę z /ota po tym uploadzie
+  if (Number.isInteger(req.body?.ota)) console.log("OTA last attempt:", OTA_RESULTS[req.body.ota] ?? req.body.ota);
+  const ota = otaOffer(config, req.body?.fw);
+  if (ota !== null) console.log("OTA offer:", req.body.fw, "->", ota);
+
+  const reply = { ok: true };
+  if (cfg) reply.cfg = cfg;
+  if (ota !== null) reply.ota = ota;
+  res.json(reply);
+});
+
+// Łatka delta od builda stacji (fw = jej CRC) do builda z config.json;
+// stacja czyta ją kawałkami AT+HTTPREAD
+app.get("/ota", (req, res) => {
+  const fw = Number(req.query.fw);
+  const patch = otaPatch(loadConfig(CONFIG_PATH), fw);
+  if (!patch) return res.status(404).json({ ok: false, error: "No update for this build" });
+  console.log(`OTA patch for ${fw}: ${patch.length} B`);
+  res.type("application/octet-stream").send(patch);
 });
 
 // prosty healthcheck
@@ -0,0 +1,114 @@
+// Dekoder paczek rekordów z firmware/telemetry/tscodec.c
+//
+// Strumień bitów (MSB first), na rekord:
+//  - znacznik czasu: pierwszy rekord 32 bity surowo, dalej delta-of-delta
+//    w zig-zag: '0' (0), '10'+7, '110'+9, '1110'+12, '1111'+32 bity
+//  - każdy kanał: delta do poprzedniego rekordu w zig-zag, '0' dla zera
+//    albo '1' i grupy 4 bitów (od najmłodszej) z bitem kontynuacji
+//
+// Uruchomione bezpośrednio sprawdza wektor z testing/tscodec_bench --vector
+// i granicę długości varintu (make test):
+//   node tscodec.js vector.json
+
+import { readFileSync } from "node:fs";
+import { fileURLToPath } from "node:url";
+
+const TS_CLASS_BITS = [7, 9, 12];
+
+class BitReader {
+  constructor(buf) {
+    this.buf = buf;
+    this.pos = 0;
+    this.bits = buf.length * 8;
+  }
+
+  read(n) {
+    if (this.pos + n > this.bits) throw new Error("truncated batch");
+    let v = 0;
+    for (let i = 0; i < n; i++) {
+      const bit = (this.buf[this.pos >> 3] >> (7 - (this.pos & 7))) & 1;
+      v = v * 2 + bit; // bez << żeby 32 bity nie przeszły na liczbę ujemną
+      this.pos++;
+    }
+    return v;
+  }
+
+  varint() {
+    if (!this.read(1)) return 0;
+    let zz = 0;
+    let scale = 1;
+    for (;;) {
+      // najwyżej 8 grup (32 bity), jak get_varint(); sprawdzane przed odczytem
+      if (scale > 2 ** 28) throw new Error("varint too long");
+      const group = this.read(5);
+      zz += (group >> 1) * scale;
+      scale *= 16;
+      if (!(group & 1)) return zz;
+    }
+  }
+
+  timestamp() {
+    for (let c = 0; c <= TS_CLASS_BITS.length; c++) {
+      if (!this.read(1)) return c === 0 ? 0 : this.read(TS_CLASS_BITS[c - 1]);
+    }
+    return this.read(32);
+  }
+}
+
+const unzigzag = (zz) => (zz % 2 ? -(zz + 1) / 2 : zz / 2);
+
+// buf: Buffer, n: liczba rekordów, ch: liczba kanałów -> [{ ts, values }]
+export function decodeBatch(buf, n, ch) {
+  const r = new BitReader(buf);
+  const out = [];
+  let prevTs = 0;
+  let prevDelta = 0;
+  const prev = new Array(ch).fill(0);
+
+  for (let i = 0; i < n; i++) {
+    let ts;
+    if (i === 0) {
+      ts = r.read(32);
+    } else {
+      prevDelta += unzigzag(r.timestamp());
+      ts = (prevTs + prevDelta) >>> 0;
+    }
+    prevTs = ts;
+
+    const values = prev.map((p, k) => (prev[k] = (p + unzigzag(r.varint())) | 0));
+    out.push({ ts, values });
+  }
+  return out;
+}
+
+// Jeden rekord, jeden kanał: czas 0, delta jako varint z `groups` grupami 0xF
+function varintBatch(groups) {
+  let bits = "0".repeat(32) + "1";
+  for (let g = 0; g < groups; g++) bits += "1111" + (g + 1 < groups ? "1" : "0");
+  bits = bits.padEnd(Math.ceil(bits.length / 8) * 8, "0");
+  return Buffer.from(bits.match(/.{8}/g).map((b) => parseInt(b, 2)));
+}
+
+// Granica długości varintu taka jak w tscodec.c: 8 grup przechodzi, 9 nie
+function checkVarintLimit() {
+  const max = decodeBatch(varintBatch(8), 1, 1)[0].values[0];
+  let rejected = false;
+  try {
+    decodeBatch(varintBatch(9), 1, 1);
+  } catch {
+    rejected = true;
+  }
+  return max === unzigzag(2 ** 32 - 1) && rejected;
+}
+
+if (process.argv[1] === fileURLToPath(import.meta.url)) {
+  const vec = JSON.parse(readFileSync(process.argv[2], "utf8"));
+  const got = decodeBatch(Buffer.from(vec.hex, "hex"), vec.n, vec.ch);
+  const bad = got.findIndex(
+    (r, i) => r.ts !== vec.records[i][0] || r.values.some((v, k) => v !== vec.records[i][k + 1])
+  );
+  const limit = checkVarintLimit();
+  console.log(bad < 0 ? `ok: ${got.length} records` : `MISMATCH at record ${bad}`);
+  console.log(limit ? "ok: varint limit" : "MISMATCH: varint limit");
+  process.exit(bad < 0 && limit ? 0 : 1);
+}
@@ -0,0 +1,13 @@
+/* avr_sim: SPM page programming on avr_sim_flash */
+#ifndef AVR_SIM_BOOT_H
+#define AVR_SIM_BOOT_H
+
+#include "io.h"
+
+#define boot_page_erase(addr)      avr_sim_page_erase((uint16_t)(addr))
+#define boot_page_fill(addr, w)    avr_sim_page_fill((uint16_t)(addr), (uint16_t)(w))
+#define boot_page_write(addr)      avr_sim_page_write((uint16_t)(addr))
+#define boot_spm_busy_wait()       ((void)0)
+#define boot_rww_enable()          ((void)0)
+
+#endif
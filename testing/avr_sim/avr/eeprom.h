@@ -0,0 +1,19 @@
+/* avr_sim: EEPROM access on avr_sim_eeprom (addresses are pointers, as in avr-libc) */
+#ifndef AVR_SIM_EEPROM_H
+#define AVR_SIM_EEPROM_H
+
+#include <stdint.h>
+#include <string.h>
+#include "io.h"
+
+#define eeprom_busy_wait() ((void)0)
+
+static inline void eeprom_read_block(void *dst, const void *src, size_t n) {
+    memcpy(dst, avr_sim_eeprom + (uintptr_t)src, n);
+}
+
+static inline void eeprom_update_dword(uint32_t *addr, uint32_t v) {
+    memcpy(avr_sim_eeprom + (uintptr_t)addr, &v, sizeof(v));
+}
+
+#endif
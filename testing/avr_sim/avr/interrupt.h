@@ -0,0 +1,10 @@
+/* avr_sim: the global interrupt flag as a bit of SREG */
+#ifndef AVR_SIM_INTERRUPT_H
+#define AVR_SIM_INTERRUPT_H
+
+#include "io.h"
+
+#define cli() (SREG &= (uint8_t)~0x80)
+#define sei() (SREG |= 0x80)
+
+#endif
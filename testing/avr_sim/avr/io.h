@@ -0,0 +1,10 @@
+/* avr_sim: registers and sizes of the ATmega328P used by the bootloader */
+#ifndef AVR_SIM_IO_H
+#define AVR_SIM_IO_H
+
+#include "../avr_sim.h"
+
+#define E2END        (AVR_SIM_EEPROM_SZ - 1)
+#define SPM_PAGESIZE 128
+
+#endif
@@ -0,0 +1,9 @@
+/* avr_sim: flash reads from avr_sim_flash */
+#ifndef AVR_SIM_PGMSPACE_H
+#define AVR_SIM_PGMSPACE_H
+
+#include "io.h"
+
+#define pgm_read_byte(addr) (avr_sim_flash[(uint16_t)(addr)])
+
+#endif
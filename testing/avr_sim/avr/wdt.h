@@ -0,0 +1,12 @@
+/* avr_sim: the watchdog; avr_sim_wdt_enable() stands for its reset */
+#ifndef AVR_SIM_WDT_H
+#define AVR_SIM_WDT_H
+
+#include "io.h"
+
+#define WDTO_2S 7
+
+#define wdt_enable(t)  avr_sim_wdt_enable(t)
+#define wdt_disable()  avr_sim_wdt_disable()
+
+#endif
@@ -0,0 +1,29 @@
+/*
+ * ATmega328P flash, EEPROM and watchdog for building the bootloader
+ * (firmware/boards/m328p/bootloader/ota_boot.c) on a PC.
+ *
+ * The avr/ headers next to this one replace avr-libc's: flash reads,
+ * SPM page erase/fill/write and EEPROM access go to the arrays below,
+ * and the functions are provided by the test (testing/ota_boot_sim.c),
+ * which also decides when a write fails or the power goes.
+ */
+
+#ifndef AVR_SIM_H
+#define AVR_SIM_H
+
+#include <stdint.h>
+
+#define AVR_SIM_FLASH_SZ  0x8000U
+#define AVR_SIM_EEPROM_SZ 1024U
+
+extern uint8_t avr_sim_flash[AVR_SIM_FLASH_SZ];
+extern uint8_t avr_sim_eeprom[AVR_SIM_EEPROM_SZ];
+extern uint8_t MCUSR, GPIOR0, SREG;
+
+void avr_sim_page_erase(uint16_t addr);
+void avr_sim_page_fill(uint16_t addr, uint16_t word);
+void avr_sim_page_write(uint16_t addr);
+void avr_sim_wdt_enable(uint8_t timeout);
+void avr_sim_wdt_disable(void);
+
+#endif /* AVR_SIM_H */
@@ -0,0 +1,236 @@
+/*
+ * Replays a weather log through the main AVR's upload triggers
+ * (firmware/telemetry/deadband.c) and compares the number of uploads
+ * with the fixed hourly schedule they replace.
+ *
+ * The log is a CSV with a header and one row per sample:
+ *   time_s,t,t_ds,p,rh,wind,rain
+ * in the firmware's units (0.01 °C, Pa, 0.01 %RH, cm/s mean wind,
+ * cumulative rain tips). Without a file a two-week synthetic log is
+ * generated (diurnal temperature and humidity, a frontal passage with a
+ * pressure drop, wind and showers); --dump writes it out as CSV.
+ *
+ * Like the firmware, the check runs every REPORT_CHECK_MIN on the latest
+ * sample; the rain channel counts tips since the last upload. Also
+ * reports how far the server's picture (the last uploaded values) drifted
+ * from the real values at the check instants.
+ *
+ * Fails if the deadband schedule does not upload less often than the
+ * hourly one, leaves a gap longer than the max silence (plus one check
+ * interval), or lets the server's picture of a channel drift by more
+ * than twice its band: a band is checked every REPORT_CHECK_MIN, so
+ * what changes between two checks comes on top of it.
+ *
+ * Build and run on the host:
+ *   cc -O2 -I../firmware/telemetry -I../firmware/boards/m328p \
+ *      deadband_replay.c ../firmware/telemetry/deadband.c -lm -o deadband_replay
+ *   ./deadband_replay [log.csv | --dump]
+ * (or "make test" at the top of the repository)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "deadband.h"
+#include "config.h"
+
+#define BASELINE_PERIOD_S 3600L
+#define SYNTH_DAYS        14
+
+typedef struct {
+    long    time_s;
+    int32_t v[DB_CHANNELS];   /* rain cumulative here */
+} row_t;
+
+static const char *const NAMES[DB_CHANNELS] = { "t", "t_ds", "p", "rh", "wind", "rain" };
+
+static row_t *rows;
+static size_t n_rows;
+
+static void push(const row_t *r) {
+    static size_t cap;
+    if (n_rows == cap) {
+        cap = cap ? cap * 2 : 1024;
+        rows = realloc(rows, cap * sizeof(row_t));
+        if (!rows) exit(1);
+    }
+    rows[n_rows++] = *r;
+}
+
+static int load_csv(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    char line[256];
+    if (!fgets(line, sizeof(line), f)) {  // header
+        fclose(f);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        row_t r;
+        long v[DB_CHANNELS];
+        if (sscanf(line, "%ld,%ld,%ld,%ld,%ld,%ld,%ld", &r.time_s,
+                   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 7) continue;
+        for (int i = 0; i < DB_CHANNELS; i++) r.v[i] = (int32_t)v[i];
+        push(&r);
+    }
+    fclose(f);
+    return 0;
+}
+
+/* Deterministic noise so runs are comparable */
+static uint32_t rng = 12345;
+static double noise(void) {
+    rng = rng * 1664525u + 1013904223u;
+    return (double)(rng >> 8) / (double)(1u << 24) - 0.5;
+}
+
+/* 0 outside [from, to], 1 inside, cosine ramps of 3 h at both ends */
+static double bump(double d, double from, double to) {
+    const double ramp = 0.125;
+    if (d <= from - ramp || d >= to + ramp) return 0.0;
+    if (d < from) return 0.5 - 0.5 * cos(M_PI * (d - from + ramp) / ramp);
+    if (d > to) return 0.5 + 0.5 * cos(M_PI * (d - to) / ramp);
+    return 1.0;
+}
+
+static void synthesize(void) {
+    const double day = 86400.0;
+    double p_walk = 0.0, t_walk = 0.0, wind_walk = 0.0, ground = 1100.0;
+    long rain = 0;
+
+    for (long t = 0; t < SYNTH_DAYS * 86400L; t += 60) {
+        double d = t / day;
+        double diurnal = sin(2.0 * M_PI * (d - 0.375));   // peak mid-afternoon
+
+        // Frontal passage on days 5-6 and a weaker one on day 10, ramped over a few hours
+        double front = bump(d, 5.0, 6.5) + 0.6 * bump(d, 10.0, 10.5);
+
+        t_walk += noise() * 4.0;
+        t_walk *= 0.999;
+        p_walk += noise() * 6.0;
+        p_walk *= 0.9995;
+        wind_walk += noise() * 30.0;
+        wind_walk *= 0.98;
+
+        double air = 1200.0 + 600.0 * diurnal * (1.0 - 0.6 * front) - 300.0 * front + t_walk;
+        ground += (1100.0 + 0.2 * (air - 1200.0) - ground) / 240.0;   // slow soil response
+        double p = 101300.0 + p_walk - 1500.0 * sin(M_PI * fmin(fmax((d - 5.0) / 1.5, 0.0), 1.0));
+        double rh = 7000.0 - 3.0 * (air - 1200.0) + 2000.0 * front + noise() * 60.0;
+        double wind = 250.0 + 150.0 * diurnal + 700.0 * front + wind_walk;
+
+        if (noise() + 0.5 < 0.1 * front) rain++;
+
+        row_t r = { t, {
+            (int32_t)lround(air + noise() * 8.0),
+            (int32_t)lround(ground),
+            (int32_t)lround(p + noise() * 8.0),
+            (int32_t)lround(fmin(fmax(rh, 1500.0), 10000.0)),
+            (int32_t)lround(fmax(wind, 0.0)),
+            (int32_t)rain,
+        } };
+        push(&r);
+    }
+}
+
+int main(int argc, char **argv) {
+    bool dump = (argc > 1 && strcmp(argv[1], "--dump") == 0);
+
+    if (argc > 1 && !dump) {
+        if (load_csv(argv[1]) != 0) return 1;
+    } else {
+        synthesize();
+    }
+    if (n_rows == 0) return 1;
+
+    if (dump) {
+        printf("time_s,t,t_ds,p,rh,wind,rain\n");
+        for (size_t i = 0; i < n_rows; i++) {
+            printf("%ld", rows[i].time_s);
+            for (int c = 0; c < DB_CHANNELS; c++) printf(",%ld", (long)rows[i].v[c]);
+            printf("\n");
+        }
+        return 0;
+    }
+
+    const deadband_config_t cfg = {
+        .band = { DEADBAND_AIR_TEMP, DEADBAND_GROUND_TEMP, DEADBAND_PRESSURE,
+                  DEADBAND_HUMIDITY, DEADBAND_WIND, DEADBAND_RAIN },
+        .max_silence_min = REPORT_MAX_SILENCE_MIN,
+    };
+    const long check_s = REPORT_CHECK_MIN * 60L;
+    const long span_s = rows[n_rows - 1].time_s - rows[0].time_s;
+
+    deadband_t db;
+    deadband_reset(&db);
+
+    unsigned uploads = 0, baseline = 0;
+    unsigned by_reason[DB_CHANNELS + 1] = { 0 };
+    int32_t worst[DB_CHANNELS] = { 0 };
+    int32_t sent_cum_rain = 0;
+    long next_check = rows[0].time_s, next_baseline = rows[0].time_s;
+    long last_upload = rows[0].time_s, longest_gap = 0;
+
+    for (size_t i = 0; i < n_rows; i++) {
+        const row_t *r = &rows[i];
+
+        if (r->time_s >= next_baseline) {
+            baseline++;
+            next_baseline += BASELINE_PERIOD_S;
+        }
+        if (r->time_s < next_check) continue;
+        next_check += check_s;
+
+        int32_t v[DB_CHANNELS];
+        memcpy(v, r->v, sizeof(v));
+        v[DB_RAIN] = r->v[DB_RAIN] - sent_cum_rain;   // monitor counter restarts at each upload
+
+        // Server's view against the truth, before this check can refresh it
+        if (db.has_sent) {
+            for (int c = 0; c < DB_CHANNELS; c++) {
+                int32_t err = (c == DB_RAIN) ? v[c] : v[c] - db.sent[c];
+                if (err < 0) err = -err;
+                if (err > worst[c]) worst[c] = err;
+            }
+        }
+
+        uint8_t why = deadband_check(&db, &cfg, v, (uint32_t)(r->time_s * 1000L));
+        if (!why) continue;
+
+        uploads++;
+        if (r->time_s - last_upload > longest_gap) longest_gap = r->time_s - last_upload;
+        last_upload = r->time_s;
+        for (int c = 0; c <= DB_CHANNELS; c++) {
+            if (why & (1 << c)) by_reason[c]++;
+        }
+        deadband_commit(&db, v, (uint32_t)(r->time_s * 1000L));
+        sent_cum_rain = r->v[DB_RAIN];
+    }
+
+    printf("log: %zu rows, %.1f days (%s)\n", n_rows, span_s / 86400.0,
+           (argc > 1) ? argv[1] : "synthetic");
+    printf("check every %d min, max silence %d min\n\n", REPORT_CHECK_MIN, REPORT_MAX_SILENCE_MIN);
+    printf("uploads, hourly schedule: %u\n", baseline);
+    printf("uploads, deadband:        %u (%.0f %% fewer)\n\n", uploads,
+           baseline ? 100.0 * (1.0 - (double)uploads / baseline) : 0.0);
+
+    printf("%-6s %8s %10s %14s\n", "chan", "band", "triggers", "worst drift");
+    for (int c = 0; c < DB_CHANNELS; c++) {
+        printf("%-6s %8u %10u %14ld\n", NAMES[c], cfg.band[c], by_reason[c], (long)worst[c]);
+    }
+    printf("%-6s %8s %10u\n", "silent", "", by_reason[DB_CHANNELS]);
+    printf("longest gap: %ld min\n", longest_gap / 60);
+
+    int ok = uploads > 0 && uploads < baseline
+          && longest_gap <= (REPORT_MAX_SILENCE_MIN + REPORT_CHECK_MIN) * 60L;
+    for (int c = 0; c < DB_CHANNELS; c++) {
+        if (worst[c] > 2 * (int32_t)cfg.band[c]) ok = 0;
+    }
+    printf("deadband: %s\n", ok ? "passed" : "FAILED");
+    return !ok;
+}
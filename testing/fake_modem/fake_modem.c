@@ -0,0 +1,775 @@
+/*
+ * Scripted fake A7670E for host runs of firmware/peripherals/gsm_module.c.
+ *
+ * Replaces uart_isr.c and clock_delay_ms(): time is virtual and only
+ * advances in clock_delay_ms(), the modem answers AT commands according
+ * to a scenario (when it boots, gets the SIM, registers and attaches)
+ * and emits the start-up URCs at those moments.
+ *
+ * Compares time-to-ready of gsm_wait_ready() (URCs only) with
+ * gsm_probe_ready() for a cold boot, a warm modem (powered before the MCU
+ * started, URCs missed, still registering) and an already registered one.
+ *
+ * Then posts through gsm_http_post() and serves an ingest response with a
+ * config delta split across AT+HTTPREAD chunks, checking what the
+ * streaming parser (config_delta.c) makes of it.
+ *
+ * Finally the learned AT timeouts (latency.c): HTTP command latencies are
+ * drawn from per-command distributions; after a learning run a hung
+ * HTTPINIT / HTTPACTION must be given up on far sooner than the worst
+ * case, and a network that turns slower must not keep failing.
+ *
+ * The MQTT client (gsm_mqtt.c) against AT+CMQTT*: a retained config
+ * arrives right after the subscription, a lost PUBACK is retried with
+ * DUP, binary payloads go through unchanged, and a publish that is never
+ * acknowledged is reported as failed.
+ *
+ * A binary GET body (OTA patch download) read back through
+ * gsm_http_read() unchanged, even where it looks like modem output.
+ *
+ * A modem holding CTS off makes uart_isr.c drop bytes; the POST must
+ * abort on the cut command rather than wait out its timeouts.
+ *
+ * And the AT+IPR switch: the link only works while both ends use the same
+ * rate, so gsm_set_baud() has to end up on a rate the modem really uses.
+ *
+ * Build and run on the host:
+ *   cc -O2 -I../../firmware/peripherals -I../../firmware/communication \
+ *      -I../../firmware/system -I../../firmware/telemetry \
+ *      fake_modem.c ../../firmware/peripherals/gsm_module.c ../../firmware/peripherals/gsm_mqtt.c \
+ *      ../../firmware/telemetry/config_delta.c ../../firmware/telemetry/latency.c \
+ *      ../../firmware/telemetry/stream_writer.c ../../firmware/hal/host/hal_host.c -lm -o fake_modem
+ *   ./fake_modem
+ * (or "make test" at the top of the repository)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "gsm_module.h"
+#include "gsm_mqtt.h"
+#include "uart_isr.h"
+#include "clock.h"
+#include "config_delta.h"
+
+uart_rx_ring_t uart_rx;
+
+/* ---------------- scenario ---------------- */
+
+typedef struct {
+    const char *name;
+    long boot_ms;     /* answers AT from here; URCs before 0 were missed */
+    long sim_ms;      /* +CPIN: READY */
+    long reg_ms;      /* registered (CEREG/CREG stat 1) */
+    long attach_ms;   /* +CGATT: 1 */
+} scenario_t;
+
+static const scenario_t SCENARIOS[] = {
+    { "cold boot",          9000,   11000, 17000, 19000 },
+    { "warm (registering)", -4000,  -2000,  3500,  5000 },
+    { "already registered", -60000, -58000, -50000, -48000 },
+};
+
+/* ---------------- virtual clock + modem output ---------------- */
+
+#define MAX_MSGS 32
+
+typedef struct {
+    long at;          /* delivery time */
+    char text[160];
+    size_t len;       /* binary bodies may contain '\0' */
+    size_t pos;
+} msg_t;
+
+static long now_ms;
+static const scenario_t *sc;
+static bool echo;
+static msg_t msgs[MAX_MSGS];
+static int n_msgs;
+static int current = -1;     /* message being delivered, never interleaved */
+static char cmd_line[96];
+static size_t cmd_len;
+static long data_left;              /* AT+HTTPDATA payload bytes still expected */
+static long data_len;
+static const char *http_body;       /* ingest response served by AT+HTTPREAD */
+static const uint8_t *http_bin;     /* binary body served after a GET */
+static long http_bin_len;
+static bool http_get;               /* last AT+HTTPACTION was method 0 */
+static uint32_t modem_baud = 115200, uart_baud = 115200;
+
+/* AT+CMQTT*: '>' blocks (topic, payload, subscription) and what was published */
+enum { BLOCK_HTTP = 0, BLOCK_TOPIC, BLOCK_PAYLOAD, BLOCK_SUB };
+static int block_kind;
+static uint8_t block[512];
+static long block_len;
+static char mqtt_topic[64];
+static uint8_t mqtt_payload[512];
+static long mqtt_payload_len;
+static const char *mqtt_retained;   /* delivered on subscribe */
+static int mqtt_drop_acks;          /* PUBACKs still to be lost */
+static int mqtt_pubs, mqtt_dups;
+typedef struct { char topic[64]; uint8_t data[512]; long len; } published_t;
+static published_t published[4];
+static int n_published;
+static uint32_t ipr_baud;           /* AT+IPR takes effect after its "OK" */
+static bool ipr_refused;            /* modem answers AT+IPR with ERROR */
+static bool cts_stalled;            /* modem holds CTS off: uart_isr.c drops every byte */
+static uint16_t tx_dropped;
+
+/* Injected latency of the HTTP commands (gsm_cmd_class_t), ms */
+typedef struct { double mean, sd; } dist_t;
+static dist_t http_lat[GSM_T_COUNT];
+static int hang_class = -1;         /* this class never answers */
+static uint32_t rng = 1;
+
+static long draw(int c) {
+    if (http_lat[c].mean <= 0) return 20;
+    double z = 0;
+    for (int i = 0; i < 4; i++) {   /* Irwin-Hall, close enough to normal */
+        rng = rng * 1664525u + 1013904223u;
+        z += (double)(rng >> 8) / (1 << 24);
+    }
+    z = (z - 2.0) * sqrt(3.0);
+    double ms = http_lat[c].mean + http_lat[c].sd * z;
+    return ms < 5 ? 5 : (long)ms;
+}
+
+static int http_class(const char *cmd) {
+    if (strcmp(cmd, "AT+HTTPINIT") == 0) return GSM_T_HTTPINIT;
+    if (strncmp(cmd, "AT+HTTPPARA", 11) == 0) return GSM_T_HTTPPARA;
+    if (strncmp(cmd, "AT+HTTPACTION=", 14) == 0) return GSM_T_HTTPACTION;
+    if (strncmp(cmd, "AT+HTTPREAD", 11) == 0) return GSM_T_HTTPREAD;
+    if (strcmp(cmd, "AT+HTTPTERM") == 0) return GSM_T_HTTPTERM;
+    return -1;
+}
+
+static void emit_bin(long at, const void *data, size_t len) {
+    if (n_msgs == MAX_MSGS) {
+        /* drop delivered messages */
+        int j = 0;
+        for (int i = 0; i < n_msgs; i++) {
+            if (msgs[i].pos < msgs[i].len) msgs[j++] = msgs[i];
+        }
+        n_msgs = j;
+        current = -1;
+        if (n_msgs == MAX_MSGS) return;
+    }
+    msg_t *m = &msgs[n_msgs++];
+    m->at = at;
+    m->len = (len < sizeof(m->text)) ? len : sizeof(m->text);
+    memcpy(m->text, data, m->len);
+    m->pos = 0;
+}
+
+static void emit(long at, const char *text) {
+    emit_bin(at, text, strlen(text));
+}
+
+void clock_delay_ms(uint16_t ms) {
+    now_ms += ms;
+}
+
+static void reset_modem(const scenario_t *s) {
+    sc = s;
+    now_ms = 0;
+    echo = true;
+    n_msgs = 0;
+    current = -1;
+    cmd_len = 0;
+    data_left = 0;
+    block_len = 0;
+    modem_baud = 115200;
+    ipr_baud = 0;
+
+    if (s->boot_ms >= 0) emit(s->boot_ms, "\r\n*ATREADY: 1\r\n");
+    if (s->sim_ms >= 0) {
+        emit(s->sim_ms, "\r\n+CPIN: READY\r\n");
+        emit(s->sim_ms + 2500, "\r\nSMS DONE\r\n");
+        emit(s->sim_ms + 3000, "\r\nPB DONE\r\n");
+    }
+}
+
+static void handle_command(const char *cmd) {
+    char reply[112];
+    long at = now_ms + 20;   /* modem response latency */
+    int cls = http_class(cmd);
+
+    if (now_ms < sc->boot_ms) return;   /* still booting: no answer */
+    if (ipr_baud) {
+        modem_baud = ipr_baud;
+        ipr_baud = 0;
+    }
+    if (modem_baud != uart_baud) return;   /* garbage at the wrong rate */
+    if (cls >= 0 && cls == hang_class) return;
+    if (cls >= 0 && cls != GSM_T_HTTPACTION) at = now_ms + draw(cls);
+
+    if (echo) {
+        snprintf(reply, sizeof(reply), "%s\r", cmd);
+        emit(now_ms + 1, reply);
+    }
+
+    if (strcmp(cmd, "ATE0") == 0) {
+        echo = false;
+        emit(at, "\r\nOK\r\n");
+    } else if (strcmp(cmd, "AT+CPIN?") == 0) {
+        emit(at, now_ms >= sc->sim_ms ? "\r\n+CPIN: READY\r\n\r\nOK\r\n" : "\r\n+CME ERROR: SIM busy\r\n");
+    } else if (strcmp(cmd, "AT+CEREG?") == 0 || strcmp(cmd, "AT+CREG?") == 0) {
+        /* "AT+CEREG?" -> "+CEREG: 0,<stat>" */
+        snprintf(reply, sizeof(reply), "\r\n%.*s: 0,%d\r\n\r\nOK\r\n",
+                 (int)(strlen(cmd) - 3), cmd + 2, (now_ms >= sc->reg_ms) ? 1 : 2);
+        emit(at, reply);
+    } else if (strcmp(cmd, "AT+CGATT?") == 0) {
+        emit(at, now_ms >= sc->attach_ms ? "\r\n+CGATT: 1\r\n\r\nOK\r\n" : "\r\n+CGATT: 0\r\n\r\nOK\r\n");
+    } else if (sscanf(cmd, "AT+HTTPDATA=%ld", &data_len) == 1) {
+        data_left = data_len;
+        block_kind = BLOCK_HTTP;
+        block_len = 0;
+        emit(at, "\r\nDOWNLOAD\r\n");
+    } else if (strcmp(cmd, "AT+CMQTTSTART") == 0) {
+        emit(at, "\r\nOK\r\n\r\n+CMQTTSTART: 0\r\n");
+    } else if (strncmp(cmd, "AT+CMQTTCONNECT=", 16) == 0) {
+        emit(at, "\r\nOK\r\n");
+        emit(now_ms + 300, "\r\n+CMQTTCONNECT: 0,0\r\n");
+    } else if (sscanf(cmd, "AT+CMQTTTOPIC=0,%ld", &data_len) == 1 ||
+               sscanf(cmd, "AT+CMQTTPAYLOAD=0,%ld", &data_len) == 1 ||
+               sscanf(cmd, "AT+CMQTTSUB=0,%ld", &data_len) == 1) {
+        block_kind = (cmd[8] == 'T') ? BLOCK_TOPIC : (cmd[8] == 'P') ? BLOCK_PAYLOAD : BLOCK_SUB;
+        block_len = 0;
+        data_left = data_len;
+        emit(at, "\r\n>");
+    } else if (strncmp(cmd, "AT+CMQTTPUB=", 12) == 0) {
+        int dup = 0;
+        sscanf(cmd, "AT+CMQTTPUB=0,1,%*d,%*d,%d", &dup);
+        mqtt_pubs++;
+        mqtt_dups += dup;
+        emit(at, "\r\nOK\r\n");
+        if (mqtt_drop_acks > 0) {
+            mqtt_drop_acks--;
+            emit(now_ms + 1000, "\r\n+CMQTTPUB: 0,11\r\n");   /* pub timeout */
+        } else {
+            emit(now_ms + 400, "\r\n+CMQTTPUB: 0,0\r\n");
+            if (n_published < 4) {
+                published_t *p = &published[n_published++];
+                snprintf(p->topic, sizeof(p->topic), "%s", mqtt_topic);
+                memcpy(p->data, mqtt_payload, (size_t)mqtt_payload_len);
+                p->len = mqtt_payload_len;
+            }
+        }
+        mqtt_topic[0] = '\0';   /* cleared after every publish */
+        mqtt_payload_len = 0;
+    } else if (strncmp(cmd, "AT+CMQTTDISC=", 13) == 0) {
+        emit(at, "\r\nOK\r\n\r\n+CMQTTDISC: 0,0\r\n");
+    } else if (strcmp(cmd, "AT+CMQTTSTOP") == 0) {
+        emit(at, "\r\nOK\r\n\r\n+CMQTTSTOP: 0\r\n");
+    } else if (strncmp(cmd, "AT+IPR=", 7) == 0) {
+        emit(at, ipr_refused ? "\r\nERROR\r\n" : "\r\nOK\r\n");
+        if (!ipr_refused) ipr_baud = (uint32_t)atol(cmd + 7);
+    } else if (strncmp(cmd, "AT+HTTPACTION=", 14) == 0) {
+        /* POST answers with http_body, GET (method 0) with http_bin */
+        http_get = (cmd[14] == '0');
+        long body = http_get ? http_bin_len : (long)strlen(http_body);
+        emit(at, "\r\nOK\r\n");
+        snprintf(reply, sizeof(reply), "\r\n+HTTPACTION: %c,200,%ld\r\n", cmd[14], body);
+        emit(now_ms + draw(GSM_T_HTTPACTION), reply);
+    } else if (strncmp(cmd, "AT+HTTPREAD=", 12) == 0) {
+        const uint8_t *src = http_get ? http_bin : (const uint8_t *)http_body;
+        long off = 0, n = 0;
+        long body = http_get ? http_bin_len : (long)strlen(http_body);
+        char chunk[160];
+        sscanf(cmd + 12, "%ld,%ld", &off, &n);
+        if (off > body) off = body;
+        if (n > body - off) n = body - off;
+        if (n > 100) n = 100;
+        int head = snprintf(chunk, sizeof(chunk), "\r\nOK\r\n\r\n+HTTPREAD: %ld\r\n", n);
+        memcpy(chunk + head, src + off, (size_t)n);
+        static const char TAIL[] = "\r\n+HTTPREAD: 0\r\n";
+        memcpy(chunk + head + n, TAIL, sizeof(TAIL) - 1);
+        emit_bin(at, chunk, (size_t)head + (size_t)n + sizeof(TAIL) - 1);
+    } else {
+        emit(at, "\r\nOK\r\n");
+    }
+}
+
+static void mqtt_block_done(void) {
+    char text[160];
+
+    emit(now_ms + 20, "\r\nOK\r\n");
+    if (block_kind == BLOCK_TOPIC) {
+        snprintf(mqtt_topic, sizeof(mqtt_topic), "%.*s", (int)block_len, (const char *)block);
+    } else if (block_kind == BLOCK_PAYLOAD) {
+        memcpy(mqtt_payload, block, (size_t)block_len);
+        mqtt_payload_len = block_len;
+    } else {
+        emit(now_ms + 200, "\r\n+CMQTTSUB: 0,0\r\n");
+        if (mqtt_retained) {
+            snprintf(text, sizeof(text), "\r\n+CMQTTRXSTART: 0,%ld,%zu\r\n+CMQTTRXTOPIC: 0,%ld\r\n",
+                     block_len, strlen(mqtt_retained), block_len);
+            emit(now_ms + 250, text);
+            snprintf(text, sizeof(text), "%.*s\r\n+CMQTTRXPAYLOAD: 0,%zu\r\n", (int)block_len,
+                     (const char *)block, strlen(mqtt_retained));
+            emit(now_ms + 250, text);
+            snprintf(text, sizeof(text), "%s\r\n+CMQTTRXEND: 0\r\n", mqtt_retained);
+            emit(now_ms + 250, text);
+        }
+    }
+}
+
+/* ---------------- uart_isr.h replacement ---------------- */
+
+void UART_init_ISR(unsigned int ubrr) { (void)ubrr; }
+
+uint16_t UART_ubrr_for(uint32_t hz, uint32_t baud, uint16_t *err_permil) {
+    uint32_t n = (hz + 4 * baud) / (8 * baud);
+    if (n == 0) n = 1;
+    if (err_permil) {
+        uint32_t actual = hz / (8 * n);
+        uint32_t err = (actual > baud) ? actual - baud : baud - actual;
+        *err_permil = (uint16_t)(err * 1000UL / baud);
+    }
+    return (uint16_t)(n - 1);
+}
+
+void UART_set_flow_control(uint8_t on) { (void)on; }
+
+void clock_set_baud(uint32_t baud) { uart_baud = baud; }
+
+/* Message whose bytes are due now, false if the line is quiet */
+static bool pick_current(void) {
+    if (modem_baud != uart_baud) return false;
+    if (current < 0 || msgs[current].pos == msgs[current].len) {
+        current = -1;
+        for (int i = 0; i < n_msgs; i++) {
+            if (msgs[i].pos < msgs[i].len && msgs[i].at <= now_ms &&
+                (current < 0 || msgs[i].at < msgs[current].at)) {
+                current = i;
+            }
+        }
+    }
+    return current >= 0;
+}
+
+int16_t UART_receive(void) {
+    if (!pick_current()) return -1;
+    return (uint8_t)msgs[current].text[msgs[current].pos++];
+}
+
+/* The rest of the current message, like a ring span ending at the wrap */
+uint8_t UART_rx_span(const uint8_t **data) {
+    if (!pick_current()) return 0;
+    size_t n = msgs[current].len - msgs[current].pos;
+    *data = (const uint8_t *)msgs[current].text + msgs[current].pos;
+    return n > 255 ? 255 : (uint8_t)n;
+}
+
+void UART_rx_consume(uint8_t n) {
+    msgs[current].pos += n;
+}
+
+uint8_t UART_data_available(void) {
+    for (int i = 0; i < n_msgs; i++) {
+        if (msgs[i].pos < msgs[i].len && msgs[i].at <= now_ms) return 1;
+    }
+    return 0;
+}
+
+uint16_t UART_tx_dropped(void) { return tx_dropped; }
+
+void UART_tx_clear_dropped(void) { tx_dropped = 0; }
+
+void UART_send(char c) {
+    if (cts_stalled) {
+        tx_dropped++;
+        return;
+    }
+    if (data_left > 0) {
+        if (data_left == data_len && c == '\n' && block_len == 0) return;   /* rest of the command's "\r\n" */
+        if (block_len < (long)sizeof(block)) block[block_len++] = (uint8_t)c;
+        if (block_kind != BLOCK_HTTP) {
+            if (--data_left == 0) mqtt_block_done();
+            return;
+        }
+        if (--data_left == 0 && hang_class != GSM_T_HTTPDATA) emit(now_ms + draw(GSM_T_HTTPDATA), "\r\nOK\r\n");
+        return;
+    }
+    if (c == '\n') return;
+    if (c == '\r') {
+        cmd_line[cmd_len] = '\0';
+        if (cmd_len) handle_command(cmd_line);
+        cmd_len = 0;
+        return;
+    }
+    if (cmd_len + 1 < sizeof(cmd_line)) cmd_line[cmd_len++] = c;
+}
+
+void UART_send_string(const char *s) {
+    while (*s) UART_send(*s++);
+}
+
+/* ---------------- runs ---------------- */
+
+static void on_body(const char *chunk, uint16_t len, void *ctx) {
+    config_delta_feed((config_delta_t *)ctx, chunk, len);
+}
+
+static const char *STAGES[] = { "off", "AT", "SIM", "registered", "attached" };
+
+static void discard(const char *chunk, uint16_t len, void *ctx) {
+    (void)chunk;
+    (void)len;
+    (void)ctx;
+}
+
+/* One POST on a registered modem; returns its (virtual) duration */
+static long http_session(bool *ok) {
+    const char *payload = "{\"v\":1}";
+    http_body = "{\"ok\":true}";
+    reset_modem(&SCENARIOS[2]);
+    (void)gsm_disable_echo(1000);
+
+    long t0 = now_ms;
+    *ok = gsm_http_post("http://example/ingest", "application/json", payload, strlen(payload),
+                        5, 120000, discard, NULL);
+    return now_ms - t0;
+}
+
+static const char *CLASS_NAMES[GSM_T_COUNT] = { "HTTPINIT", "HTTPPARA", "HTTPDATA", "HTTPACTION", "HTTPREAD", "HTTPTERM" };
+
+static int timeout_tests(void) {
+    static const dist_t NORMAL[GSM_T_COUNT] = {
+        [GSM_T_HTTPINIT]   = { 150, 50 },
+        [GSM_T_HTTPPARA]   = { 60, 20 },
+        [GSM_T_HTTPDATA]   = { 300, 100 },
+        [GSM_T_HTTPACTION] = { 2500, 700 },
+        [GSM_T_HTTPREAD]   = { 80, 30 },
+        [GSM_T_HTTPTERM]   = { 100, 30 },
+    };
+    int failures = 0;
+    bool ok;
+
+    memcpy(http_lat, NORMAL, sizeof(http_lat));
+    memset(gsm_latency, 0, sizeof(gsm_latency));
+    hang_class = -1;
+
+    /* Learning: no answer may be cut off by a learned timeout */
+    int failed = 0;
+    for (int i = 0; i < 200; i++) {
+        http_session(&ok);
+        if (!ok) failed++;
+    }
+    printf("\nlearned timeouts after 200 sessions (%d failed):\n", failed);
+    for (int c = 0; c < GSM_T_COUNT; c++) {
+        printf("  %-11s latency %5.0f +- %4.0f ms -> timeout %6u ms\n", CLASS_NAMES[c],
+               NORMAL[c].mean, NORMAL[c].sd, (unsigned)gsm_timeout_ms(c));
+    }
+    if (failed * 50 > 200) failures++;   /* over 2 % false timeouts */
+
+    /* Hung commands: learned vs worst-case timeouts */
+    latency_t learned[GSM_T_COUNT];
+    memcpy(learned, gsm_latency, sizeof(learned));
+    static const int HANGS[] = { GSM_T_HTTPINIT, GSM_T_HTTPACTION };
+    for (size_t h = 0; h < sizeof(HANGS) / sizeof(HANGS[0]); h++) {
+        hang_class = HANGS[h];
+
+        memset(gsm_latency, 0, sizeof(gsm_latency));
+        long worst = http_session(&ok);
+        memcpy(gsm_latency, learned, sizeof(gsm_latency));
+        long adaptive = http_session(&ok);
+
+        printf("hung %-11s session gives up after %6.1f s (worst case %6.1f s)\n",
+               CLASS_NAMES[HANGS[h]], adaptive / 1000.0, worst / 1000.0);
+        if (ok || adaptive * 4 > worst) failures++;
+    }
+    hang_class = -1;
+
+    /* Network turns three times slower: the estimate has to follow */
+    memcpy(gsm_latency, learned, sizeof(gsm_latency));
+    http_lat[GSM_T_HTTPACTION].mean *= 3;
+    http_lat[GSM_T_HTTPACTION].sd *= 3;
+    failed = 0;
+    int last_fail = -1;
+    for (int i = 0; i < 50; i++) {
+        http_session(&ok);
+        if (!ok) {
+            failed++;
+            last_fail = i;
+        }
+    }
+    printf("HTTPACTION 3x slower: %d of 50 sessions timed out, last at #%d\n", failed, last_fail);
+    if (failed > 5 || last_fail > 20) failures++;
+
+    return failures;
+}
+
+static int mqtt_tests(void) {
+    static const uint8_t report[] = "{\"v\":1,\"t\":[12,2051,2210,2133,41],\"cfg\":3}";
+    /* raw record packet: binary, with CR/LF and NUL inside */
+    static const uint8_t rec[] = { 3, 0, 4, 0x2c, 0x01, 0, 0, 0x80, '\r', '\n', 0x00, 0x7f, 0xff, '>', 'O', 'K' };
+    int failures = 0;
+    config_delta_t delta;
+
+    reset_modem(&SCENARIOS[2]);
+    (void)gsm_disable_echo(1000);
+    config_delta_init(&delta);
+    mqtt_retained = "{\"cfg\":\"v5;0=60;1=15\"}";
+    mqtt_drop_acks = 1;
+    mqtt_pubs = mqtt_dups = n_published = 0;
+
+    bool open = gsm_mqtt_open("tcp://broker:1883", "troposense-1", 60, on_body, &delta) &&
+                gsm_mqtt_subscribe("troposense/1/cfg");
+    bool sent_report = open && gsm_mqtt_publish("troposense/1/report", report, sizeof(report) - 1);
+    bool sent_rec = open && gsm_mqtt_publish("troposense/1/rec", rec, sizeof(rec));
+    gsm_mqtt_close();
+
+    bool delivered = n_published == 2 &&
+                     strcmp(published[0].topic, "troposense/1/report") == 0 &&
+                     published[0].len == (long)sizeof(report) - 1 &&
+                     strcmp(published[1].topic, "troposense/1/rec") == 0 &&
+                     published[1].len == (long)sizeof(rec) && memcmp(published[1].data, rec, sizeof(rec)) == 0;
+    bool cfg_ok = config_delta_complete(&delta) && delta.version == 5 && delta.count == 2 &&
+                  gsm_mqtt_received() == 1;
+
+    printf("\nMQTT session: open %s, report %s, rec %s (%d PUB, %d DUP), %s, retained config %s\n",
+           open ? "ok" : "FAIL", sent_report ? "acked" : "FAIL", sent_rec ? "acked" : "FAIL",
+           mqtt_pubs, mqtt_dups, delivered ? "payloads intact" : "payloads WRONG", cfg_ok ? "ok" : "FAIL");
+    if (!open || !sent_report || !sent_rec || !delivered || !cfg_ok || mqtt_dups != 1) failures++;
+
+    /* Never acknowledged: the caller must keep the data */
+    reset_modem(&SCENARIOS[2]);
+    (void)gsm_disable_echo(1000);
+    mqtt_retained = NULL;
+    mqtt_drop_acks = 10;
+    mqtt_pubs = 0;
+    open = gsm_mqtt_open("tcp://broker:1883", "troposense-1", 60, on_body, &delta);
+    sent_report = open && gsm_mqtt_publish("troposense/1/report", report, sizeof(report) - 1);
+    gsm_mqtt_close();
+    printf("no PUBACK: publish %s after %d attempts\n", sent_report ? "acked (FAIL)" : "failed", mqtt_pubs);
+    if (sent_report) failures++;
+    mqtt_drop_acks = 0;
+
+    return failures;
+}
+
+/* Report-like body for the streaming POST; extra > 0 makes the second
+   pass differ from the counted one */
+static int extra;
+
+static void report_fill(sw_t *w, void *ctx) {
+    static const uint8_t rec[] = { 0x01, 0xfe, 0x80, 0x7f };
+    (void)ctx;
+
+    sw_obj_begin(w);
+    sw_kv_u32(w, "v", 1);
+    sw_key(w, "t");
+    sw_arr_begin(w);
+    sw_item_u32(w, 3);
+    sw_item_i32(w, -125);
+    sw_item_i32(w, 2147483647);
+    sw_item_u32(w, 4294967295UL);
+    sw_arr_end(w);
+    sw_key(w, "sess");
+    sw_arr_begin(w);
+    for (int i = 0; i < 2; i++) {
+        sw_item(w);
+        sw_arr_begin(w);
+        sw_item_i32(w, -i);
+        sw_item_u32(w, 0);
+        sw_arr_end(w);
+    }
+    sw_arr_end(w);
+    sw_key(w, "x");
+    sw_fixed(w, -5, 2);
+    sw_key(w, "y");
+    sw_fixed(w, 123456, 3);
+    sw_key(w, "b64");
+    sw_char(w, '"');
+    sw_base64(w, rec, sizeof(rec));
+    sw_char(w, '"');
+    if (extra) sw_kv_i32(w, "extra", -extra);
+    sw_obj_end(w);
+}
+
+static int stream_tests(void) {
+    static const char WANT[] =
+        "{\"v\":1,\"t\":[3,-125,2147483647,4294967295],\"sess\":[[0,0],[-1,0]],"
+        "\"x\":-0.05,\"y\":123.456,\"b64\":\"Af6Afw==\"}";
+    static const char PDU[] = "0011000B918466103254F60008AA0C005A0061017C00F301420107";
+    int failures = 0;
+    char buf[128];
+    sw_t w;
+
+    extra = 0;
+    sw_init_buf(&w, buf, sizeof(buf));
+    report_fill(&w, NULL);
+    uint16_t len = sw_measure(report_fill, NULL);
+    bool text_ok = strcmp(buf, WANT) == 0 && len == strlen(WANT) && !sw_overflow(&w);
+
+    sw_init_buf(&w, buf, 8);
+    sw_str(&w, "0123456789");
+    bool cut_ok = strcmp(buf, "0123456") == 0 && sw_overflow(&w) && w.len == 10;
+
+    http_body = "{\"ok\":true}";
+    reset_modem(&SCENARIOS[2]);
+    (void)gsm_disable_echo(1000);
+    bool posted = gsm_http_post_stream("http://example/ingest", "application/json", report_fill, NULL, len,
+                                       5, 120000, discard, NULL) &&
+                  block_len == len && memcmp(block, WANT, len) == 0;
+
+    /* body changed after counting: cut at the announced length ... */
+    extra = 7;
+    bool longer = gsm_http_post_stream("http://example/ingest", NULL, report_fill, NULL, len,
+                                       5, 120000, discard, NULL) &&
+                  block_len == len && memcmp(block, WANT, len - 1) == 0 && block[len - 1] == ',';
+    /* ... or padded up to it */
+    extra = 0;
+    bool shorter = gsm_http_post_stream("http://example/ingest", NULL, report_fill, NULL, len + 3,
+                                        5, 120000, discard, NULL) &&
+                   block_len == len + 3 && memcmp(block, WANT, len) == 0 && memcmp(block + len, "   ", 3) == 0;
+
+    /* modem holds CTS off: the command is cut, the POST gives up at once
+       instead of waiting out its timeouts, and the next command is clean */
+    long t0 = now_ms;
+    cts_stalled = true;
+    bool stalled = !gsm_http_post_stream("http://example/ingest", NULL, report_fill, NULL, len,
+                                         5, 120000, discard, NULL) && now_ms - t0 < 1000;
+    cts_stalled = false;
+    stalled = stalled && gsm_ping(300);
+
+    char pdu[128];
+    size_t tpdu = gsm_build_pdu_submit_ucs2("+48660123456", "Za\xc5\xbc\xc3\xb3\xc5\x82\xc4\x87", pdu, sizeof(pdu));
+    bool pdu_ok = tpdu == 26 && strcmp(pdu, PDU) == 0 &&
+                  gsm_build_pdu_submit_ucs2("+48660123456", "Za\xc5\xbc\xc3\xb3\xc5\x82\xc4\x87", pdu, 40) == 0;
+
+    printf("\nstream writer: JSON %s (%u B counted), cut %s, POST %s, changed body cut %s / padded %s, SMS PDU %s\n",
+           text_ok ? "ok" : "WRONG", len, cut_ok ? "ok" : "WRONG", posted ? "ok" : "FAIL",
+           longer ? "ok" : "FAIL", shorter ? "ok" : "FAIL", pdu_ok ? "ok" : "WRONG");
+    printf("CTS held off: POST %s\n", stalled ? "aborted" : "FAIL");
+    if (!text_ok || !cut_ok || !posted || !longer || !shorter || !pdu_ok || !stalled) failures++;
+    return failures;
+}
+
+/* OTA download path: a binary GET body (with bytes that look like modem
+   output) read back in AT+HTTPREAD chunks, as ota.c does */
+static int get_tests(void) {
+    static const char TRAPS[] = "\r\nOK\r\n+HTTPREAD: 0\r\nERROR\0";
+    static uint8_t body[300], got[300];
+    uint8_t piece[GSM_HTTP_READ_CHUNK];
+    uint32_t len = 0, off = 0;
+
+    for (size_t i = 0; i < sizeof(body); i++) body[i] = (uint8_t)(i * 37 + 11);
+    memcpy(body + 60, TRAPS, sizeof(TRAPS));
+    http_bin = body;
+    http_bin_len = sizeof(body);
+    reset_modem(&SCENARIOS[2]);
+    (void)gsm_disable_echo(1000);
+
+    bool ok = gsm_http_get("http://example/ota?fw=1", 120000, &len) && len == sizeof(body);
+    while (ok && off < len) {
+        uint16_t want = (len - off < sizeof(piece)) ? (uint16_t)(len - off) : sizeof(piece);
+        int32_t n = gsm_http_read(off, piece, want);
+        if (n <= 0) {
+            ok = false;
+            break;
+        }
+        memcpy(got + off, piece, (size_t)n);
+        off += (uint32_t)n;
+    }
+    gsm_http_term();
+    ok = ok && off == sizeof(body) && memcmp(got, body, sizeof(body)) == 0;
+
+    printf("\nHTTP GET binary body (%u B in %u B reads): %s\n", (unsigned)sizeof(body),
+           (unsigned)sizeof(piece), ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+static int baud_tests(void) {
+    static const uint32_t CLOCKS[] = { 16000000UL, 14745600UL, 8000000UL };
+    int failures = 0;
+
+    printf("\nbest AT+IPR rate (U2X, <= 2.5 %% error):");
+    for (size_t i = 0; i < sizeof(CLOCKS) / sizeof(CLOCKS[0]); i++) {
+        printf("  %.4f MHz: %lu", CLOCKS[i] / 1e6, (unsigned long)gsm_best_baud(CLOCKS[i], 25));
+    }
+    printf("\n");
+    if (gsm_best_baud(16000000UL, 25) != 115200UL || gsm_best_baud(14745600UL, 25) != 921600UL) failures++;
+
+    reset_modem(&SCENARIOS[2]);
+    (void)gsm_disable_echo(1000);
+    bool up = gsm_set_baud(115200, 921600);
+    bool works = gsm_ping(300);
+    bool down = gsm_set_baud(921600, 115200);
+    printf("AT+IPR 921600: %s, AT %s, back to 115200: %s\n", up ? "ok" : "FAIL",
+           works ? "ok" : "FAIL", down && gsm_ping(300) ? "ok" : "FAIL");
+    if (!up || !works || !down || uart_baud != 115200) failures++;
+
+    ipr_refused = true;
+    up = gsm_set_baud(115200, 921600);
+    printf("AT+IPR refused: %s, link still at %lu\n", up ? "switched (FAIL)" : "kept", (unsigned long)uart_baud);
+    if (up || uart_baud != 115200 || !gsm_ping(300)) failures++;
+    ipr_refused = false;
+
+    return failures;
+}
+
+int main(void) {
+    int failures = 0;
+
+    printf("%-20s %16s %22s %22s\n", "scenario", "gsm_wait_ready", "probe (registered)", "probe (attached)");
+
+    for (size_t i = 0; i < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); i++) {
+        const scenario_t *s = &SCENARIOS[i];
+        char old_col[32], reg_col[32], att_col[32];
+
+        reset_modem(s);
+        bool ok = gsm_wait_ready(60000);
+        snprintf(old_col, sizeof(old_col), "%s %5.1f s", ok ? "ok  " : "FAIL", now_ms / 1000.0);
+
+        reset_modem(s);
+        gsm_stage_t st = gsm_probe_ready(60000, GSM_STAGE_REGISTERED);
+        long t_reg = now_ms;
+        snprintf(reg_col, sizeof(reg_col), "%-10s %5.1f s", STAGES[st], now_ms / 1000.0);
+        if (st != GSM_STAGE_REGISTERED || t_reg < s->reg_ms) failures++;
+
+        reset_modem(s);
+        st = gsm_probe_ready(60000, GSM_STAGE_ATTACHED);
+        snprintf(att_col, sizeof(att_col), "%-10s %5.1f s", STAGES[st], now_ms / 1000.0);
+        if (st != GSM_STAGE_ATTACHED || now_ms < s->attach_ms) failures++;
+
+        /* ready must be reported within one poll interval (+ query time) of the modem */
+        long late = now_ms - (s->attach_ms > 0 ? s->attach_ms : 0);
+        if (late > 1500) failures++;
+
+        printf("%-20s %16s %22s %22s\n", s->name, old_col, reg_col, att_col);
+    }
+
+    /* Ingest response: the delta straddles the 64-byte AT+HTTPREAD chunks */
+    http_body = "{\"ok\":true,\"note\":\"padding to push the delta across a read chunk\","
+                "\"cfg\":\"v3;0=30;1=5;7=150\"}";
+    reset_modem(&SCENARIOS[2]);
+    (void)gsm_disable_echo(1000);
+
+    config_delta_t delta;
+    config_delta_init(&delta);
+    const char *payload = "{\"v\":1,\"cfg\":0}";
+    long t0 = now_ms;
+    bool posted = gsm_http_post("http://example/ingest", "application/json", payload, strlen(payload),
+                                5, 120000, on_body, &delta);
+    bool delta_ok = config_delta_complete(&delta) && delta.version == 3 && delta.count == 3 &&
+                    delta.keys[0] == 0 && delta.values[0] == 30 && delta.keys[1] == 1 &&
+                    delta.values[1] == 5 && delta.keys[2] == 7 && delta.values[2] == 150;
+    printf("\nHTTP POST %s in %.1f s, response %zu B, config delta %s (v%u, %u pairs)\n",
+           posted ? "ok" : "FAIL", (now_ms - t0) / 1000.0, strlen(http_body),
+           delta_ok ? "ok" : "WRONG", delta.version, delta.count);
+    if (!posted || !delta_ok) failures++;
+
+    failures += timeout_tests();
+    failures += mqtt_tests();
+    failures += baud_tests();
+    failures += stream_tests();
+    failures += get_tests();
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
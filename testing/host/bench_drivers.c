@@ -0,0 +1,90 @@
+/*
+ * Driver micro-benchmarks on the host HAL.
+ *
+ * For each operation: host time per call (the driver's own code; only a
+ * ratio to compare builds, as in the other benchmarks here) and the
+ * virtual time the simulated bus advanced, i.e. how long the operation
+ * holds the AVR in busy waits. The second column is exact and does not
+ * depend on the host, so a driver change that adds bus traffic or longer
+ * delays shows up as a different number.
+ *
+ * Build and run with "make bench" at the top of the repository.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "hal.h"
+#include "sim_twi.h"
+#include "sim_onewire.h"
+#include "sim_uart.h"
+#include "i2c.h"
+#include "bme280.h"
+#include "one_wire.h"
+#include "ds18b20.h"
+#include "uart_isr.h"
+
+static sim_regfile_t bme;
+static sim_onewire_t ow;
+static volatile int32_t sink;
+
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench(const char *name, void (*op)(void), unsigned rounds) {
+    uint64_t v0 = hal_host_ns();
+    double t0 = seconds();
+
+    for (unsigned i = 0; i < rounds; i++) op();
+
+    double host = (seconds() - t0) / rounds;
+    double bus = (double)(hal_host_ns() - v0) / rounds;
+    printf("%-28s %9.0f ns host %12.1f us bus\n", name, host * 1e9, bus / 1e3);
+}
+
+static void op_reg_read(void)  { sink += bme280_read1Byte(BME280_REGISTER_STATUS); }
+static void op_temp(void)      { sink += (int32_t)bme280_readTemperature(); }
+static void op_pressure(void)  { sink += (int32_t)bme280_readPressure(); }
+static void op_coeffs(void)    { bme280_readCoefficients(); }
+static void op_ow_reset(void)  { sink += one_wire_reset(); }
+static void op_ow_byte(void)   { one_wire_writeByte(0xCC); }
+static void op_scratch(void)   { sink += ds18b20_readScratchpad(); }
+
+static void op_uart_rx(void) {
+    static const char LINE[] = "+CSQ: 17,99\r\n";
+    int16_t c;
+
+    sim_uart_rx(LINE, sizeof(LINE) - 1);
+    while ((c = UART_receive()) >= 0) sink += c;
+}
+
+static void op_uart_tx(void) {
+    UART_send_string("AT+HTTPACTION=1\r");
+}
+
+int main(void) {
+    hal_host_reset();
+    sim_twi_attach();
+    sim_regfile_init(&bme, BME280_I2C_ADDRSS);
+    bme.reg[BME280_REGISTER_DIG_P1] = 0x7D;     /* non-zero, or pressure returns early */
+    sim_twi_add(&bme.dev);
+    sim_onewire_attach(&ow, &ONE_WIRE_DDR, &ONE_WIRE_PORT, &ONE_WIRE_PIN_REG, ONE_WIRE_PIN);
+    sim_uart_attach();
+    I2C_init();
+    UART_init_ISR(MYUBRR);
+    sei();
+
+    bench("i2c register read", op_reg_read, 200000);
+    bench("bme280 temperature", op_temp, 100000);
+    bench("bme280 pressure", op_pressure, 100000);
+    bench("bme280 calibration", op_coeffs, 20000);
+    bench("1-wire reset", op_ow_reset, 200000);
+    bench("1-wire byte", op_ow_byte, 200000);
+    bench("ds18b20 scratchpad (T)", op_scratch, 50000);
+    bench("uart rx 13 B line (isr+get)", op_uart_rx, 200000);
+    sim_uart.tx_len = 0;
+    bench("uart tx 16 B command", op_uart_tx, 200000);
+    return 0;
+}
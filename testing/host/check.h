@@ -0,0 +1,20 @@
+/*
+ * Failure counting shared by the host tests.
+ *
+ * CHECK(cond, fmt, ...) prints the file, line and message of a failed
+ * condition and counts it in failures; main() prints "<name>: passed" or
+ * "FAILED" and returns failures != 0.
+ */
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { failures++; printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } \
+} while (0)
+
+#endif /* CHECK_H */
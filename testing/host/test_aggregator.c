@@ -0,0 +1,154 @@
+/*
+ * Integer Welford aggregator (firmware/telemetry/aggregator.c) against a
+ * double-precision two-pass reference.
+ *
+ * Mean and sample standard deviation of sensor-like series: air
+ * temperature (0.01 °C, crossing zero), pressure (Pa, large offset and
+ * small spread), a constant, a series entirely below zero and ones at the
+ * value and spread limits of the header. Min, max and count are exact;
+ * the mean and the deviation may differ from the rounded reference by
+ * one unit.
+ * Then the interval cycle of pipeline.c: the record taken for an upload,
+ * agg_reset() after it succeeds and a new interval that must not carry
+ * anything over, plus the single-sample, empty and count-saturation cases.
+ *
+ * Build and run with "make test" at the top of the repository.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "aggregator.h"
+#include "check.h"
+
+#define N_MAX 2000
+
+static int32_t xs[N_MAX];
+static uint32_t rng = 12345;
+
+static int32_t noise(int32_t span) {
+    rng = rng * 1664525u + 1013904223u;
+    return (int32_t)((rng >> 8) % (uint32_t)(2 * span + 1)) - span;
+}
+
+/* Feeds xs[0..n) and compares with the reference */
+static void check_series(const char *name, uint16_t n) {
+    agg_t a;
+    agg_record_t r;
+    double sum = 0.0, ss = 0.0;
+    int32_t min = xs[0], max = xs[0];
+
+    agg_reset(&a);
+    for (uint16_t i = 0; i < n; i++) {
+        agg_add(&a, xs[i]);
+        sum += xs[i];
+        if (xs[i] < min) min = xs[i];
+        if (xs[i] > max) max = xs[i];
+    }
+    double mean = sum / n;
+    for (uint16_t i = 0; i < n; i++) ss += (xs[i] - mean) * (xs[i] - mean);
+    double sd = n > 1 ? sqrt(ss / (n - 1)) : 0.0;
+
+    agg_record(&a, &r);
+    CHECK(r.count == n && r.min == min && r.max == max, "%s: count %u min %ld max %ld", name,
+          r.count, (long)r.min, (long)r.max);
+    CHECK(fabs(r.mean - mean) <= 1.0, "%s: mean %ld, reference %.2f", name, (long)r.mean, mean);
+    CHECK(fabs(r.stddev - sd) <= 1.0, "%s: stddev %lu, reference %.2f", name, (unsigned long)r.stddev, sd);
+}
+
+static void test_series(void) {
+    uint16_t n;
+
+    /* Air temperature drifting across 0 °C, 0.01 °C */
+    n = 1500;
+    for (uint16_t i = 0; i < n; i++) xs[i] = 300 - (int32_t)i + noise(25);
+    check_series("air temperature", n);
+
+    /* Pressure: 101325 Pa +- a few Pa */
+    n = 2000;
+    for (uint16_t i = 0; i < n; i++) xs[i] = 101325 + noise(4);
+    check_series("pressure", n);
+
+    n = 500;
+    for (uint16_t i = 0; i < n; i++) xs[i] = -1234;
+    check_series("constant", n);
+
+    /* Winter ground temperature, all negative */
+    n = 800;
+    for (uint16_t i = 0; i < n; i++) xs[i] = -1850 + noise(120);
+    check_series("negative", n);
+
+    /* Range edge of the header: +-2^22, as many of them as m2 holds */
+    n = 6;
+    for (uint16_t i = 0; i < n; i++) xs[i] = (i & 1) ? (1L << 22) - 1 : -(1L << 22) + 1;
+    check_series("range edge", n);
+
+    /* Wide spread, the full count of it is in test_saturation() */
+    n = N_MAX;
+    for (uint16_t i = 0; i < n; i++) xs[i] = (i & 1) ? 45000 : -45000;
+    check_series("wide spread", n);
+
+    n = 2;
+    xs[0] = -5;
+    xs[1] = 5;
+    check_series("two samples", n);
+}
+
+static void test_interval(void) {
+    agg_t a;
+    agg_record_t r;
+
+    /* Interval one: mostly warm values */
+    agg_reset(&a);
+    for (int i = 0; i < 100; i++) agg_add(&a, 2500 + noise(50));
+    agg_record(&a, &r);         /* what the upload sends */
+    CHECK(r.count == 100 && r.mean > 2400, "first interval: count %u mean %ld", r.count, (long)r.mean);
+
+    /* Upload succeeded: sampler_reset_metrics() */
+    agg_reset(&a);
+    agg_record(&a, &r);
+    CHECK(r.count == 0 && r.min == 0 && r.max == 0 && r.mean == 0 && r.stddev == 0,
+          "after reset: count %u min %ld max %ld mean %ld sd %lu", r.count, (long)r.min,
+          (long)r.max, (long)r.mean, (unsigned long)r.stddev);
+
+    /* Interval two: nothing of the first one in min, max, mean or spread */
+    agg_add(&a, -40);
+    agg_record(&a, &r);
+    CHECK(r.count == 1 && r.min == -40 && r.max == -40 && r.mean == -40 && r.stddev == 0,
+          "one sample: min %ld max %ld mean %ld sd %lu", (long)r.min, (long)r.max, (long)r.mean,
+          (unsigned long)r.stddev);
+    agg_add(&a, -60);
+    agg_add(&a, -50);
+    agg_record(&a, &r);
+    CHECK(r.count == 3 && r.min == -60 && r.max == -40 && r.mean == -50 && r.stddev == 10,
+          "second interval: min %ld max %ld mean %ld sd %lu", (long)r.min, (long)r.max,
+          (long)r.mean, (unsigned long)r.stddev);
+}
+
+static void test_saturation(void) {
+    agg_t a;
+    agg_record_t r;
+
+    agg_reset(&a);
+    for (uint32_t i = 0; i < UINT16_MAX; i++) agg_add(&a, 7);
+    agg_add(&a, 1000000);       /* past the counter: ignored */
+    agg_record(&a, &r);
+    CHECK(r.count == UINT16_MAX && r.max == 7 && r.mean == 7 && r.stddev == 0,
+          "saturated: count %u max %ld mean %ld sd %lu", r.count, (long)r.max, (long)r.mean,
+          (unsigned long)r.stddev);
+
+    /* Deviations of 45000 over the full count: m2 just below 2^63 */
+    agg_reset(&a);
+    for (uint32_t i = 0; i < UINT16_MAX; i++) agg_add(&a, (i & 1) ? 45000 : -45000);
+    agg_record(&a, &r);
+    CHECK(r.count == UINT16_MAX && abs(r.mean) <= 1 && r.stddev == 45000,
+          "full spread: mean %ld sd %lu", (long)r.mean, (unsigned long)r.stddev);
+}
+
+int main(void) {
+    test_series();
+    test_interval();
+    test_saturation();
+    printf("aggregator: %s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * Clock scaling (firmware/system/clock.c) on the host HAL, and the CPU
+ * charge of a simulated sample and upload cycle with and without it.
+ *
+ * The checks cover the divider choice (boost, UART in use at 115200 and
+ * at 9600), the CLKPCE sequence, UBRR and TWBR following the divider,
+ * and clock_delay_ms() keeping real time at every divider.
+ *
+ * The cycles run the real drivers against the simulated BME280 and
+ * DS18B20 (bus time and busy waits from the virtual clock, as in
+ * bench_drivers) inside the same boost brackets as sampler.c, and wait
+ * out the DS18B20 conversion and the modem session at whatever divider
+ * clock.c picks. The modem session lasts as long as the fake modem run
+ * (testing/fake_modem) takes to attach after a warm start (5.3 s) plus
+ * its HTTP POST (0.2 s); as in pipeline.c the link waits for the network
+ * at 9600 baud and posts at 115200. Each cycle runs once with CLOCK_SLOW_DIV 0 and
+ * once with the board's divider; the printed charge is clock_charge_uas(),
+ * i.e. the simulated residency per divider times CLOCK_UA_PER_MHZ, the
+ * same figures the station reports as cpu_uas.
+ *
+ * Build and run with "make test" at the top of the repository.
+ */
+
+#include <stdio.h>
+#include "hal.h"
+#include "sim_twi.h"
+#include "sim_onewire.h"
+#include "sim_uart.h"
+#include "clock.h"
+#include "systick.h"
+#include "uart_isr.h"
+#include "i2c.h"
+#include "bme280.h"
+#include "one_wire.h"
+#include "ds18b20.h"
+#include "check.h"
+
+#define SLOW_DIV            4       /* CLOCK_SLOW_DIV of boards/m328p/config.h */
+#define MODEM_ATTACH_MS     5300    /* fake modem, warm start: attached */
+#define MODEM_POST_MS       200     /* fake modem: HTTP POST */
+#define LINK_WAIT_BAUD      9600    /* pipeline.c link_wait() at 1 MHz */
+
+static sim_regfile_t bme;
+static sim_onewire_t ow;
+static unsigned rescales;
+static uint8_t clkpr_enables;
+static volatile int32_t sink;
+
+/* systick.c is Timer2 hardware; here the ms count is the virtual clock */
+uint32_t systick_ms(void) {
+    return (uint32_t)(hal_host_ns() / 1000000ULL);
+}
+
+bool systick_rescale(uint32_t cpu_hz) {
+    (void)cpu_hz;
+    rescales++;
+    return true;
+}
+
+static void clkpr_written(volatile uint8_t *reg, uint8_t old, void *ctx) {
+    (void)old;
+    (void)ctx;
+    if (*reg & (1 << CLKPCE)) clkpr_enables++;
+}
+
+static void setup(uint8_t slow) {
+    hal_host_reset();
+    sim_twi_attach();
+    sim_regfile_init(&bme, BME280_I2C_ADDRSS);
+    bme.reg[0xD0] = 0x60;
+    bme.reg[BME280_REGISTER_DIG_P1] = 0x7D;     /* non-zero, or pressure returns early */
+    sim_twi_add(&bme.dev);
+    sim_onewire_attach(&ow, &ONE_WIRE_DDR, &ONE_WIRE_PORT, &ONE_WIRE_PIN_REG, ONE_WIRE_PIN);
+    sim_uart_attach();
+    (void)hal_host_hook(&CLKPR, clkpr_written, NULL, NULL);
+    I2C_init();
+    UART_init_ISR(MYUBRR);
+    sei();
+    rescales = 0;
+    clkpr_enables = 0;
+    clock_init(115200, slow);
+}
+
+static void test_divider(void) {
+    uint16_t err;
+
+    setup(SLOW_DIV);
+    CHECK(clock_div() == SLOW_DIV && hal_host_cpu_hz() == F_CPU >> SLOW_DIV, "div %u, %u Hz",
+          clock_div(), (unsigned)hal_host_cpu_hz());
+    CHECK(clkpr_enables == 1 && rescales == 1, "CLKPCE writes %u, rescales %u", clkpr_enables, rescales);
+    uint16_t ubrr = UART_ubrr_for(F_CPU >> SLOW_DIV, 115200, &err);
+    CHECK(((UBRR0H << 8) | UBRR0L) == ubrr, "UBRR %u, want %u", (UBRR0H << 8) | UBRR0L, ubrr);
+    CHECK(TWBR == 0, "TWBR %u at 1 MHz", TWBR);
+
+    /* 115200 baud is only clean at full speed */
+    clock_uart_active(true);
+    CHECK(clock_div() == 0 && hal_host_cpu_hz() == F_CPU, "UART active: div %u", clock_div());
+    CHECK(TWBR == 32, "TWBR %u at 16 MHz", TWBR);
+
+    /* 9600 baud allows dividing, within the error limit */
+    clock_set_baud(9600);
+    uint32_t baud = sim_uart_baud(hal_host_cpu_hz());
+    CHECK(clock_div() > 0, "9600 baud kept full speed");
+    CHECK(baud * 1000 >= 9600UL * (1000 - CLOCK_UART_MAX_ERR_PERMIL) &&
+          baud * 1000 <= 9600UL * (1000 + CLOCK_UART_MAX_ERR_PERMIL), "baud %u at div %u",
+          (unsigned)baud, clock_div());
+    clock_set_baud(115200);
+    clock_uart_active(false);
+
+    /* Boosts nest */
+    clock_boost();
+    clock_boost();
+    clock_unboost();
+    CHECK(clock_div() == 0, "div %u inside a nested boost", clock_div());
+    clock_unboost();
+    CHECK(clock_div() == SLOW_DIV, "div %u after the boosts", clock_div());
+}
+
+static void test_delay(void) {
+    for (uint8_t slow = 0; slow <= CLOCK_MAX_DIV; slow++) {
+        setup(slow);
+        uint64_t t0 = hal_host_ns();
+        clock_delay_ms(250);
+        uint64_t took = hal_host_ns() - t0;
+        CHECK(took > 249000000ULL && took < 251000000ULL, "div %u: 250 ms took %llu ns",
+              slow, (unsigned long long)took);
+    }
+
+    setup(SLOW_DIV);
+    clock_clear_residency();
+    clock_delay_ms(1000);
+    CHECK(clock_residency_ms(SLOW_DIV) == 1000 && clock_residency_ms(0) == 0, "residency %u / %u",
+          (unsigned)clock_residency_ms(SLOW_DIV), (unsigned)clock_residency_ms(0));
+}
+
+/* sampler_start(): sensor rail up, DS18B20 conversion, BME280 init and forced mode */
+static void sensors_start(void) {
+    clock_boost();
+    (void)ds18b20_startConversion();
+    bme280_init();
+    bme280_startForced();
+    clock_unboost();
+}
+
+/* sampler_poll(): float compensation and the scratchpad, boosted */
+static void sensors_read(void) {
+    clock_boost();
+    sink += (int32_t)(bme280_readTemperature() * 100.0f);
+    sink += (int32_t)(bme280_readPressure() * 100.0f);
+    sink += (int32_t)(bme280_readHumidity() * 100.0f);
+    sink += ds18b20_readScratchpad();
+    clock_unboost();
+}
+
+static void sample_cycle(void) {
+    sensors_start();
+    clock_delay_ms(DS18B20_CONVERSION_MS);
+    sensors_read();
+}
+
+/* pipeline.c: sensors started, modem rail on (UART in use) and on the
+   slow link while the conversion runs and the network attaches, readout,
+   POST back at 115200, rail off */
+static void upload_cycle(void) {
+    sensors_start();
+    clock_uart_active(true);
+    clock_set_baud(LINK_WAIT_BAUD);
+    clock_delay_ms(MODEM_ATTACH_MS);
+    sensors_read();
+    clock_set_baud(115200);
+    clock_delay_ms(MODEM_POST_MS);
+    clock_uart_active(false);
+}
+
+typedef struct {
+    uint32_t ms;
+    uint32_t full_ms;
+    uint32_t uas;
+} cycle_t;
+
+static cycle_t run(void (*cycle)(void), uint8_t slow) {
+    cycle_t c;
+
+    setup(slow);
+    clock_clear_residency();
+    uint32_t t0 = systick_ms();
+    cycle();
+    c.ms = systick_ms() - t0;
+    c.full_ms = clock_residency_ms(0);
+    c.uas = clock_charge_uas();
+    return c;
+}
+
+static void compare(const char *name, void (*cycle)(void)) {
+    cycle_t fixed = run(cycle, 0);
+    cycle_t scaled = run(cycle, SLOW_DIV);
+
+    printf("%-14s %6u ms   16 MHz: %6u uA*s   /%u: %6u uA*s (%u ms at 16 MHz)   %+5.1f %%\n",
+           name, (unsigned)scaled.ms, (unsigned)fixed.uas, 1u << SLOW_DIV, (unsigned)scaled.uas,
+           (unsigned)scaled.full_ms, 100.0 * ((double)scaled.uas - fixed.uas) / fixed.uas);
+    CHECK(fixed.ms == scaled.ms, "%s: %u ms fixed, %u ms scaled", name, (unsigned)fixed.ms, (unsigned)scaled.ms);
+    CHECK(fixed.full_ms == fixed.ms, "%s: fixed run left full speed", name);
+    CHECK(scaled.uas <= fixed.uas, "%s: scaling costs charge", name);
+}
+
+int main(void) {
+    test_divider();
+    test_delay();
+    compare("sample cycle", sample_cycle);
+    compare("upload cycle", upload_cycle);
+    printf("clock: %s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
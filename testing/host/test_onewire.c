@@ -0,0 +1,87 @@
+/*
+ * 1-Wire driver (one_wire.c) and ds18b20.c against the simulated bus.
+ *
+ * The bus model decodes the driver's pin toggling by virtual time, so a
+ * wrong slot length or sample point shows up as a wrong byte here, not
+ * only on a scope. Checks presence, a full 12-bit reading (positive and
+ * negative), the scratchpad CRC, a read before the conversion has
+ * finished, a missing sensor, and the time a reading holds the CPU.
+ *
+ * Build and run with "make test" at the top of the repository.
+ */
+
+#include <stdio.h>
+#include "hal.h"
+#include "sim_onewire.h"
+#include "one_wire.h"
+#include "ds18b20.h"
+#include "check.h"
+
+static sim_onewire_t bus;
+
+static void setup(void) {
+    hal_host_reset();
+    sim_onewire_attach(&bus, &ONE_WIRE_DDR, &ONE_WIRE_PORT, &ONE_WIRE_PIN_REG, ONE_WIRE_PIN);
+}
+
+static void test_reading(void) {
+    setup();
+    CHECK(one_wire_reset() == 1, "no presence");
+
+    bus.temp_raw = 0x0191;                      /* 25.0625 °C */
+    uint64_t t0 = hal_host_ns();
+    int16_t raw = ds18b20_readTemperature();
+    uint64_t took = hal_host_ns() - t0;
+    CHECK(raw == 0x0191, "raw %04X", (uint16_t)raw);
+    CHECK(bus.conversions == 1 && bus.early_reads == 0, "conversions %u early %u", bus.conversions, bus.early_reads);
+
+    /* 2 resets, 4 bytes written, 2 read; all but the conversion wait is CPU time */
+    uint64_t bus_ns = 2 * 960000ULL + 6 * 8 * 62000ULL;
+    CHECK(took == DS18B20_CONVERSION_MS * 1000000ULL + bus_ns, "reading took %llu ns", (unsigned long long)took);
+
+    bus.temp_raw = (int16_t)0xFE6F;             /* -25.0625 °C */
+    raw = ds18b20_readTemperature();
+    CHECK(raw == -401, "negative raw %d", raw);
+}
+
+static void test_scratchpad(void) {
+    uint8_t sp[9];
+
+    setup();
+    bus.temp_raw = 0x07D0;                      /* 125 °C */
+    CHECK(ds18b20_startConversion(), "no presence");
+    HAL_DELAY_MS(750);
+
+    CHECK(one_wire_reset(), "no presence");
+    one_wire_writeByte(0xCC);
+    one_wire_writeByte(0xBE);
+    for (uint8_t i = 0; i < 9; i++) sp[i] = one_wire_readByte();
+    CHECK(sp[0] == 0xD0 && sp[1] == 0x07 && sp[4] == 0x7F, "scratchpad %02X %02X .. %02X", sp[0], sp[1], sp[4]);
+    CHECK(sim_onewire_crc8(sp, 9) == 0, "scratchpad CRC");
+}
+
+static void test_early_read(void) {
+    setup();
+    CHECK(ds18b20_startConversion(), "no presence");
+    HAL_DELAY_MS(100);
+    int16_t raw = ds18b20_readScratchpad();
+    CHECK(raw == 0x0550, "early read %04X, want the power-on 85 C", (uint16_t)raw);
+    CHECK(bus.early_reads == 1, "early reads %u", bus.early_reads);
+}
+
+static void test_missing(void) {
+    setup();
+    bus.present = false;
+    CHECK(one_wire_reset() == 0, "presence without a device");
+    CHECK(ds18b20_readTemperature() == -1000, "missing sensor");
+    CHECK(bus.slots == 0, "slots sent to nobody: %u", bus.slots);
+}
+
+int main(void) {
+    test_reading();
+    test_scratchpad();
+    test_early_read();
+    test_missing();
+    printf("onewire: %s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
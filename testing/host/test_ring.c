@@ -0,0 +1,200 @@
+/*
+ * SPSC ring (firmware/system/spsc_ring.h): single-threaded checks and a
+ * two-thread stress run.
+ *
+ * Capacity, drop and high-water counting, spans split at the wrap, bulk
+ * push/pop and the 256-slot case where the byte indices wrap by
+ * themselves. Then an ISR-like producer interleaved with the consumer
+ * (pseudo-random bursts, drops allowed: every sequence number arrives in
+ * order or is counted as dropped), and a producer and consumer on two
+ * threads moving a sequence through a small ring with spans and single
+ * elements, which only stays in order if the slot is published after it
+ * is written and released after it is read.
+ *
+ * Build and run with "make test" at the top of the repository.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "spsc_ring.h"
+#include "check.h"
+
+SPSC_RING(ring8, uint16_t, 8)
+SPSC_RING(ring16, uint8_t, 16)
+SPSC_RING(ring256, uint8_t, 256)
+SPSC_RING(seq, uint32_t, 16)
+
+static uint32_t rng = 1;
+
+static uint32_t rnd(uint32_t n) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) % n;
+}
+
+static void test_capacity(void) {
+    static ring8_t r;
+    uint16_t v;
+
+    ring8_reset(&r);
+    CHECK(ring8_empty(&r) && !ring8_pop(&r, &v), "not empty");
+    for (uint16_t i = 0; i < 7; i++) CHECK(ring8_push(&r, 1000 + i), "push %u", i);
+    CHECK(!ring8_push(&r, 9999) && !ring8_push(&r, 9999), "push into a full ring");
+    CHECK(r.dropped == 2 && r.high_water == 7 && ring8_count(&r) == 7,
+          "dropped %u high %u count %u", r.dropped, r.high_water, ring8_count(&r));
+
+    for (uint16_t i = 0; i < 7; i++) CHECK(ring8_pop(&r, &v) && v == 1000 + i, "pop %u: %u", i, v);
+    CHECK(!ring8_pop(&r, &v), "pop from an empty ring");
+
+    ring8_clear_stats(&r);
+    CHECK(r.dropped == 0 && r.high_water == 0, "stats not cleared");
+
+    r.dropped = 0xFFFE;
+    ring8_drop(&r, 5);
+    CHECK(r.dropped == 0xFFFF, "dropped does not saturate: %u", r.dropped);
+}
+
+static void test_spans(void) {
+    static ring16_t r;
+    uint8_t out[16];
+    uint8_t *w;
+    const uint8_t *p;
+
+    ring16_reset(&r);
+    for (uint8_t i = 0; i < 12; i++) ring16_push(&r, i);
+    CHECK(ring16_pop_n(&r, out, 12) == 12 && out[11] == 11, "pop_n");
+
+    /* head = tail = 12: writable up to the wrap, then up to one short of tail */
+    CHECK(ring16_write_span(&r, &w) == 4 && w == &r.buf[12], "write span at 12");
+    memcpy(w, "abcd", 4);
+    ring16_commit(&r, 4);
+    CHECK(ring16_write_span(&r, &w) == 11 && w == &r.buf[0], "write span after the wrap");
+
+    CHECK(ring16_read_span(&r, &p) == 4 && memcmp(p, "abcd", 4) == 0, "read span before the wrap");
+    ring16_consume(&r, 3);
+    CHECK(ring16_read_span(&r, &p) == 1 && *p == 'd', "read span after a partial consume");
+
+    /* Bulk push across the wrap, the excess is dropped */
+    static const uint8_t SRC[20] = "0123456789ABCDEFGHIJ";
+    CHECK(ring16_push_n(&r, SRC, 20) == 14, "push_n stored %u", ring16_count(&r));
+    CHECK(r.dropped == 6 && r.high_water == 15, "dropped %u high %u", r.dropped, r.high_water);
+    CHECK(ring16_pop_n(&r, out, 16) == 15 && out[0] == 'd' && memcmp(out + 1, SRC, 14) == 0, "pop_n across the wrap");
+    CHECK(ring16_read_span(&r, &p) == 0, "span of an empty ring");
+}
+
+static void test_256(void) {
+    static ring256_t r;
+    uint8_t v;
+
+    ring256_reset(&r);
+    for (unsigned round = 0; round < 3; round++) {
+        for (unsigned i = 0; i < 300; i++) ring256_push(&r, (uint8_t)(i + round));
+        CHECK(ring256_count(&r) == 255, "count %u", ring256_count(&r));
+        for (unsigned i = 0; i < 255; i++) {
+            if (!ring256_pop(&r, &v) || v != (uint8_t)(i + round)) { CHECK(0, "round %u byte %u", round, i); break; }
+        }
+        CHECK(ring256_empty(&r), "round %u not empty", round);
+        for (unsigned i = 0; i < 100; i++) ring256_push(&r, 0);   /* move the indices on */
+        CHECK(ring256_pop_n(&r, (uint8_t[100]){ 0 }, 100) == 100, "pop_n 100");
+    }
+    CHECK(r.dropped == 3 * 45 && r.high_water == 255, "dropped %u high %u", r.dropped, r.high_water);
+}
+
+/* ISR-like producer: bursts arrive while the consumer is between reads */
+static void test_interleaved(void) {
+    static seq_t r;
+    uint32_t next = 0, expect = 0, got = 0, gaps = 0;
+
+    seq_reset(&r);
+    for (uint32_t step = 0; step < 50000; step++) {
+        for (uint32_t n = rnd(6); n; n--) seq_push(&r, next++);
+
+        const uint32_t *p;
+        uint8_t avail = seq_read_span(&r, &p);
+        uint8_t take = avail ? (uint8_t)(1 + rnd(avail)) : 0;
+        for (uint8_t i = 0; i < take; i++) {
+            if (p[i] < expect) { CHECK(0, "%u after %u", p[i], expect); return; }
+            gaps += p[i] - expect;
+            expect = p[i] + 1;
+        }
+        seq_consume(&r, take);
+        got += take;
+    }
+    got += seq_count(&r);
+    gaps += next - expect - seq_count(&r);   /* still waiting: not gaps */
+    CHECK(got + r.dropped == next && gaps == r.dropped, "sent %u got %u dropped %u gaps %u",
+          next, got, r.dropped, gaps);
+    CHECK(r.high_water == 15, "high water %u", r.high_water);
+}
+
+#define THREAD_COUNT 2000000u
+
+static seq_t shared;
+static bool stop;   /* consumer gave up, the producer must not wait on a full ring */
+
+static void *producer(void *arg) {
+    (void)arg;
+    uint32_t next = 0;
+    uint32_t lr = 7;
+
+    while (next < THREAD_COUNT && !__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+        lr = lr * 1664525u + 1013904223u;
+        if (lr & 0x100) {
+            if (seq_push(&shared, next)) next++;
+            else sched_yield();   /* one CPU: let the consumer run */
+            continue;
+        }
+        uint32_t *w;
+        uint8_t room = seq_write_span(&shared, &w);
+        if (room > THREAD_COUNT - next) room = (uint8_t)(THREAD_COUNT - next);
+        if (room == 0) sched_yield();
+        for (uint8_t i = 0; i < room; i++) w[i] = next++;
+        seq_commit(&shared, room);
+    }
+    return NULL;
+}
+
+static void test_threads(void) {
+    pthread_t t;
+    uint32_t expect = 0, v, bad = 0;
+    uint32_t lr = 11;
+
+    seq_reset(&shared);
+    stop = false;
+    if (pthread_create(&t, NULL, producer, NULL) != 0) {
+        CHECK(0, "pthread_create");
+        return;
+    }
+    while (expect < THREAD_COUNT && !bad) {
+        lr = lr * 1664525u + 1013904223u;
+        if (lr & 0x100) {
+            if (!seq_pop(&shared, &v)) sched_yield();
+            else if (v != expect++) bad = v + 1;
+            continue;
+        }
+        const uint32_t *p;
+        uint8_t avail = seq_read_span(&shared, &p);
+        if (avail == 0) sched_yield();
+        for (uint8_t i = 0; i < avail; i++) {
+            if (p[i] != expect++) { bad = p[i] + 1; break; }
+        }
+        seq_consume(&shared, avail);
+    }
+    __atomic_store_n(&stop, true, __ATOMIC_RELAXED);
+    pthread_join(t, NULL);
+
+    /* The producer retries instead of dropping, nothing may be lost */
+    CHECK(!bad, "got %u, expected %u", bad - 1, expect - 1);
+    CHECK(bad || seq_empty(&shared), "%u left", seq_count(&shared));
+}
+
+int main(void) {
+    test_capacity();
+    test_spans();
+    test_256();
+    test_interleaved();
+    test_threads();
+    printf("ring: %s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
@@ -0,0 +1,146 @@
+/*
+ * I2C driver (i2c.c) with bme280.c and ds3231.c against simulated slaves.
+ *
+ * The BME280 register file holds the calibration and raw readings of the
+ * datasheet's compensation example (section 8.2), so the driver must
+ * give 25.08 °C and 1006.53 hPa. The DS3231 one checks the BCD seconds,
+ * the alarm and control registers the driver programs, and the TWSR
+ * codes and bus time of the transfers.
+ *
+ * Build and run with "make test" at the top of the repository.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "hal.h"
+#include "sim_twi.h"
+#include "i2c.h"
+#include "bme280.h"
+#include "ds3231.h"
+#include "check.h"
+
+static sim_regfile_t bme, rtc;
+static uint8_t bme_resets;
+
+static void put16(sim_regfile_t *r, uint8_t at, uint16_t v) {
+    r->reg[at] = (uint8_t)v;
+    r->reg[at + 1] = (uint8_t)(v >> 8);
+}
+
+static void put20(sim_regfile_t *r, uint8_t at, uint32_t adc) {
+    r->reg[at] = (uint8_t)(adc >> 12);
+    r->reg[at + 1] = (uint8_t)(adc >> 4);
+    r->reg[at + 2] = (uint8_t)(adc << 4);
+}
+
+static void bme_written(sim_regfile_t *r, uint8_t reg, uint8_t v) {
+    (void)r;
+    if (reg == BME280_REGISTER_SOFTRESET && v == BME280_REGISTER_POWERONRESET) bme_resets++;
+}
+
+static void setup(void) {
+    hal_host_reset();
+    sim_twi_attach();
+
+    sim_regfile_init(&bme, BME280_I2C_ADDRSS);
+    bme.reg[0xD0] = 0x60;                       /* chip id */
+    put16(&bme, BME280_REGISTER_DIG_T1, 27504);
+    put16(&bme, BME280_REGISTER_DIG_T2, 26435);
+    put16(&bme, BME280_REGISTER_DIG_T3, (uint16_t)-1000);
+    put16(&bme, BME280_REGISTER_DIG_P1, 36477);
+    put16(&bme, BME280_REGISTER_DIG_P2, (uint16_t)-10685);
+    put16(&bme, BME280_REGISTER_DIG_P3, 3024);
+    put16(&bme, BME280_REGISTER_DIG_P4, 2855);
+    put16(&bme, BME280_REGISTER_DIG_P5, 140);
+    put16(&bme, BME280_REGISTER_DIG_P6, (uint16_t)-7);
+    put16(&bme, BME280_REGISTER_DIG_P7, 15500);
+    put16(&bme, BME280_REGISTER_DIG_P8, (uint16_t)-14600);
+    put16(&bme, BME280_REGISTER_DIG_P9, 6000);
+    put20(&bme, BME280_REGISTER_TEMPDATA, 519888);
+    put20(&bme, BME280_REGISTER_PRESSUREDATA, 415148);
+    bme.on_write = bme_written;
+    sim_twi_add(&bme.dev);
+
+    sim_regfile_init(&rtc, DS3231_I2C_ADDRESS);
+    sim_twi_add(&rtc.dev);
+
+    I2C_init();
+}
+
+static void test_bus(void) {
+    setup();
+    CHECK(TWBR == 32, "TWBR %u at 16 MHz", TWBR);
+    CHECK(sim_twi_scl_hz(F_CPU) == I2C_SCL_HZ, "SCL %u Hz", (unsigned)sim_twi_scl_hz(F_CPU));
+
+    /* START, SLA+W, reg, STOP, START, SLA+R, data, STOP */
+    sim_twi_stats = (sim_twi_stats_t){ 0 };
+    uint8_t id = bme280_read1Byte(0xD0);
+    CHECK(id == 0x60, "chip id %02X", id);
+    CHECK(sim_twi_stats.starts == 2 && sim_twi_stats.bytes == 4 && sim_twi_stats.nacks == 0,
+          "starts %u bytes %u nacks %u", sim_twi_stats.starts, sim_twi_stats.bytes, sim_twi_stats.nacks);
+    CHECK(sim_twi_stats.bus_ns == 40 * 5000ULL, "register read took %llu ns on the bus",
+          (unsigned long long)sim_twi_stats.bus_ns);
+
+    /* Nobody at 0x50 */
+    I2C_start_with_address(0x50, 0);
+    CHECK((TWSR & 0xF8) == 0x20, "SLA+W NACK status %02X", TWSR & 0xF8);
+    I2C_stop();
+    CHECK(sim_twi_stats.nacks == 1, "nacks %u", sim_twi_stats.nacks);
+
+    I2C_start_with_address(BME280_I2C_ADDRSS, 1);
+    CHECK((TWSR & 0xF8) == 0x40, "SLA+R ACK status %02X", TWSR & 0xF8);
+    (void)I2C_read_nack();
+    CHECK((TWSR & 0xF8) == 0x58, "data NACK status %02X", TWSR & 0xF8);
+    I2C_stop();
+
+    /* A slower CPU clock gives the fastest rate it can */
+    I2C_set_clock(2000000UL);
+    CHECK(TWBR == 0 && sim_twi_scl_hz(2000000UL) == 125000, "2 MHz: TWBR %u", TWBR);
+}
+
+static void test_bme280(void) {
+    setup();
+    bme280_init();
+    CHECK(bme_resets == 1, "soft resets %u", bme_resets);
+    CHECK(bme.reg[BME280_REGISTER_CONTROLHUMID] == 0x01, "ctrl_hum %02X", bme.reg[BME280_REGISTER_CONTROLHUMID]);
+    CHECK(bme.reg[BME280_REGISTER_CONTROL] == 0x27, "ctrl_meas %02X", bme.reg[BME280_REGISTER_CONTROL]);
+    CHECK(hal_host_ns() >= 110000000ULL, "init waited %llu ns", (unsigned long long)hal_host_ns());
+
+    float t = bme280_readTemperature();
+    CHECK(fabsf(t - 25.08f) < 0.001f, "temperature %.3f", t);
+    float p = bme280_readPressure();
+    CHECK(fabsf(p - 1006.53f) < 0.01f, "pressure %.3f", p);
+
+    bme280_startForced();
+    CHECK(bme.reg[BME280_REGISTER_CONTROL] == 0x25, "forced ctrl_meas %02X", bme.reg[BME280_REGISTER_CONTROL]);
+    CHECK(!bme280_isMeasuring(), "measuring");
+    bme.reg[BME280_REGISTER_STATUS] = 0x08;
+    CHECK(bme280_isMeasuring(), "not measuring");
+}
+
+static void test_ds3231(void) {
+    setup();
+    rtc.reg[0x00] = 0x47;
+    CHECK(DS3231_get_seconds() == 47, "seconds");
+
+    DS3231_set_alarm1_next_15s();
+    CHECK(rtc.reg[0x07] == 0x00 && rtc.reg[0x08] == 0x80 && rtc.reg[0x09] == 0x80 && rtc.reg[0x0A] == 0x80,
+          "alarm %02X %02X %02X %02X", rtc.reg[7], rtc.reg[8], rtc.reg[9], rtc.reg[10]);
+    CHECK(rtc.reg[0x0E] == 0x05, "control %02X", rtc.reg[0x0E]);
+
+    rtc.reg[0x00] = 0x12;
+    DS3231_set_alarm1_next_15s();
+    CHECK(rtc.reg[0x07] == 0x15, "alarm seconds %02X", rtc.reg[0x07]);
+
+    rtc.reg[0x0F] = 0x03;
+    DS3231_clear_alarm1_flag();
+    CHECK(rtc.reg[0x0F] == 0x00, "status %02X", rtc.reg[0x0F]);
+}
+
+int main(void) {
+    test_bus();
+    test_bme280();
+    test_ds3231();
+    printf("twi: %s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
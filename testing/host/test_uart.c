@@ -0,0 +1,179 @@
+/*
+ * UART driver (uart_isr.c) against the simulated USART0 byte stream.
+ *
+ * Bytes go in through USART_RX_vect as on the chip: order through the
+ * ring, overflow and the high-water mark, the error flags, RTS following
+ * the fill level with flow control on, in-place reads through spans,
+ * TX capture and CTS (a byte held off past the spin limit is dropped).
+ *
+ * Build and run with "make test" at the top of the repository.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "sim_uart.h"
+#include "uart_isr.h"
+#include "check.h"
+
+static void setup(void) {
+    hal_host_reset();
+    sim_uart_attach();
+    while (UART_receive() >= 0) { }
+    uart_rx.err_fe = uart_rx.err_dor = uart_rx.err_upe = 0;
+    UART_set_flow_control(0);
+    UART_init_ISR(MYUBRR);
+    UART_clear_counters();
+    sei();
+}
+
+static void test_order(void) {
+    static const char MSG[] = "AT+CSQ\r\n+CSQ: 17,99\r\n\r\nOK\r\n";
+    char got[sizeof(MSG)] = { 0 };
+
+    setup();
+    uint32_t rx0 = UART_rx_total();
+    CHECK(sim_uart_baud(F_CPU) == 117647, "baud %u", (unsigned)sim_uart_baud(F_CPU));
+
+    for (int round = 0; round < 20; round++) {     /* wraps the ring several times */
+        uint64_t t0 = hal_host_ns();
+        sim_uart_rx(MSG, sizeof(MSG) - 1);
+        CHECK(hal_host_ns() - t0 == (sizeof(MSG) - 1) * (10 * 1000000000ULL / 117647), "frame time");
+
+        uint8_t n = 0;
+        int16_t c;
+        while ((c = UART_receive()) >= 0 && n < sizeof(MSG) - 1) got[n++] = (char)c;
+        CHECK(n == sizeof(MSG) - 1 && memcmp(got, MSG, n) == 0, "round %d: got %u bytes", round, n);
+    }
+    CHECK(!UART_data_available(), "data left");
+    CHECK(uart_rx.ring.dropped == 0, "overflows %u", uart_rx.ring.dropped);
+    CHECK(UART_rx_total() - rx0 == 20 * (sizeof(MSG) - 1), "rx total %u", (unsigned)(UART_rx_total() - rx0));
+}
+
+static void test_overflow(void) {
+    uint8_t burst[300];
+
+    setup();
+    for (unsigned i = 0; i < sizeof(burst); i++) burst[i] = (uint8_t)i;
+    sim_uart_rx(burst, sizeof(burst));
+    CHECK(UART_rx_dropped() == sizeof(burst) - (RX_BUF_SZ - 1), "overflows %u", UART_rx_dropped());
+    CHECK(hal_host_irq_on, "interrupts left off by the atomic read");
+    CHECK(uart_rx.ring.high_water == RX_BUF_SZ - 1, "high water %u", uart_rx.ring.high_water);
+
+    /* The oldest bytes are kept, the excess is dropped */
+    for (unsigned i = 0; i < RX_BUF_SZ - 1; i++) {
+        int16_t c = UART_receive();
+        if (c != (int16_t)(uint8_t)i) { CHECK(0, "byte %u: %d", i, c); break; }
+    }
+    CHECK(UART_receive() == -1, "not empty");
+}
+
+static void test_errors(void) {
+    setup();
+    sim_uart_rx_flags('a', 1 << FE0);
+    sim_uart_rx_flags('b', 1 << DOR0);
+    sim_uart_rx_flags('c', (1 << UPE0) | (1 << FE0));
+    CHECK(uart_rx.err_fe == 2 && uart_rx.err_dor == 1 && uart_rx.err_upe == 1,
+          "fe %u dor %u upe %u", uart_rx.err_fe, uart_rx.err_dor, uart_rx.err_upe);
+    CHECK(UART_receive() == 'a', "byte with error flags not stored");
+
+    cli();
+    sim_uart_rx("x", 1);
+    CHECK(sim_uart.rx_lost == 1 && uart_ring_count(&uart_rx.ring) == 2, "lost %u", sim_uart.rx_lost);
+}
+
+static void test_flow_control(void) {
+    uint8_t fill[UART_RTS_HIGH];
+
+    setup();
+    UART_set_flow_control(1);
+    CHECK(sim_uart_rts(), "RTS not asserted on an empty ring");
+    CHECK(DDRD & (1 << UART_RTS_PIN), "RTS not an output");
+
+    memset(fill, 'x', sizeof(fill));
+    sim_uart_rx(fill, sizeof(fill) - 1);
+    CHECK(sim_uart_rts(), "RTS deasserted below the high mark");
+    sim_uart_rx(fill, 1);
+    CHECK(!sim_uart_rts(), "RTS still asserted at %u bytes", UART_RTS_HIGH);
+
+    while (uart_ring_count(&uart_rx.ring) > UART_RTS_LOW + 1) (void)UART_receive();
+    CHECK(!sim_uart_rts(), "RTS asserted above the low mark");
+    (void)UART_receive();
+    CHECK(sim_uart_rts(), "RTS not asserted at %u bytes", UART_RTS_LOW);
+    UART_set_flow_control(0);
+}
+
+static void test_span(void) {
+    uint8_t line[200];
+
+    setup();
+    uart_ring_reset(&uart_rx.ring);
+    for (unsigned i = 0; i < sizeof(line); i++) line[i] = (uint8_t)i;
+    sim_uart_rx(line, sizeof(line));
+    while (UART_receive() >= 0) { }
+    uint32_t rx0 = UART_rx_total();
+
+    /* 200 more bytes from slot 200: the span stops at the wrap, the rest follows */
+    sim_uart_rx(line, sizeof(line));
+    const uint8_t *p;
+    uint8_t n = UART_rx_span(&p);
+    CHECK(n == RX_BUF_SZ - 200 && memcmp(p, line, n) == 0, "first span %u", n);
+    UART_rx_consume(n);
+    const uint8_t *q;
+    uint8_t m = UART_rx_span(&q);
+    CHECK(m == sizeof(line) - n && memcmp(q, line + n, m) == 0, "second span %u", m);
+    UART_rx_consume(10);
+    CHECK(UART_rx_span(&q) == m - 10 && q[0] == line[n + 10], "after a partial consume");
+    CHECK(UART_rx_total() - rx0 == n + 10u, "rx total %u", (unsigned)(UART_rx_total() - rx0));
+    while (UART_receive() >= 0) { }
+    CHECK(UART_rx_span(&q) == 0, "span of an empty ring");
+
+    /* Consuming a span below the low mark asserts RTS again */
+    UART_set_flow_control(1);
+    uint8_t fill[UART_RTS_HIGH];
+    memset(fill, 'y', sizeof(fill));
+    sim_uart_rx(fill, sizeof(fill));
+    CHECK(!sim_uart_rts(), "RTS still asserted");
+    while ((n = UART_rx_span(&p)) > 0 && sim_uart_rts() == 0) UART_rx_consume(n > 16 ? 16 : n);
+    CHECK(sim_uart_rts() && uart_ring_count(&uart_rx.ring) <= UART_RTS_LOW, "RTS at %u bytes",
+          uart_ring_count(&uart_rx.ring));
+    UART_set_flow_control(0);
+}
+
+static void test_tx(void) {
+    setup();
+    uint32_t tx0 = UART_tx_total();
+    CHECK(UART_tx_idle(), "busy before sending");
+    UART_send_string("AT+IPR=460800\r");
+    CHECK(sim_uart.tx_len == 14 && memcmp(sim_uart.tx, "AT+IPR=460800\r", 14) == 0, "tx %u bytes", sim_uart.tx_len);
+    CHECK(UART_tx_idle(), "busy after sending");
+
+    /* A peer holding CTS off delays TX up to the spin limit, then the
+       byte is dropped and counted instead of overrunning it */
+    UART_set_flow_control(1);
+    sim_uart.cts_ready = false;
+    UART_send('!');
+    CHECK(sim_uart.tx_len == 14 && UART_tx_dropped() == 1, "tx %u bytes, %u dropped after CTS timeout",
+          sim_uart.tx_len, UART_tx_dropped());
+    UART_send_string("AT\r");
+    CHECK(sim_uart.tx_len == 14 && UART_tx_dropped() == 4, "stalled peer: %u dropped", UART_tx_dropped());
+    CHECK(UART_tx_total() - tx0 == 14, "tx total %u", (unsigned)(UART_tx_total() - tx0));
+
+    /* CTS back and the count cleared for the next command: sent again */
+    sim_uart.cts_ready = true;
+    UART_tx_clear_dropped();
+    UART_send('?');
+    CHECK(sim_uart.tx_len == 15 && sim_uart.tx[14] == '?' && UART_tx_dropped() == 0, "tx after CTS is back");
+    UART_set_flow_control(0);
+}
+
+int main(void) {
+    test_order();
+    test_overflow();
+    test_errors();
+    test_flow_control();
+    test_span();
+    test_tx();
+    printf("uart: %s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
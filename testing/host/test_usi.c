@@ -0,0 +1,131 @@
+/*
+ * USI two-wire slave of the monitoring AVR (boards/t84/usi_slave.c)
+ * against the bit-level I2C master of sim_usi.
+ *
+ * The START interrupt has to be enabled for the slave to see a
+ * transaction at all (it is also what wakes the sleeping CPU); after it
+ * the address is matched, a read clocks out the tx callback's bytes from
+ * index 0 until the master's NACK and a write hands every byte to rx.
+ * Bytes the slave sends never reach rx, so a block full of the monitor's
+ * command bytes ('T', 'A', 'R') cannot change its thresholds, alerts or
+ * counters.
+ *
+ * Build and run with "make test" at the top of the repository.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "sim_usi.h"
+#include "usi_slave.h"
+#include "monitor_avr.h"
+#include "check.h"
+
+#define ADDR 0x42
+
+static uint8_t block[40];
+static unsigned tx_calls, rx_calls;
+static uint8_t rx_index[16], rx_byte[16];
+
+static uint8_t tx(uint8_t index) {
+    tx_calls++;
+    return index < sizeof(block) ? block[index] : 0xFF;
+}
+
+static void rx(uint8_t index, uint8_t b) {
+    if (rx_calls < sizeof(rx_byte)) {
+        rx_index[rx_calls] = index;
+        rx_byte[rx_calls] = b;
+    }
+    rx_calls++;
+}
+
+static void setup(void) {
+    hal_host_reset();
+    sim_usi_attach();
+    usi_slave_init(ADDR, tx, rx);
+    sei();
+    tx_calls = rx_calls = 0;
+    for (unsigned i = 0; i < sizeof(block); i++) block[i] = (uint8_t)(0x10 + i * 7);
+}
+
+static void test_init(void) {
+    setup();
+    CHECK(USICR & (1 << USISIE), "START interrupt not enabled");
+    CHECK(!(DDRA & (1 << USI_SDA)) && (PORTA & (1 << USI_SDA)), "SDA not released");
+    CHECK((DDRA & (1 << USI_SCL)) && (PORTA & (1 << USI_SCL)), "SCL not released");
+}
+
+static void test_read(void) {
+    uint8_t got[36];
+
+    setup();
+    for (int round = 0; round < 3; round++) {       /* every read starts at the first byte */
+        memset(got, 0, sizeof(got));
+        CHECK(sim_usi_read(ADDR, got, sizeof(got)), "round %d: address NACKed", round);
+        CHECK(memcmp(got, block, sizeof(got)) == 0, "round %d: data", round);
+    }
+    CHECK(tx_calls == 3 * sizeof(got) && rx_calls == 0, "tx %u rx %u", tx_calls, rx_calls);
+    CHECK(sim_usi_stats.str_irqs == 3 && sim_usi_stats.nacks == 0, "starts %u nacks %u",
+          sim_usi_stats.str_irqs, sim_usi_stats.nacks);
+    CHECK(!(DDRA & (1 << USI_SDA)), "SDA held after the NACK");
+}
+
+static void test_address(void) {
+    uint8_t got[4];
+
+    setup();
+    CHECK(!sim_usi_read(ADDR + 1, got, sizeof(got)), "other address ACKed");
+    CHECK(sim_usi_write(ADDR ^ 0x40, (const uint8_t *)"A", 1) == -1, "other address ACKed");
+    CHECK(tx_calls == 0 && rx_calls == 0, "tx %u rx %u", tx_calls, rx_calls);
+    CHECK(!(DDRA & (1 << USI_SDA)), "SDA driven for another address");
+
+    /* Still answers its own address afterwards */
+    CHECK(sim_usi_read(ADDR, got, sizeof(got)) && memcmp(got, block, sizeof(got)) == 0, "read after a foreign one");
+}
+
+static void test_write(void) {
+    static const uint8_t MSG[5] = { 'T', 0x06, 0xDC, 0x05, 0x32 };
+
+    setup();
+    CHECK(sim_usi_write(ADDR, MSG, sizeof(MSG)) == (int)sizeof(MSG), "bytes not ACKed");
+    CHECK(rx_calls == sizeof(MSG) && tx_calls == 0, "rx %u tx %u", rx_calls, tx_calls);
+    for (unsigned i = 0; i < sizeof(MSG) && i < rx_calls; i++) {
+        CHECK(rx_index[i] == i && rx_byte[i] == MSG[i], "byte %u: [%u] %02x", i, rx_index[i], rx_byte[i]);
+    }
+}
+
+/* Block bytes equal to the monitor's commands are data, not commands */
+static void test_read_command_bytes(void) {
+    static const uint8_t CMDS[3] = { MONITOR_CMD_THRESHOLDS, MONITOR_CMD_ACK, MONITOR_CMD_RESET };
+    uint8_t got[sizeof(block)];
+
+    setup();
+    for (unsigned i = 0; i < sizeof(block); i++) block[i] = CMDS[i % 3];
+    CHECK(sim_usi_read(ADDR, got, sizeof(got)) && memcmp(got, block, sizeof(got)) == 0, "read");
+    CHECK(rx_calls == 0, "%u block bytes taken as written", rx_calls);
+
+    /* A write right after still starts at index 0 */
+    CHECK(sim_usi_write(ADDR, CMDS + 2, 1) == 1 && rx_calls == 1 && rx_index[0] == 0 &&
+          rx_byte[0] == MONITOR_CMD_RESET, "command after a read");
+}
+
+static void test_no_start_irq(void) {
+    uint8_t got[2];
+
+    /* Without USISIE nothing ever reaches the slave */
+    setup();
+    USICR &= (uint8_t)~((1 << USISIE) | (1 << USIOIE));
+    CHECK(!sim_usi_read(ADDR, got, sizeof(got)) && tx_calls == 0, "answered without interrupts");
+}
+
+int main(void) {
+    test_init();
+    test_read();
+    test_address();
+    test_write();
+    test_read_command_bytes();
+    test_no_start_irq();
+    printf("usi: %s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * Host check of the OTA patch decoder (firmware/telemetry/ota_patch.c)
+ * against patches made by server/ota.js.
+ *
+ * The old region is the "flash" read_old() sees, pages go into a staging
+ * array as write_page() would program them. The patch is fed in uneven
+ * pieces, as AT+HTTPREAD delivers it. Then the staging region must equal
+ * the new image; a patch damaged anywhere, for another build or signed
+ * with another key must end in an error.
+ *
+ * Run with "make test" at the top of the repository (needs node), which
+ * writes the vectors with node server/ota.js --vectors <dir> first.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ota_patch.h"
+
+static uint8_t old_region[OTA_REGION_SZ], new_region[OTA_REGION_SZ], staging[OTA_REGION_SZ];
+static uint8_t patch[OTA_REGION_SZ * 2], key[16];
+static long patch_len;
+static int pages;
+
+static long load(const char *dir, const char *name, uint8_t *buf, long cap) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        exit(2);
+    }
+    long n = (long)fread(buf, 1, (size_t)cap, f);
+    fclose(f);
+    return n;
+}
+
+static uint8_t read_old(uint16_t offset) {
+    return old_region[offset];
+}
+
+static bool write_page(uint16_t offset, const uint8_t *page) {
+    if (offset % OTA_PAGE_SZ || (uint32_t)offset + OTA_PAGE_SZ > OTA_REGION_SZ) return false;
+    memcpy(staging + offset, page, OTA_PAGE_SZ);
+    pages++;
+    return true;
+}
+
+/* Whole patch in pieces of 1..step bytes; base is the CRC the station reports */
+static ota_result_t apply(const uint8_t *p, long len, const uint8_t *k, uint32_t base, int step) {
+    ota_patch_t d;
+    ota_result_t r = OTA_MORE;
+
+    memset(staging, 0, sizeof(staging));
+    pages = 0;
+    ota_patch_init(&d, k, base, read_old, write_page);
+    for (long off = 0, i = 0; off < len && r == OTA_MORE; i++) {
+        long n = 1 + (i * 7) % step;
+        if (n > len - off) n = len - off;
+        r = ota_patch_feed(&d, p + off, (uint16_t)n);
+        off += n;
+    }
+    return r;
+}
+
+int main(int argc, char **argv) {
+    const char *dir = (argc > 1) ? argv[1] : "/tmp/otavec";
+    int failures = 0;
+
+    load(dir, "old.bin", old_region, sizeof(old_region));
+    load(dir, "new.bin", new_region, sizeof(new_region));
+    load(dir, "key.bin", key, sizeof(key));
+    patch_len = load(dir, "patch.bin", patch, sizeof(patch));
+
+    uint32_t base = (uint32_t)patch[4] | (uint32_t)patch[5] << 8 | (uint32_t)patch[6] << 16 |
+                    (uint32_t)patch[7] << 24;
+
+    ota_result_t r = apply(patch, patch_len, key, base, 64);
+    bool same = memcmp(staging, new_region, sizeof(staging)) == 0;
+    printf("patch %ld B: result %d, %d pages, region %s\n", patch_len, r, pages, same ? "identical" : "DIFFERS");
+    if (r != OTA_DONE || !same || pages != OTA_REGION_SZ / OTA_PAGE_SZ) failures++;
+
+    // One flipped bit at a time, header and operations alike
+    int accepted = 0;
+    for (long i = 0; i < patch_len; i++) {
+        patch[i] ^= 0x01;
+        if (apply(patch, patch_len, key, base, 16) == OTA_DONE) accepted++;
+        patch[i] ^= 0x01;
+    }
+    printf("damaged patches accepted: %d of %ld\n", accepted, patch_len);
+    if (accepted) failures++;
+
+    r = apply(patch, patch_len - 1, key, base, 64);
+    printf("cut patch: result %d\n", r);
+    if (r != OTA_MORE) failures++;
+
+    r = apply(patch, patch_len, key, base ^ 1, 64);
+    printf("other build: result %d\n", r);
+    if (r != OTA_ERR_BASE) failures++;
+
+    key[0] ^= 0x80;
+    r = apply(patch, patch_len, key, base, 64);
+    printf("other key: result %d\n", r);
+    if (r != OTA_ERR_TAG) failures++;
+
+    printf("ota: %s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
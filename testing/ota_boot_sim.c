@@ -0,0 +1,247 @@
+/*
+ * Host run of the bootloader (firmware/boards/m328p/bootloader/ota_boot.c)
+ * on simulated flash, EEPROM and watchdog (testing/avr_sim).
+ *
+ * ota_boot.c is compiled into this file unchanged, its main() renamed;
+ * a reset is a fresh call of it. Jumping to the application, a watchdog
+ * reset and a power cut end the call through longjmp. The old image is
+ * in the active region, the new one in staging and the EEPROM marker
+ * carries the CRC the application recorded, as ota.c leaves them.
+ *
+ *  - no marker: the application starts, nothing is written;
+ *  - marker: only the pages that differ are copied, the marker is cleared
+ *    and the new image starts;
+ *  - staging that fails its CRC: nothing is copied, the marker is cleared
+ *    and the old image keeps running;
+ *  - power cut after every page of the copy: the next reset finishes it;
+ *  - a page that does not take the write for a while: retried within
+ *    COPY_TRIES, or by the watchdog reset with the marker kept; a
+ *    half-written image is never started;
+ *  - page_write() for the application: staging pages only.
+ *
+ * Cycle counts and the real SPM/EEPROM timing need simavr (open item);
+ * this checks the decisions and the copy.
+ *
+ * Run with "make test" at the top of the repository.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <setjmp.h>
+#include "avr_sim.h"
+#include "host/check.h"
+
+#define main boot_main
+#define BOOT_ENTER_APP() avr_sim_enter_app()
+static void avr_sim_enter_app(void);
+#include "../firmware/boards/m328p/bootloader/ota_boot.c"
+#undef main
+
+enum { END_APP = 1, END_WDT, END_POWER };
+
+uint8_t avr_sim_flash[AVR_SIM_FLASH_SZ];
+uint8_t avr_sim_eeprom[AVR_SIM_EEPROM_SZ];
+uint8_t MCUSR, GPIOR0, SREG;
+
+static jmp_buf reset;
+static uint8_t page_buf[SPM_PAGESIZE];
+static unsigned writes, stray_writes;
+static int power_left;              /* page writes until the power goes, -1: never */
+static uint16_t worn_page;          /* page that keeps its erased first byte... */
+static int worn_left;               /* ...for this many writes, -1: for good */
+
+static uint8_t old_image[BOOT_REGION_SZ], new_image[BOOT_REGION_SZ];
+static unsigned differing;
+
+static void avr_sim_enter_app(void) {
+    longjmp(reset, END_APP);
+}
+
+void avr_sim_wdt_enable(uint8_t timeout) {
+    (void)timeout;
+    longjmp(reset, END_WDT);        /* nothing resets it: the reset comes */
+}
+
+void avr_sim_wdt_disable(void) { }
+
+void avr_sim_page_erase(uint16_t addr) {
+    memset(avr_sim_flash + addr, 0xFF, SPM_PAGESIZE);
+}
+
+void avr_sim_page_fill(uint16_t addr, uint16_t word) {
+    page_buf[addr % SPM_PAGESIZE] = (uint8_t)word;
+    page_buf[addr % SPM_PAGESIZE + 1] = (uint8_t)(word >> 8);
+}
+
+void avr_sim_page_write(uint16_t addr) {
+    if (addr >= BOOT_START || addr % SPM_PAGESIZE) stray_writes++;
+    if (power_left >= 0 && power_left-- == 0) longjmp(reset, END_POWER);   /* erased, not written */
+
+    writes++;
+    for (uint8_t i = 0; i < SPM_PAGESIZE; i++) avr_sim_flash[addr + i] &= page_buf[i];
+    if (addr == worn_page && worn_left != 0) {
+        avr_sim_flash[addr] = 0xFF;
+        if (worn_left > 0) worn_left--;
+    }
+}
+
+static uint32_t image_crc(const uint8_t *image) {
+    uint32_t crc = CRC32_INIT;
+    for (uint16_t i = 0; i < BOOT_REGION_SZ; i++) crc = crc32_update(crc, image[i]);
+    return crc32_final(crc);
+}
+
+static boot_mark_t mark_now(void) {
+    boot_mark_t m;
+    memcpy(&m, avr_sim_eeprom + (uintptr_t)BOOT_MARK_ADDR, sizeof(m));
+    return m;
+}
+
+/* After a download: old image active, new one staged, marker set */
+static void setup(bool marked) {
+    memset(avr_sim_flash, 0xFF, sizeof(avr_sim_flash));
+    memset(avr_sim_eeprom, 0xFF, sizeof(avr_sim_eeprom));
+    memcpy(avr_sim_flash + BOOT_ACTIVE, old_image, BOOT_REGION_SZ);
+    memcpy(avr_sim_flash + BOOT_STAGING, new_image, BOOT_REGION_SZ);
+    if (marked) {
+        boot_mark_t m = { BOOT_MARK_SWAP, image_crc(new_image) };
+        memcpy(avr_sim_eeprom + (uintptr_t)BOOT_MARK_ADDR, &m, sizeof(m));
+    }
+    writes = stray_writes = 0;
+    power_left = -1;
+    worn_page = 0xFFFF;
+    worn_left = 0;
+}
+
+static int boot(uint8_t cause) {
+    MCUSR = cause;
+    SREG = 0;
+    int end = setjmp(reset);
+    if (end == 0) {
+        (void)boot_main();
+        end = 0;                    /* returned: never on the chip */
+    }
+    return end;
+}
+
+static bool active_is(const uint8_t *image) {
+    return memcmp(avr_sim_flash + BOOT_ACTIVE, image, BOOT_REGION_SZ) == 0;
+}
+
+static void make_images(void) {
+    uint32_t rng = 7;
+
+    for (uint16_t i = 0; i < BOOT_REGION_SZ; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        old_image[i] = new_image[i] = (uint8_t)(rng >> 24);
+    }
+    /* Every third page changes, as a patch touching part of the image */
+    differing = 0;
+    for (uint16_t off = 0; off < BOOT_REGION_SZ; off += 3 * SPM_PAGESIZE) {
+        new_image[off] = (uint8_t)(old_image[off] ^ 0x5A);
+        if (new_image[off] == 0xFF) new_image[off] = 0x12;
+        differing++;
+    }
+}
+
+static void test_no_marker(void) {
+    setup(false);
+    int end = boot(0x02);           /* EXTRF */
+    CHECK(end == END_APP && active_is(old_image) && writes == 0, "end %d, %u writes", end, writes);
+    CHECK(BOOT_RESET_CAUSE == 0x02 && MCUSR == 0, "reset cause %02x, MCUSR %02x", BOOT_RESET_CAUSE, MCUSR);
+}
+
+static void test_swap(void) {
+    setup(true);
+    int end = boot(0x01);
+    CHECK(end == END_APP && active_is(new_image), "end %d, new image active %d", end, active_is(new_image));
+    CHECK(writes == differing && stray_writes == 0, "%u writes for %u changed pages, %u stray", writes,
+          differing, stray_writes);
+    CHECK(mark_now().magic == 0xFFFFFFFFUL, "marker left set");
+    CHECK(memcmp(avr_sim_flash + BOOT_STAGING, new_image, BOOT_REGION_SZ) == 0, "staging changed");
+    CHECK(!(SREG & 0x80), "interrupts left on");
+
+    end = boot(0x01);               /* next reset: nothing more to do */
+    CHECK(end == END_APP && writes == differing, "second boot: end %d, %u writes", end, writes);
+}
+
+static void test_bad_staging(void) {
+    setup(true);
+    avr_sim_flash[BOOT_STAGING + 1000] ^= 0x01;
+    int end = boot(0x01);
+    CHECK(end == END_APP && active_is(old_image) && writes == 0, "end %d, %u writes", end, writes);
+    CHECK(mark_now().magic == 0xFFFFFFFFUL, "marker kept for a bad staging image");
+}
+
+static void test_power_cuts(void) {
+    unsigned bad = 0;
+
+    for (unsigned cut = 0; cut < differing; cut++) {
+        setup(true);
+        power_left = (int)cut;
+        int first = boot(0x01);
+        int second = boot(0x01);    /* power back */
+        if (first != END_POWER || second != END_APP || !active_is(new_image) ||
+            mark_now().magic != 0xFFFFFFFFUL) bad++;
+    }
+    CHECK(bad == 0, "%u of %u cuts not recovered", bad, differing);
+}
+
+static void test_worn_page(void) {
+    int end;
+
+    /* One failed write: the second copy inside the same boot fixes it */
+    setup(true);
+    worn_page = BOOT_ACTIVE + 3 * SPM_PAGESIZE;
+    worn_left = 1;
+    end = boot(0x01);
+    CHECK(end == END_APP && active_is(new_image), "one bad write: end %d", end);
+
+    /* Bad for every copy of one boot: watchdog reset with the marker
+       kept, the next boot copies again */
+    setup(true);
+    worn_page = BOOT_ACTIVE + 3 * SPM_PAGESIZE;
+    worn_left = COPY_TRIES;
+    end = boot(0x01);
+    CHECK(end == END_WDT && mark_now().magic == BOOT_MARK_SWAP, "bad for a boot: end %d", end);
+    end = boot(0x08);               /* WDRF */
+    CHECK(end == END_APP && active_is(new_image) && mark_now().magic == 0xFFFFFFFFUL,
+          "after the watchdog reset: end %d", end);
+
+    /* Never takes the write: no boot ever starts the broken image */
+    setup(true);
+    worn_page = BOOT_ACTIVE + 3 * SPM_PAGESIZE;
+    worn_left = -1;
+    for (int i = 0; i < 3; i++) {
+        end = boot(0x08);
+        CHECK(end == END_WDT && mark_now().magic == BOOT_MARK_SWAP, "worn page, boot %d: end %d", i, end);
+    }
+}
+
+static void test_page_write(void) {
+    uint8_t page[SPM_PAGESIZE];
+
+    setup(false);
+    memset(page, 0xA5, sizeof(page));
+    CHECK(!page_write(BOOT_ACTIVE, page), "active region written");
+    CHECK(!page_write(BOOT_START, page), "boot section written");
+    CHECK(!page_write(BOOT_STAGING + 2, page), "unaligned address written");
+    CHECK(!page_write(BOOT_STAGING - SPM_PAGESIZE, page), "page below staging written");
+    CHECK(writes == 0 && active_is(old_image), "%u writes", writes);
+
+    CHECK(page_write(BOOT_STAGING + SPM_PAGESIZE, page) && writes == 1 &&
+          memcmp(avr_sim_flash + BOOT_STAGING + SPM_PAGESIZE, page, sizeof(page)) == 0, "staging page");
+}
+
+int main(void) {
+    make_images();
+    test_no_marker();
+    test_swap();
+    test_bad_staging();
+    test_power_cuts();
+    test_worn_page();
+    test_page_write();
+    printf("bootloader: %s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
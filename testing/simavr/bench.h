@@ -0,0 +1,44 @@
+/*
+ * Scenario markers shared by the benchmark firmware and the simavr runner.
+ *
+ * The firmware brackets each measured piece of code with BENCH_BEGIN()
+ * and BENCH_END(): single OUT instructions to two otherwise unused
+ * general purpose I/O registers, which the runner watches. Everything
+ * between the two writes is counted, including the interrupts that came
+ * in on the way. BENCH_DONE() ends the run (simavr stops on sleep with
+ * interrupts disabled).
+ *
+ * A scenario may run several times (BENCH_BEGIN/END pairs with the same
+ * id); the runner reports mean and maximum.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+enum {
+    /* main AVR (bench_m328p.c) */
+    BENCH_BME280_SAMPLE = 1,    /* forced measurement read out: T, p, RH */
+    BENCH_DS18B20_READ,         /* scratchpad read after a finished conversion */
+    BENCH_GSM_PING,             /* "AT" through wait_for_tokens(), modem answers at once */
+    BENCH_UART_BURST,           /* 64-byte modem burst through USART_RX_vect and UART_receive() */
+    BENCH_TSC_APPEND,           /* one 4-channel weather record into the record batch */
+
+    /* monitoring AVR (bench_t84.c) */
+    BENCH_GET_AVERAGE = 16,     /* circular mean of 16 wind directions */
+    BENCH_USI_BLOCK_READ,       /* data block and checksum through USI_OVF_vect */
+    BENCH_T84_IDLE_PULSES,      /* main loop for 2 s with 10 Hz anemometer pulses */
+
+    BENCH_COUNT
+};
+
+#ifdef __AVR__
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#define BENCH_BEGIN(id) (GPIOR1 = (id))
+#define BENCH_END(id)   (GPIOR2 = (id))
+#define BENCH_DONE()    do { cli(); sleep_enable(); sleep_cpu(); } while (0)
+#endif
+
+#endif /* BENCH_H */
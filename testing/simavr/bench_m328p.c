@@ -0,0 +1,89 @@
+/*
+ * Benchmark firmware for the main AVR, run by simbench on simavr.
+ *
+ * Links the board's drivers unchanged and calls the pieces under test
+ * between BENCH_BEGIN/BENCH_END, with the 1 ms systick running as on the
+ * board. The runner provides the BME280 on TWI, the DS18B20 on PB0 and
+ * the modem's side of the UART.
+ */
+
+#include <stdint.h>
+#include <util/delay.h>
+#include "bench.h"
+#include "i2c.h"
+#include "bme280.h"
+#include "ds18b20.h"
+#include "uart_isr.h"
+#include "gsm_module.h"
+#include "systick.h"
+#include "tscodec.h"
+#include "config.h"
+
+#define RUNS 8
+#define BURST 64        /* simavr's UART input FIFO holds 64 bytes */
+
+static volatile int32_t sink;
+static uint8_t batch[RECORD_BUF_SZ];
+
+int main(void) {
+    systick_init();
+    UART_init_ISR(MYUBRR);
+    I2C_init();
+    sei();
+
+    bme280_init();
+    for (uint8_t i = 0; i < RUNS; i++) {
+        bme280_startForced();
+        while (bme280_isMeasuring());
+
+        BENCH_BEGIN(BENCH_BME280_SAMPLE);
+        sink = (int32_t)(bme280_readTemperature() * 100.0f);
+        sink = (int32_t)(bme280_readPressure() * 100.0f);
+        sink = (int32_t)(bme280_readHumidity() * 100.0f);
+        BENCH_END(BENCH_BME280_SAMPLE);
+    }
+
+    for (uint8_t i = 0; i < RUNS; i++) {
+        ds18b20_startConversion();
+        _delay_ms(DS18B20_CONVERSION_MS);
+
+        BENCH_BEGIN(BENCH_DS18B20_READ);
+        sink = ds18b20_readScratchpad();
+        BENCH_END(BENCH_DS18B20_READ);
+    }
+
+    for (uint8_t i = 0; i < RUNS; i++) {
+        BENCH_BEGIN(BENCH_GSM_PING);
+        sink = gsm_ping(100);
+        BENCH_END(BENCH_GSM_PING);
+    }
+
+    for (uint8_t i = 0; i < RUNS; i++) {
+        uint8_t n = 0;
+
+        BENCH_BEGIN(BENCH_UART_BURST);     /* the runner starts sending here */
+        while (n < BURST) {
+            int16_t c = UART_receive();
+            if (c >= 0) { sink += c; n++; }
+        }
+        BENCH_END(BENCH_UART_BURST);
+    }
+
+    /* Weather-like records as the recorder appends them: regular timestamps,
+       small drifts, the ground temperature mostly unchanged */
+    tsc_encoder_t enc;
+    int32_t v[4] = { 1850, 101325, 6200, 1400 };
+    tsc_init(&enc, batch, sizeof(batch), 4);
+    for (uint8_t i = 0; i < RUNS; i++) {
+        v[0] += (i & 1) ? -3 : 7;
+        v[1] += (int8_t)(i * 5 - 17);
+        v[2] -= 40;
+        if (i == 4) v[3] += 6;
+
+        BENCH_BEGIN(BENCH_TSC_APPEND);
+        sink = tsc_append(&enc, (uint32_t)i * RECORD_PERIOD_S, v);
+        BENCH_END(BENCH_TSC_APPEND);
+    }
+
+    BENCH_DONE();
+}
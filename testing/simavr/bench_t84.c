@@ -0,0 +1,52 @@
+/*
+ * Benchmark firmware for the monitoring AVR, run by simbench on simavr.
+ *
+ * main_copy.c is compiled with main renamed to board_main, so its
+ * functions and ISRs are the ones measured here and the last scenario
+ * runs the real main loop. The runner plays the I2C master on the USI
+ * bit by bit (simavr has no USI model, it shifts USIDR and raises the two
+ * USI vectors itself) and pulses the anemometer input.
+ */
+
+#include <stdint.h>
+#include "bench.h"
+#include "config.h"
+#include "../../peripherals/monitor_avr.h"
+
+#define RUNS 8
+
+float get_average(uint16_t *angles, uint8_t length);
+void init(uint8_t i2c_address);
+int board_main(void);
+
+static volatile float sink;
+
+int main(void) {
+    /* Around north and the 0/360 wrap: the worst case for the quadrant logic */
+    static uint16_t dirs[16] = {
+        35000, 35500, 100, 1250, 34800, 200, 900, 35900,
+        450, 35100, 1800, 2250, 34000, 600, 35750, 50,
+    };
+
+    init(MONITOR_I2C_ADDRESS);
+    sei();
+
+    for (uint8_t i = 0; i < RUNS; i++) {
+        BENCH_BEGIN(BENCH_GET_AVERAGE);
+        sink = get_average(dirs, sizeof(dirs) / sizeof(dirs[0]));
+        BENCH_END(BENCH_GET_AVERAGE);
+    }
+
+    /* init() armed the USI start condition, the runner plays the master */
+    for (uint8_t i = 0; i < RUNS; i++) {
+        GPIOR0 = 0;
+        BENCH_BEGIN(BENCH_USI_BLOCK_READ);
+        while (!GPIOR0);                    /* set by the runner after the STOP */
+        BENCH_END(BENCH_USI_BLOCK_READ);
+    }
+
+    /* Never returns; the runner ends the scenario and the run */
+    BENCH_BEGIN(BENCH_T84_IDLE_PULSES);
+    board_main();
+    BENCH_DONE();
+}
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""Compare simbench results with a baseline.
+
+Prints every scenario with its cycle count and worst ISR latency next to
+the baseline and fails (exit 1) when one got slower by more than the
+tolerance, or disappeared. New scenarios are listed but do not fail.
+
+    python3 compare.py baseline.jsonl build/results.jsonl [--tolerance 5]
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    rows = {}
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if line:
+                r = json.loads(line)
+                rows[(r["board"], r["scenario"])] = r
+    return rows
+
+
+def metrics(r):
+    """Numbers that must not grow: cycles, awake time, per vector worst latency and length."""
+    m = {
+        "cycles_mean": r["cycles_mean"],
+        "cycles_max": r["cycles_max"],
+        "awake_cycles_mean": r["awake_cycles_mean"],
+    }
+    for isr in r["isr"]:
+        m[isr["vector"] + ".latency_max"] = isr["latency_max"]
+        m[isr["vector"] + ".cycles_max"] = isr["cycles_max"]
+    return m
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("baseline")
+    ap.add_argument("results")
+    ap.add_argument("--tolerance", type=float, default=5.0, help="allowed growth in percent")
+    args = ap.parse_args()
+
+    base = load(args.baseline)
+    new = load(args.results)
+    failed = False
+
+    for key in sorted(set(base) | set(new)):
+        name = "%s/%s" % key
+        if key not in new:
+            print("%-28s missing" % name)
+            failed = True
+            continue
+        if key not in base:
+            print("%-28s new, %d cycles" % (name, new[key]["cycles_mean"]))
+            continue
+
+        old_m, new_m = metrics(base[key]), metrics(new[key])
+        for k in sorted(new_m):
+            if k not in old_m:
+                continue
+            was, now = old_m[k], new_m[k]
+            grow = (now - was) * 100.0 / was if was else (100.0 if now else 0.0)
+            bad = grow > args.tolerance
+            failed |= bad
+            if bad or k == "cycles_mean":
+                print("%-28s %-24s %10d -> %10d  %+6.1f%%%s" % (name, k, was, now, grow, "  SLOWER" if bad else ""))
+
+    print("FAILED" if failed else "passed")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
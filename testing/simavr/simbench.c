@@ -0,0 +1,648 @@
+/*
+ * Cycle benchmark runner: loads bench_m328p.elf or bench_t84.elf into
+ * simavr, plays the peripherals and measures the BENCH_* scenarios.
+ *
+ * Per scenario it counts CPU cycles between BENCH_BEGIN and BENCH_END
+ * (mean and maximum over the runs), the awake part of them (cycles not
+ * spent in a sleep mode) and, per interrupt vector that fired inside the
+ * scenario, the latency from the flag being raised to the first
+ * instruction of the handler and the cycles in the handler up to RETI.
+ * Latency includes any time interrupts were disabled, so its maximum is
+ * the worst case the scenario produced.
+ *
+ * Peripherals:
+ *  - main AVR: BME280 register file on TWI (datasheet calibration example),
+ *    DS18B20 on PB0 decoded from the pin timing, modem on USART0 that
+ *    answers "AT" with OK and sends 64-byte bursts;
+ *  - monitoring AVR: I2C master on the USI, bit by bit (simavr has no
+ *    USI: the runner registers its two vectors, shifts USIDR, counts the
+ *    clock edges in USISR and holds SCL until the handler clears its
+ *    flag), reading the block at MONITOR_I2C_ADDRESS; anemometer pulses
+ *    on PB0.
+ *
+ * Output is one JSON object per scenario and line (see compare.py).
+ *
+ *   simbench atmega328p 16000000 bench_m328p.elf
+ *   simbench attiny84 8000000 bench_t84.elf
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_irq.h"
+#include "sim_interrupts.h"
+#include "sim_cycle_timers.h"
+#include "avr_ioport.h"
+#include "avr_uart.h"
+#include "avr_twi.h"
+#include "bench.h"
+
+/* Gives up on a firmware that never reaches BENCH_DONE (simulated seconds) */
+#define RUN_LIMIT_S 60
+
+static avr_t *avr;
+
+static avr_cycle_count_t us_to_cycles(uint32_t us) {
+    return (avr_cycle_count_t)us * avr->frequency / 1000000UL;
+}
+
+static double cycles_to_us(double c) {
+    return c * 1e6 / avr->frequency;
+}
+
+/* ---------------- boards ---------------- */
+
+typedef struct {
+    uint8_t num;
+    const char *name;
+} vector_t;
+
+typedef struct {
+    const char *mcu;
+    const char *board;
+    avr_io_addr_t gpior0, gpior1, gpior2;
+    const vector_t *vectors;
+} board_t;
+
+static const vector_t M328P_VECTORS[] = {
+    { 7, "TIMER2_COMPA" }, { 18, "USART_RX" }, { 24, "TWI" }, { 0, NULL },
+};
+
+static const vector_t T84_VECTORS[] = {
+    { 2, "PCINT0" }, { 6, "TIM1_COMPA" }, { 13, "ADC" }, { 15, "USI_STR" }, { 16, "USI_OVF" }, { 0, NULL },
+};
+
+static const board_t BOARDS[] = {
+    { "atmega328p", "m328p", 0x3E, 0x4A, 0x4B, M328P_VECTORS },
+    { "attiny84",   "t84",   0x33, 0x34, 0x35, T84_VECTORS },
+};
+
+static const board_t *board;
+
+/* ---------------- scenarios ---------------- */
+
+static const char *const SCENARIO_NAMES[BENCH_COUNT] = {
+    [BENCH_BME280_SAMPLE]   = "bme280_sample",
+    [BENCH_DS18B20_READ]    = "ds18b20_read",
+    [BENCH_GSM_PING]        = "gsm_ping",
+    [BENCH_UART_BURST]      = "uart_burst",
+    [BENCH_TSC_APPEND]      = "tsc_append",
+    [BENCH_GET_AVERAGE]     = "get_average",
+    [BENCH_USI_BLOCK_READ]  = "usi_block_read",
+    [BENCH_T84_IDLE_PULSES] = "idle_pulses",
+};
+
+#define MAX_VECTORS 8
+
+typedef struct {
+    uint32_t count;
+    uint64_t latency_sum, latency_max;
+    uint64_t cycles_sum, cycles_max;
+} isr_stats_t;
+
+typedef struct {
+    uint32_t runs;
+    uint64_t cycles_sum, cycles_max;
+    uint64_t awake_sum;
+    isr_stats_t isr[MAX_VECTORS];
+} scenario_t;
+
+static scenario_t scenarios[BENCH_COUNT];
+static uint8_t current;                 /* open scenario, 0 = none */
+static avr_cycle_count_t begin_cycle;
+static avr_cycle_count_t asleep, begin_asleep;
+static bool stop;
+
+/* Per watched vector: when its flag was raised and its handler entered */
+static avr_cycle_count_t pending_at[MAX_VECTORS], running_at[MAX_VECTORS];
+
+static void scenario_start(uint8_t id);
+
+static void scenario_end(uint8_t id) {
+    if (id != current || id >= BENCH_COUNT) return;
+
+    scenario_t *s = &scenarios[id];
+    uint64_t c = avr->cycle - begin_cycle;
+
+    s->runs++;
+    s->cycles_sum += c;
+    if (c > s->cycles_max) s->cycles_max = c;
+    s->awake_sum += c - (asleep - begin_asleep);
+    current = 0;
+}
+
+static void marker_begin(avr_t *a, avr_io_addr_t addr, uint8_t v, void *param) {
+    (void)param;
+    a->data[addr] = v;
+    current = v;
+    begin_cycle = a->cycle;
+    begin_asleep = asleep;
+    scenario_start(v);
+}
+
+static void marker_end(avr_t *a, avr_io_addr_t addr, uint8_t v, void *param) {
+    (void)param;
+    a->data[addr] = v;
+    scenario_end(v);
+}
+
+static void int_pending(avr_irq_t *irq, uint32_t value, void *param) {
+    (void)irq;
+    if (value) pending_at[(uintptr_t)param] = avr->cycle;
+}
+
+static void int_running(avr_irq_t *irq, uint32_t value, void *param) {
+    uintptr_t i = (uintptr_t)param;
+    (void)irq;
+
+    if (value) {
+        running_at[i] = avr->cycle;
+        if (current) {
+            isr_stats_t *st = &scenarios[current].isr[i];
+            uint64_t lat = avr->cycle - pending_at[i];
+            st->count++;
+            st->latency_sum += lat;
+            if (lat > st->latency_max) st->latency_max = lat;
+        }
+    } else if (current && scenarios[current].isr[i].count) {
+        isr_stats_t *st = &scenarios[current].isr[i];
+        uint64_t c = avr->cycle - running_at[i];
+        st->cycles_sum += c;
+        if (c > st->cycles_max) st->cycles_max = c;
+    }
+}
+
+static void watch_vectors(void) {
+    for (uintptr_t i = 0; board->vectors[i].name && i < MAX_VECTORS; i++) {
+        avr_irq_t *irq = avr_get_interrupt_irq(avr, board->vectors[i].num);
+        if (!irq) continue;
+        avr_irq_register_notify(irq + AVR_INT_IRQ_PENDING, int_pending, (void *)i);
+        avr_irq_register_notify(irq + AVR_INT_IRQ_RUNNING, int_running, (void *)i);
+    }
+}
+
+static void print_results(void) {
+    for (int id = 1; id < BENCH_COUNT; id++) {
+        const scenario_t *s = &scenarios[id];
+        if (!s->runs) continue;
+
+        double mean = (double)s->cycles_sum / s->runs;
+        printf("{\"board\":\"%s\",\"scenario\":\"%s\",\"runs\":%u,\"cycles_mean\":%.0f,\"cycles_max\":%llu,"
+               "\"us_mean\":%.1f,\"awake_cycles_mean\":%.0f,\"awake_pct\":%.2f,\"isr\":[",
+               board->board, SCENARIO_NAMES[id], s->runs, mean, (unsigned long long)s->cycles_max,
+               cycles_to_us(mean), (double)s->awake_sum / s->runs,
+               s->cycles_sum ? 100.0 * s->awake_sum / s->cycles_sum : 0.0);
+
+        bool first = true;
+        for (int i = 0; board->vectors[i].name; i++) {
+            const isr_stats_t *st = &s->isr[i];
+            if (!st->count) continue;
+            printf("%s{\"vector\":\"%s\",\"count\":%u,\"latency_mean\":%.1f,\"latency_max\":%llu,"
+                   "\"cycles_mean\":%.1f,\"cycles_max\":%llu}",
+                   first ? "" : ",", board->vectors[i].name, st->count,
+                   (double)st->latency_sum / st->count, (unsigned long long)st->latency_max,
+                   (double)st->cycles_sum / st->count, (unsigned long long)st->cycles_max);
+            first = false;
+        }
+        printf("]}\n");
+    }
+}
+
+/* ---------------- main AVR: BME280 on TWI ---------------- */
+
+typedef struct {
+    avr_irq_t *irq;
+    uint8_t addr;
+    uint8_t selected;       /* address byte with R/W, 0 = not addressed */
+    bool ptr_next;
+    uint8_t ptr;
+    uint8_t reg[256];
+} twi_regfile_t;
+
+static twi_regfile_t bme;
+
+static void twi_reply(twi_regfile_t *d, uint8_t cond, uint8_t data) {
+    avr_raise_irq(d->irq + TWI_IRQ_INPUT, avr_twi_irq_msg(cond, d->selected, data));
+}
+
+static void twi_hook(avr_irq_t *irq, uint32_t value, void *param) {
+    twi_regfile_t *d = param;
+    avr_twi_msg_irq_t v;
+    (void)irq;
+
+    v.u.v = value;
+    if (v.u.twi.msg & TWI_COND_STOP) d->selected = 0;
+    if (v.u.twi.msg & TWI_COND_START) {
+        d->selected = 0;
+        if ((v.u.twi.addr >> 1) == d->addr) {
+            d->selected = v.u.twi.addr;
+            d->ptr_next = !(v.u.twi.addr & 1);
+            twi_reply(d, TWI_COND_ACK, 1);
+        }
+    }
+    if (!d->selected) return;
+    if (v.u.twi.msg & TWI_COND_WRITE) {
+        if (d->ptr_next) d->ptr = v.u.twi.data;
+        else d->reg[d->ptr++] = v.u.twi.data;
+        d->ptr_next = false;
+        twi_reply(d, TWI_COND_ACK, 1);
+    }
+    if (v.u.twi.msg & TWI_COND_READ) {
+        twi_reply(d, TWI_COND_READ, d->reg[d->ptr++]);
+    }
+}
+
+static void put16(uint8_t at, uint16_t v) {
+    bme.reg[at] = (uint8_t)v;
+    bme.reg[at + 1] = (uint8_t)(v >> 8);
+}
+
+static void put20(uint8_t at, uint32_t adc) {
+    bme.reg[at] = (uint8_t)(adc >> 12);
+    bme.reg[at + 1] = (uint8_t)(adc >> 4);
+    bme.reg[at + 2] = (uint8_t)(adc << 4);
+}
+
+static void bme280_attach(void) {
+    static const char *names[2] = { "twi.bme280.out", "twi.bme280.in" };
+
+    memset(&bme, 0, sizeof(bme));
+    bme.addr = 0x76;
+    bme.reg[0xD0] = 0x60;
+    put16(0x88, 27504); put16(0x8A, 26435); put16(0x8C, (uint16_t)-1000);
+    put16(0x8E, 36477); put16(0x90, (uint16_t)-10685); put16(0x92, 3024);
+    put16(0x94, 2855); put16(0x96, 140); put16(0x98, (uint16_t)-7);
+    put16(0x9A, 15500); put16(0x9C, (uint16_t)-14600); put16(0x9E, 6000);
+    bme.reg[0xA1] = 75; put16(0xE1, 362); bme.reg[0xE3] = 0;
+    bme.reg[0xE4] = 0x13; bme.reg[0xE5] = 0x20; bme.reg[0xE6] = 0x03; bme.reg[0xE7] = 30;
+    put20(0xFA, 519888);
+    put20(0xF7, 415148);
+    bme.reg[0xFD] = 0x6A; bme.reg[0xFE] = 0x40;
+
+    bme.irq = avr_alloc_irq(&avr->irq_pool, 0, 2, names);
+    avr_irq_register_notify(bme.irq + TWI_IRQ_OUTPUT, twi_hook, &bme);
+    avr_connect_irq(avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT), bme.irq + TWI_IRQ_OUTPUT);
+    avr_connect_irq(bme.irq + TWI_IRQ_INPUT, avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_INPUT));
+}
+
+/* ---------------- main AVR: DS18B20 on PB0 ---------------- */
+
+enum { OW_IDLE, OW_ROM, OW_FUNCTION, OW_SENDING };
+
+static struct {
+    avr_irq_t *pin;
+    uint8_t ddr, port;
+    bool master_low;
+    avr_cycle_count_t fall;
+    uint8_t state, shift, nbits, tx_pos;
+    uint8_t scratch[9];
+} ow;
+
+static avr_cycle_count_t ow_release(avr_t *a, avr_cycle_count_t when, void *param) {
+    (void)a; (void)when; (void)param;
+    avr_raise_irq(ow.pin, 1);
+    return 0;
+}
+
+static avr_cycle_count_t ow_presence(avr_t *a, avr_cycle_count_t when, void *param) {
+    (void)when; (void)param;
+    avr_raise_irq(ow.pin, 0);
+    avr_cycle_timer_register_usec(a, 120, ow_release, NULL);
+    return 0;
+}
+
+static void ow_command(uint8_t cmd) {
+    if (ow.state == OW_ROM) {
+        ow.state = (cmd == 0xCC) ? OW_FUNCTION : OW_IDLE;
+        return;
+    }
+    ow.state = OW_IDLE;
+    if (cmd == 0xBE) {
+        ow.tx_pos = 0;
+        ow.state = OW_SENDING;
+    }
+}
+
+static void ow_edge(void) {
+    bool low = (ow.ddr & 1) && !(ow.port & 1);
+
+    if (low == ow.master_low) return;
+    ow.master_low = low;
+
+    if (low) {                              /* slot or reset starts */
+        ow.fall = avr->cycle;
+        if (ow.state == OW_SENDING && ow.tx_pos < 72 &&
+            !((ow.scratch[ow.tx_pos / 8] >> (ow.tx_pos % 8)) & 1)) {
+            avr_raise_irq(ow.pin, 0);       /* 0 bit: hold the line past the sample point */
+            avr_cycle_timer_register_usec(avr, 30, ow_release, NULL);
+        }
+        return;
+    }
+
+    avr_cycle_count_t held = avr->cycle - ow.fall;
+    if (held >= us_to_cycles(480)) {
+        ow.state = OW_ROM;
+        ow.nbits = 0;
+        avr_cycle_timer_register_usec(avr, 30, ow_presence, NULL);
+    } else if (ow.state == OW_SENDING) {
+        if (++ow.tx_pos == 72) ow.state = OW_IDLE;
+    } else if (ow.state == OW_ROM || ow.state == OW_FUNCTION) {
+        ow.shift = (uint8_t)((ow.shift >> 1) | (held < us_to_cycles(15) ? 0x80 : 0));
+        if (++ow.nbits == 8) {
+            ow.nbits = 0;
+            ow_command(ow.shift);
+        }
+    }
+}
+
+static void ow_ddr(avr_irq_t *irq, uint32_t value, void *param) {
+    (void)irq; (void)param;
+    ow.ddr = (uint8_t)value;
+    ow_edge();
+}
+
+static void ow_port(avr_irq_t *irq, uint32_t value, void *param) {
+    (void)irq; (void)param;
+    ow.port = (uint8_t)value;
+    ow_edge();
+}
+
+static uint8_t crc8(const uint8_t *p, uint8_t len) {
+    uint8_t crc = 0;
+
+    while (len--) {
+        uint8_t b = *p++;
+        for (uint8_t i = 0; i < 8; i++, b >>= 1) {
+            crc = ((crc ^ b) & 1) ? (uint8_t)((crc >> 1) ^ 0x8C) : (uint8_t)(crc >> 1);
+        }
+    }
+    return crc;
+}
+
+static void ds18b20_attach(void) {
+    static const uint8_t SP[8] = { 0x91, 0x01, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10 };  /* 25.0625 °C */
+
+    memset(&ow, 0, sizeof(ow));
+    memcpy(ow.scratch, SP, 8);
+    ow.scratch[8] = crc8(SP, 8);
+    ow.pin = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), IOPORT_IRQ_PIN0);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), IOPORT_IRQ_DIRECTION_ALL),
+                            ow_ddr, NULL);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), IOPORT_IRQ_REG_PORT),
+                            ow_port, NULL);
+    avr_raise_irq(ow.pin, 1);               /* pull-up */
+}
+
+/* ---------------- main AVR: modem on USART0 ---------------- */
+
+static avr_irq_t *uart_in;
+static char tx_line[64];
+static uint8_t tx_len;
+
+static void modem_send(const char *s, uint16_t len) {
+    while (len--) avr_raise_irq(uart_in, (uint8_t)*s++);
+}
+
+static void modem_rx(avr_irq_t *irq, uint32_t value, void *param) {
+    (void)irq; (void)param;
+
+    if (value != '\r') {
+        if (tx_len < sizeof(tx_line) - 1) tx_line[tx_len++] = (char)value;
+        return;
+    }
+    tx_line[tx_len] = '\0';
+    tx_len = 0;
+    if (strcmp(tx_line, "AT") == 0) modem_send("\r\nOK\r\n", 6);
+}
+
+static void modem_attach(void) {
+    uint32_t flags = 0;
+
+    avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+    flags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+
+    uart_in = avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT), modem_rx, NULL);
+}
+
+/* ---------------- monitoring AVR: USI master ---------------- */
+
+#define T84_USICR 0x2D
+#define T84_USISR 0x2E
+#define T84_USIDR 0x2F
+#define T84_PINA  0x39
+#define T84_DDRA  0x3A
+#define T84_PORTA 0x3B
+#define USI_SCL   4                         /* PA4 */
+#define USI_SDA   6                         /* PA6 */
+#define USI_ADDR  0x42                      /* MONITOR_I2C_ADDRESS */
+#define USI_BYTES 48                        /* more than the block and its checksum */
+#define USI_BIT_US 10                       /* 100 kHz SCL */
+
+static avr_int_vector_t usi_start = {
+    .vector = 15, .enable = AVR_IO_REGBIT(T84_USICR, 7), .raised = AVR_IO_REGBIT(T84_USISR, 7),
+};
+static avr_int_vector_t usi_ovf = {
+    .vector = 16, .enable = AVR_IO_REGBIT(T84_USICR, 6), .raised = AVR_IO_REGBIT(T84_USISR, 6),
+};
+
+/* Position in the read: START, address and its ACK, USI_BYTES bytes each
+   followed by the master's ACK (NACK after the last), STOP */
+static struct {
+    uint16_t bit;                           /* bits clocked since the START */
+    bool held;                              /* SCL stretched until the handler clears its flag */
+    bool acked;                             /* address ACKed by the slave */
+} usi;
+
+/* USISR: the three flags clear by writing one, USIDC is read-only. Clearing
+   the start or overflow flag is what releases SCL. */
+static void usisr_write(avr_t *a, avr_io_addr_t addr, uint8_t v, void *param) {
+    uint8_t old = a->data[addr];
+    (void)param;
+    a->data[addr] = (uint8_t)(((old & 0xE0) & ~(v & 0xE0)) | (old & 0x10) | (v & 0x0F));
+    if (v & 0xC0) usi.held = false;
+}
+
+/* SCL and SDA as the port reads them; SCL is an output of the slave, so
+   its PORTA bit stands in for the line while the master holds it low */
+static void usi_lines(avr_t *a, bool scl, bool sda) {
+    a->data[T84_PORTA] = (uint8_t)((a->data[T84_PORTA] & ~(1 << USI_SCL)) | (scl << USI_SCL));
+    a->data[T84_PINA] = (uint8_t)((a->data[T84_PINA] & ~(1 << USI_SDA)) | (sda << USI_SDA));
+}
+
+/* One SCL period: wired-AND of the master's bit and the slave's (USIDR
+   bit 7 while it drives SDA), shifted in, two edges on the counter */
+static bool usi_clock(avr_t *a, bool master) {
+    bool slave = (a->data[T84_DDRA] & (1 << USI_SDA)) ? (a->data[T84_USIDR] >> 7) : 1;
+    bool line = master && slave;
+    uint8_t sr = a->data[T84_USISR];
+
+    a->data[T84_USIDR] = (uint8_t)((a->data[T84_USIDR] << 1) | line);
+    uint8_t count = (uint8_t)((sr + 2) & 0x0F);
+    a->data[T84_USISR] = (uint8_t)((sr & 0xF0) | count);
+    if (count < 2) {                        /* wrapped on one of the two edges */
+        usi.held = true;
+        avr_raise_interrupt(a, &usi_ovf);
+    }
+    return line;
+}
+
+static avr_cycle_count_t usi_next(avr_t *a, avr_cycle_count_t when, void *param) {
+    const uint16_t last = 9 + USI_BYTES * 9;   /* address + ACK, then 9 bits per byte */
+    (void)param;
+
+    if (usi.bit == 0) {
+        usi_lines(a, true, false);          /* START: SDA falls while SCL is high */
+        usi.held = true;
+        avr_raise_interrupt(a, &usi_start);
+        usi.bit++;
+        return when + us_to_cycles(USI_BIT_US / 2);
+    }
+    if (usi.bit == 1) {
+        usi_lines(a, false, false);         /* SCL low: the START is complete */
+        usi.bit++;
+        return when + us_to_cycles(USI_BIT_US / 2);
+    }
+
+    if (usi.held) return when + us_to_cycles(1);
+
+    uint16_t n = usi.bit - 2;               /* bit of the transfer */
+    if (n < 8) {
+        usi_clock(a, ((USI_ADDR << 1) | 1) & (0x80 >> n));
+    } else if (n == 8) {
+        usi.acked = !usi_clock(a, true);
+        if (!usi.acked) usi.bit = last + 1;
+    } else if (n < last) {
+        uint16_t k = (n - 9) % 9;
+        usi_clock(a, k < 8 ? true : (n + 1 == last)); /* data released, then ACK / NACK */
+    } else if (n == last) {
+        usi_lines(a, true, true);           /* STOP: SDA rises while SCL is high */
+        a->data[T84_USISR] |= 1 << 5;       /* USIPF */
+    } else {
+        if (!usi.acked) fprintf(stderr, "t84: USI address 0x%02X not acknowledged\n", USI_ADDR);
+        a->data[board->gpior0] = 1;         /* tell the firmware the transfer is over */
+        return 0;
+    }
+    usi.bit++;
+    return when + us_to_cycles(USI_BIT_US);
+}
+
+static void usi_attach(void) {
+    avr_register_vector(avr, &usi_start);
+    avr_register_vector(avr, &usi_ovf);
+    avr_register_io_write(avr, T84_USISR, usisr_write, NULL);
+}
+
+/* ---------------- monitoring AVR: anemometer ---------------- */
+
+#define IDLE_S       12                     /* two Timer1 periods of the board */
+#define PULSE_HZ     10
+
+static avr_irq_t *wind_pin;
+static bool wind_level = true;
+
+static avr_cycle_count_t wind_toggle(avr_t *a, avr_cycle_count_t when, void *param) {
+    (void)a; (void)param;
+    wind_level = !wind_level;
+    avr_raise_irq(wind_pin, wind_level);
+    return when + us_to_cycles(1000000UL / PULSE_HZ / 2);
+}
+
+static avr_cycle_count_t idle_over(avr_t *a, avr_cycle_count_t when, void *param) {
+    (void)a; (void)when; (void)param;
+    scenario_end(BENCH_T84_IDLE_PULSES);
+    stop = true;
+    return 0;
+}
+
+/* ---------------- stimuli per scenario ---------------- */
+
+static void scenario_start(uint8_t id) {
+    switch (id) {
+    case BENCH_UART_BURST: {
+        char burst[64];
+        for (uint8_t i = 0; i < sizeof(burst); i++) burst[i] = (char)('0' + i % 64);
+        modem_send(burst, sizeof(burst));
+        break;
+    }
+    case BENCH_USI_BLOCK_READ:
+        memset(&usi, 0, sizeof(usi));
+        avr_cycle_timer_register_usec(avr, 90, usi_next, NULL);
+        break;
+    case BENCH_T84_IDLE_PULSES:
+        avr_cycle_timer_register_usec(avr, 1000000UL / PULSE_HZ / 2, wind_toggle, NULL);
+        avr_cycle_timer_register(avr, us_to_cycles(1000000UL) * IDLE_S, idle_over, NULL);
+        break;
+    default:
+        break;
+    }
+}
+
+/* ---------------- main ---------------- */
+
+int main(int argc, char **argv) {
+    elf_firmware_t fw;
+
+    if (argc != 4) {
+        fprintf(stderr, "usage: %s <mcu> <hz> <firmware.elf>\n", argv[0]);
+        return 2;
+    }
+    for (size_t i = 0; i < sizeof(BOARDS) / sizeof(BOARDS[0]); i++) {
+        if (strcmp(BOARDS[i].mcu, argv[1]) == 0) board = &BOARDS[i];
+    }
+    if (!board) {
+        fprintf(stderr, "no scenarios for %s\n", argv[1]);
+        return 2;
+    }
+
+    memset(&fw, 0, sizeof(fw));
+    if (elf_read_firmware(argv[3], &fw) != 0) {
+        fprintf(stderr, "cannot read %s\n", argv[3]);
+        return 2;
+    }
+    avr = avr_make_mcu_by_name(argv[1]);
+    if (!avr) {
+        fprintf(stderr, "simavr has no %s\n", argv[1]);
+        return 2;
+    }
+    avr_init(avr);
+    fw.frequency = (uint32_t)strtoul(argv[2], NULL, 10);
+    avr_load_firmware(avr, &fw);
+    avr->frequency = fw.frequency;
+    avr->log = LOG_ERROR;
+
+    avr_register_io_write(avr, board->gpior1, marker_begin, NULL);
+    avr_register_io_write(avr, board->gpior2, marker_end, NULL);
+
+    if (strcmp(board->board, "m328p") == 0) {
+        bme280_attach();
+        ds18b20_attach();
+        modem_attach();
+    } else {
+        usi_attach();
+        wind_pin = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), IOPORT_IRQ_PIN0);
+        avr_raise_irq(wind_pin, 1);
+    }
+    watch_vectors();
+
+    int state = cpu_Running;
+    while (!stop && state != cpu_Done && state != cpu_Crashed) {
+        int before = avr->state;
+        avr_cycle_count_t c0 = avr->cycle;
+
+        state = avr_run(avr);
+        if (before == cpu_Sleeping) asleep += avr->cycle - c0;
+        if (avr->cycle > us_to_cycles(1000000UL) * RUN_LIMIT_S) {
+            fprintf(stderr, "%s: no BENCH_DONE after %d s, scenario %u open\n", board->board, RUN_LIMIT_S, current);
+            state = cpu_Crashed;
+        }
+    }
+
+    print_results();
+    return state == cpu_Crashed ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * Replays an INA219 solar log (monitor_solar.py CSV) through the
+ * monitoring AVR's fixed-point energy accumulator and compares the
+ * result with the float energy column of the log.
+ *
+ * Fails if the fixed-point energy is off the float trapezoid by more
+ * than 0.01 % or off the log's own energy column by more than 0.5 %.
+ *
+ * Build and run on the host:
+ *   cc -O2 -DF_CPU=8000000UL -I../firmware/boards/t84 \
+ *      solar_replay.c ../firmware/boards/t84/solar_energy.c -o solar_replay
+ *   ./solar_replay solar_log_2025_04_17.csv
+ * (or "make test" at the top of the repository)
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include "solar_energy.h"
+
+/* Timer1 runs at F_CPU / 1024, i.e. 7812.5 ticks/s at 8 MHz */
+#define TICKS_X2_PER_SECOND (F_CPU / 512UL)
+
+int main(int argc, char **argv) {
+    const char *path = (argc > 1) ? argv[1] : "solar_log_2025_04_17.csv";
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+
+    char line[256];
+    if (!fgets(line, sizeof(line), f)) {  // header
+        fclose(f);
+        return 1;
+    }
+
+    SolarEnergy solar;
+    solar_energy_reset(&solar);
+
+    double log_mwh = 0.0;      // sum of the log's per-row energy (assumes 60 s rows)
+    double exact_mwh = 0.0;    // float trapezoid over the real timestamps
+    double prev_mw = 0.0;
+    long first_s = -1, prev_s = 0;
+    unsigned rows = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        int y, mo, d, h, mi, s;
+        float current_ma, voltage_v, power_mw, energy_mwh;
+
+        if (sscanf(line, "%d-%d-%d %d:%d:%d,%f,%f,%f,%f",
+                   &y, &mo, &d, &h, &mi, &s,
+                   &current_ma, &voltage_v, &power_mw, &energy_mwh) != 10) {
+            continue;
+        }
+
+        long t_s = (long)h * 3600 + mi * 60 + s;
+        if (first_s < 0) {
+            first_s = t_s;
+        }
+        uint32_t now = (uint32_t)((uint64_t)(t_s - first_s) * TICKS_X2_PER_SECOND / 2);
+
+        uint16_t mv = (uint16_t)(voltage_v * 1000.0f + 0.5f);
+        uint32_t ua = (uint32_t)(current_ma * 1000.0f + 0.5f);
+        solar_energy_update(&solar, mv, ua, now);
+
+        double mw = (double)mv * ua / 1e6;
+        if (rows > 0) {
+            exact_mwh += (prev_mw + mw) / 2.0 * (double)(t_s - prev_s) / 3600.0;
+        }
+        prev_mw = mw;
+        prev_s = t_s;
+
+        log_mwh += energy_mwh;
+        rows++;
+    }
+    fclose(f);
+
+    double fixed_mwh = solar.energy_uwh / 1000.0;
+
+    printf("rows             : %u (%.1f h)\n", rows, (prev_s - first_s) / 3600.0);
+    printf("log energy column: %.3f mWh\n", log_mwh);
+    printf("float trapezoid  : %.3f mWh\n", exact_mwh);
+    printf("fixed-point      : %.3f mWh (%lu uWh)\n", fixed_mwh, (unsigned long)solar.energy_uwh);
+    printf("fixed vs float   : %+.4f %%\n", exact_mwh ? (fixed_mwh - exact_mwh) / exact_mwh * 100.0 : 0.0);
+    printf("peak power       : %.2f mW\n", solar.peak_power_uw / 1000.0);
+    printf("voltage range    : %u .. %u mV\n", solar.min_voltage_mv, solar.max_voltage_mv);
+
+    int ok = rows > 0 && exact_mwh > 0.0
+          && fabs(fixed_mwh - exact_mwh) <= exact_mwh * 1e-4
+          && fabs(fixed_mwh - log_mwh) <= log_mwh * 5e-3;
+    printf("solar: %s\n", ok ? "passed" : "FAILED");
+    return !ok;
+}
@@ -0,0 +1,196 @@
+/*
+ * Formatting benchmark of firmware/telemetry/stream_writer.c.
+ *
+ * Builds the main AVR's report (same fields and formats as pipeline.c,
+ * fixed sample values) twice: with the vsnprintf appender pipeline.c used
+ * before, and with the stream writer into a buffer. Checks that both give
+ * the same bytes, then times each and the writer's counting pass.
+ *
+ * This runs on the host, so the times are only a ratio; on the AVR the
+ * gain is larger, as avr-libc's vfprintf works through every conversion
+ * with 32-bit division and the writer uses 16-bit division below 65536.
+ *
+ * Build and run on the host:
+ *   cc -O2 -I../firmware/telemetry stream_writer_bench.c \
+ *      ../firmware/telemetry/stream_writer.c -o stream_writer_bench
+ *   ./stream_writer_bench
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "stream_writer.h"
+
+#define ROUNDS 200000
+
+typedef struct { uint16_t count; int32_t min, max, mean; uint32_t stddev; } record_t;
+
+static const char *const KEYS[4] = { "t", "p", "rh", "t_ds" };
+static const record_t METRICS[4] = {
+    { 12, 1834, 2291, 2047, 131 },
+    { 12, 101210, 101388, 101302, 52 },
+    { 12, 5410, 7120, 6233, 488 },
+    { 12, -212, 2310, 2011, 140 },
+};
+static const int8_t SESS[3][2] = { { 9, 14 }, { 11, 12 }, { 17, 21 } };
+static const uint8_t REC[40] = { 0x04, 0x00, 0x21, 0x8f, 0x13, 0x77, 0x02, 0xc9, 0x55, 0x10 };
+
+/* ---------------- before: vsnprintf ---------------- */
+
+static char payload[704];
+static int payload_len;
+
+static void put(const char *fmt, ...) {
+    size_t room = sizeof(payload) - (size_t)payload_len;
+    va_list ap;
+
+    va_start(ap, fmt);
+    int n = vsnprintf(payload + payload_len, room, fmt, ap);
+    va_end(ap);
+
+    payload_len += (n < 0) ? 0 : ((size_t)n < room) ? n : (int)room - 1;
+}
+
+static void report_printf(void) {
+    static const char B64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    payload_len = 0;
+    put("{\"v\":1,\"cfg\":%u,\"why\":%u", 7u, 5u);
+    for (int i = 0; i < 4; i++) {
+        const record_t *r = &METRICS[i];
+        put(",\"%s\":[%u,%ld,%ld,%ld,%lu]", KEYS[i], r->count, (long)r->min, (long)r->max,
+            (long)r->mean, (unsigned long)r->stddev);
+    }
+    put(",\"rain\":%u,\"wind\":%u,\"gust\":%u,\"mean\":%u,\"dir\":%u,\"rate\":%u"
+        ",\"e_uwh\":%lu,\"pk_mw\":%u,\"vmin\":%u,\"vmax\":%u,\"ev\":%u",
+        14u, 3310u, 42u, 17u, 225u, 3u, 1834221UL, 2210u, 3612u, 4188u, 0u);
+    put(",\"awake_ms\":%lu,\"net_ms\":%lu,\"up\":%u,\"fast_ms\":%lu,\"cpu_uas\":%lu,\"cpu_uas_16m\":%lu",
+        24312UL, 19108UL, 1u, 2210UL, 31877UL, 243120UL);
+    put(",\"uart\":[%lu,%u,%u]", 115200UL, 61u, 0u);
+    put(",\"sess\":[");
+    for (int i = 0; i < 3; i++) put("%s[%d,%d,%u,%u]", i ? "," : "", SESS[i][0], SESS[i][1], 31u + i, 1u);
+    put("]");
+    put(",\"rec\":{\"n\":%u,\"ch\":%u,\"now\":%lu,\"b64\":\"", 3u, 4u, 902113UL);
+    for (unsigned i = 0; i < sizeof(REC); i += 3) {
+        uint32_t v = (uint32_t)REC[i] << 16;
+        if (i + 1 < sizeof(REC)) v |= (uint16_t)REC[i + 1] << 8;
+        if (i + 2 < sizeof(REC)) v |= REC[i + 2];
+        payload[payload_len++] = B64[(v >> 18) & 0x3F];
+        payload[payload_len++] = B64[(v >> 12) & 0x3F];
+        payload[payload_len++] = (i + 1 < sizeof(REC)) ? B64[(v >> 6) & 0x3F] : '=';
+        payload[payload_len++] = (i + 2 < sizeof(REC)) ? B64[v & 0x3F] : '=';
+    }
+    payload[payload_len] = '\0';
+    put("\"}}");
+}
+
+/* ---------------- after: stream writer ---------------- */
+
+static void report_fill(sw_t *w, void *ctx) {
+    (void)ctx;
+    sw_obj_begin(w);
+    sw_kv_u32(w, "v", 1);
+    sw_kv_u32(w, "cfg", 7);
+    sw_kv_u32(w, "why", 5);
+    for (int i = 0; i < 4; i++) {
+        const record_t *r = &METRICS[i];
+        sw_key(w, KEYS[i]);
+        sw_arr_begin(w);
+        sw_item_u32(w, r->count);
+        sw_item_i32(w, r->min);
+        sw_item_i32(w, r->max);
+        sw_item_i32(w, r->mean);
+        sw_item_u32(w, r->stddev);
+        sw_arr_end(w);
+    }
+    sw_kv_u32(w, "rain", 14);
+    sw_kv_u32(w, "wind", 3310);
+    sw_kv_u32(w, "gust", 42);
+    sw_kv_u32(w, "mean", 17);
+    sw_kv_u32(w, "dir", 225);
+    sw_kv_u32(w, "rate", 3);
+    sw_kv_u32(w, "e_uwh", 1834221UL);
+    sw_kv_u32(w, "pk_mw", 2210);
+    sw_kv_u32(w, "vmin", 3612);
+    sw_kv_u32(w, "vmax", 4188);
+    sw_kv_u32(w, "ev", 0);
+    sw_kv_u32(w, "awake_ms", 24312UL);
+    sw_kv_u32(w, "net_ms", 19108UL);
+    sw_kv_u32(w, "up", 1);
+    sw_kv_u32(w, "fast_ms", 2210UL);
+    sw_kv_u32(w, "cpu_uas", 31877UL);
+    sw_kv_u32(w, "cpu_uas_16m", 243120UL);
+    sw_key(w, "uart");
+    sw_arr_begin(w);
+    sw_item_u32(w, 115200UL);
+    sw_item_u32(w, 61);
+    sw_item_u32(w, 0);
+    sw_arr_end(w);
+    sw_key(w, "sess");
+    sw_arr_begin(w);
+    for (int i = 0; i < 3; i++) {
+        sw_item(w);
+        sw_arr_begin(w);
+        sw_item_i32(w, SESS[i][0]);
+        sw_item_i32(w, SESS[i][1]);
+        sw_item_u32(w, 31 + i);
+        sw_item_u32(w, 1);
+        sw_arr_end(w);
+    }
+    sw_arr_end(w);
+    sw_key(w, "rec");
+    sw_obj_begin(w);
+    sw_kv_u32(w, "n", 3);
+    sw_kv_u32(w, "ch", 4);
+    sw_kv_u32(w, "now", 902113UL);
+    sw_key(w, "b64");
+    sw_char(w, '"');
+    sw_base64(w, REC, sizeof(REC));
+    sw_char(w, '"');
+    sw_obj_end(w);
+    sw_obj_end(w);
+}
+
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(void) {
+    static char buf[704];
+    sw_t w;
+    volatile uint16_t sink = 0;
+
+    report_printf();
+    sw_init_buf(&w, buf, sizeof(buf));
+    report_fill(&w, NULL);
+    if (strcmp(buf, payload) != 0 || sw_measure(report_fill, NULL) != (uint16_t)payload_len) {
+        printf("output differs:\n  printf: %s\n  writer: %s\n", payload, buf);
+        return 1;
+    }
+    printf("report: %d B, identical\n", payload_len);
+
+    double t0 = seconds();
+    for (int i = 0; i < ROUNDS; i++) { report_printf(); sink += (uint16_t)payload_len; }
+    double t_printf = (seconds() - t0) / ROUNDS;
+
+    t0 = seconds();
+    for (int i = 0; i < ROUNDS; i++) {
+        sw_init_buf(&w, buf, sizeof(buf));
+        report_fill(&w, NULL);
+        sink += w.len;
+    }
+    double t_writer = (seconds() - t0) / ROUNDS;
+
+    t0 = seconds();
+    for (int i = 0; i < ROUNDS; i++) sink += sw_measure(report_fill, NULL);
+    double t_count = (seconds() - t0) / ROUNDS;
+
+    printf("vsnprintf      %7.2f us\n", t_printf * 1e6);
+    printf("writer, buffer %7.2f us  (%.1fx faster)\n", t_writer * 1e6, t_printf / t_writer);
+    printf("writer, count  %7.2f us  (%.1fx faster)\n", t_count * 1e6, t_printf / t_count);
+    return 0;
+}
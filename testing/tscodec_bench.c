@@ -0,0 +1,199 @@
+/*
+ * Compression benchmark of firmware/telemetry/tscodec.c.
+ *
+ * Packs a log into batches of RECORD_BUF_SZ bytes (the main AVR's record
+ * buffer), decodes every batch back and compares, then reports records
+ * per batch and the ratio against the native record struct
+ * (uint32_t timestamp + int32_t per channel).
+ *
+ * Accepted logs (detected from the header):
+ *  - monitor_solar.py CSV (recorded INA219 data): current, voltage and
+ *    power as 0.01 mA / 0.01 V / 0.01 mW integers, 3 channels;
+ *  - deadband_replay weather CSV (time_s,t,t_ds,p,rh,...): the four
+ *    sensor channels the firmware records. Decimated to one row per
+ *    RECORD_PERIOD_S like the firmware; --every-row keeps all rows.
+ *
+ * --vector writes the first batch of the log as JSON for the server
+ * decoder check (node server/tscodec.js <file>).
+ *
+ * Build and run on the host:
+ *   cc -O2 -DOTA_ENABLE=0 -I../firmware/telemetry -I../firmware/boards/m328p \
+ *      tscodec_bench.c ../firmware/telemetry/tscodec.c -o tscodec_bench
+ *   ./deadband_replay --dump > synthetic_weather.csv
+ *   ./tscodec_bench solar_log_2025_04_17.csv synthetic_weather.csv
+ *
+ * Options apply to the logs after them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "tscodec.h"
+#include "config.h"
+
+#define MAX_ROWS 40000
+
+typedef struct {
+    uint32_t ts;
+    int32_t  v[TSC_MAX_CHANNELS];
+} row_t;
+
+static row_t rows[MAX_ROWS];
+static size_t n_rows;
+static uint8_t channels;
+
+static int32_t hundredths(const char *s) {
+    return (int32_t)(strtod(s, NULL) * 100.0 + (s[0] == '-' ? -0.5 : 0.5));
+}
+
+static int load(const char *path, bool every_row) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    char line[256];
+    n_rows = 0;
+    if (!fgets(line, sizeof(line), f)) {
+        fclose(f);
+        return -1;
+    }
+    bool solar = strncmp(line, "Timestamp", 9) == 0;
+    channels = solar ? 3 : 4;
+    long last_kept = -1000000;
+
+    while (fgets(line, sizeof(line), f) && n_rows < MAX_ROWS) {
+        row_t *r = &rows[n_rows];
+
+        if (solar) {
+            struct tm tm = { 0 };
+            char *fields[5];
+            char *p = line;
+            for (int i = 0; i < 5; i++) {
+                fields[i] = p;
+                p = strchr(p, ',');
+                if (!p && i < 4) break;
+                if (p) *p++ = '\0';
+            }
+            if (sscanf(fields[0], "%d-%d-%d %d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                       &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6) continue;
+            tm.tm_year -= 1900;
+            tm.tm_mon -= 1;
+            r->ts = (uint32_t)timegm(&tm);
+            r->v[0] = hundredths(fields[1]);
+            r->v[1] = hundredths(fields[2]);
+            r->v[2] = hundredths(fields[3]);
+        } else {
+            long t, v[6];
+            if (sscanf(line, "%ld,%ld,%ld,%ld,%ld,%ld,%ld", &t,
+                       &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) < 5) continue;
+            if (!every_row && t - last_kept < RECORD_PERIOD_S) continue;
+            last_kept = t;
+            // firmware order: METRIC_AIR_TEMP, PRESSURE, HUMIDITY, GROUND_TEMP
+            r->ts = (uint32_t)t;
+            r->v[0] = (int32_t)v[0];
+            r->v[1] = (int32_t)v[2];
+            r->v[2] = (int32_t)v[3];
+            r->v[3] = (int32_t)v[1];
+        }
+        n_rows++;
+    }
+    fclose(f);
+    return n_rows ? 0 : -1;
+}
+
+static void write_vector(FILE *out, const uint8_t *buf, uint16_t len, size_t first, uint16_t count) {
+    fprintf(out, "{\"n\":%u,\"ch\":%u,\"hex\":\"", count, channels);
+    for (uint16_t i = 0; i < len; i++) fprintf(out, "%02x", buf[i]);
+    fprintf(out, "\",\"records\":[");
+    for (uint16_t i = 0; i < count; i++) {
+        const row_t *r = &rows[first + i];
+        fprintf(out, "%s[%lu", i ? "," : "", (unsigned long)r->ts);
+        for (uint8_t c = 0; c < channels; c++) fprintf(out, ",%ld", (long)r->v[c]);
+        fprintf(out, "]");
+    }
+    fprintf(out, "]}\n");
+}
+
+static int bench(const char *path, bool every_row, FILE *vector) {
+    if (load(path, every_row) != 0) return 1;
+
+    static uint8_t buf[RECORD_BUF_SZ];
+    tsc_encoder_t e;
+    size_t first = 0, batches = 0, bytes = 0, errors = 0;
+    uint16_t min_n = UINT16_MAX, max_n = 0;
+    double enc_s = 0.0;
+
+    while (first < n_rows) {
+        tsc_init(&e, buf, sizeof(buf), channels);
+
+        clock_t t0 = clock();
+        size_t i = first;
+        while (i < n_rows && tsc_append(&e, rows[i].ts, rows[i].v)) i++;
+        enc_s += (double)(clock() - t0) / CLOCKS_PER_SEC;
+
+        if (e.count == 0) return 1;
+        if (vector && batches == 0) write_vector(vector, buf, tsc_bytes(&e), first, e.count);
+
+        tsc_decoder_t d;
+        tsc_decoder_init(&d, buf, tsc_bytes(&e), e.count, channels);
+        for (size_t k = first; k < i; k++) {
+            uint32_t ts;
+            int32_t v[TSC_MAX_CHANNELS];
+            if (!tsc_next(&d, &ts, v) || ts != rows[k].ts ||
+                memcmp(v, rows[k].v, channels * sizeof(int32_t)) != 0) {
+                errors++;
+                break;
+            }
+        }
+
+        // the last batch is partial and would skew the per-batch numbers
+        if (i < n_rows || batches == 0) {
+            if (e.count < min_n) min_n = e.count;
+            if (e.count > max_n) max_n = e.count;
+        }
+        bytes += tsc_bytes(&e);
+        batches++;
+        first = i;
+    }
+
+    size_t native = n_rows * (sizeof(uint32_t) + channels * sizeof(int32_t));
+    printf("%s\n", path);
+    printf("  %zu records x %u channels, %zu batches of %u B\n",
+           n_rows, channels, batches, (unsigned)RECORD_BUF_SZ);
+    printf("  records per full batch: %u..%u (native struct: %zu)\n",
+           min_n, max_n, RECORD_BUF_SZ / (sizeof(uint32_t) + channels * sizeof(int32_t)));
+    printf("  %.2f bytes/record, ratio %.1f:1, host encode %.0f ns/record\n",
+           (double)bytes / n_rows, (double)native / bytes, enc_s * 1e9 / n_rows);
+    printf("  round trip: %s\n\n", errors ? "MISMATCH" : "ok");
+    return errors ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    bool every_row = false;
+    FILE *vector = NULL;
+    int failures = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--every-row") == 0) {
+            every_row = true;
+        } else if (strcmp(argv[i], "--vector") == 0 && i + 1 < argc) {
+            vector = fopen(argv[++i], "w");
+            if (!vector) {
+                perror(argv[i]);
+                return 1;
+            }
+        } else {
+            failures += bench(argv[i], every_row, vector);
+            if (vector) {
+                fclose(vector);
+                vector = NULL;
+            }
+        }
+    }
+    return failures ? 1 : 0;
+}